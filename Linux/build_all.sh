@@ -11,6 +11,7 @@ BUILD_KERNEL_VERSION=no
 BUILD_TEST=
 BUILD_BASIC_TEST_ONLY=0
 BUILD_UMD_API_TYPE=standard_api
+BUILD_UMD_LOG_LEVEL=
 MAKE_JOBS_NUM=-j32
 
 set -e
@@ -40,6 +41,12 @@ build_help() {
     echo "-a, --api         Build UMD API type (optional, by default standard api):"
     echo "                    - standard_api"
     echo "                    - python_api"
+    echo "-l, --loglevel    Compile out UMD logs above a level (optional, by default none):"
+    echo "                    - err"
+    echo "                    - warn"
+    echo "                    - alert"
+    echo "                    - info"
+    echo "                    - debug"
     echo "-s, --set         Set UMD and KMD version number"
     echo "                  format: umd_major,umd_minor,kmd_version"
     echo "                  eg: 5,2.0,3.3.0 umd: 5.2.0; kmd: 3.3.0"
@@ -84,7 +91,7 @@ function set_get_version()
     exit 0
 }
 
-ARGS=`getopt -o hdp:v:k:a:t:s:g --long help,debug,platform:,version:,kversion:,api:,np,test:,set:,get -n 'build_all.sh' -- "$@"`
+ARGS=`getopt -o hdp:v:k:a:l:t:s:g --long help,debug,platform:,version:,kversion:,api:,loglevel:,np,test:,set:,get -n 'build_all.sh' -- "$@"`
 eval set -- "$ARGS"
 
 while [ -n "$1" ]
@@ -112,6 +119,10 @@ do
         BUILD_UMD_API_TYPE="$2"
         shift
         ;;
+    -l|--loglevel)
+        BUILD_UMD_LOG_LEVEL="$2"
+        shift
+        ;;
     -t|--test)
         BUILD_TEST="$2"
         shift
@@ -171,6 +182,18 @@ if [ "$BUILD_UMD_API_TYPE"x != "standard_api"x ] &&
 fi
 export BUILD_UMD_API_TYPE=$BUILD_UMD_API_TYPE
 
+if [ -n "$BUILD_UMD_LOG_LEVEL" ]; then
+    if [ "$BUILD_UMD_LOG_LEVEL"x != "err"x ] &&
+       [ "$BUILD_UMD_LOG_LEVEL"x != "warn"x ] &&
+       [ "$BUILD_UMD_LOG_LEVEL"x != "alert"x ] &&
+       [ "$BUILD_UMD_LOG_LEVEL"x != "info"x ] &&
+       [ "$BUILD_UMD_LOG_LEVEL"x != "debug"x ]; then
+        echo -e "$COMPASS_DRV_BRENVAR_ERROR Invalid UMD log level $BUILD_UMD_LOG_LEVEL"
+        exit 3
+    fi
+    export BUILD_UMD_LOG_LEVEL=LOG_$(echo $BUILD_UMD_LOG_LEVEL | tr '[a-z]' '[A-Z]')
+fi
+
 ### export toolchain/kpath env variables of your supported platform(s)
 if [ "$BUILD_TARGET_PLATFORM"x = "sim"x ]; then
     export CXX=$COMPASS_DRV_BTENVAR_X86_CXX
@@ -274,6 +297,8 @@ if [ "$BUILD_TEST"x = "sample"x ]; then
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=sharebuffer_test
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=dynamic_shape_test
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=multiple_bss_test
+        make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=api_overhead_test
+        make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=quant_bench_test
     else
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=benchmark_test
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=batch_test
@@ -291,6 +316,8 @@ if [ "$BUILD_TEST"x = "sample"x ]; then
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=emulation_test
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=dynamic_shape_test
         make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=multiple_bss_test
+        make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=api_overhead_test
+        make $MAKE_JOBS_NUM CXX=$CXX BUILD_TEST_CASE=quant_bench_test
     fi
     cd -
 elif [ "$BUILD_TEST"x = "demo"x ]; then
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/uio.h>
 
 typedef struct ctx_handle {
     uint32_t handle;
@@ -110,6 +111,8 @@ typedef enum {
     AIPU_CONFIG_TYPE_HW                       = 0x800,
     AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK = 0x1000,
     AIPU_GLOBAL_CONFIG_TYPE_ENABLE_VER_CHECK  = 0x2000,
+    AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY      = 0x4000,
+    AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN          = 0x8000,
 } aipu_config_type_t;
 
 typedef struct {
@@ -190,6 +193,43 @@ typedef struct {
     bool poll_in_commit_thread;
 } aipu_global_config_hw_t;
 
+/**
+ * @brief residency configuration of weight of graphs loaded with 'wt_on_demand'
+ */
+typedef struct {
+    /**  device memory budget (in bytes) for resident weight of graphs loaded with
+     *   'wt_on_demand'. once exceeded, idle BSS weight buffers are evicted in LRU order.
+     *
+     *   default(no config via this structure) 0: no limit, BSS weight buffers are
+     *   kept resident after first use.
+     *
+     *   eg: keep at most 256MB of on-demand weight resident
+     *      wt_residency_config->budget = 256 * 1024 * 1024;
+     *      aipu_config_global(ctx, AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY, wt_residency_config);
+     */
+    uint64_t budget;
+} aipu_global_config_wt_residency_t;
+
+/**
+ * @brief graph unload and job clean configuration
+ */
+typedef struct {
+    /**  set true to tear down graphs and jobs in background: the graph/job ID
+     *   of aipu_unload_graph/aipu_clean_job is invalid once the call returns while
+     *   the buffers are freed later in bulk.
+     *
+     *   default(no config via this structure) false: buffers are freed before
+     *   aipu_unload_graph/aipu_clean_job returns.
+     *
+     *   eg: free buffers in background
+     *      teardown_config->deferred = true;
+     *      aipu_config_global(ctx, AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN, teardown_config);
+     *
+     *   note: a buffer allocation failing due to pending teardowns waits for them and retries.
+     */
+    bool deferred;
+} aipu_global_config_teardown_t;
+
 /**
  * @brief function prototype for job's callback handler
  *
@@ -205,6 +245,19 @@ typedef std::function<int(uint64_t, aipu_job_status_t)> aipu_job_callback_func_t
 typedef int (*aipu_job_callback_func_t)(uint64_t job_id, aipu_job_status_t job_state);
 #endif
 
+/**
+ * @brief function prototype for asynchronous graph loading progress handler
+ *
+ * @param[in] graph_id    Pending graph's id returned by aipu_load_graph_async
+ * @param[in] bytes_done  Bytes of text/rodata/weight data uploaded to device so far
+ * @param[in] bytes_total Total bytes to be uploaded for this graph
+ * @param[in] arg         Private argument passed to aipu_load_graph_async
+ *
+ * @note it is called in UMD's loading thread, so it should return quickly.
+ */
+typedef void (*aipu_load_graph_progress_t)(uint64_t graph_id, uint64_t bytes_done,
+    uint64_t bytes_total, void *arg);
+
 /**
  * @brief AIPU core info struct; returned by UMD API for AIPU debugger to use
  */
@@ -334,6 +387,281 @@ typedef struct aipu_bin_buildversion
     uint32_t aipubin_buildversion; /**< the build version of searched graph */
 } aipu_bin_buildversion_t;
 
+/**
+ * @brief graph load/unload phases
+ *
+ * @note phases nest as CREATE_GRAPH > LOAD > {PARSE > EXTRACT_GM, ALLOC_WEIGHT},
+ *       the figures of a phase include its inner phases.
+ */
+typedef enum {
+    AIPU_LOAD_PHASE_CREATE_GRAPH = 0, /**< whole graph loading, including device open */
+    AIPU_LOAD_PHASE_LOAD,             /**< graph binary parsing and buffer loading */
+    AIPU_LOAD_PHASE_PARSE,            /**< graph binary parsing */
+    AIPU_LOAD_PHASE_EXTRACT_GM,       /**< GM info extraction, only for aipu v3/v3_1 */
+    AIPU_LOAD_PHASE_ALLOC_WEIGHT,     /**< weight buffer allocation and loading */
+    AIPU_LOAD_PHASE_UNLOAD,           /**< graph unloading */
+    AIPU_LOAD_PHASE_MAX
+} aipu_load_phase_t;
+
+#define AIPU_LOAD_STATS_ASID_CNT   4
+#define AIPU_LOAD_STATS_REGION_CNT 3
+
+/**
+ * @struct aipu_load_phase_stats
+ *
+ * @brief time and device memory consumed by one graph load/unload phase
+ */
+typedef struct aipu_load_phase_stats
+{
+    uint64_t wall_ns;      /**< wall time in nanoseconds */
+    uint64_t bytes_copied; /**< bytes written to device memory */
+    uint32_t alloc_cnt;    /**< number of device buffer allocations */
+    uint32_t free_cnt;     /**< number of device buffer frees */
+    uint64_t free_bytes;   /**< device memory freed */
+    uint64_t alloc_bytes[AIPU_LOAD_STATS_ASID_CNT][AIPU_LOAD_STATS_REGION_CNT]; /**< device memory
+                              allocated, indexed by ASID and aipu_mem_region_t */
+} aipu_load_phase_stats_t;
+
+/**
+ * @struct aipu_graph_load_stats
+ *
+ * @brief load/unload report of a graph
+ *
+ * @note the UNLOAD phase is only available for the latest unloaded graph of a context,
+ *       query it with that graph's id after aipu_unload_graph.
+ */
+typedef struct aipu_graph_load_stats
+{
+    uint64_t graph_id;     /**< the graph id to be searched */
+    const char *json_path; /**< optional, also dump the report to this JSON file if not nullptr */
+    aipu_load_phase_stats_t phases[AIPU_LOAD_PHASE_MAX]; /**< indexed by aipu_load_phase_t */
+} aipu_graph_load_stats_t;
+
+#define AIPU_METRICS_QOS_CNT       2
+#define AIPU_METRICS_PARTITION_CNT 4
+#define AIPU_METRICS_HIST_BUCKETS  160
+
+/**
+ * @brief operations with latency histograms
+ */
+typedef enum {
+    AIPU_METRICS_LAT_CREATE = 0, /**< job creation */
+    AIPU_METRICS_LAT_SCHEDULE,   /**< job schedule */
+    AIPU_METRICS_LAT_WAIT,       /**< blocking wait for a job status */
+    AIPU_METRICS_LAT_COPY,       /**< tensor load/get */
+    AIPU_METRICS_LAT_MAX
+} aipu_metrics_latency_t;
+
+/**
+ * @struct aipu_latency_hist
+ *
+ * @brief log-linear latency histogram, 4 buckets per power of 2
+ *
+ * @note bucket i counts samples in [lo(i), lo(i + 1)) ns, lo(i) = i for i < 4,
+ *       else (4 + i % 4) << (i / 4 - 1). the last bucket counts all larger samples.
+ */
+typedef struct aipu_latency_hist
+{
+    uint64_t count;  /**< sample count */
+    uint64_t sum_ns; /**< sum of samples in nanoseconds */
+    uint64_t max_ns; /**< largest sample in nanoseconds */
+    uint64_t buckets[AIPU_METRICS_HIST_BUCKETS];
+} aipu_latency_hist_t;
+
+/**
+ * @struct aipu_job_counters
+ *
+ * @brief job counters indexed by QoS level
+ */
+typedef struct aipu_job_counters
+{
+    uint64_t created[AIPU_METRICS_QOS_CNT];
+    uint64_t scheduled[AIPU_METRICS_QOS_CNT];  /**< jobs committed to the NPU */
+    uint64_t completed[AIPU_METRICS_QOS_CNT];  /**< committed jobs done */
+    uint64_t failed[AIPU_METRICS_QOS_CNT];     /**< committed jobs with an exception */
+} aipu_job_counters_t;
+
+/**
+ * @struct aipu_metrics
+ *
+ * @brief runtime metrics of a context, device memory is accounted for the device
+ *        the context works on
+ *
+ * @note partitions/QoS levels beyond the array sizes are accounted into the last entry
+ */
+typedef struct aipu_metrics
+{
+    uint64_t graph_id;             /**< optional, also fill 'graph' if not 0 */
+    const char *prom_path;         /**< optional, also write the metrics to this file in
+                                        Prometheus text format if not nullptr */
+    aipu_job_counters_t jobs;      /**< jobs of all graphs */
+    aipu_job_counters_t graph;     /**< jobs of graph 'graph_id' */
+    uint32_t inflight[AIPU_METRICS_PARTITION_CNT];     /**< jobs in flight per partition */
+    uint32_t inflight_max[AIPU_METRICS_PARTITION_CNT]; /**< high-water mark of 'inflight' */
+    uint64_t mem_bytes[AIPU_LOAD_STATS_ASID_CNT][AIPU_LOAD_STATS_REGION_CNT]; /**< device
+                                        memory in use, indexed by ASID and aipu_mem_region_t */
+    uint64_t mem_bytes_max[AIPU_LOAD_STATS_ASID_CNT][AIPU_LOAD_STATS_REGION_CNT]; /**< high-water
+                                        mark of 'mem_bytes' */
+    uint64_t alloc_fail_cnt;       /**< device memory allocation failures */
+    aipu_latency_hist_t latency[AIPU_METRICS_LAT_MAX]; /**< indexed by aipu_metrics_latency_t */
+} aipu_metrics_t;
+
+/**
+ * @struct aipu_metrics_export
+ *
+ * @brief periodic Prometheus text export of the metrics of a context
+ */
+typedef struct aipu_metrics_export
+{
+    const char *prom_path; /**< output file, eg. for a node exporter textfile collector */
+    uint32_t period_ms;    /**< write period, 0 stops the export */
+} aipu_metrics_export_t;
+
+/**
+ * @struct aipu_profile_layout
+ *
+ * @brief layout of the per-layer records in the profiler buffer
+ *
+ * @note the profiler buffer holds one region per subgraph, starting at the
+ *       subgraph's profiler offset in the graph binary. a region is a header
+ *       followed by fixed size records, it ends at the first record whose end
+ *       cycle count is 0. the record layout is the one of the NPU runtime the
+ *       graph is built with.
+ */
+typedef struct aipu_profile_layout
+{
+    uint32_t header_size;     /**< bytes skipped at the start of a subgraph region */
+    uint32_t record_size;     /**< bytes per layer record */
+    uint32_t layer_id_offset; /**< offset of the 32-bit layer ID in a record */
+    uint32_t start_offset;    /**< offset of the 64-bit start cycle count in a record */
+    uint32_t end_offset;      /**< offset of the 64-bit end cycle count in a record */
+} aipu_profile_layout_t;
+
+/**
+ * @struct aipu_profile_run
+ *
+ * @brief decode the profiler buffer of a done job into the report of its graph
+ */
+typedef struct aipu_profile_run
+{
+    uint64_t job_id;
+    aipu_profile_layout_t layout;
+    uint32_t layer_cnt;       /**< [out] layer records decoded */
+} aipu_profile_run_t;
+
+/**
+ * @struct aipu_profile_layer_stats
+ *
+ * @brief cycles of a layer aggregated over the runs added to a report
+ *
+ * @note p99 is taken over the latest 4096 runs of the layer
+ */
+typedef struct aipu_profile_layer_stats
+{
+    uint32_t subgraph_id;
+    uint32_t layer_id;
+    uint64_t runs;
+    uint64_t min_cycles;
+    uint64_t mean_cycles;
+    uint64_t p99_cycles;
+    uint64_t max_cycles;
+    double mean_us;           /**< 0 if freq_mhz of the report is 0 */
+    double p99_us;            /**< 0 if freq_mhz of the report is 0 */
+} aipu_profile_layer_stats_t;
+
+/**
+ * @struct aipu_profile_report
+ *
+ * @brief per-layer report of a graph, ordered by subgraph ID and layer ID
+ */
+typedef struct aipu_profile_report
+{
+    uint64_t graph_id;
+    uint32_t freq_mhz;        /**< NPU clock to convert cycles into microseconds */
+    uint32_t reset;           /**< drop the runs added so far after reporting if not 0 */
+    const char *csv_path;     /**< optional, also write the report to this CSV file */
+    const char *json_path;    /**< optional, also write the report to this JSON file */
+    aipu_profile_layer_stats_t *layers; /**< optional, filled up to 'layer_cnt' entries */
+    uint32_t layer_cnt;       /**< [in] entries of 'layers', [out] layers in the report */
+} aipu_profile_report_t;
+
+/**
+ * @brief callback receiving the NPU printf output of a job, one NUL terminated line
+ *        without the line feed per call. a line longer than 4KB comes in pieces.
+ *
+ * @note it's called in the reader thread of the job, not the thread running the job
+ */
+typedef void (*aipu_printf_sink_t)(uint64_t job_id, const char *line, uint32_t len, void *arg);
+
+/**
+ * @struct aipu_printf_stream
+ *
+ * @brief stream the printf buffer of a job to a sink while it runs
+ *
+ * @note the buffer is polled every 'poll_ms', text overwritten between two polls is lost
+ */
+typedef struct aipu_printf_stream
+{
+    uint64_t job_id;
+    aipu_printf_sink_t sink;  /**< nullptr stops the stream after draining what's left */
+    void *arg;                /**< passed to the sink */
+    uint32_t poll_ms;         /**< poll period, 0 for the default 10ms */
+    uint64_t lost_bytes;      /**< [out] bytes overwritten before being read, set on stop */
+} aipu_printf_stream_t;
+
+typedef enum {
+    AIPU_DUMP_COMPRESS_NONE = 0,
+    AIPU_DUMP_COMPRESS_LZ4  = 1, /**< LZ4 frame, the file name gets a ".lz4" suffix */
+} aipu_dump_compress_t;
+
+/**
+ * @struct aipu_dump_writer_cfg
+ *
+ * @brief how the buffer dumps configured by aipu_config_job are written, process wide
+ *
+ * @note async
+ *       a dump is copied into a staging buffer and written by a background thread, so
+ *       scheduling a job isn't held up by file I/O. the callers wait only when the
+ *       queued snapshots exceed 'max_pending_mb'.
+ * @note dedup
+ *       a dump identical to one written before in this process, eg. the weight dumped
+ *       by every job of a graph, becomes a hard link to it. the dump files should not be
+ *       rewritten in place then.
+ */
+typedef struct aipu_dump_writer_cfg
+{
+    uint32_t async;           /**< 1: write dumps in the background, 0: in the caller */
+    uint32_t compress;        /**< aipu_dump_compress_t */
+    uint32_t dedup;           /**< 1: hard link a dump identical to an earlier one */
+    uint32_t max_pending_mb;  /**< staging memory limit, 0 for the default 512MB */
+} aipu_dump_writer_cfg_t;
+
+#define AIPU_TENSOR_COPY_MAX_DIMS 6
+
+/**
+ * @struct aipu_tensor_copy
+ *
+ * @brief strided copy between an application buffer and a tensor buffer
+ *
+ * @note both sides are walked over the same logical index space, each side gives
+ *       its own byte stride per logical dimension. eg. NCHW host data into an NHWC
+ *       tensor of Cp >= C padded channels with 4 byte elements:
+ *       shape {N, C, H, W}, host_strides {C*H*W*4, H*W*4, W*4, 4},
+ *       tensor_strides {H*W*Cp*4, 4, W*Cp*4, Cp*4}.
+ *       tensor bytes not covered, like padded channels, are left untouched.
+ */
+typedef struct aipu_tensor_copy
+{
+    uint32_t dim_cnt;   /**< logical dimension count, 1 ~ AIPU_TENSOR_COPY_MAX_DIMS */
+    uint32_t elem_size; /**< element byte size: 1, 2, 4 or 8 */
+    uint64_t shape[AIPU_TENSOR_COPY_MAX_DIMS];          /**< element count per dimension */
+    uint64_t host_strides[AIPU_TENSOR_COPY_MAX_DIMS];   /**< byte stride per dimension in the
+                                                             application buffer */
+    uint64_t tensor_strides[AIPU_TENSOR_COPY_MAX_DIMS]; /**< byte stride per dimension in the
+                                                             tensor buffer */
+    uint64_t tensor_offset; /**< byte offset of the first element in the tensor buffer, eg. a plane */
+} aipu_tensor_copy_t;
+
 /**
  * @struct aipu_dynshape_num
  *
@@ -449,12 +777,22 @@ typedef enum {
  * @note wt_idxes
  *       the indexes of weight tensors, those tensor buffers firstly try to be allocated from
  *       region specified in 'wt_mem_region'.
+ *
+ * @note wt_on_demand
+ *       only for aipu v3/v3_1 with default 'wt_mem_region'. weight of each BSS is uploaded
+ *       when a job needs it instead of on loading: a job runs the subgraphs of one BSS at a
+ *       time, with only that BSS pinned while the BSS of the next subgraphs is prefetched.
+ *       idle BSS may be evicted under the budget of AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY,
+ *       so a graph runs as long as its largest BSS fits. it suits multi-BSS graphs whose total
+ *       weight size is large. a job of such graph moves on to its next BSS in whichever
+ *       thread polls the device, its callback is called once after the last BSS.
  */
 typedef struct aipu_load_graph_cfg {
     union {
         uint32_t misc = 0;
         struct {
             uint8_t wt_mem_region:4; /**< default 0, weight buffer memory region */
+            uint8_t wt_on_demand:1;  /**< default 0, upload BSS weight on demand */
         };
     };
 
@@ -519,7 +857,17 @@ typedef enum {
     AIPU_IOCTL_READ_DMABUF,
     AIPU_IOCTL_ATTACH_DMABUF,
     AIPU_IOCTL_DETACH_DMABUF,
-    AIPU_IOCTL_GET_VERSION
+    AIPU_IOCTL_GET_VERSION,
+    AIPU_IOCTL_GET_GRAPH_LOAD_STATS,
+    AIPU_IOCTL_SET_JOB_TRACE,
+    AIPU_IOCTL_DUMP_JOB_TRACE,
+    AIPU_IOCTL_GET_METRICS,
+    AIPU_IOCTL_SET_METRICS_EXPORT,
+    AIPU_IOCTL_ADD_PROFILE_RUN,
+    AIPU_IOCTL_GET_PROFILE_REPORT,
+    AIPU_IOCTL_SET_PRINTF_STREAM,
+    AIPU_IOCTL_SET_DUMP_WRITER,
+    AIPU_IOCTL_FLUSH_DUMPS
 } aipu_ioctl_cmd_t;
 
 /**
@@ -577,7 +925,10 @@ typedef enum {
     AIPU_STATUS_ERROR_ZERO_TENSOR_SIZE     = 0x32,
     AIPU_STATUS_ERROR_ALLOC_GRIP_ID        = 0x33,
     AIPU_STATUS_ERROR_ALLOC_GROUP_ID       = 0x34,
-    AIPU_STATUS_MAX                        = 0x35,
+    AIPU_STATUS_ERROR_GRAPH_LOADING        = 0x35,
+    AIPU_STATUS_ERROR_LOAD_CANCELED        = 0x36,
+    AIPU_STATUS_ERROR_NO_FREE_HANDLE       = 0x37,
+    AIPU_STATUS_MAX                        = 0x38,
     /* AIPU layer library runtime error code */
     AIPU_STATUS_ERROR_UNKNOWN_ERROR        = 0x200,
     AIPU_STATUS_ERROR_KEYBOARD_INTERRUPT   = 0x300,
@@ -618,6 +969,7 @@ extern "C" {
  * @retval AIPU_STATUS_ERROR_NULL_PTR
  * @retval AIPU_STATUS_ERROR_OPEN_DEV_FAIL
  * @retval AIPU_STATUS_ERROR_DEV_ABNORMAL
+ * @retval AIPU_STATUS_ERROR_NO_FREE_HANDLE
  *
  * @note Before invoking any other UMD API calls, any UMD application must initialize a context first.
  */
@@ -666,6 +1018,8 @@ aipu_status_t aipu_get_error_message(const aipu_ctx_handle_t* ctx, aipu_status_t
  * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK/none
  * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_ENABLE_VER_CHECK/none
  * @note accepted types/config: AIPU_CONFIG_TYPE_HW
+ * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY/aipu_global_config_wt_residency_t
+ * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN/aipu_global_config_teardown_t
  */
 aipu_status_t aipu_config_global(const aipu_ctx_handle_t* ctx, uint64_t types, void* config);
 
@@ -690,6 +1044,7 @@ aipu_status_t aipu_config_global(const aipu_ctx_handle_t* ctx, uint64_t types, v
  * @retval AIPU_STATUS_ERROR_BUF_ALLOC_FAIL
  * @retval AIPU_STATUS_ERROR_RESERVE_SRAM_FAIL
  * @retval AIPU_STATUS_ERROR_INVALID_GM
+ * @retval AIPU_STATUS_ERROR_NO_FREE_HANDLE
  */
 aipu_status_t aipu_load_graph(const aipu_ctx_handle_t* ctx, const char* graph,
     uint64_t* id, aipu_load_graph_cfg_t *config = nullptr);
@@ -717,10 +1072,75 @@ aipu_status_t aipu_load_graph(const aipu_ctx_handle_t* ctx, const char* graph,
  * @retval AIPU_STATUS_ERROR_BUF_ALLOC_FAIL
  * @retval AIPU_STATUS_ERROR_RESERVE_SRAM_FAIL
  * @retval AIPU_STATUS_ERROR_INVALID_GM
+ * @retval AIPU_STATUS_ERROR_NO_FREE_HANDLE
  */
 aipu_status_t aipu_load_graph_helper(const aipu_ctx_handle_t* ctx, const char* graph_buf,
     uint32_t graph_size, uint64_t* id, aipu_load_graph_cfg_t *config = nullptr);
 
+/**
+ * @brief This API starts loading a graph binary from file system in background and
+ *        returns a pending graph ID immediately.
+ *
+ * @param[in]  ctx      Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  graph    Executable graph binary file path
+ * @param[out] id       Pointer to a memory location allocated by application where UMD stores the
+ *                          pending graph ID
+ * @param[in]  config   Pointer to specific configuration struct, it is copied by UMD
+ * @param[in]  progress Optional handler to report uploaded bytes, can be NULL
+ * @param[in]  arg      Private argument passed to 'progress'
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_OPEN_FILE_FAIL
+ * @retval AIPU_STATUS_ERROR_NO_FREE_HANDLE
+ *
+ * @note The graph ID can't be used to create job until loading is done. The final loading
+ *       result is returned by aipu_wait_graph_loaded, which should be called once for each
+ *       pending graph to release its loading record.
+ * @note Graphs loaded in parallel from the same or different contexts don't block each other.
+ */
+aipu_status_t aipu_load_graph_async(const aipu_ctx_handle_t* ctx, const char* graph,
+    uint64_t* id, aipu_load_graph_cfg_t *config = nullptr,
+    aipu_load_graph_progress_t progress = nullptr, void *arg = nullptr);
+
+/**
+ * @brief This API waits for a graph loading started by aipu_load_graph_async.
+ *
+ * @param[in] ctx      Pointer to a context handle struct returned by aipu_init_context
+ * @param[in] graph    Pending graph ID returned by aipu_load_graph_async
+ * @param[in] time_out Wait time in ms, 0 for polling, -1 for waiting until loading is done
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_GRAPH_ID
+ * @retval AIPU_STATUS_ERROR_GRAPH_LOADING
+ * @retval AIPU_STATUS_ERROR_LOAD_CANCELED
+ * @retval other error codes returned by aipu_load_graph
+ *
+ * @note Except AIPU_STATUS_ERROR_GRAPH_LOADING, the loading record is released after return,
+ *       and a failed or canceled graph ID becomes invalid.
+ */
+aipu_status_t aipu_wait_graph_loaded(const aipu_ctx_handle_t* ctx, uint64_t graph, int32_t time_out);
+
+/**
+ * @brief This API requests to cancel a graph loading started by aipu_load_graph_async.
+ *
+ * @param[in] ctx   Pointer to a context handle struct returned by aipu_init_context
+ * @param[in] graph Pending graph ID returned by aipu_load_graph_async
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_GRAPH_ID
+ *
+ * @note Canceling is asynchronous and takes effect on the next section/BSS boundary;
+ *       call aipu_wait_graph_loaded to reap the result. A graph which finished
+ *       loading before canceling stays loaded.
+ */
+aipu_status_t aipu_cancel_load_graph(const aipu_ctx_handle_t* ctx, uint64_t graph);
+
 /**
  * @brief This API is used to unload a loaded graph
  *
@@ -731,6 +1151,8 @@ aipu_status_t aipu_load_graph_helper(const aipu_ctx_handle_t* ctx, const char* g
  * @retval AIPU_STATUS_ERROR_NULL_PTR
  * @retval AIPU_STATUS_ERROR_INVALID_CTX
  * @retval AIPU_STATUS_ERROR_INVALID_GRAPH_ID
+ *
+ * @note Unloading a graph still pending in aipu_load_graph_async cancels and reaps the loading.
  */
 aipu_status_t aipu_unload_graph(const aipu_ctx_handle_t* ctx, uint64_t graph);
 
@@ -749,6 +1171,7 @@ aipu_status_t aipu_unload_graph(const aipu_ctx_handle_t* ctx, uint64_t graph);
  * @retval AIPU_STATUS_ERROR_INVALID_CTX
  * @retval AIPU_STATUS_ERROR_INVALID_GRAPH_ID
  * @retval AIPU_STATUS_ERROR_BUF_ALLOC_FAIL
+ * @retval AIPU_STATUS_ERROR_NO_FREE_HANDLE
  *
  * @note The application can create one or multiple jobs by calling this API one or multiple times.
  * @note The application can schedule one created job one or multiple times by calling
@@ -904,6 +1327,203 @@ aipu_status_t aipu_load_tensor(const aipu_ctx_handle_t* ctx, uint64_t job, uint3
 aipu_status_t aipu_get_tensor(const aipu_ctx_handle_t* ctx, uint64_t job,
     aipu_tensor_type_t type, uint32_t tensor, void* data);
 
+/**
+ * @brief This API is used to load an input tensor from float data, the data is
+ *        quantized/converted into the tensor data type while it's copied
+ *
+ * @param[in] ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in] job    Job ID returned by aipu_create_job
+ * @param[in] tensor Input tensor ID
+ * @param[in] data   Float data, one element per tensor element
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note q = clamp(round_half_even(f * scale) - zero_point) with scale and zero_point
+ *       of the tensor descriptor. S8/U8/S16/U16 and 4/12-bit aligned/compact tensors
+ *       are quantized, F16/BF16/F32 ones are converted, other data types are not supported.
+ */
+aipu_status_t aipu_load_tensor_float(const aipu_ctx_handle_t* ctx, uint64_t job,
+    uint32_t tensor, const float* data);
+
+/**
+ * @brief This API is used to get input/output tensor data as float, the data is
+ *        dequantized/converted from the tensor data type while it's copied
+ *
+ * @param[in]  ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  job    Job ID returned by aipu_create_job
+ * @param[in]  type   Tensor type, AIPU_TENSOR_TYPE_INPUT or AIPU_TENSOR_TYPE_OUTPUT
+ * @param[in]  tensor Tensor ID
+ * @param[out] data   Float data, one element per tensor element
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note f = (q + zero_point) / scale, see aipu_load_tensor_float
+ */
+aipu_status_t aipu_get_tensor_float(const aipu_ctx_handle_t* ctx, uint64_t job,
+    aipu_tensor_type_t type, uint32_t tensor, float* data);
+
+/**
+ * @brief This API is used to load an input tensor from unpacked integer data, the
+ *        data is packed into the 4/12-bit tensor data type while it's copied
+ *
+ * @param[in] ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in] job    Job ID returned by aipu_create_job
+ * @param[in] tensor Input tensor ID
+ * @param[in] data   One int8/uint8 per element for 4-bit types, one int16/uint16
+ *                   per element for 12-bit types
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note Values out of the 4/12-bit range saturate. AIPU_DATA_TYPE_ALIGNED_* tensors keep
+ *       one element per byte/half-word, AIPU_DATA_TYPE_COMPACT_* ones store element 2n
+ *       in the low bits. Tensors of the other data types aipu_load_tensor_float supports
+ *       are copied as they are.
+ */
+aipu_status_t aipu_load_tensor_unpacked(const aipu_ctx_handle_t* ctx, uint64_t job,
+    uint32_t tensor, const void* data);
+
+/**
+ * @brief This API is used to get input/output tensor data unpacked from the 4/12-bit
+ *        tensor data type, signed types are sign extended
+ *
+ * @param[in]  ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  job    Job ID returned by aipu_create_job
+ * @param[in]  type   Tensor type, AIPU_TENSOR_TYPE_INPUT or AIPU_TENSOR_TYPE_OUTPUT
+ * @param[in]  tensor Tensor ID
+ * @param[out] data   Unpacked data, see aipu_load_tensor_unpacked
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ */
+aipu_status_t aipu_get_tensor_unpacked(const aipu_ctx_handle_t* ctx, uint64_t job,
+    aipu_tensor_type_t type, uint32_t tensor, void* data);
+
+/**
+ * @brief This API is used to load an input tensor from application data of another
+ *        layout, the data is written straight into the tensor buffer in the tensor's layout
+ *
+ * @param[in] ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in] job    Job ID returned by aipu_create_job
+ * @param[in] tensor Input tensor ID
+ * @param[in] data   Application data, the first element of the copy
+ * @param[in] copy   Strided copy descriptor, see aipu_tensor_copy_t
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_INVALID_CONFIG
+ * @retval AIPU_STATUS_ERROR_INVALID_SIZE
+ *
+ * @note the copy must stay inside the tensor buffer, the application buffer is not
+ *       checked. planar data, eg. YUV, is loaded by one call per plane with its
+ *       tensor_offset.
+ */
+aipu_status_t aipu_load_tensor_layout(const aipu_ctx_handle_t* ctx, uint64_t job,
+    uint32_t tensor, const void* data, const aipu_tensor_copy_t* copy);
+
+/**
+ * @brief This API is used to get input/output tensor data into an application buffer
+ *        of another layout
+ *
+ * @param[in]  ctx    Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  job    Job ID returned by aipu_create_job
+ * @param[in]  type   Tensor type, AIPU_TENSOR_TYPE_INPUT or AIPU_TENSOR_TYPE_OUTPUT
+ * @param[in]  tensor Tensor ID
+ * @param[out] data   Application buffer, the first element of the copy
+ * @param[in]  copy   Strided copy descriptor, see aipu_tensor_copy_t
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_INVALID_CONFIG
+ * @retval AIPU_STATUS_ERROR_INVALID_SIZE
+ */
+aipu_status_t aipu_get_tensor_layout(const aipu_ctx_handle_t* ctx, uint64_t job,
+    aipu_tensor_type_t type, uint32_t tensor, void* data, const aipu_tensor_copy_t* copy);
+
+/**
+ * @brief This API loads all input tensors, runs a job, waits for it to end and
+ *        gets all output tensors in one call.
+ *
+ * @param[in]  ctx      Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  job      Job ID returned by aipu_create_job
+ * @param[in]  inputs   Input tensor data, one entry per input tensor ID; a NULL entry leaves
+ *                      that tensor as is; NULL loads no input
+ * @param[out] outputs  Output tensor buffers, one entry per output tensor ID; a NULL entry skips
+ *                      that tensor; NULL gets no output
+ * @param[in]  time_out Timeout value(in ms) to wait for the job end; <= 0 means blocking
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_JOB_EXCEPTION
+ * @retval AIPU_STATUS_ERROR_TIMEOUT
+ *
+ * @note It's equivalent to aipu_load_tensor for each input, aipu_finish_job and aipu_get_tensor
+ *       for each output, but resolves the job once. the output buffers should be as large as
+ *       the tensor sizes after the job ends (for dynamic shape graph).
+ */
+aipu_status_t aipu_run_job(const aipu_ctx_handle_t* ctx, uint64_t job,
+    const void* const inputs[], void* const outputs[], int32_t time_out);
+
+/**
+ * @brief This API is the scatter/gather version of aipu_run_job.
+ *
+ * @param[in]  ctx        Pointer to a context handle struct returned by aipu_init_context
+ * @param[in]  job        Job ID returned by aipu_create_job
+ * @param[in]  inputs     Segments filling all input tensors concatenated in tensor ID order
+ * @param[in]  input_cnt  Segment count of inputs; 0 loads no input
+ * @param[in]  outputs    Segments receiving all output tensors concatenated in tensor ID order
+ * @param[in]  output_cnt Segment count of outputs; 0 gets no output
+ * @param[in]  time_out   Timeout value(in ms) to wait for the job end; <= 0 means blocking
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_NULL_PTR
+ * @retval AIPU_STATUS_ERROR_INVALID_CTX
+ * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+ * @retval AIPU_STATUS_ERROR_INVALID_OP
+ * @retval AIPU_STATUS_ERROR_INVALID_SIZE
+ * @retval AIPU_STATUS_ERROR_JOB_EXCEPTION
+ * @retval AIPU_STATUS_ERROR_TIMEOUT
+ *
+ * @note The total segment length of each side should equal the total tensor size of it, a
+ *       segment may span several tensors. a segment with NULL iov_base skips its length.
+ */
+aipu_status_t aipu_run_job_iov(const aipu_ctx_handle_t* ctx, uint64_t job,
+    const struct iovec* inputs, uint32_t input_cnt,
+    const struct iovec* outputs, uint32_t output_cnt, int32_t time_out);
+
 /**
  * @brief This API is used to configure a specified option of a job.
  *
@@ -1283,6 +1903,45 @@ aipu_status_t aipu_finish_batch(const aipu_ctx_handle_t *ctx, uint64_t graph_id,
  *       AIPU_IOCTL_GET_AIPUBIN_BUILDVERSION
  *           get model binary's build version.
  *           arg: { aipu_bin_buildversion_t* }
+ *       AIPU_IOCTL_GET_GRAPH_LOAD_STATS
+ *           get time and device memory breakdown of graph load/unload phases.
+ *           arg: { aipu_graph_load_stats_t* }
+ *       AIPU_IOCTL_SET_JOB_TRACE
+ *           enable/disable the process wide job lifecycle trace: job creation and
+ *           init phases, tensor load/get, schedule and NPU execution.
+ *           arg: { int32_t* } 1: enable, 0: disable
+ *       AIPU_IOCTL_DUMP_JOB_TRACE
+ *           export the recorded job trace as a Chrome trace-event JSON file,
+ *           open it in chrome://tracing or Perfetto.
+ *           arg: { const char* } file path
+ *       AIPU_IOCTL_GET_METRICS
+ *           get job counters, in-flight depth, device memory usage and latency
+ *           histograms.
+ *           arg: { aipu_metrics_t* }
+ *       AIPU_IOCTL_SET_METRICS_EXPORT
+ *           start/stop writing the metrics, with per graph job counters, to a file
+ *           in Prometheus text format periodically.
+ *           arg: { aipu_metrics_export_t* }
+ *       AIPU_IOCTL_ADD_PROFILE_RUN
+ *           decode the profiler buffer of a done job into per-subgraph/per-layer
+ *           cycle counts and add them to the profile report of its graph.
+ *           arg: { aipu_profile_run_t* }
+ *       AIPU_IOCTL_GET_PROFILE_REPORT
+ *           get min/mean/p99/max cycles and latency per layer over the runs added,
+ *           optionally written to CSV/JSON files for comparing compiler builds.
+ *           arg: { aipu_profile_report_t* }
+ *       AIPU_IOCTL_SET_PRINTF_STREAM
+ *           start/stop a thread streaming the printf buffer of a job to a sink line by
+ *           line, it follows the ring across wraps and later runs of the job. the job
+ *           stops it on destroy.
+ *           arg: { aipu_printf_stream_t* }
+ *       AIPU_IOCTL_SET_DUMP_WRITER
+ *           write the buffer dumps in the background, compressed and/or deduplicated.
+ *           arg: { aipu_dump_writer_cfg_t* }
+ *       AIPU_IOCTL_FLUSH_DUMPS
+ *           wait until the dumps queued so far are written, it fails with
+ *           AIPU_STATUS_ERROR_WRITE_FILE_FAIL if any of them wasn't written.
+ *           no arg
  */
 aipu_status_t aipu_ioctl(aipu_ctx_handle_t *ctx, uint32_t cmd, void *arg = nullptr);
 
@@ -9,6 +9,7 @@
  */
 
 #include <set>
+#include <algorithm>
 #include <queue>
 #include <iomanip>
 #include <iostream>
@@ -16,10 +17,12 @@
 #include <string.h>
 #include <sys/time.h>
 #include "context.h"
+#include "reclaimer.h"
 #include "type.h"
 #include "utils/log.h"
 #include "utils/debug.h"
 #include "utils/helper.h"
+#include "utils/dump_writer.h"
 #include "device.h"
 
 #if (defined ZHOUYI_V12)
@@ -71,6 +74,7 @@ aipudrv::MainContext::MainContext()
     m_sim_cfg.perf_report = nullptr;
 
     m_hw_cfg.poll_in_commit_thread = true;
+    m_teardown_cfg.deferred = false;
     if (umd_log_level_env != nullptr)
     {
         int32_t log_level = umd_log_level_env[0] - '0';
@@ -86,6 +90,7 @@ aipudrv::MainContext::MainContext()
 
 aipudrv::MainContext::~MainContext()
 {
+    m_metrics_exporter.stop();
     pthread_rwlock_destroy(&m_glock);
     if (m_sim_cfg.simulator != nullptr)
     {
@@ -151,13 +156,42 @@ aipu_status_t aipudrv::MainContext::init()
 
 void aipudrv::MainContext::force_deinit()
 {
-    GraphTable::iterator iter;
+    std::vector<GRAPH_ID> loading;
 
-    pthread_rwlock_wrlock(&m_glock);
-    for (iter = m_graphs.begin(); iter != m_graphs.end(); iter++)
-        iter->second->unload();
+    m_metrics_exporter.stop();
 
-    m_graphs.clear();
+    /* stop and reap background loadings before tearing down graphs */
+    {
+        std::lock_guard<std::mutex> lock_(m_load_lock);
+        for (auto &task : m_load_tasks)
+        {
+            task.second->monitor.cancel = true;
+            loading.push_back(task.first);
+        }
+    }
+
+    for (auto id : loading)
+        wait_graph_loaded(id, -1);
+
+    /* graphs unloaded in background still refer to this context */
+    Reclaimer::get_reclaimer().drain();
+
+    glock_wr();
+    for (auto &entry : m_graphs.entries())
+    {
+        if (entry.second != nullptr)
+            entry.second->unload();
+        m_graphs.release(entry.first);
+    }
+
+#ifdef UMD_TEST_HOOKS
+    if (m_dev_borrowed)
+    {
+        m_dev = nullptr;
+        m_dev_borrowed = false;
+        m_dram = nullptr;
+    }
+#endif
 
     if (put_device(m_dev))
         m_dram = nullptr;
@@ -200,23 +234,40 @@ finish:
     return ret;
 }
 
-uint64_t aipudrv::MainContext::create_unique_graph_id_inner() const
+/**
+ * @brief push nullptr into graphs to pin a graph ID
+ *
+ * @retval 0 if there's no free graph ID
+ */
+aipudrv::GRAPH_ID aipudrv::MainContext::pin_graph_id()
 {
-    uint64_t id_candidate = (1UL << 32);
+    uint32_t handle = 0;
+
+    glock_wr();
+    handle = m_graphs.alloc(nullptr);
+    pthread_rwlock_unlock(&m_glock);
+
+    if (handle == 0)
+        LOG(LOG_ERR, "no free graph ID\n");
 
-    while (m_graphs.count(id_candidate) == 1)
-        id_candidate += (1UL << 32);
+    return graph_handle2id(handle);
+}
 
-    return id_candidate;
+void aipudrv::MainContext::unpin_graph_id(GRAPH_ID id)
+{
+    glock_wr();
+    m_graphs.release(graph_id2handle(id));
+    pthread_rwlock_unlock(&m_glock);
 }
 
 aipu_status_t aipudrv::MainContext::create_graph_object(std::istream& gbin, uint32_t size,
-    uint64_t id, GraphBase** gobj, aipu_load_graph_cfg_t *config)
+    uint64_t id, GraphBase** gobj, aipu_load_graph_cfg_t *config, GraphLoadMonitor *monitor)
 {
-    static std::mutex mtex;
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     GraphBase* p_gobj = nullptr;
     uint32_t g_version = 0;
+    aipu_load_phase_stats_t load_stats[AIPU_LOAD_PHASE_MAX] = {};
+    LoadPhase phase(load_stats, AIPU_LOAD_PHASE_CREATE_GRAPH);
 
     if (gobj == nullptr)
     {
@@ -230,7 +281,7 @@ aipu_status_t aipudrv::MainContext::create_graph_object(std::istream& gbin, uint
         goto finish;
 
     {
-        std::lock_guard<std::mutex> lock_(mtex);
+        std::lock_guard<std::mutex> lock_(m_dram_lock);
         if (m_dram == nullptr)
             m_dram = m_dev->get_mem();
     }
@@ -250,13 +301,21 @@ aipu_status_t aipudrv::MainContext::create_graph_object(std::istream& gbin, uint
         goto finish;
     }
 
+    p_gobj->set_weight_residency(&m_wt_residency);
+    p_gobj->set_teardown_config(&m_teardown_cfg);
+    p_gobj->set_load_monitor(monitor);
     ret = p_gobj->load(gbin, size, m_do_vcheck, config);
+    p_gobj->set_load_monitor(nullptr);
     if (ret != AIPU_STATUS_SUCCESS)
     {
         destroy_graph_object(&p_gobj);
         goto finish;
     }
 
+    /* phases inside Graph::load are recorded into load_stats as well */
+    phase.end();
+    memcpy(p_gobj->get_load_stats(), load_stats, sizeof(load_stats));
+
     /* success or return nullptr */
     *gobj = p_gobj;
 
@@ -266,13 +325,11 @@ finish:
 
 aipudrv::GraphBase* aipudrv::MainContext::get_graph_object(GRAPH_ID id)
 {
-    GraphBase* p_gobj = nullptr;
-    pthread_rwlock_rdlock(&m_glock);
-    if (m_graphs.count(id) != 0)
-        p_gobj = m_graphs[id];
-    pthread_rwlock_unlock(&m_glock);
+    /* lock-free, the low 32 bits of a graph ID are 0 */
+    if (job_id2handle(id) != 0)
+        return nullptr;
 
-    return p_gobj;
+    return m_graphs.get(graph_id2handle(id));
 }
 
 aipudrv::JobBase* aipudrv::MainContext::get_job_object(JOB_ID id)
@@ -298,6 +355,12 @@ aipu_status_t aipudrv::MainContext::destroy_graph_object(GraphBase** gobj)
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
 
+    {
+        std::lock_guard<std::mutex> lock_(m_load_lock);
+        m_unload_stats_id = (*gobj)->get_id();
+        memcpy(m_unload_stats, (*gobj)->get_load_stats(), sizeof(m_unload_stats));
+    }
+
     /* success */
     delete *gobj;
     *gobj = nullptr;
@@ -310,7 +373,6 @@ aipu_status_t aipudrv::MainContext::load_graph(const char* graph_file, GRAPH_ID*
     aipu_load_graph_cfg_t *config)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
-    GraphBase* gobj = nullptr;
     uint64_t id = 0;
     std::ifstream gbin;
     int fsize = 0;
@@ -330,24 +392,17 @@ aipu_status_t aipudrv::MainContext::load_graph(const char* graph_file, GRAPH_ID*
     gbin.seekg(0, gbin.beg);
 
     /* push nullptr into graphs to pin this graph ID */
-    pthread_rwlock_wrlock(&m_glock);
-    id = create_unique_graph_id_inner();
-    m_graphs[id] = nullptr;
-    pthread_rwlock_unlock(&m_glock);
-
-    ret = create_graph_object(gbin, fsize, id, &gobj, config);
-    if (ret != AIPU_STATUS_SUCCESS)
+    id = pin_graph_id();
+    if (id == 0)
     {
-        pthread_rwlock_wrlock(&m_glock);
-        m_graphs.erase(id);
-        pthread_rwlock_unlock(&m_glock);
+        ret = AIPU_STATUS_ERROR_NO_FREE_HANDLE;
         goto finish;
     }
 
-    /* success: update graphs[id] */
-    pthread_rwlock_wrlock(&m_glock);
-    m_graphs[id] = gobj;
-    pthread_rwlock_unlock(&m_glock);
+    ret = load_graph_pinned(gbin, fsize, id, config);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
     *_id = id;
 
 finish:
@@ -359,7 +414,6 @@ aipu_status_t aipudrv::MainContext::load_graph(const char* graph_buf, uint32_t g
     GRAPH_ID* _id, aipu_load_graph_cfg_t *config)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
-    GraphBase* gobj = nullptr;
     uint64_t id = 0;
 
     if ((graph_buf == nullptr) || (_id == nullptr))
@@ -375,10 +429,9 @@ aipu_status_t aipudrv::MainContext::load_graph(const char* graph_buf, uint32_t g
     }
 
     /* push nullptr into graphs to pin this graph ID */
-    pthread_rwlock_wrlock(&m_glock);
-    id = create_unique_graph_id_inner();
-    m_graphs[id] = nullptr;
-    pthread_rwlock_unlock(&m_glock);
+    id = pin_graph_id();
+    if (id == 0)
+        return AIPU_STATUS_ERROR_NO_FREE_HANDLE;
 
     CustomMemBuf buf(const_cast<char*>(graph_buf), graph_size);
     std::istream gbin(&buf);
@@ -388,30 +441,173 @@ aipu_status_t aipudrv::MainContext::load_graph(const char* graph_buf, uint32_t g
         goto finish;
     }
 
-    ret = create_graph_object(gbin, graph_size, id, &gobj, config);
+    ret = load_graph_pinned(gbin, graph_size, id, config);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    *_id = id;
+
+finish:
+    return ret;
+}
+
+aipu_status_t aipudrv::MainContext::load_graph_pinned(std::istream& gbin, uint32_t size,
+    GRAPH_ID id, aipu_load_graph_cfg_t *config, GraphLoadMonitor *monitor)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    GraphBase* gobj = nullptr;
+
+    ret = create_graph_object(gbin, size, id, &gobj, config, monitor);
     if (ret != AIPU_STATUS_SUCCESS)
     {
-        pthread_rwlock_wrlock(&m_glock);
-        m_graphs.erase(id);
-        pthread_rwlock_unlock(&m_glock);
+        unpin_graph_id(id);
         goto finish;
     }
 
     /* success: update graphs[id] */
-    pthread_rwlock_wrlock(&m_glock);
-    m_graphs[id] = gobj;
+    glock_wr();
+    m_graphs.set(graph_id2handle(id), gobj);
     pthread_rwlock_unlock(&m_glock);
+
+finish:
+    return ret;
+}
+
+void aipudrv::MainContext::load_graph_worker(GRAPH_ID id, GraphLoadTask *task)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+    ret = load_graph_pinned(task->gbin, task->size, id,
+        task->has_config ? &task->config : nullptr, &task->monitor);
+    task->gbin.close();
+    if (ret != AIPU_STATUS_SUCCESS)
+        LOG(LOG_ALERT, "async load graph 0x%lx [fail], ret=0x%x\n", id, ret);
+
+    std::lock_guard<std::mutex> lock_(m_load_lock);
+    task->status = ret;
+    task->done = true;
+    m_load_cv.notify_all();
+}
+
+aipu_status_t aipudrv::MainContext::load_graph_async(const char* graph_file, GRAPH_ID* _id,
+    aipu_load_graph_cfg_t *config, aipu_load_graph_progress_t progress, void *arg)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    GraphLoadTask *task = nullptr;
+    uint64_t id = 0;
+
+    if ((graph_file == nullptr) || (_id == nullptr))
+    {
+        ret = AIPU_STATUS_ERROR_NULL_PTR;
+        goto finish;
+    }
+
+    task = new GraphLoadTask;
+    task->gbin.open(graph_file, std::ifstream::in | std::ifstream::binary);
+    if (!task->gbin.is_open())
+    {
+        delete task;
+        ret = AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+        goto finish;
+    }
+
+    task->gbin.seekg(0, task->gbin.end);
+    task->size = task->gbin.tellg();
+    task->gbin.seekg(0, task->gbin.beg);
+    task->monitor.cb = progress;
+    task->monitor.cb_arg = arg;
+
+    /* the caller's config may go away before the worker parses it, keep a private copy */
+    if (config != nullptr)
+    {
+        task->has_config = true;
+        task->config = *config;
+        if ((config->wt_idxes != nullptr) && (config->wt_idxes_cnt > 0))
+        {
+            task->wt_idxes.assign(config->wt_idxes, config->wt_idxes + config->wt_idxes_cnt);
+            task->config.wt_idxes = task->wt_idxes.data();
+        }
+
+        if (config->extra_weight_path != nullptr)
+        {
+            task->extra_weight_path = config->extra_weight_path;
+            task->config.extra_weight_path = task->extra_weight_path.c_str();
+        }
+    }
+
+    /* push nullptr into graphs to pin this graph ID */
+    id = pin_graph_id();
+    if (id == 0)
+    {
+        delete task;
+        ret = AIPU_STATUS_ERROR_NO_FREE_HANDLE;
+        goto finish;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock_(m_load_lock);
+        m_load_tasks[id] = task;
+        task->worker = std::thread(&MainContext::load_graph_worker, this, id, task);
+    }
     *_id = id;
 
 finish:
     return ret;
 }
 
+aipu_status_t aipudrv::MainContext::wait_graph_loaded(GRAPH_ID id, int32_t time_out)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    GraphLoadTask *task = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock_(m_load_lock);
+        auto is_done = [this, id] {
+            auto iter = m_load_tasks.find(id);
+            return (iter == m_load_tasks.end()) || iter->second->done;
+        };
+
+        if (time_out < 0)
+            m_load_cv.wait(lock_, is_done);
+        else if (!m_load_cv.wait_for(lock_, std::chrono::milliseconds(time_out), is_done))
+            return AIPU_STATUS_ERROR_GRAPH_LOADING;
+
+        /* another waiter may have reaped it */
+        auto iter = m_load_tasks.find(id);
+        if (iter == m_load_tasks.end())
+            return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+        task = iter->second;
+        m_load_tasks.erase(iter);
+    }
+
+    ret = task->status;
+    task->worker.join();
+    delete task;
+    return ret;
+}
+
+aipu_status_t aipudrv::MainContext::cancel_load_graph(GRAPH_ID id)
+{
+    std::lock_guard<std::mutex> lock_(m_load_lock);
+
+    if (m_load_tasks.count(id) == 0)
+        return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+    m_load_tasks[id]->monitor.cancel = true;
+    return AIPU_STATUS_SUCCESS;
+}
+
 aipu_status_t aipudrv::MainContext::unload_graph(GRAPH_ID id)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     GraphBase* p_gobj = nullptr;
 
+    /* a pending asynchronous load is canceled and reaped first */
+    if ((cancel_load_graph(id) == AIPU_STATUS_SUCCESS) &&
+        (wait_graph_loaded(id, -1) != AIPU_STATUS_SUCCESS))
+        goto finish;
+
     p_gobj = get_graph_object(id);
     if (p_gobj == nullptr)
     {
@@ -419,6 +615,18 @@ aipu_status_t aipudrv::MainContext::unload_graph(GRAPH_ID id)
         goto finish;
     }
 
+    if (m_teardown_cfg.deferred)
+    {
+        /* the graph ID is invalid from now on, its buffers are freed in background */
+        unpin_graph_id(id);
+
+        Reclaimer::get_reclaimer().defer([this, p_gobj, id]() mutable {
+            if (destroy_graph_object(&p_gobj) != AIPU_STATUS_SUCCESS)
+                LOG(LOG_ERR, "deferred unload graph 0x%lx [fail]\n", id);
+        });
+        goto finish;
+    }
+
     ret = destroy_graph_object(&p_gobj);
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
@@ -426,18 +634,130 @@ aipu_status_t aipudrv::MainContext::unload_graph(GRAPH_ID id)
     /* p_gobj becomes NULL after destroy */
 
     /* success */
-    pthread_rwlock_wrlock(&m_glock);
-    m_graphs.erase(id);
-    pthread_rwlock_unlock(&m_glock);
+    unpin_graph_id(id);
 
 finish:
     return ret;
 }
 
+/**
+ * @brief the stats of a loaded graph, or of the graph unloaded the latest
+ */
+aipu_status_t aipudrv::MainContext::get_graph_load_stats(aipu_graph_load_stats_t *stats)
+{
+    GraphBase* p_gobj = nullptr;
+
+    if (!aipudrv::valid_graph_id(stats->graph_id))
+        return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+    p_gobj = get_graph_object(stats->graph_id);
+    if (p_gobj != nullptr)
+    {
+        memcpy(stats->phases, p_gobj->get_load_stats(), sizeof(stats->phases));
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    std::lock_guard<std::mutex> lock_(m_load_lock);
+    if (stats->graph_id != m_unload_stats_id)
+        return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+    memcpy(stats->phases, m_unload_stats, sizeof(stats->phases));
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::MainContext::get_metrics(aipu_metrics_t *metrics)
+{
+    MemoryBase* mem = (m_dram != nullptr) ? m_dram : m_dev->get_mem();
+    GraphBase* p_gobj = nullptr;
+
+    if (metrics->graph_id != 0)
+    {
+        p_gobj = get_graph_object(metrics->graph_id);
+        if (p_gobj == nullptr)
+            return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+        p_gobj->get_job_counters().read(&metrics->graph);
+    } else {
+        memset(&metrics->graph, 0, sizeof(metrics->graph));
+    }
+
+    m_metrics.read(metrics);
+    if (mem != nullptr)
+    {
+        mem->get_metrics().read(metrics);
+    } else {
+        memset(metrics->mem_bytes, 0, sizeof(metrics->mem_bytes));
+        memset(metrics->mem_bytes_max, 0, sizeof(metrics->mem_bytes_max));
+        metrics->alloc_fail_cnt = 0;
+    }
+
+    if (metrics->prom_path != nullptr)
+        return write_metrics(metrics->prom_path);
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::MainContext::get_profile_report(aipu_profile_report_t *report)
+{
+    std::vector<aipu_profile_layer_stats_t> stats;
+    GraphBase* p_gobj = get_graph_object(report->graph_id);
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+    if (p_gobj == nullptr)
+        return AIPU_STATUS_ERROR_INVALID_GRAPH_ID;
+
+    p_gobj->get_profile_report().read(stats, report->freq_mhz, report->reset != 0);
+    if (report->layers != nullptr)
+        memcpy(report->layers, stats.data(),
+            std::min<size_t>(report->layer_cnt, stats.size()) * sizeof(stats[0]));
+    report->layer_cnt = stats.size();
+
+    if (report->csv_path != nullptr)
+    {
+        ret = write_profile_csv(report->csv_path, stats);
+        if (ret != AIPU_STATUS_SUCCESS)
+            return ret;
+    }
+
+    if (report->json_path != nullptr)
+        ret = write_profile_json(report->json_path, report->graph_id, report->freq_mhz, stats);
+
+    return ret;
+}
+
+/**
+ * @brief write the metrics of this context along with the job counters of
+ *        every loaded graph in Prometheus text format
+ */
+aipu_status_t aipudrv::MainContext::write_metrics(const char *path)
+{
+    MemoryBase* mem = (m_dram != nullptr) ? m_dram : m_dev->get_mem();
+    std::vector<std::pair<uint64_t, aipu_job_counters_t>> graphs;
+    aipu_metrics_t metrics = {0};
+
+    m_metrics.read(&metrics);
+    if (mem != nullptr)
+        mem->get_metrics().read(&metrics);
+
+    glock_rd();
+    for (auto &entry : m_graphs.entries())
+    {
+        if (entry.second == nullptr)
+            continue;
+
+        graphs.emplace_back(graph_handle2id(entry.first), aipu_job_counters_t());
+        entry.second->get_job_counters().read(&graphs.back().second);
+    }
+    pthread_rwlock_unlock(&m_glock);
+
+    return write_metrics_prom(path, &metrics, graphs);
+}
+
 aipu_status_t aipudrv::MainContext::create_job(GRAPH_ID graph, JOB_ID* id, aipu_create_job_cfg_t *config)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     GraphBase* p_gobj = nullptr;
+    LatencyTimer timer(&m_metrics, AIPU_METRICS_LAT_CREATE);
 
     if (id == nullptr)
     {
@@ -453,6 +773,13 @@ aipu_status_t aipudrv::MainContext::create_job(GRAPH_ID graph, JOB_ID* id, aipu_
     }
 
     ret = p_gobj->create_job(id, &m_sim_cfg, &m_hw_cfg, config);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    /* success */
+    UMD_USDT4(job_create, *id, graph, config->partition_id, config->qos_level);
+    m_metrics.jobs().created(config->qos_level);
+    p_gobj->get_job_counters().created(config->qos_level);
 
 finish:
     return ret;
@@ -619,6 +946,28 @@ aipu_status_t aipudrv::MainContext::config_hw(uint64_t types, aipu_global_config
     return ret;
 }
 
+aipu_status_t aipudrv::MainContext::config_wt_residency(aipu_global_config_wt_residency_t *config)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+    if (config == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    m_wt_residency.set_budget(config->budget);
+    return ret;
+}
+
+aipu_status_t aipudrv::MainContext::config_teardown(aipu_global_config_teardown_t *config)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+    if (config == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    m_teardown_cfg = *config;
+    return ret;
+}
+
 aipu_status_t aipudrv::MainContext::debugger_malloc(uint32_t size, void** va)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
@@ -998,7 +1347,8 @@ aipu_status_t aipudrv::MainContext::ioctl_cmd(uint32_t cmd, void *arg)
             return AIPU_STATUS_ERROR_NULL_PTR;
     }
 
-    if (cmd >= AIPU_IOCTL_SET_PROFILE && cmd <= AIPU_IOCTL_FREE_SHARE_BUF)
+    if ((cmd >= AIPU_IOCTL_SET_PROFILE && cmd <= AIPU_IOCTL_FREE_SHARE_BUF)
+        || (cmd >= AIPU_IOCTL_GET_GRAPH_LOAD_STATS && cmd <= AIPU_IOCTL_FLUSH_DUMPS))
     {
         switch(cmd)
         {
@@ -1113,6 +1463,91 @@ aipu_status_t aipudrv::MainContext::ioctl_cmd(uint32_t cmd, void *arg)
                 }
                 break;
 
+            case AIPU_IOCTL_GET_GRAPH_LOAD_STATS:
+                {
+                    aipu_graph_load_stats_t *stats = (aipu_graph_load_stats_t *)arg;
+
+                    ret = get_graph_load_stats(stats);
+                    if (ret != AIPU_STATUS_SUCCESS)
+                        return ret;
+
+                    if (stats->json_path != nullptr)
+                        ret = dump_load_stats_json(stats);
+                }
+                break;
+
+            case AIPU_IOCTL_SET_JOB_TRACE:
+                JobTrace::enable((*(int32_t *)arg) != 0);
+                break;
+
+            case AIPU_IOCTL_DUMP_JOB_TRACE:
+                ret = JobTrace::dump_json((const char *)arg);
+                break;
+
+            case AIPU_IOCTL_GET_METRICS:
+                ret = get_metrics((aipu_metrics_t *)arg);
+                break;
+
+            case AIPU_IOCTL_SET_METRICS_EXPORT:
+                {
+                    aipu_metrics_export_t *exp = (aipu_metrics_export_t *)arg;
+
+                    if (exp->period_ms == 0)
+                    {
+                        m_metrics_exporter.stop();
+                        break;
+                    }
+
+                    if (exp->prom_path == nullptr)
+                        return AIPU_STATUS_ERROR_NULL_PTR;
+
+                    ret = write_metrics(exp->prom_path);
+                    if (ret != AIPU_STATUS_SUCCESS)
+                        return ret;
+
+                    std::string path = exp->prom_path;
+                    m_metrics_exporter.start(exp->period_ms, [this, path] {
+                        write_metrics(path.c_str());
+                    });
+                }
+                break;
+
+            case AIPU_IOCTL_ADD_PROFILE_RUN:
+                {
+                    aipu_profile_run_t *run = (aipu_profile_run_t *)arg;
+                    JobBase *p_job = get_job_object(run->job_id);
+
+                    if (p_job == nullptr)
+                        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+                    ret = p_job->add_profile_run(&run->layout, &run->layer_cnt);
+                }
+                break;
+
+            case AIPU_IOCTL_GET_PROFILE_REPORT:
+                ret = get_profile_report((aipu_profile_report_t *)arg);
+                break;
+
+            case AIPU_IOCTL_SET_PRINTF_STREAM:
+                {
+                    aipu_printf_stream_t *stream = (aipu_printf_stream_t *)arg;
+                    JobBase *p_job = get_job_object(stream->job_id);
+
+                    if (p_job == nullptr)
+                        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+                    ret = p_job->set_printf_stream(stream);
+                }
+                break;
+
+            case AIPU_IOCTL_SET_DUMP_WRITER:
+                umd_dump_writer_config((const aipu_dump_writer_cfg_t *)arg);
+                break;
+
+            case AIPU_IOCTL_FLUSH_DUMPS:
+                ret = umd_dump_writer_flush();
+                break;
+
             default:
                 LOG(LOG_ERR, "invalid command\n");
                 return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
@@ -12,28 +12,69 @@
 #define _CONTEXT_H_
 
 #include <map>
+#include <vector>
+#include <string>
 #include <cstring>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <pthread.h>
 #include "standard_api.h"
 #include "graph_base.h"
 #include "device_base.h"
 #include "memory_base.h"
+#include "weight_residency.h"
+#include "load_phase.h"
+#include "metrics.h"
+#include "handle_table.h"
+#include "utils/usdt.h"
 
 namespace aipudrv
 {
 #define BUF_LEN 1204
 typedef std::map<GRAPH_ID, GraphBase*> GraphTable;
 
+/**
+ * @brief record of one graph loading started by aipu_load_graph_async,
+ *        the pending graph ID stays pinned in GraphTable until it's done.
+ */
+struct GraphLoadTask
+{
+    GraphLoadMonitor monitor;
+    std::ifstream gbin;
+    uint32_t size = 0;
+    bool has_config = false;
+    aipu_load_graph_cfg_t config;
+    std::vector<int32_t> wt_idxes;
+    std::string extra_weight_path;
+    std::thread worker;
+    bool done = false;
+    aipu_status_t status = AIPU_STATUS_SUCCESS;
+};
+typedef std::map<GRAPH_ID, GraphLoadTask*> GraphLoadTable;
+
 class MainContext
 {
 private:
     DeviceBase* m_dev = nullptr;
+#ifdef UMD_TEST_HOOKS
+    bool m_dev_borrowed = false;
+#endif
     MemoryBase* m_dram = nullptr;
-    GraphTable  m_graphs;
+    HandleTable<GraphBase> m_graphs;
     pthread_rwlock_t m_glock;
+    std::mutex m_dram_lock;
+    GraphLoadTable m_load_tasks;
+    std::mutex m_load_lock;
+    std::condition_variable m_load_cv;
+    WeightResidency m_wt_residency;
+    GRAPH_ID m_unload_stats_id = 0;
+    aipu_load_phase_stats_t m_unload_stats[AIPU_LOAD_PHASE_MAX] = {};
     bool m_do_vcheck = true;
     std::map<void*, BufferDesc*> m_dbg_buffers;
+    Metrics m_metrics;
+    MetricsExporter m_metrics_exporter;
 
 private:
     static std::map<uint32_t, std::string> umd_status_string;
@@ -43,15 +84,37 @@ private:
 private:
     aipu_global_config_simulation_t m_sim_cfg;
     aipu_global_config_hw_t m_hw_cfg;
+    aipu_global_config_teardown_t m_teardown_cfg;
 
 private:
     std::string m_umd_version;
 
 private:
-    uint64_t create_unique_graph_id_inner() const;
+    void glock_rd()
+    {
+        UMD_USDT1(glock_wait, 0);
+        pthread_rwlock_rdlock(&m_glock);
+        UMD_USDT1(glock_acquired, 0);
+    }
+    void glock_wr()
+    {
+        UMD_USDT1(glock_wait, 1);
+        pthread_rwlock_wrlock(&m_glock);
+        UMD_USDT1(glock_acquired, 1);
+    }
+    GRAPH_ID pin_graph_id();
+    void unpin_graph_id(GRAPH_ID id);
     aipu_status_t create_graph_object(std::istream& gbin, uint32_t size, uint64_t id,
-        GraphBase** gobj, aipu_load_graph_cfg_t *config = nullptr);
+        GraphBase** gobj, aipu_load_graph_cfg_t *config = nullptr,
+        GraphLoadMonitor *monitor = nullptr);
     aipu_status_t destroy_graph_object(GraphBase** gobj);
+    aipu_status_t load_graph_pinned(std::istream& gbin, uint32_t size, GRAPH_ID id,
+        aipu_load_graph_cfg_t *config, GraphLoadMonitor *monitor = nullptr);
+    void load_graph_worker(GRAPH_ID id, GraphLoadTask *task);
+    aipu_status_t get_graph_load_stats(aipu_graph_load_stats_t *stats);
+    aipu_status_t get_metrics(aipu_metrics_t *metrics);
+    aipu_status_t write_metrics(const char *path);
+    aipu_status_t get_profile_report(aipu_profile_report_t *report);
 
 private:
     bool is_deinit_ok();
@@ -65,12 +128,20 @@ public:
     void force_deinit();
     aipu_status_t deinit();
     GraphBase*    get_graph_object(GRAPH_ID id);
+    Metrics&      get_metrics()
+    {
+        return m_metrics;
+    }
     JobBase*      get_job_object(JOB_ID id);
     aipu_status_t get_status_msg(aipu_status_t status, const char** msg);
     aipu_status_t load_graph(const char* graph_file, GRAPH_ID* id,
         aipu_load_graph_cfg_t *config = nullptr);
     aipu_status_t load_graph(const char* graph_buf, uint32_t graph_size,
         GRAPH_ID* id, aipu_load_graph_cfg_t *config = nullptr);
+    aipu_status_t load_graph_async(const char* graph_file, GRAPH_ID* id,
+        aipu_load_graph_cfg_t *config, aipu_load_graph_progress_t progress, void *arg);
+    aipu_status_t wait_graph_loaded(GRAPH_ID id, int32_t time_out);
+    aipu_status_t cancel_load_graph(GRAPH_ID id);
     aipu_status_t unload_graph(GRAPH_ID id);
     aipu_status_t get_simulation_instance(void** simulator, void** memory);
     aipu_status_t create_job(GRAPH_ID graph, JOB_ID* id, aipu_create_job_cfg_t *config);
@@ -81,6 +152,8 @@ public:
     aipu_status_t debugger_get_job_info(JOB_ID job, aipu_debugger_job_info_t* info);
     aipu_status_t config_simulation(uint64_t types, aipu_global_config_simulation_t* config);
     aipu_status_t config_hw(uint64_t types, aipu_global_config_hw_t* config);
+    aipu_status_t config_wt_residency(aipu_global_config_wt_residency_t* config);
+    aipu_status_t config_teardown(aipu_global_config_teardown_t* config);
     aipu_status_t aipu_get_target(char *target);
     aipu_status_t aipu_get_device_status(device_status_t *status);
     aipu_status_t run_batch(GraphBase &graph, uint32_t queue_id, aipu_create_job_cfg_t *config);
@@ -124,9 +197,35 @@ public:
         return m_dev;
     };
 
-    GraphTable &get_graphtable()
+#ifdef UMD_TEST_HOOKS
+    /**
+     * @brief run on the given device instead of the probed NPU/simulator,
+     *        used by tests and benchmarks measuring the driver alone
+     *
+     * @note  call it before loading any graph, in place of init(). the device
+     *        stays the caller's, deinit() doesn't put it.
+     */
+    void set_dev(DeviceBase* dev)
+    {
+        m_dev = dev;
+        m_dev_borrowed = true;
+        m_dram = dev->get_mem();
+        m_umd_version = MACRO_UMD_VERSION;
+    }
+#endif
+
+    GraphTable get_graphtable()
     {
-        return m_graphs;
+        GraphTable graphs;
+
+        glock_rd();
+        for (auto &entry : m_graphs.entries())
+        {
+            if (entry.second != nullptr)
+                graphs[graph_handle2id(entry.first)] = entry.second;
+        }
+        pthread_rwlock_unlock(&m_glock);
+        return graphs;
     }
 
 public:
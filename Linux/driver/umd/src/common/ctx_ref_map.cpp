@@ -12,56 +12,36 @@
 
 aipudrv::CtxRefMap::CtxRefMap()
 {
-    data.clear();
     pthread_mutex_init(&lock, NULL);
 }
 
 aipudrv::CtxRefMap::~CtxRefMap()
 {
-    std::map<uint32_t, MainContext*>::iterator iter;
     pthread_mutex_lock(&lock);
-    for (iter = data.begin(); iter != data.end(); iter++)
+    for (auto &entry : data.entries())
     {
-        iter->second->force_deinit();
-        delete iter->second;
-        iter->second = nullptr;
+        data.release(entry.first);
+        entry.second->force_deinit();
+        delete entry.second;
     }
-    data.clear();
     pthread_mutex_unlock(&lock);
     pthread_mutex_destroy(&lock);
 }
 
 uint32_t aipudrv::CtxRefMap::create_ctx_ref()
 {
-    uint32_t handle = 0xFFFFFFFF;
+    uint32_t handle = 0;
+    MainContext* ctx = new MainContext;
 
     pthread_mutex_lock(&lock);
-    while(nullptr != get_ctx_ref_inner(handle))
-    {
-        handle--;
-    }
-    data[handle] = new MainContext;
+    handle = data.alloc(ctx);
     pthread_mutex_unlock(&lock);
 
-    return handle;
-}
-
-aipudrv::MainContext* aipudrv::CtxRefMap::get_ctx_ref_inner(uint32_t handle)
-{
-    MainContext* ctx = nullptr;
-
-    if (data.count(handle) == 1)
-        ctx = data[handle];
-    return ctx;
-}
+    /* handle 0 is never valid */
+    if (handle == 0)
+        delete ctx;
 
-aipudrv::MainContext* aipudrv::CtxRefMap::get_ctx_ref(uint32_t handle)
-{
-    MainContext* ctx = nullptr;
-    pthread_mutex_lock(&lock);
-    ctx = get_ctx_ref_inner(handle);
-    pthread_mutex_unlock(&lock);
-    return ctx;
+    return handle;
 }
 
 aipu_status_t aipudrv::CtxRefMap::destroy_ctx_ref(uint32_t handle)
@@ -70,16 +50,13 @@ aipu_status_t aipudrv::CtxRefMap::destroy_ctx_ref(uint32_t handle)
     MainContext* ctx = nullptr;
 
     pthread_mutex_lock(&lock);
-    ctx = get_ctx_ref_inner(handle);
+    ctx = data.release(handle);
+    pthread_mutex_unlock(&lock);
+
     if (ctx != nullptr)
-    {
         delete ctx;
-        ctx = nullptr;
-        data.erase(handle);
-    } else {
+    else
         ret = AIPU_STATUS_ERROR_INVALID_CTX;
-    }
-    pthread_mutex_unlock(&lock);
 
     return ret;
-}
\ No newline at end of file
+}
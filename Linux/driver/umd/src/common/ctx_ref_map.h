@@ -11,27 +11,29 @@
 #ifndef _CTX_REF_MAP_H_
 #define _CTX_REF_MAP_H_
 
-#include <map>
 #include <pthread.h>
 #include "standard_api.h"
 #include "context.h"
+#include "handle_table.h"
 
 namespace aipudrv
 {
 class CtxRefMap
 {
 private:
-    std::map<uint32_t, MainContext*> data;
+    HandleTable<MainContext> data;
     pthread_mutex_t lock;
 
-private:
-    MainContext*  get_ctx_ref_inner(uint32_t handle);
-
 public:
     uint32_t      create_ctx_ref();
-    MainContext*  get_ctx_ref(uint32_t handle);
     aipu_status_t destroy_ctx_ref(uint32_t handle);
 
+    /* lock-free, called on every API */
+    MainContext*  get_ctx_ref(uint32_t handle)
+    {
+        return data.get(handle);
+    }
+
 public:
     static CtxRefMap& get_ctx_map()
     {
@@ -120,6 +120,9 @@ enum DeviceType
     DEV_TYPE_SIMULATOR_V3     = 2,
     DEV_TYPE_SIMULATOR_V3_1   = 3,
     DEV_TYPE_AIPU             = 4,
+#ifdef UMD_TEST_HOOKS
+    DEV_TYPE_MOCK             = 5,  /**< host-only device set by tests and benchmarks */
+#endif
 };
 
 class DeviceBase
@@ -18,6 +18,10 @@
 #include <map>
 #include <vector>
 #include <tuple>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "standard_api.h"
 #include "kmd/armchina_aipu.h"
 #include "pybind11/pybind11.h"
@@ -26,6 +30,7 @@
 #include "pybind11/numpy.h"
 
 #define PATH_LEN 1024
+#define ASYNC_POLL_MS 1
 
 namespace py = pybind11;
 
@@ -43,7 +48,18 @@ typedef enum {
     D_UINT32 = 0x120,
 } data_type_t;
 
-class NPU
+/**
+ * @brief keep the low bytes of each element, one branch-free loop per width
+ *        so that the compiler can vectorize it
+ */
+template <typename T>
+static void narrow_copy(T *dest, const int *src, uint32_t cnt)
+{
+    for (uint32_t i = 0; i < cnt; i++)
+        dest[i] = (T)src[i];
+}
+
+class __attribute__((visibility("hidden"))) NPU
 {
     public:
     /**
@@ -72,6 +88,7 @@ class NPU
      */
     aipu_status_t aipu_deinit_context_py()
     {
+        stop_reaper();
         return aipu_deinit_context(m_ctx);
     }
 
@@ -91,7 +108,8 @@ class NPU
     }
 
     /**
-     * @par types: AIPU_CONFIG_TYPE_HW/AIPU_CONFIG_TYPE_SIMULATION
+     * @par types: AIPU_CONFIG_TYPE_HW/AIPU_CONFIG_TYPE_SIMULATION/AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY/
+     *             AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN
      * @par global_cfg_simulation: (python dict type)
      *      {
      *          "simulator" : "simulator path",
@@ -113,6 +131,8 @@ class NPU
      *          "ddr_bw" : "256|512",
      *          "ddr_bw_ratio" : "1.0",
      *          "perf_report" : "fast evaluation performance file name",
+     *          "wt_resident_budget" : "on-demand weight budget in bytes, with AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY",
+     *          "deferred_teardown" : "0|1, with AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN",
      *      }
      *
      *
@@ -125,6 +145,8 @@ class NPU
      * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK/none
      * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_ENABLE_VER_CHECK/none
      * @note accepted types/config: AIPU_CONFIG_TYPE_HW
+     * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY
+     * @note accepted types/config: AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN
      *
      */
     aipu_status_t aipu_config_global_py(uint64_t types,
@@ -230,6 +252,19 @@ class NPU
             ret = aipu_config_global(m_ctx, AIPU_CONFIG_TYPE_HW, &m_global_config_hw);
         else if (types & AIPU_CONFIG_TYPE_SIMULATION) {
             ret = aipu_config_global(m_ctx, AIPU_CONFIG_TYPE_SIMULATION, &m_global_config_simulation);
+        } else if (types & AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY) {
+            aipu_global_config_wt_residency_t wt_residency = {0};
+
+            if (global_cfg_simulation.count("wt_resident_budget") == 1)
+                wt_residency.budget = strtoull(global_cfg_simulation["wt_resident_budget"].c_str(),
+                    nullptr, 0);
+            ret = aipu_config_global(m_ctx, AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY, &wt_residency);
+        } else if (types & AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN) {
+            aipu_global_config_teardown_t teardown = {0};
+
+            if (global_cfg_simulation.count("deferred_teardown") == 1)
+                teardown.deferred = atoi(global_cfg_simulation["deferred_teardown"].c_str());
+            ret = aipu_config_global(m_ctx, AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN, &teardown);
         } else {
             ret = aipu_config_global(m_ctx, types, nullptr);
         }
@@ -285,6 +320,7 @@ class NPU
      * @param[in]  load_cfg  Configuration in loading graph stage
      *             {
      *                 "wt_mem_region" : preferred weight allocation region (AIPU_MEM_REGION_SRAM)
+     *                 "wt_on_demand"  : upload BSS weight on demand (1), aipu v3/v3_1 only
      *             }
      * @param[in]  wt_idxes  Weight buffer index indicating which buffer is allocated from
      *                       specified memory region
@@ -322,6 +358,9 @@ class NPU
             if (load_cfg.count("wt_mem_region") > 0)
                 load_grach_cfg.wt_mem_region = load_cfg["wt_mem_region"];
 
+            if (load_cfg.count("wt_on_demand") > 0)
+                load_grach_cfg.wt_on_demand = load_cfg["wt_on_demand"];
+
             if (wt_idxes.size() > 0)
             {
                 load_grach_cfg.wt_idxes_cnt = wt_idxes.size();
@@ -359,6 +398,7 @@ class NPU
      * @param[in]  load_cfg  Configuration in loading graph stage
      *             {
      *                 "wt_mem_region" : preferred weight allocation region (AIPU_MEM_REGION_SRAM)
+     *                 "wt_on_demand"  : upload BSS weight on demand (1), aipu v3/v3_1 only
      *             }
      * @param[in]  wt_idxes  Weight buffer index indicating which buffer is allocated from
      *                       specified memory region
@@ -398,6 +438,9 @@ class NPU
             if (load_cfg.count("wt_mem_region") > 0)
                 load_grach_cfg.wt_mem_region = load_cfg["wt_mem_region"];
 
+            if (load_cfg.count("wt_on_demand") > 0)
+                load_grach_cfg.wt_on_demand = load_cfg["wt_on_demand"];
+
             if (wt_idxes.size() > 0)
             {
                 load_grach_cfg.wt_idxes_cnt = wt_idxes.size();
@@ -981,7 +1024,80 @@ class NPU
         const char *status_msg = nullptr;
         char *data = PyBytes_AsString(raw_bytes.ptr());
 
-        ret = aipu_load_tensor(m_ctx, job_id, tensor, data);
+        {
+            py::gil_scoped_release release;
+            ret = aipu_load_tensor(m_ctx, job_id, tensor, data);
+        }
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(m_ctx, ret, &status_msg);
+            fprintf(stderr, "[PY UMD ERROR] aipu_load_tensor: %s\n", status_msg);
+        }
+
+        return ret;
+    }
+
+    /**
+     * @brief This API is used to load input tensor data from any buffer object
+     *        (numpy array, memoryview, bytearray...) in tensor native data type
+     *
+     * @param[in] job    Job ID returned by aipu_create_job
+     * @param[in] tensor Input tensor ID
+     * @param[in] buffer Object supporting the buffer protocol
+     *
+     * @retval AIPU_STATUS_SUCCESS
+     * @retval AIPU_STATUS_ERROR_NULL_PTR
+     * @retval AIPU_STATUS_ERROR_INVALID_CTX
+     * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
+     * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+     * @retval AIPU_STATUS_ERROR_INVALID_SIZE
+     * @retval AIPU_STATUS_ERROR_INVALID_OP
+     *
+     * @note a C-contiguous buffer is loaded in place without any copy, other layouts
+     *       are made contiguous by numpy first. the buffer size should equal the tensor size.
+     */
+    aipu_status_t aipu_load_tensor_buffer_py(uint64_t job_id, uint32_t tensor, py::buffer buffer)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        const char *status_msg = nullptr;
+        aipu_tensor_desc_t desc;
+        py::buffer_info info = buffer.request();
+        py::ssize_t stride = info.itemsize;
+        bool contiguous = true;
+
+        for (py::ssize_t i = info.ndim - 1; i >= 0; i--)
+        {
+            if ((info.shape[i] > 1) && (info.strides[i] != stride))
+                contiguous = false;
+            stride *= info.shape[i];
+        }
+
+        if (!contiguous)
+        {
+            auto np = py::module::import("numpy");
+            buffer = np.attr("ascontiguousarray")(buffer);
+            info = buffer.request();
+        }
+
+        ret = aipu_get_tensor_descriptor(m_ctx, job_id, AIPU_TENSOR_TYPE_INPUT, tensor, &desc);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(m_ctx, ret, &status_msg);
+            fprintf(stderr, "[PY UMD ERROR] aipu_get_tensor_descriptor: %s\n", status_msg);
+            return ret;
+        }
+
+        if ((uint64_t)(info.size * info.itemsize) != desc.size)
+        {
+            fprintf(stderr, "[PY UMD ERROR] aipu_load_tensor: buffer size %ld != tensor size %u\n",
+                (long)(info.size * info.itemsize), desc.size);
+            return AIPU_STATUS_ERROR_INVALID_SIZE;
+        }
+
+        {
+            py::gil_scoped_release release;
+            ret = aipu_load_tensor(m_ctx, job_id, tensor, info.ptr);
+        }
         if (ret != AIPU_STATUS_SUCCESS)
         {
             aipu_get_error_message(m_ctx, ret, &status_msg);
@@ -1003,7 +1119,10 @@ class NPU
      * @retval AIPU_STATUS_ERROR_INVALID_CTX
      * @retval AIPU_STATUS_ERROR_INVALID_JOB_ID
      * @retval AIPU_STATUS_ERROR_INVALID_TENSOR_ID
+     * @retval AIPU_STATUS_ERROR_INVALID_SIZE
      * @retval AIPU_STATUS_ERROR_INVALID_OP
+     *
+     * @note the array should have at least as many elements as the tensor, extra ones are ignored
      */
     aipu_status_t aipu_load_tensor_numpyarray_py(uint64_t job_id, uint32_t tensor,
         py::array_t<int> numpy_array, data_type_t data_size)
@@ -1012,6 +1131,7 @@ class NPU
         aipu_tensor_desc_t desc;
         const char *status_msg = nullptr;
         uint8_t * in_data = nullptr;
+        uint32_t cnt = 0;
 
         constexpr int C_CONTIGUOUS = py::detail::npy_api::constants::NPY_ARRAY_C_CONTIGUOUS_;
         if (C_CONTIGUOUS != (numpy_array.flags() & C_CONTIGUOUS))
@@ -1030,6 +1150,20 @@ class NPU
             goto finish;
         }
 
+        if (data_size == D_INT32  || data_size == D_UINT32 ||
+            data_size == D_INT16  || data_size == D_UINT16 ||
+            data_size == D_INT8   || data_size == D_UINT8)
+        {
+            cnt = desc.size / ((data_size & 0xFF) / D_INT8);
+            if ((uint64_t)numpy_array.size() < cnt)
+            {
+                fprintf(stderr, "[PY UMD ERROR] aipu_load_tensor: array of %ld elements < tensor of %u\n",
+                    (long)numpy_array.size(), cnt);
+                ret = AIPU_STATUS_ERROR_INVALID_SIZE;
+                goto finish;
+            }
+        }
+
         if (data_size == D_INT32 || data_size == D_UINT32)
         {
             in_data = (uint8_t *)data;
@@ -1039,16 +1173,11 @@ class NPU
                  data_size == D_UINT16 ||
                  data_size == D_UINT8)
         {
-            int for_loop = desc.size / ((data_size & 0xFF) / D_INT8);
-            in_data = new uint8_t[desc.size];
-            for (int i = 0; i < for_loop; i++)
-            {
-                if (data_size == D_INT8 || data_size == D_UINT8)
-                    *(in_data + i) = *((uint8_t *)data + 4*i);
-
-                if (data_size == D_INT16 || data_size == D_UINT16)
-                    *((uint16_t *)in_data + i) = *((uint16_t *)data + 2*i);
-            }
+            in_data = new uint8_t[desc.size]();
+            if ((data_size & 0xFF) == D_INT8)
+                narrow_copy(in_data, data, cnt);
+            else
+                narrow_copy((uint16_t *)in_data, data, cnt);
         }
         else
         {
@@ -1056,7 +1185,10 @@ class NPU
             goto finish;
         }
 
-        ret = aipu_load_tensor(m_ctx, job_id, tensor, in_data);
+        {
+            py::gil_scoped_release release;
+            ret = aipu_load_tensor(m_ctx, job_id, tensor, in_data);
+        }
         if (ret != AIPU_STATUS_SUCCESS)
         {
             aipu_get_error_message(m_ctx, ret, &status_msg);
@@ -1177,6 +1309,100 @@ class NPU
         return retmap;
     }
 
+    /**
+     * @brief This API is used to get tensor data of specified type as a numpy array
+     *
+     * @param[in]  job    Job ID returned by aipu_create_job
+     * @param[in]  type   Tensor type
+     * @param[in]  tensor Input tensor ID
+     *
+     * @retval     return value dict
+     *             {
+     *                 "ret": retval
+     *                 "data": 1-D numpy.ndarray of tensor data type
+     *             }
+     *
+     * @note the tensor is copied once into the array. f16 comes as float16, bf16 and
+     *       packed 4/12-bit data as raw unsigned integers, bool as uint8.
+     */
+    py::dict aipu_get_tensor_ndarray_py(uint64_t job_id, aipu_tensor_type_t type, uint32_t tensor)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        const char *status_msg = nullptr;
+        aipu_tensor_desc_t desc;
+        py::dict retdict;
+        py::dtype dtype("uint8");
+
+        ret = aipu_get_tensor_descriptor(m_ctx, job_id, type, tensor, &desc);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(m_ctx, ret, &status_msg);
+            fprintf(stderr, "[PY UMD ERROR] aipu_get_tensor_descriptor: %s\n", status_msg);
+            retdict["ret"] = ret;
+            retdict["data"] = py::array(dtype, 0);
+            return retdict;
+        }
+
+        switch (desc.data_type)
+        {
+            case AIPU_DATA_TYPE_S8:
+                dtype = py::dtype("int8");
+                break;
+            case AIPU_DATA_TYPE_U16:
+            case AIPU_DATA_TYPE_BF16:
+            case AIPU_DATA_TYPE_ALIGNED_U12:
+            case AIPU_DATA_TYPE_ALIGNED_S12:
+                dtype = py::dtype("uint16");
+                break;
+            case AIPU_DATA_TYPE_S16:
+                dtype = py::dtype("int16");
+                break;
+            case AIPU_DATA_TYPE_U32:
+                dtype = py::dtype("uint32");
+                break;
+            case AIPU_DATA_TYPE_S32:
+                dtype = py::dtype("int32");
+                break;
+            case AIPU_DATA_TYPE_U64:
+                dtype = py::dtype("uint64");
+                break;
+            case AIPU_DATA_TYPE_S64:
+                dtype = py::dtype("int64");
+                break;
+            case AIPU_DATA_TYPE_F16:
+                dtype = py::dtype("float16");
+                break;
+            case AIPU_DATA_TYPE_F32:
+                dtype = py::dtype("float32");
+                break;
+            case AIPU_DATA_TYPE_F64:
+                dtype = py::dtype("float64");
+                break;
+            default:
+                break;
+        }
+
+        /* a size not of whole elements can't be typed */
+        if (desc.size % dtype.itemsize() != 0)
+            dtype = py::dtype("uint8");
+
+        py::array data(dtype, desc.size / dtype.itemsize());
+        {
+            char *dest = (char *)data.mutable_data();
+            py::gil_scoped_release release;
+            ret = aipu_get_tensor(m_ctx, job_id, type, tensor, dest);
+        }
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(m_ctx, ret, &status_msg);
+            fprintf(stderr, "[PY UMD ERROR] aipu_get_tensor: %s\n", status_msg);
+        }
+
+        retdict["ret"] = ret;
+        retdict["data"] = data;
+        return retdict;
+    }
+
     /**
      * @brief This API is used to send specific command to NPU driver.
      *
@@ -1435,6 +1661,156 @@ class NPU
         return ret;
     }
 
+    /**
+     * @brief This API loads input tensors and runs a job asynchronously on the running
+     *        asyncio event loop
+     *
+     * @param[in] job_id Job ID returned by aipu_create_job
+     * @param[in] inputs Buffer objects of input tensors in tensor ID order, empty if
+     *                   the inputs were loaded already
+     *
+     * @retval asyncio.Future resolved with the job's retval once it ends
+     *         AIPU_STATUS_SUCCESS: job done, outputs can be got via aipu_get_tensor
+     *         AIPU_STATUS_ERROR_JOB_EXCEPTION: job exception
+     *         others: loading input or flushing job fails
+     *
+     * @note It should be called from a coroutine, eg: ret = await npu.aipu_run_job_async(job_id, inputs).
+     *       a background reaper thread flushes and polls the jobs, so a single event loop can keep
+     *       many jobs in flight. a job can't be run again before its future is resolved.
+     */
+    py::object aipu_run_job_async_py(uint64_t job_id, std::vector<py::buffer> inputs)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        py::object loop = py::module::import("asyncio").attr("get_running_loop")();
+        py::object future = loop.attr("create_future")();
+
+        for (uint32_t i = 0; i < inputs.size(); i++)
+        {
+            ret = aipu_load_tensor_buffer_py(job_id, i, inputs[i]);
+            if (ret != AIPU_STATUS_SUCCESS)
+            {
+                future.attr("set_result")(ret);
+                return future;
+            }
+        }
+
+        AsyncJob *ajob = new AsyncJob{job_id, loop, future};
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock_(m_async_lock);
+
+            if (!m_reaper.joinable())
+            {
+                m_reaper_exit = false;
+                m_reaper = std::thread(&NPU::reaper_loop, this);
+            }
+            m_async_submit.push_back(ajob);
+            m_async_cond.notify_one();
+        }
+
+        return future;
+    }
+
+    private:
+    struct AsyncJob
+    {
+        uint64_t job_id;
+        py::object loop;
+        py::object future;
+    };
+
+    /**
+     * @brief hand the job retval to its event loop, the loop may be closed already
+     */
+    void resolve_async_job(AsyncJob *ajob, aipu_status_t ret)
+    {
+        py::gil_scoped_acquire acquire;
+        py::object future = ajob->future;
+
+        try {
+            ajob->loop.attr("call_soon_threadsafe")(py::cpp_function([future, ret]() {
+                if (!future.attr("done")().cast<bool>())
+                    future.attr("set_result")(ret);
+            }));
+        } catch (py::error_already_set &e) {
+            fprintf(stderr, "[PY UMD ERROR] aipu_run_job_async: %s\n", e.what());
+        }
+
+        delete ajob;
+    }
+
+    /**
+     * @brief flush submitted jobs and poll flushed ones, it blocks shortly on the
+     *        oldest job only and exits once every job is reaped after stop_reaper.
+     *        flushing in this thread keeps polling in the commit thread.
+     */
+    void reaper_loop()
+    {
+        std::vector<AsyncJob *> pending;
+        std::deque<AsyncJob *> submitted;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock_(m_async_lock);
+                m_async_cond.wait(lock_, [&] {
+                    return m_reaper_exit || !m_async_submit.empty() || !pending.empty();
+                });
+
+                if (m_reaper_exit && m_async_submit.empty() && pending.empty())
+                    break;
+
+                submitted.swap(m_async_submit);
+            }
+
+            for (auto ajob : submitted)
+            {
+                aipu_status_t ret = aipu_flush_job(m_ctx, ajob->job_id);
+
+                if (ret != AIPU_STATUS_SUCCESS)
+                    resolve_async_job(ajob, ret);
+                else
+                    pending.push_back(ajob);
+            }
+            submitted.clear();
+
+            for (uint32_t i = 0; i < pending.size(); )
+            {
+                aipu_job_status_t status = AIPU_JOB_STATUS_NO_STATUS;
+                aipu_status_t ret = aipu_get_job_status(m_ctx, pending[i]->job_id, &status,
+                    (i == 0) ? ASYNC_POLL_MS : 0);
+
+                if ((ret == AIPU_STATUS_ERROR_TIMEOUT) ||
+                    ((ret == AIPU_STATUS_SUCCESS) && (status == AIPU_JOB_STATUS_NO_STATUS)))
+                {
+                    i++;
+                    continue;
+                }
+
+                if ((ret == AIPU_STATUS_SUCCESS) && (status != AIPU_JOB_STATUS_DONE))
+                    ret = AIPU_STATUS_ERROR_JOB_EXCEPTION;
+
+                resolve_async_job(pending[i], ret);
+                pending.erase(pending.begin() + i);
+            }
+        }
+    }
+
+    /**
+     * @brief wait for all async jobs to be reaped and stop the reaper, without GIL
+     */
+    void stop_reaper()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(m_async_lock);
+            m_reaper_exit = true;
+            m_async_cond.notify_one();
+        }
+
+        if (m_reaper.joinable())
+            m_reaper.join();
+    }
+
     public:
     NPU() {};
     NPU(const NPU& aipu) = delete;
@@ -1442,10 +1818,22 @@ class NPU
 
     virtual ~NPU()
     {
+        if (m_reaper.joinable())
+        {
+            py::gil_scoped_release release;
+            stop_reaper();
+        }
     };
 
     private:
     aipu_ctx_handle_t* m_ctx = nullptr;
+
+    /* aipu_run_job_async jobs waiting for the reaper thread */
+    std::mutex m_async_lock;
+    std::condition_variable m_async_cond;
+    std::deque<AsyncJob *> m_async_submit;
+    std::thread m_reaper;
+    bool m_reaper_exit = false;
     aipu_global_config_hw_t m_global_config_hw = {0};
     aipu_global_config_simulation_t m_global_config_simulation = {0};
 };
@@ -1543,6 +1931,8 @@ PYBIND11_MODULE(libaipudrv, m) {
         .value("AIPU_CONFIG_TYPE_HW", aipu_config_type_t::AIPU_CONFIG_TYPE_HW)
         .value("AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK", aipu_config_type_t::AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK)
         .value("AIPU_GLOBAL_CONFIG_TYPE_ENABLE_VER_CHECK", aipu_config_type_t::AIPU_GLOBAL_CONFIG_TYPE_ENABLE_VER_CHECK)
+        .value("AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY", aipu_config_type_t::AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY)
+        .value("AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN", aipu_config_type_t::AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN)
         .export_values();
 
     py::class_<aipu_job_config_dump_t>(m, "aipu_job_config_dump_t")
@@ -1582,6 +1972,14 @@ PYBIND11_MODULE(libaipudrv, m) {
         .def(py::init<>())
         .def_readwrite("poll_in_commit_thread", &aipu_global_config_hw_t::poll_in_commit_thread);
 
+    py::class_<aipu_global_config_wt_residency_t>(m, "aipu_global_config_wt_residency_t")
+        .def(py::init<>())
+        .def_readwrite("budget", &aipu_global_config_wt_residency_t::budget);
+
+    py::class_<aipu_global_config_teardown_t>(m, "aipu_global_config_teardown_t")
+        .def(py::init<>())
+        .def_readwrite("deferred", &aipu_global_config_teardown_t::deferred);
+
 #if 0
     py::class_<callback_args_t>(m, "callback_args_t")
         .def(py::init<>())
@@ -1748,6 +2146,9 @@ PYBIND11_MODULE(libaipudrv, m) {
         .value("AIPU_STATUS_ERROR_ZERO_TENSOR_SIZE", aipu_status_t::AIPU_STATUS_ERROR_ZERO_TENSOR_SIZE)
         .value("AIPU_STATUS_ERROR_ALLOC_GRIP_ID", aipu_status_t::AIPU_STATUS_ERROR_ALLOC_GRIP_ID)
         .value("AIPU_STATUS_ERROR_ALLOC_GROUP_ID", aipu_status_t::AIPU_STATUS_ERROR_ALLOC_GROUP_ID)
+        .value("AIPU_STATUS_ERROR_GRAPH_LOADING", aipu_status_t::AIPU_STATUS_ERROR_GRAPH_LOADING)
+        .value("AIPU_STATUS_ERROR_LOAD_CANCELED", aipu_status_t::AIPU_STATUS_ERROR_LOAD_CANCELED)
+        .value("AIPU_STATUS_ERROR_NO_FREE_HANDLE", aipu_status_t::AIPU_STATUS_ERROR_NO_FREE_HANDLE)
         .value("AIPU_STATUS_MAX", aipu_status_t::AIPU_STATUS_MAX)
         .value("AIPU_STATUS_ERROR_UNKNOWN_ERROR", aipu_status_t::AIPU_STATUS_ERROR_UNKNOWN_ERROR)
         .value("AIPU_STATUS_ERROR_KEYBOARD_INTERRUPT", aipu_status_t::AIPU_STATUS_ERROR_KEYBOARD_INTERRUPT)
@@ -1775,9 +2176,11 @@ PYBIND11_MODULE(libaipudrv, m) {
     py::class_<NPU>(m, "NPU")
         .def(py::init())
 
-        .def("aipu_init_context", &NPU::aipu_init_context_py)
+        .def("aipu_init_context", &NPU::aipu_init_context_py,
+            py::call_guard<py::gil_scoped_release>())
 
-        .def("aipu_deinit_context", &NPU::aipu_deinit_context_py)
+        .def("aipu_deinit_context", &NPU::aipu_deinit_context_py,
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_get_error_message", &NPU::aipu_get_error_message_py,
             py::arg("status"),
@@ -1791,43 +2194,56 @@ PYBIND11_MODULE(libaipudrv, m) {
             py::arg("graph_bin"),
             py::arg("load_cfg") = std::map<std::string, int>{},
             py::arg("wt_idxes") = std::vector<int>{},
-            py::return_value_policy::copy)
+            py::return_value_policy::copy,
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_load_graph", &NPU::aipu_load_graph_helper_py,
             py::arg("graph_buffer"),
             py::arg("graph_size"),
             py::arg("load_cfg") = std::map<std::string, int>{},
             py::arg("wt_idxes") = std::vector<int>{},
-            py::return_value_policy::copy)
+            py::return_value_policy::copy,
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_unload_graph", &NPU::aipu_unload_graph_py,
-            py::arg("graph_id"))
+            py::arg("graph_id"),
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_create_job", &NPU::aipu_create_job_py,
             py::arg("graph_id"),
             py::arg("job_cfg") = std::map<std::string, int>{},
             py::arg("fm_idxes") = std::vector<int>{},
-            py::arg("ds_shapes") = std::vector<std::vector<uint64_t>>{})
+            py::arg("ds_shapes") = std::vector<std::vector<uint64_t>>{},
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_config_job", &NPU::aipu_config_job_py,
             py::arg("job_id"),
             py::arg("types"),
-            py::arg("job_config_dump") = std::map<std::string, std::string>{})
+            py::arg("job_config_dump") = std::map<std::string, std::string>{},
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_finish_job", &NPU::aipu_finish_job_py,
             py::arg("job_id"),
-            py::arg("time_out") = -1)
+            py::arg("time_out") = -1,
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_flush_job", &NPU::aipu_flush_job_py,
             py::arg("job_id"),
-            py::arg("py_cb") = nullptr)
+            py::arg("py_cb") = nullptr,
+            py::call_guard<py::gil_scoped_release>())
+
+        .def("aipu_run_job_async", &NPU::aipu_run_job_async_py,
+            py::arg("job_id"),
+            py::arg("inputs") = std::vector<py::buffer>{})
 
         .def("aipu_get_job_status", &NPU::aipu_get_job_status_py,
             py::arg("job_id"),
-            py::arg("timeout") = -1)
+            py::arg("timeout") = -1,
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_clean_job", &NPU::aipu_clean_job_py,
-            py::arg("job_id"))
+            py::arg("job_id"),
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_get_tensor_count", &NPU::aipu_get_tensor_count_py,
             py::arg("graph_id"),
@@ -1843,18 +2259,25 @@ PYBIND11_MODULE(libaipudrv, m) {
         .def("aipu_load_tensor_from_file", &NPU::aipu_load_tensor_file_py,
             py::arg("job_id"),
             py::arg("tensor"),
-            py::arg("filename"))
+            py::arg("filename"),
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_load_tensor", &NPU::aipu_load_tensor_rawbytes_py,
             py::arg("job_id"),
             py::arg("tensor"),
-            py::arg("data"))
+            py::arg("data"),
+            py::call_guard<py::gil_scoped_release>())
 
         .def("aipu_load_tensor", &NPU::aipu_load_tensor_pybytes_py,
             py::arg("job_id"),
             py::arg("tensor"),
             py::arg("raw_bytes"))
 
+        .def("aipu_load_tensor", &NPU::aipu_load_tensor_buffer_py,
+            py::arg("job_id"),
+            py::arg("tensor"),
+            py::arg("buffer"))
+
         .def("aipu_load_tensor", &NPU::aipu_load_tensor_numpyarray_py,
             py::arg("job_id"),
             py::arg("tensor"),
@@ -1866,7 +2289,13 @@ PYBIND11_MODULE(libaipudrv, m) {
             py::arg("type"),
             py::arg("tensor"),
             py::arg("data_size"),
-            py::return_value_policy::copy)
+            py::return_value_policy::copy,
+            py::call_guard<py::gil_scoped_release>())
+
+        .def("aipu_get_tensor", &NPU::aipu_get_tensor_ndarray_py,
+            py::arg("job_id"),
+            py::arg("type"),
+            py::arg("tensor"))
 
         .def("aipu_ioctl", &NPU::aipu_ioctl_py,
             py::arg("cmd"),
@@ -0,0 +1,221 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  extra_weight_cache.cpp
+ * @brief AIPU User Mode Driver (UMD) process-wide extra weight file cache implementation
+ */
+
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "extra_weight_cache.h"
+#include "utils/log.h"
+
+#define EXTRA_WEIGHT_DIGEST_CHUNK (16 * MB_SIZE)
+#define FNV1A_64_OFFSET 0xcbf29ce484222325UL
+#define FNV1A_64_PRIME  0x100000001b3UL
+
+/**
+ * @brief word-wise FNV-1a over fixed size chunks, the chunks are hashed in
+ *        parallel and the chunk digests are folded in order, so the result
+ *        doesn't depend on the number of threads.
+ */
+uint64_t aipudrv::ExtraWeightCache::digest(const char *va, uint64_t size)
+{
+    uint64_t chunk_cnt = (size + EXTRA_WEIGHT_DIGEST_CHUNK - 1) / EXTRA_WEIGHT_DIGEST_CHUNK;
+    std::vector<uint64_t> chunk_digests(chunk_cnt);
+    std::vector<std::thread> workers;
+    uint32_t thread_cnt = std::max(1U, std::thread::hardware_concurrency());
+    uint64_t ret = FNV1A_64_OFFSET ^ size;
+
+    thread_cnt = std::min((uint64_t)thread_cnt, chunk_cnt);
+    auto hash_chunks = [&](uint32_t tid) {
+        for (uint64_t c = tid; c < chunk_cnt; c += thread_cnt)
+        {
+            uint64_t start = c * EXTRA_WEIGHT_DIGEST_CHUNK;
+            uint64_t end = std::min(size, start + EXTRA_WEIGHT_DIGEST_CHUNK);
+            uint64_t h = FNV1A_64_OFFSET;
+            uint64_t word = 0;
+            uint64_t i = start;
+
+            for (; i + sizeof(word) <= end; i += sizeof(word))
+            {
+                memcpy(&word, va + i, sizeof(word));
+                h = (h ^ word) * FNV1A_64_PRIME;
+            }
+
+            for (; i < end; i++)
+                h = (h ^ (uint8_t)va[i]) * FNV1A_64_PRIME;
+
+            chunk_digests[c] = h;
+        }
+    };
+
+    for (uint32_t tid = 1; tid < thread_cnt; tid++)
+        workers.emplace_back(hash_chunks, tid);
+    hash_chunks(0);
+
+    for (auto &worker : workers)
+        worker.join();
+
+    for (auto chunk_digest : chunk_digests)
+        ret = (ret ^ chunk_digest) * FNV1A_64_PRIME;
+
+    return ret;
+}
+
+aipu_status_t aipudrv::ExtraWeightCache::open(const std::string &path, const std::string &name,
+    const std::string &hash, ExtraWeightFile **file)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    struct stat finfo;
+    void *va = MAP_FAILED;
+    uint64_t file_digest = 0;
+    bool digest_cached = false;
+    std::string prefix = name + "+" + hash + "#";
+    std::string key;
+    int fd = -1;
+
+    if (file == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (stat(path.c_str(), &finfo) != 0)
+    {
+        LOG(LOG_ERR, "no such a file: %s! (errno = %d)\n", path.c_str(), errno);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG(LOG_ERR, "open file failed: %s! (errno = %d)\n", path.c_str(), errno);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    va = mmap(nullptr, finfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (va == MAP_FAILED)
+    {
+        LOG(LOG_ERR, "mmap extra weight: %s! (errno = %d)\n", path.c_str(), errno);
+        return AIPU_STATUS_ERROR_MAP_FILE_FAIL;
+    }
+
+    /* only hash the content once as long as the file isn't touched */
+    ExtraWeightStamp stamp(finfo.st_dev, finfo.st_ino,
+        (int64_t)finfo.st_mtim.tv_sec * 1000000000 + finfo.st_mtim.tv_nsec, finfo.st_size);
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        if (m_digests.count(stamp) != 0)
+        {
+            file_digest = m_digests[stamp];
+            digest_cached = true;
+        }
+    }
+
+    if (!digest_cached)
+    {
+        file_digest = digest((const char *)va, finfo.st_size);
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_digests[stamp] = file_digest;
+    }
+
+    key = prefix + std::to_string(file_digest);
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        auto iter = m_files.find(key);
+
+        if (iter != m_files.end())
+        {
+            munmap(va, finfo.st_size);
+            iter->second->ref++;
+            iter->second->stamps.insert(stamp);
+            *file = iter->second;
+            goto finish;
+        }
+
+        iter = m_files.lower_bound(prefix);
+        if ((iter != m_files.end()) && (iter->first.compare(0, prefix.size(), prefix) == 0))
+            LOG(LOG_WARN, "extra weight %s differs from the one in use, not shared\n", path.c_str());
+
+        ExtraWeightFile *new_file = new ExtraWeightFile;
+        new_file->key = key;
+        new_file->va = (const char *)va;
+        new_file->size = finfo.st_size;
+        new_file->digest = file_digest;
+        new_file->ref = 1;
+        new_file->stamps.insert(stamp);
+        m_files[key] = new_file;
+        *file = new_file;
+    }
+
+finish:
+    return ret;
+}
+
+void aipudrv::ExtraWeightCache::close(ExtraWeightFile *file)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+
+    if ((file == nullptr) || (--file->ref != 0))
+        return;
+
+    for (auto &stamp : file->stamps)
+        m_digests.erase(stamp);
+    m_files.erase(file->key);
+    munmap((void *)file->va, file->size);
+    delete file;
+}
+
+/**
+ * @brief get the device weight buffer of a file for one memory manager and
+ *        BSS layout, the first user allocates and fills it via 'fill'.
+ *
+ * @note  'fill' runs with the file's buffer lock held, it must not call back
+ *        into user code.
+ */
+aipu_status_t aipudrv::ExtraWeightCache::acquire_buffer(ExtraWeightFile *file, MemoryBase *mem,
+    const SharedWeightLayout &layout, std::function<void(BufferDesc*)> fill, BufferDesc **buf)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::lock_guard<std::mutex> lock_(file->buf_lock);
+    auto key = std::make_pair(mem, layout);
+    auto iter = file->buffers.find(key);
+    BufferDesc *new_buf = nullptr;
+
+    if (iter != file->buffers.end())
+    {
+        iter->second.ref++;
+        *buf = iter->second.buf;
+        return ret;
+    }
+
+    ret = mem->malloc(layout.size, 0, &new_buf, "extra_weight", layout.region);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    fill(new_buf);
+    file->buffers[key] = {new_buf, 1};
+    *buf = new_buf;
+    return ret;
+}
+
+void aipudrv::ExtraWeightCache::release_buffer(ExtraWeightFile *file, MemoryBase *mem,
+    const SharedWeightLayout &layout)
+{
+    std::lock_guard<std::mutex> lock_(file->buf_lock);
+    auto iter = file->buffers.find(std::make_pair(mem, layout));
+
+    if ((iter == file->buffers.end()) || (--iter->second.ref != 0))
+        return;
+
+    mem->free(&iter->second.buf);
+    file->buffers.erase(iter);
+}
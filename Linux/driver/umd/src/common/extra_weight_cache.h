@@ -0,0 +1,107 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  extra_weight_cache.h
+ * @brief AIPU User Mode Driver (UMD) process-wide extra weight file cache header
+ */
+
+#ifndef _EXTRA_WEIGHT_CACHE_H_
+#define _EXTRA_WEIGHT_CACHE_H_
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <functional>
+#include <sys/types.h>
+#include "standard_api.h"
+#include "memory_base.h"
+
+namespace aipudrv
+{
+/* <st_dev, st_ino, st_mtime (ns), st_size> */
+typedef std::tuple<dev_t, ino_t, int64_t, uint64_t> ExtraWeightStamp;
+
+/**
+ * @brief what a shared device weight buffer holds: its size, memory region and
+ *        the <relative_addr, offset_in_file, size> of each section copied in
+ */
+struct SharedWeightLayout
+{
+    uint64_t size = 0;
+    uint32_t region = 0;
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> sections;
+
+    bool operator<(const SharedWeightLayout &layout) const
+    {
+        return std::tie(size, region, sections) < std::tie(layout.size, layout.region, layout.sections);
+    }
+};
+
+/**
+ * @brief one extra weight file mapped into this process
+ *
+ * @note  graphs referring the same name+hash with identical file content
+ *        share the mapping and, per memory manager and BSS layout, one
+ *        device weight buffer.
+ */
+struct ExtraWeightFile
+{
+    std::string key;
+    const char *va = nullptr;
+    uint64_t size = 0;
+    uint64_t digest = 0;
+    uint32_t ref = 0;
+
+    /* stamps of the files the digest was computed from, dropped on last close */
+    std::set<ExtraWeightStamp> stamps;
+
+    struct SharedBuffer
+    {
+        BufferDesc *buf;
+        uint32_t ref;
+    };
+
+    /* <memory manager, BSS layout> */
+    std::map<std::pair<MemoryBase*, SharedWeightLayout>, SharedBuffer> buffers;
+    std::mutex buf_lock;
+};
+
+class ExtraWeightCache
+{
+private:
+    std::map<std::string, ExtraWeightFile*> m_files;
+    std::map<ExtraWeightStamp, uint64_t> m_digests;
+    std::mutex m_lock;
+
+private:
+    static uint64_t digest(const char *va, uint64_t size);
+
+public:
+    aipu_status_t open(const std::string &path, const std::string &name,
+        const std::string &hash, ExtraWeightFile **file);
+    void close(ExtraWeightFile *file);
+    aipu_status_t acquire_buffer(ExtraWeightFile *file, MemoryBase *mem, const SharedWeightLayout &layout,
+        std::function<void(BufferDesc*)> fill, BufferDesc **buf);
+    void release_buffer(ExtraWeightFile *file, MemoryBase *mem, const SharedWeightLayout &layout);
+
+public:
+    static ExtraWeightCache& get_cache()
+    {
+        static ExtraWeightCache cache;
+        return cache;
+    }
+    ExtraWeightCache(const ExtraWeightCache& cache) = delete;
+    ExtraWeightCache& operator=(const ExtraWeightCache& cache) = delete;
+
+private:
+    ExtraWeightCache() {};
+};
+}
+
+#endif /* _EXTRA_WEIGHT_CACHE_H_ */
@@ -11,6 +11,8 @@
 #include <cstring>
 #include "graph.h"
 #include "parser_base.h"
+#include "weight_residency.h"
+#include "load_phase.h"
 #include "utils/helper.h"
 #include "utils/log.h"
 
@@ -32,6 +34,7 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
     aipu_load_graph_cfg_t *config)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    LoadPhase phase(AIPU_LOAD_PHASE_LOAD);
 
     /**
     * decide weight allocation strategy
@@ -39,6 +42,7 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
     if (config != nullptr)
     {
         m_wt_mem_region = config->wt_mem_region;
+        m_wt_on_demand = config->wt_on_demand;
         if (config->wt_idxes)
         {
             for (int i = 0; i < config->wt_idxes_cnt; i++)
@@ -57,7 +61,10 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
         }
     }
 
-    ret = m_parser->parse_graph(gbin, size, *this);
+    {
+        LoadPhase parse_phase(AIPU_LOAD_PHASE_PARSE);
+        ret = m_parser->parse_graph(gbin, size, *this);
+    }
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
 
@@ -66,6 +73,13 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
     if (ver_check && !m_dev->has_target(m_arch, m_hw_version, m_hw_config, m_hw_revision))
         return AIPU_STATUS_ERROR_TARGET_NOT_FOUND;
 
+    load_progress_init();
+    if (load_canceled())
+    {
+        ret = AIPU_STATUS_ERROR_LOAD_CANCELED;
+        goto finish;
+    }
+
     /* alloc and load text buffer */
     if (m_btext.size != 0)
     {
@@ -76,7 +90,7 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
         ret = m_mem->malloc(m_btext.size + 16, 0, &m_text, "text");
         if (ret != AIPU_STATUS_SUCCESS)
             goto finish;
-        m_mem->write(m_text->pa, m_btext.va, m_btext.size);
+        load_write(m_text->pa, m_btext.va, m_btext.size);
     }
 
     if (m_bcrodata.size != 0)
@@ -84,7 +98,13 @@ aipu_status_t aipudrv::Graph::load(std::istream& gbin, uint32_t size,bool ver_ch
         ret = m_mem->malloc(m_bcrodata.size, 0, &m_crodata, "crodata");
         if (ret != AIPU_STATUS_SUCCESS)
             goto finish;
-        m_mem->write(m_crodata->pa, m_bcrodata.va, m_bcrodata.size);
+        load_write(m_crodata->pa, m_bcrodata.va, m_bcrodata.size);
+    }
+
+    if (load_canceled())
+    {
+        ret = AIPU_STATUS_ERROR_LOAD_CANCELED;
+        goto finish;
     }
 
     if (m_bweight.size() > 0)
@@ -238,12 +258,15 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     struct GraphSectionDesc *static_section = nullptr;
     uint32_t asid = 0;
-    int pad_sz = 0;
+    int pad_sz = get_weight_pad_size();
+    LoadPhase phase(AIPU_LOAD_PHASE_ALLOC_WEIGHT);
 
-#ifndef SIMULATION
-    if (m_hw_version == AIPU_ISA_VERSION_ZHOUYI_V3)
-        pad_sz = 0x800;
-#endif
+    if (m_wt_on_demand && ((m_wt_residency == nullptr) || (m_wt_mem_region != AIPU_MEM_REGION_DEFAULT)
+        || ((m_hw_version != AIPU_ISA_VERSION_ZHOUYI_V3) && (m_hw_version != AIPU_ISA_VERSION_ZHOUYI_V3_1))))
+    {
+        LOG(LOG_WARN, "on-demand weight needs aipu v3/v3_1 and default region, load weight eagerly\n");
+        m_wt_on_demand = false;
+    }
 
     if (m_wt_mem_region == AIPU_MEM_REGION_DEFAULT)
     {
@@ -252,7 +275,14 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
             std::vector<struct GraphSectionDesc> &static_sections = get_static_section_ref(bss_id);
             struct WeightBufferInfo weightBufferInfo = {0};
 
-            if (m_bweight.size() > 0 && m_bweight[bss_id].size != 0)
+            /* cancel on BSS boundary so that m_weight_buffers_vec stays consistent for unload */
+            if (load_canceled())
+            {
+                ret = AIPU_STATUS_ERROR_LOAD_CANCELED;
+                goto finish;
+            }
+
+            if (m_bweight.size() > bss_id && m_bweight[bss_id].size != 0)
             {
                 if (m_hw_version == AIPU_ISA_VERSION_ZHOUYI_V3
                     || m_hw_version == AIPU_ISA_VERSION_ZHOUYI_V3_1)
@@ -261,13 +291,21 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
                 /**
                 * allocate weight from ASID1 region defalut.if all ASIDs are configured
                 * with the same base addr, it's also equal to allocate from ASID0.
+                * on-demand weight is allocated later when a job needs it.
                 */
-                ret = m_mem->malloc(get_const_size(bss_id) + pad_sz, 0,
-                    &weightBufferInfo.wb_weight, "weight", (asid << 8) | AIPU_MEM_REGION_DEFAULT);
-                if (ret != AIPU_STATUS_SUCCESS)
+                if (!m_wt_on_demand)
                 {
-                    LOG(LOG_ERR, "alloc weight buffer [fail]");
-                    goto finish;
+                    if (get_extra_weight_file(bss_id) != nullptr)
+                        ret = alloc_shared_weight(bss_id, pad_sz, (asid << 8) | m_wt_mem_region,
+                            weightBufferInfo);
+                    else
+                        ret = m_mem->malloc(get_const_size(bss_id) + pad_sz, 0,
+                            &weightBufferInfo.wb_weight, "weight", (asid << 8) | AIPU_MEM_REGION_DEFAULT);
+                    if (ret != AIPU_STATUS_SUCCESS)
+                    {
+                        LOG(LOG_ERR, "alloc weight buffer [fail]");
+                        goto finish;
+                    }
                 }
 
                 if (get_zerocpy_const_size(bss_id) > 0)
@@ -290,16 +328,26 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
 
                 if (static_section->type == SECTION_TYPE_ZEROCPY_CONSTANT)
                 {
-                    m_mem->write(weightBufferInfo.wb_zerocpy_const->pa + static_section->relative_addr,
+                    load_write(weightBufferInfo.wb_zerocpy_const->pa + static_section->relative_addr,
                         m_bweight[bss_id].va + static_section->offset_in_file, static_section->size);
                     buf->init(weightBufferInfo.wb_zerocpy_const->asid_base,
                         weightBufferInfo.wb_zerocpy_const->pa + static_section->relative_addr,
                         static_section->size, static_section->size);
                     LOG(LOG_INFO, "zerocpy %d, pa=%lx, a_b=%lx, asid_pa=%lx, relative_addr=%x\n", i,
                         buf->pa, buf->asid_base, buf->align_asid_pa, static_section->relative_addr);
+                } else if (m_wt_on_demand) {
+                    /**
+                     * ASID1 base is the BSS buffer address once it gets resident, so
+                     * the ASID relative address in rodata is fixed from now on.
+                     */
+                    buf->init(0, static_section->relative_addr, static_section->size,
+                        static_section->size, 0, asid << 8);
+                    load_skip(static_section->size);
                 } else {
-                    m_mem->write(weightBufferInfo.wb_weight->pa + static_section->relative_addr,
-                        m_bweight[bss_id].va + static_section->offset_in_file, static_section->size);
+                    /* shared weight is filled by alloc_shared_weight() */
+                    if (weightBufferInfo.wb_shared_file == nullptr)
+                        load_write(weightBufferInfo.wb_weight->pa + static_section->relative_addr,
+                            m_bweight[bss_id].va + static_section->offset_in_file, static_section->size);
                     buf->init(weightBufferInfo.wb_weight->asid_base,
                         weightBufferInfo.wb_weight->pa + static_section->relative_addr,
                         static_section->size, static_section->size, 0, asid << 8);
@@ -310,8 +358,12 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
                     m_weight_buffers_vec[0].wb_weights.push_back(buf);
             }
 
-            weightBufferInfo.wb_asid_base = weightBufferInfo.wb_weight->asid_base;
+            if (weightBufferInfo.wb_weight != nullptr)
+                weightBufferInfo.wb_asid_base = weightBufferInfo.wb_weight->asid_base;
             m_weight_buffers_vec.push_back(weightBufferInfo);
+
+            if (m_wt_on_demand && (m_bweight[bss_id].size != 0))
+                m_wt_residency->add(this, bss_id, get_const_size(bss_id) + pad_sz);
         }
     } else {
         if (get_bss_cnt() == 1)
@@ -348,7 +400,7 @@ aipu_status_t aipudrv::Graph::alloc_weight_buffer(std::vector<struct GraphSectio
                             goto finish;
                         }
 
-                        m_mem->write(buf->pa, (char *)static_section->load_src, static_section->size);
+                        load_write(buf->pa, (char *)static_section->load_src, static_section->size);
                         weightBufferInfo.wb_weights.push_back(buf);
                         if (bss_id != 0)
                             m_weight_buffers_vec[0].wb_weights.push_back(buf);
@@ -370,11 +422,15 @@ finish:
 aipu_status_t aipudrv::Graph::unload()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    LoadPhase phase(m_load_stats, AIPU_LOAD_PHASE_UNLOAD);
 
     ret = destroy_jobs();
     if (ret != AIPU_STATUS_SUCCESS)
         return ret;
 
+    if (m_wt_on_demand)
+        m_wt_residency->remove(this);
+
     if (m_text && m_text->size != 0)
         m_mem->free(&m_text);
 
@@ -383,18 +439,27 @@ aipu_status_t aipudrv::Graph::unload()
 
     if (m_bweight.size() > 0)
     {
-        for (uint32_t bss_id = 0; bss_id < get_bss_cnt(); bss_id++)
+        /* a failed or canceled load may have stopped before the last BSS */
+        for (uint32_t bss_id = 0; bss_id < m_weight_buffers_vec.size(); bss_id++)
         {
             struct WeightBufferInfo &weightBufferInfo = m_weight_buffers_vec[bss_id];
 
             if (weightBufferInfo.wb_zerocpy_const != nullptr && weightBufferInfo.wb_zerocpy_const->size != 0)
                 m_mem->free(&weightBufferInfo.wb_zerocpy_const);
 
-            if (weightBufferInfo.wb_weight != nullptr)
+            if (weightBufferInfo.wb_shared_file != nullptr)
             {
-                if (weightBufferInfo.wb_weight->size != 0)
-                    m_mem->free(&weightBufferInfo.wb_weight);
+                ExtraWeightCache::get_cache().release_buffer(weightBufferInfo.wb_shared_file,
+                    m_mem, weightBufferInfo.wb_shared_layout);
+                weightBufferInfo.wb_shared_file = nullptr;
+                weightBufferInfo.wb_weight = nullptr;
+            } else if (weightBufferInfo.wb_weight != nullptr && weightBufferInfo.wb_weight->size != 0) {
+                m_mem->free(&weightBufferInfo.wb_weight);
+            }
 
+            /* BSS descriptors are owned by the graph in default region, else by memory manager */
+            if (m_wt_mem_region == AIPU_MEM_REGION_DEFAULT)
+            {
                 if (bss_id == 0)
                 {
                     for (uint32_t i = 0; i < weightBufferInfo.wb_weights.size(); i++)
@@ -415,10 +480,157 @@ aipu_status_t aipudrv::Graph::unload()
         }
     }
 
+    /* graph parse may fail after extra weight files got mapped */
+    for (auto &extraWeightInfo : m_extra_weight_info_vec)
+        ExtraWeightCache::get_cache().close(extraWeightInfo.extraWeight_file);
+    m_extra_weight_info_vec.clear();
+
     m_mem->dump_tracking_log_end();
     return ret;
 }
 
+void aipudrv::Graph::load_progress_init()
+{
+    if (m_load_monitor == nullptr)
+        return;
+
+    m_load_monitor->done_bytes = 0;
+    m_load_monitor->total_bytes = m_btext.size + m_bcrodata.size;
+    if (m_bweight.size() == 0)
+        return;
+
+    for (uint32_t bss_id = 0; bss_id < get_bss_cnt(); bss_id++)
+    {
+        std::vector<struct GraphSectionDesc> &static_sections = get_static_section_ref(bss_id);
+
+        for (uint32_t i = 0; i < static_sections.size(); i++)
+            m_load_monitor->total_bytes += static_sections[i].size;
+    }
+}
+
+void aipudrv::Graph::load_write(DEV_PA_64 pa, const char* src, uint32_t size)
+{
+    m_mem->write(pa, src, size);
+    load_done(size);
+}
+
+void aipudrv::Graph::load_done(uint64_t size)
+{
+    if (m_load_monitor == nullptr)
+        return;
+
+    m_load_monitor->done_bytes += size;
+    if (m_load_monitor->cb != nullptr)
+        m_load_monitor->cb(m_id, m_load_monitor->done_bytes, m_load_monitor->total_bytes,
+            m_load_monitor->cb_arg);
+}
+
+/**
+ * @brief use the device weight buffer of an extra weight file shared by all graphs
+ *        with the same file content and BSS layout, or create it on first use.
+ *
+ * @note  the buffer is filled under the cache lock of the file, so the load
+ *        progress is only reported once the lock is dropped.
+ */
+aipu_status_t aipudrv::Graph::alloc_shared_weight(uint32_t bss_id, uint32_t pad_sz, uint32_t region,
+    struct WeightBufferInfo &weightBufferInfo)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::vector<struct GraphSectionDesc> &static_sections = get_static_section_ref(bss_id);
+    ExtraWeightFile *file = get_extra_weight_file(bss_id);
+    SharedWeightLayout layout;
+    uint64_t bytes = 0;
+    bool filled = false;
+
+    layout.size = get_const_size(bss_id) + pad_sz;
+    layout.region = region;
+    for (auto &section : static_sections)
+    {
+        if (section.type == SECTION_TYPE_ZEROCPY_CONSTANT)
+            continue;
+
+        layout.sections.push_back(std::make_tuple(section.relative_addr, section.offset_in_file,
+            section.size));
+        bytes += section.size;
+    }
+
+    ret = ExtraWeightCache::get_cache().acquire_buffer(file, m_mem, layout, [&](BufferDesc *buf) {
+            for (auto &section : layout.sections)
+                m_mem->write(buf->pa + std::get<0>(section),
+                    m_bweight[bss_id].va + std::get<1>(section), std::get<2>(section));
+            filled = true;
+        }, &weightBufferInfo.wb_weight);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    if (filled)
+        load_done(bytes);
+    else
+        load_skip(bytes);
+
+    weightBufferInfo.wb_shared_file = file;
+    weightBufferInfo.wb_shared_layout = layout;
+    return ret;
+}
+
+uint32_t aipudrv::Graph::get_weight_pad_size()
+{
+#ifndef SIMULATION
+    if (m_hw_version == AIPU_ISA_VERSION_ZHOUYI_V3)
+        return 0x800;
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief allocate and fill a weight buffer for an evicted BSS
+ *
+ * @note  jobs can't see the buffer until set_bss_weight(), so this runs out
+ *        of the residency lock. the BSS descriptors keep their ASID relative
+ *        address, only the ASID1 base (wb_asid_base) changes with each upload.
+ */
+aipu_status_t aipudrv::Graph::upload_bss_weight(uint32_t bss_id, BufferDesc **weight)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::vector<struct GraphSectionDesc> &static_sections = get_static_section_ref(bss_id);
+
+    ret = m_mem->malloc(get_const_size(bss_id) + get_weight_pad_size(), 0, weight,
+        "weight", (1 << 8) | AIPU_MEM_REGION_DEFAULT);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    for (auto &static_section : static_sections)
+    {
+        if (static_section.type == SECTION_TYPE_ZEROCPY_CONSTANT)
+            continue;
+
+        m_mem->write((*weight)->pa + static_section.relative_addr,
+            m_bweight[bss_id].va + static_section.offset_in_file, static_section.size);
+    }
+
+    return ret;
+}
+
+void aipudrv::Graph::set_bss_weight(uint32_t bss_id, BufferDesc *weight)
+{
+    struct WeightBufferInfo &weightBufferInfo = m_weight_buffers_vec[bss_id];
+
+    weightBufferInfo.wb_weight = weight;
+    weightBufferInfo.wb_asid_base = weight->pa;
+}
+
+void aipudrv::Graph::evict_bss_weight(uint32_t bss_id)
+{
+    struct WeightBufferInfo &weightBufferInfo = m_weight_buffers_vec[bss_id];
+
+    if (weightBufferInfo.wb_weight != nullptr)
+        m_mem->free(&weightBufferInfo.wb_weight);
+
+    weightBufferInfo.wb_weight = nullptr;
+    weightBufferInfo.wb_asid_base = 0;
+}
+
 int32_t aipudrv::Graph::get_dynamic_shape_dim_num(uint32_t idx, bool max_shape_dim)
 {
     if (!is_dynamic_shape())
@@ -483,14 +695,19 @@ aipu_status_t aipudrv::Graph::set_graph_extra_weight(BinSection extra_weight)
         start += extra_weight_bin_name_len;
 
         path = m_extra_weight_path + "/" + extraWeightInfo.extraWeight_name;
-        ret = umd_mmap_file_helper(path.c_str(), (void **)&ew_binsection.va, &ew_binsection.size);
+        ret = ExtraWeightCache::get_cache().open(path, extraWeightInfo.extraWeight_name,
+            extraWeightInfo.extraWeight_hash, &extraWeightInfo.extraWeight_file);
         if (ret != AIPU_STATUS_SUCCESS)
         {
             LOG(LOG_ERR, "Mmap extra weight: %s [fail]\n", path.c_str());
+            for (auto &info : m_extra_weight_info_vec)
+                ExtraWeightCache::get_cache().close(info.extraWeight_file);
             m_extra_weight_info_vec.clear();
             return ret;
         }
 
+        ew_binsection.va = extraWeightInfo.extraWeight_file->va;
+        ew_binsection.size = extraWeightInfo.extraWeight_file->size;
         set_graph_weight(ew_binsection);
         m_extra_weight_info_vec.push_back(extraWeightInfo);
     }
@@ -19,6 +19,7 @@
 #include "standard_api.h"
 #include "graph_base.h"
 #include "parser_base.h"
+#include "extra_weight_cache.h"
 
 namespace aipudrv
 {
@@ -110,6 +111,7 @@ protected:
     struct ExtraWeightInfo {
         std::string extraWeight_name;
         std::string extraWeight_hash;
+        ExtraWeightFile *extraWeight_file = nullptr;
      };
     std::vector<ExtraWeightInfo> m_extra_weight_info_vec;
     std::string m_extra_weight_path;
@@ -141,12 +143,19 @@ protected:
 
         /* weight buffer ASID base address */
         DEV_PA_64 wb_asid_base = 0;
+
+        /* wb_weight shared with other graphs using the same extra weight file */
+        ExtraWeightFile *wb_shared_file = nullptr;
+        SharedWeightLayout wb_shared_layout;
     };
 
     std::vector<struct WeightBufferInfo> m_weight_buffers_vec;
 
     bool m_do_vcheck = true;
 
+    /* BSS weights are uploaded per job schedule, see WeightResidency */
+    bool m_wt_on_demand = false;
+
     /* DTCM size, KB unit */
     int m_dtcm_size = 0;
 
@@ -191,6 +200,38 @@ public:
     aipu_status_t alloc_weight_buffer(std::vector<struct GraphSectionDesc> &static_sections,
         aipu_load_graph_cfg_t *config = nullptr);
 
+protected:
+    /* asynchronous load helpers, no-op if no load monitor is attached */
+    void load_progress_init();
+    void load_write(DEV_PA_64 pa, const char* src, uint32_t size);
+    void load_done(uint64_t size);
+    bool load_canceled()
+    {
+        return (m_load_monitor != nullptr) && m_load_monitor->cancel.load();
+    }
+    void load_skip(uint64_t size)
+    {
+        if (m_load_monitor != nullptr)
+            m_load_monitor->total_bytes -= size;
+    }
+
+    /* extra weight file backing a BSS, nullptr for the embedded weight */
+    ExtraWeightFile *get_extra_weight_file(uint32_t bss_id)
+    {
+        if ((bss_id == 0) || (bss_id > m_extra_weight_info_vec.size()))
+            return nullptr;
+
+        return m_extra_weight_info_vec[bss_id - 1].extraWeight_file;
+    }
+    aipu_status_t alloc_shared_weight(uint32_t bss_id, uint32_t pad_sz, uint32_t region,
+        struct WeightBufferInfo &weightBufferInfo);
+
+    /* on-demand weight helpers, called by WeightResidency */
+    uint32_t get_weight_pad_size();
+    aipu_status_t upload_bss_weight(uint32_t bss_id, BufferDesc **weight);
+    void set_bss_weight(uint32_t bss_id, BufferDesc *weight);
+    void evict_bss_weight(uint32_t bss_id);
+
 public:
     /* Set functions */
     void set_parser(ParserBase* parser)
@@ -240,6 +281,11 @@ public:
         return m_weight_buffers_vec[bss_id];
     }
 
+    bool is_wt_on_demand()
+    {
+        return m_wt_on_demand;
+    }
+
     virtual uint32_t get_bss_cnt()
     {
         return 1;
@@ -362,6 +408,7 @@ public:
     Graph& operator=(const Graph& graph) = delete;
 
     friend class JobBase;
+    friend class WeightResidency;
 };
 }
 
@@ -9,6 +9,7 @@
  */
 #include "graph_base.h"
 #include "job_base.h"
+#include "reclaimer.h"
 
 aipudrv::GraphBase::GraphBase(void* ctx, GRAPH_ID id, DeviceBase* dev):
     m_ctx(ctx),
@@ -22,47 +23,63 @@ aipudrv::GraphBase::GraphBase(void* ctx, GRAPH_ID id, DeviceBase* dev):
 
 aipudrv::GraphBase::~GraphBase()
 {
+    /**
+     * deferred destroy_job() teardowns capture this graph, they must be done
+     * before it goes away. unload() drains them in destroy_jobs() already, this
+     * covers graphs deleted without unload().
+     */
+    if (m_deferred_jobs != 0)
+        Reclaimer::get_reclaimer().drain();
+
     m_wt_idxes.clear();
     pthread_rwlock_destroy(&m_lock);
     pthread_rwlock_destroy(&m_batch_queue_lock);
 }
 
-aipudrv::JOB_ID aipudrv::GraphBase::create_job_id_inner()
+aipudrv::JOB_ID aipudrv::GraphBase::add_job(JobBase* job)
 {
-    uint64_t id_candidate = create_full_job_id(m_id, 1);
+    uint32_t handle = 0;
 
-    while (m_jobs.count(id_candidate) == 1)
-    {
-        id_candidate++;
-    }
-    return id_candidate;
+    pthread_rwlock_wrlock(&m_lock);
+    handle = m_jobs.alloc(job);
+    pthread_rwlock_unlock(&m_lock);
+
+    if (handle == 0)
+        LOG(LOG_ERR, "no free job ID in graph 0x%lx\n", m_id);
+
+    job->set_id((handle != 0) ? create_full_job_id(m_id, handle) : 0);
+    return job->get_id();
 }
 
-aipudrv::JOB_ID aipudrv::GraphBase::add_job(JobBase* job)
+std::map<aipudrv::JOB_ID, aipudrv::JobBase*> aipudrv::GraphBase::get_jobs()
 {
-    pthread_rwlock_wrlock(&m_lock);
-    job->set_id(create_job_id_inner());
-    m_jobs[job->get_id()] = job;
+    std::map<JOB_ID, JobBase*> jobs;
+
+    pthread_rwlock_rdlock(&m_lock);
+    for (auto &entry : m_jobs.entries())
+        jobs[create_full_job_id(m_id, entry.first)] = entry.second;
     pthread_rwlock_unlock(&m_lock);
-    return job->get_id();
+
+    return jobs;
 }
 
 aipu_status_t aipudrv::GraphBase::destroy_jobs()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
-    auto iter = m_jobs.begin();
+
+    /* deferred jobs still refer to this graph */
+    if (m_deferred_jobs != 0)
+        Reclaimer::get_reclaimer().drain();
 
     pthread_rwlock_wrlock(&m_lock);
-    while(iter != m_jobs.end())
+    for (auto &entry : m_jobs.entries())
     {
-        ret = iter->second->destroy();
+        ret = entry.second->destroy();
         if (ret != AIPU_STATUS_SUCCESS)
             goto unlock;
 
-        delete iter->second;
-        iter->second = nullptr;
-        m_jobs.erase(iter);
-        iter = m_jobs.begin();
+        m_jobs.release(entry.first);
+        delete entry.second;
     }
 
 unlock:
@@ -73,17 +90,30 @@ unlock:
 aipu_status_t aipudrv::GraphBase::destroy_job(JOB_ID id)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    JobBase *job = nullptr;
 
     pthread_rwlock_wrlock(&m_lock);
-    if (m_jobs.count(id) != 0)
+    job = get_job(id);
+    if ((job != nullptr) && (m_teardown_cfg != nullptr) && m_teardown_cfg->deferred)
     {
-        ret = m_jobs[id]->destroy();
+        /* the job ID is invalid from now on, its buffers are freed in background */
+        m_jobs.release(job_id2handle(id));
+        m_deferred_jobs++;
+        /* 'this' stays valid: graph teardown drains the reclaimer before freeing it */
+        Reclaimer::get_reclaimer().defer([this, job] {
+            /* nobody can retry with a released ID, delete the job anyway */
+            if (job->destroy() != AIPU_STATUS_SUCCESS)
+                LOG(LOG_ERR, "deferred destroy job 0x%lx [fail]\n", job->get_id());
+            delete job;
+            m_deferred_jobs--;
+        });
+    } else if (job != nullptr) {
+        ret = job->destroy();
         if (ret != AIPU_STATUS_SUCCESS)
             goto unlock;
 
-        delete m_jobs[id];
-        m_jobs[id] = nullptr;
-        m_jobs.erase(id);
+        m_jobs.release(job_id2handle(id));
+        delete job;
     }
 
 unlock:
@@ -14,11 +14,15 @@
 #include <fstream>
 #include <map>
 #include <set>
+#include <atomic>
 #include <pthread.h>
 #include "standard_api.h"
 #include "device_base.h"
 #include "memory_base.h"
+#include "metrics.h"
+#include "profile_report.h"
 #include "type.h"
+#include "handle_table.h"
 
 namespace aipudrv
 {
@@ -65,7 +69,21 @@ typedef struct batch_info
     }
 } batch_info_t;
 
+/**
+ * @brief state shared between an asynchronous load request and the graph
+ *        object being loaded: progress reporting and cancellation
+ */
+struct GraphLoadMonitor
+{
+    aipu_load_graph_progress_t cb = nullptr;
+    void *cb_arg = nullptr;
+    std::atomic<bool> cancel{false};
+    uint64_t total_bytes = 0;
+    uint64_t done_bytes = 0;
+};
+
 class JobBase;
+class WeightResidency;
 class GraphBase
 {
 protected:
@@ -82,17 +100,23 @@ protected:
     uint32_t m_sram_flag = 0;
     uint32_t m_wt_mem_region = AIPU_MEM_REGION_DEFAULT;
     std::set<uint32_t> m_wt_idxes;
+    GraphLoadMonitor *m_load_monitor = nullptr;
+    WeightResidency *m_wt_residency = nullptr;
+    const aipu_global_config_teardown_t *m_teardown_cfg = nullptr;
+    aipu_load_phase_stats_t m_load_stats[AIPU_LOAD_PHASE_MAX] = {};
+    JobCounters m_job_counters;
+    ProfileReport m_profile_report;
 
 protected:
     DeviceBase* m_dev;
     MemoryBase* m_mem;
 
 protected:
-    std::map<JOB_ID, JobBase*> m_jobs;
+    HandleTable<JobBase> m_jobs;
     pthread_rwlock_t m_lock;
+    std::atomic<uint32_t> m_deferred_jobs{0};
 
 protected:
-    virtual JOB_ID create_job_id_inner();
     JOB_ID add_job(JobBase* job);
     aipu_status_t destroy_jobs();
 
@@ -122,15 +146,20 @@ public:
     virtual uint32_t get_dynamic_shape_num() = 0;
     virtual int32_t get_dynamic_shape_dim_num(uint32_t idx, bool max_shape_dim) = 0;
     virtual bool get_dynamic_shape_data(uint32_t idx, bool max_shape_dim, uint32_t *data) = 0;
+    virtual void get_profile_regions(ProfileRegions &regions)
+    {
+        regions.push_back(std::make_pair(0, 0));
+    }
 
+    /* lock-free, called on every job API */
     JobBase* get_job(JOB_ID id)
     {
-        JobBase* job = nullptr;
-        pthread_rwlock_rdlock(&m_lock);
-        job = (m_jobs.count(id) ? m_jobs[id]: nullptr);
-        pthread_rwlock_unlock(&m_lock);
-        return job;
+        if (job_id2graph_id(id) != m_id)
+            return nullptr;
+
+        return m_jobs.get(job_id2handle(id));
     }
+    std::map<JOB_ID, JobBase*> get_jobs();
     aipu_status_t destroy_job(JOB_ID id);
 
 public:
@@ -184,6 +213,18 @@ public:
     {
         m_aipubin_buildversion = buildversion;
     }
+    void set_load_monitor(GraphLoadMonitor *monitor)
+    {
+        m_load_monitor = monitor;
+    }
+    void set_weight_residency(WeightResidency *residency)
+    {
+        m_wt_residency = residency;
+    }
+    void set_teardown_config(const aipu_global_config_teardown_t *cfg)
+    {
+        m_teardown_cfg = cfg;
+    }
 
     /* Get functions */
     uint32_t get_gversion()
@@ -202,6 +243,22 @@ public:
     {
         return m_aipubin_buildversion;
     }
+    GRAPH_ID get_id()
+    {
+        return m_id;
+    }
+    aipu_load_phase_stats_t *get_load_stats()
+    {
+        return m_load_stats;
+    }
+    JobCounters& get_job_counters()
+    {
+        return m_job_counters;
+    }
+    ProfileReport& get_profile_report()
+    {
+        return m_profile_report;
+    }
 
 public:
     GraphBase(void* ctx, GRAPH_ID id, DeviceBase* dev);
@@ -0,0 +1,200 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  handle_table.h
+ * @brief AIPU User Mode Driver (UMD) generation-checked handle table header
+ */
+
+#ifndef _HANDLE_TABLE_H_
+#define _HANDLE_TABLE_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+namespace aipudrv
+{
+/**
+ * @brief slot array mapping 32-bit handles to objects
+ *
+ * @note  handle bit[15:0] is slot index + 1 (never 0), bit[31:16] is the
+ *        generation of the slot, bumped on every release so that a stale
+ *        handle doesn't resolve to the object reusing its slot. so at most
+ *        MAX_CNT handles are live at once, alloc() fails beyond that and the
+ *        callers return AIPU_STATUS_ERROR_NO_FREE_HANDLE. the generation wraps
+ *        after 65536 releases of one slot, FIFO reuse of the free slots keeps
+ *        that far away while many slots are in use.
+ *
+ *        get() is lock-free: a bounds check plus atomic loads. slots are
+ *        allocated in chunks which are never freed before the table, other
+ *        operations must be serialized by the owner.
+ */
+template <typename T>
+class HandleTable
+{
+public:
+    static const uint32_t SLOT_BITS = 16;
+    static const uint32_t SLOT_MASK = (1U << SLOT_BITS) - 1;
+    static const uint32_t MAX_CNT = SLOT_MASK;
+
+private:
+    static const uint32_t CHUNK_BITS = 8;
+    static const uint32_t CHUNK_SIZE = 1U << CHUNK_BITS;
+    static const uint32_t CHUNK_CNT = (SLOT_MASK + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    struct Slot
+    {
+        std::atomic<uint32_t> handle{0}; /**< live handle, 0: free */
+        std::atomic<T*> obj{nullptr};
+        uint32_t gen = 0;
+    };
+
+private:
+    std::atomic<Slot*> m_chunks[CHUNK_CNT];
+    std::deque<uint32_t> m_free;
+    uint32_t m_next = 0;
+    uint32_t m_cnt = 0;
+
+private:
+    Slot *get_slot(uint32_t handle) const
+    {
+        uint32_t idx = (handle & SLOT_MASK) - 1;
+        Slot *chunk = nullptr;
+
+        if ((handle & SLOT_MASK) == 0)
+            return nullptr;
+
+        chunk = m_chunks[idx >> CHUNK_BITS].load(std::memory_order_acquire);
+        if (chunk == nullptr)
+            return nullptr;
+
+        return &chunk[idx & (CHUNK_SIZE - 1)];
+    }
+
+public:
+    /**
+     * @brief take a free slot for obj (nullptr just pins the handle)
+     *
+     * @retval handle, 0 if MAX_CNT handles are live already
+     */
+    uint32_t alloc(T *obj)
+    {
+        uint32_t idx = 0;
+        Slot *slot = nullptr;
+        uint32_t handle = 0;
+
+        /* FIFO reuse keeps stale handles away from their slot for long */
+        if (!m_free.empty())
+        {
+            idx = m_free.front();
+            m_free.pop_front();
+        } else if (m_next < SLOT_MASK) {
+            idx = m_next++;
+            if ((idx & (CHUNK_SIZE - 1)) == 0)
+                m_chunks[idx >> CHUNK_BITS].store(new Slot[CHUNK_SIZE], std::memory_order_release);
+        } else {
+            return 0;
+        }
+
+        slot = &m_chunks[idx >> CHUNK_BITS].load(std::memory_order_relaxed)[idx & (CHUNK_SIZE - 1)];
+        handle = ((slot->gen & SLOT_MASK) << SLOT_BITS) | (idx + 1);
+        slot->obj.store(obj, std::memory_order_relaxed);
+        slot->handle.store(handle, std::memory_order_release);
+        m_cnt++;
+        return handle;
+    }
+
+    void set(uint32_t handle, T *obj)
+    {
+        Slot *slot = get_slot(handle);
+
+        if ((slot != nullptr) && (slot->handle.load(std::memory_order_relaxed) == handle))
+            slot->obj.store(obj, std::memory_order_release);
+    }
+
+    T *get(uint32_t handle) const
+    {
+        Slot *slot = get_slot(handle);
+        T *obj = nullptr;
+
+        if ((slot == nullptr) || (slot->handle.load(std::memory_order_acquire) != handle))
+            return nullptr;
+
+        obj = slot->obj.load(std::memory_order_acquire);
+
+        /* released and reused in between */
+        if (slot->handle.load(std::memory_order_acquire) != handle)
+            return nullptr;
+
+        return obj;
+    }
+
+    bool contains(uint32_t handle) const
+    {
+        Slot *slot = get_slot(handle);
+
+        return (slot != nullptr) && (slot->handle.load(std::memory_order_acquire) == handle);
+    }
+
+    T *release(uint32_t handle)
+    {
+        Slot *slot = get_slot(handle);
+        T *obj = nullptr;
+
+        if ((slot == nullptr) || (slot->handle.load(std::memory_order_relaxed) != handle))
+            return nullptr;
+
+        slot->handle.store(0, std::memory_order_release);
+        obj = slot->obj.exchange(nullptr, std::memory_order_acq_rel);
+        slot->gen++;
+        m_free.push_back((handle & SLOT_MASK) - 1);
+        m_cnt--;
+        return obj;
+    }
+
+    uint32_t size() const
+    {
+        return m_cnt;
+    }
+
+    /**
+     * @brief <handle, object> of all live slots, pinned slots included
+     */
+    std::vector<std::pair<uint32_t, T*>> entries() const
+    {
+        std::vector<std::pair<uint32_t, T*>> ret;
+
+        for (uint32_t idx = 0; idx < m_next; idx++)
+        {
+            Slot &slot = m_chunks[idx >> CHUNK_BITS].load(std::memory_order_relaxed)[idx & (CHUNK_SIZE - 1)];
+            uint32_t handle = slot.handle.load(std::memory_order_relaxed);
+
+            if (handle != 0)
+                ret.push_back(std::make_pair(handle, slot.obj.load(std::memory_order_relaxed)));
+        }
+
+        return ret;
+    }
+
+public:
+    HandleTable()
+    {
+        for (uint32_t i = 0; i < CHUNK_CNT; i++)
+            m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    ~HandleTable()
+    {
+        for (uint32_t i = 0; i < CHUNK_CNT; i++)
+            delete[] m_chunks[i].load(std::memory_order_relaxed);
+    }
+    HandleTable(const HandleTable& table) = delete;
+    HandleTable& operator=(const HandleTable& table) = delete;
+};
+}
+
+#endif /* _HANDLE_TABLE_H_ */
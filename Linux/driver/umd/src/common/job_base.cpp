@@ -9,10 +9,15 @@
  */
 
 #include <cstring>
+#include <algorithm>
 #include <unistd.h>
 #include <sys/mman.h>
 #include "job_base.h"
+#include "weight_residency.h"
+#include "kmd/tcb.h"
 #include "utils/helper.h"
+#include "utils/quant.h"
+#include "utils/layout.h"
 
 #define DUMP_RO_ENTRY 0
 
@@ -30,6 +35,7 @@ aipudrv::JobBase::JobBase(MainContext* ctx, GraphBase& graph, DeviceBase* dev):
 
 aipudrv::JobBase::~JobBase()
 {
+    release_weights();
 #if DUMP_RO_ENTRY
     m_ro_entry_dump.close();
 #endif
@@ -54,11 +60,19 @@ aipu_status_t aipudrv::JobBase::get_status(aipu_job_status_t* status)
     if (jobs_status.size() != 0)
         m_status = jobs_status[0].state;
 
+    if ((m_status == AIPU_JOB_STATUS_DONE) && wt_grid_pending())
+    {
+        ret = next_grid();
+        if (ret != AIPU_STATUS_SUCCESS)
+            return ret;
+    }
+
     if ((m_status == AIPU_JOB_STATUS_DONE) || (m_status == AIPU_JOB_STATUS_EXCEPTION))
     {
         *status = (aipu_job_status_t)m_status;
         dump_job_private_buffers_after_run(*m_rodata, m_descriptor);
         dump_job_shared_buffers_after_run();
+        release_weights();
     } else {
         *status = AIPU_JOB_STATUS_NO_STATUS;
     }
@@ -68,6 +82,8 @@ aipu_status_t aipudrv::JobBase::get_status(aipu_job_status_t* status)
 
 aipu_status_t aipudrv::JobBase::get_status_blocking(aipu_job_status_t* status, int32_t time_out)
 {
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_WAIT);
+
     if (get_subgraph_cnt() == 0)
     {
         m_status = AIPU_JOB_STATE_DONE;
@@ -76,10 +92,19 @@ aipu_status_t aipudrv::JobBase::get_status_blocking(aipu_job_status_t* status, i
         if (job_callback_func != nullptr)
             job_callback_func(get_id(), (aipu_job_status_t)m_status);
     } else {
-        aipu_status_t ret = convert_ll_status(m_dev->poll_status(1, time_out,
-            m_hw_cfg->poll_in_commit_thread, this));
-        if (ret != AIPU_STATUS_SUCCESS)
-            return ret;
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        uint32_t grid = 0;
+
+        /* a done grid goes on with the next one in update_job_status() */
+        do
+        {
+            grid = m_wt_grid;
+            ret = convert_ll_status(m_dev->poll_status(1, time_out,
+                m_hw_cfg->poll_in_commit_thread, this));
+            if (ret != AIPU_STATUS_SUCCESS)
+                return ret;
+        } while ((m_wt_grid != grid) && (m_status == AIPU_JOB_STATUS_SCHED));
 
         ret = parse_dynamic_out_shape();
         if (ret != AIPU_STATUS_SUCCESS)
@@ -95,6 +120,7 @@ aipu_status_t aipudrv::JobBase::get_status_blocking(aipu_job_status_t* status, i
         {
             m_dev->dump_profiling();
         }
+        release_weights();
     } else {
         *status = AIPU_JOB_STATUS_NO_STATUS;
     }
@@ -102,8 +128,112 @@ aipu_status_t aipudrv::JobBase::get_status_blocking(aipu_job_status_t* status, i
     return get_runtime_err_code();
 }
 
+void aipudrv::JobBase::trace_create(uint64_t begin_ns)
+{
+    JobTrace::record(JOB_TRACE_CREATE_JOB, begin_ns, JobTrace::now(), m_id, get_part_id());
+
+    /* init phases are recorded here as the job id is only known after init */
+    for (uint32_t event = JOB_TRACE_INIT_ALLOC; event <= JOB_TRACE_INIT_TCB; event++)
+    {
+        uint64_t ns = get_init_phase_ns(event);
+
+        if (ns != 0)
+            JobTrace::record(event, m_trace_init_ns[event - JOB_TRACE_INIT_ALLOC],
+                m_trace_init_ns[event - JOB_TRACE_INIT_ALLOC] + ns, m_id, get_part_id());
+    }
+}
+
+uint64_t aipudrv::JobBase::get_init_phase_ns(uint32_t event) const
+{
+    const uint32_t end_idx = JOB_TRACE_INIT_TCB - JOB_TRACE_INIT_ALLOC + 1;
+    uint32_t i = event - JOB_TRACE_INIT_ALLOC;
+    uint64_t end_ns = 0;
+
+    if ((event < JOB_TRACE_INIT_ALLOC) || (event > JOB_TRACE_INIT_TCB) ||
+        (m_trace_init_ns[i] == 0))
+        return 0;
+
+    /* a phase ends where the next recorded one begins */
+    for (uint32_t j = i + 1; (j <= end_idx) && (end_ns == 0); j++)
+        end_ns = m_trace_init_ns[j];
+
+    return (end_ns != 0) ? end_ns - m_trace_init_ns[i] : 0;
+}
+
+/**
+ * @brief called right before the job is committed to the device, a poller may
+ *        observe it done before the commit returns
+ */
+void aipudrv::JobBase::mark_commit()
+{
+    Metrics *metrics = get_metrics();
+
+    UMD_USDT3(job_schedule, m_id, get_part_id(), get_qos());
+    m_trace_commit_ns = JobTrace::enabled() ? JobTrace::now() : 0;
+    if (metrics != nullptr)
+        metrics->commit(get_qos(), get_part_id());
+    m_graph.get_job_counters().scheduled(get_qos());
+    m_committed = true;
+}
+
+/**
+ * @brief the device rejected the commit, the job is accounted as failed
+ */
+void aipudrv::JobBase::cancel_commit()
+{
+    m_trace_commit_ns = 0;
+    if (m_committed)
+        end_commit(true);
+}
+
+/**
+ * @brief the device reports the job or, with on-demand weight, its current grid
+ *        ended with 'status'
+ *
+ * @note  a done grid commits the next one right here so that a job goes on in
+ *        whichever thread polls the device, the job is done after its last grid.
+ */
+void aipudrv::JobBase::update_job_status(uint32_t status)
+{
+    if ((status == AIPU_JOB_STATUS_DONE) && wt_grid_pending())
+    {
+        next_grid();
+        return;
+    }
+
+    m_status = status;
+    if (m_committed)
+        mark_done();
+}
+
+void aipudrv::JobBase::mark_done()
+{
+    if ((m_status != AIPU_JOB_STATUS_DONE) && (m_status != AIPU_JOB_STATUS_EXCEPTION))
+        return;
+
+    if ((m_trace_commit_ns != 0) && JobTrace::enabled())
+        JobTrace::record(JOB_TRACE_NPU_EXEC, m_trace_commit_ns, JobTrace::now(),
+            m_id, get_part_id());
+    m_trace_commit_ns = 0;
+    end_commit(m_status == AIPU_JOB_STATUS_EXCEPTION);
+}
+
+void aipudrv::JobBase::end_commit(bool exception)
+{
+    Metrics *metrics = get_metrics();
+
+    UMD_USDT3(job_done, m_id, get_part_id(), exception);
+    m_committed = false;
+    if (metrics != nullptr)
+        metrics->done(get_qos(), get_part_id(), exception);
+    m_graph.get_job_counters().done(get_qos(), exception);
+}
+
 aipu_status_t aipudrv::JobBase::load_tensor(uint32_t tensor, const void* data)
 {
+  JobTraceSpan span(JOB_TRACE_LOAD_TENSOR, m_id, get_part_id());
+  LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_COPY);
+
   if (nullptr == data)
     return AIPU_STATUS_ERROR_NULL_PTR;
 
@@ -156,6 +286,8 @@ aipu_status_t aipudrv::JobBase::get_tensor(aipu_tensor_type_t type, uint32_t ten
     uint64_t size = 0;
     uint32_t isa = AIPU_ISA_VERSION_ZHOUYI_V1;
     std::vector<struct JobIOBuffer> *iobuffer_vec = nullptr;
+    JobTraceSpan span(JOB_TRACE_GET_TENSOR, m_id, get_part_id());
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_COPY);
 
     if (nullptr == data)
         return AIPU_STATUS_ERROR_NULL_PTR;
@@ -231,6 +363,471 @@ aipu_status_t aipudrv::JobBase::get_tensor(aipu_tensor_type_t type, uint32_t ten
     return AIPU_STATUS_SUCCESS;
 }
 
+/**
+ * @brief host address of an IO buffer, a dma_buf is mapped and returned in 'map'
+ *        for the caller to unmap
+ */
+aipu_status_t aipudrv::JobBase::get_io_buffer_va(struct JobIOBuffer &buf, char **va, char **map)
+{
+    *map = nullptr;
+    if (buf.dmabuf_fd < 0)
+    {
+        if (m_mem->pa_to_va(buf.pa, buf.size, va) != 0)
+            return AIPU_STATUS_ERROR_INVALID_OP;
+    } else {
+        *map = (char *)mmap(NULL, buf.dmabuf_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            buf.dmabuf_fd, 0);
+        if (MAP_FAILED == *map)
+        {
+            *map = nullptr;
+            LOG(LOG_ERR, "%s: mmap dma_buf fail\n", __FUNCTION__);
+            return AIPU_STATUS_ERROR_MAP_FILE_FAIL;
+        }
+        *va = *map + buf.offset_in_dmabuf;
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+/**
+ * @brief quantize/dequantize float data or pack/unpack 4/12-bit data straight
+ *        between the caller and the tensor mapping, so no intermediate tensor
+ *        typed copy is made
+ */
+aipu_status_t aipudrv::JobBase::quant_io_buffer(aipu_tensor_type_t type, uint32_t tensor,
+    struct JobIOBuffer &buf, void *data, bool load, bool is_float)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipu_tensor_desc_t desc;
+    uint64_t cnt = 0;
+    char *va = nullptr;
+    char *map = nullptr;
+
+    ret = m_graph.get_tensor_descriptor(type, tensor, &desc);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    cnt = umd_quant_elem_cnt(desc.data_type, buf.size);
+    if (cnt == 0)
+        return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+
+    ret = get_io_buffer_va(buf, &va, &map);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    if (is_float && load)
+        ret = umd_quantize((const float *)data, va, cnt, desc.data_type, desc.scale, desc.zero_point);
+    else if (is_float)
+        ret = umd_dequantize(va, (float *)data, cnt, desc.data_type, desc.scale, desc.zero_point);
+    else if (load)
+        ret = umd_pack(data, va, cnt, desc.data_type);
+    else
+        ret = umd_unpack(va, data, cnt, desc.data_type);
+
+    if (map != nullptr)
+        munmap(map, buf.dmabuf_size);
+
+    return ret;
+}
+
+/**
+ * @brief strided copy straight between the caller buffer and the tensor mapping,
+ *        so a layout transform needs no staging buffer
+ */
+aipu_status_t aipudrv::JobBase::copy_io_layout(struct JobIOBuffer &buf, void *data,
+    const aipu_tensor_copy_t *copy, bool load)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    char *va = nullptr;
+    char *map = nullptr;
+
+    ret = umd_check_tensor_copy(copy, buf.size);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    ret = get_io_buffer_va(buf, &va, &map);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    va += copy->tensor_offset;
+    if (load)
+        umd_strided_copy((const char *)data, copy->host_strides, va, copy->tensor_strides,
+            copy->shape, copy->dim_cnt, copy->elem_size);
+    else
+        umd_strided_copy(va, copy->tensor_strides, (char *)data, copy->host_strides,
+            copy->shape, copy->dim_cnt, copy->elem_size);
+
+    if (map != nullptr)
+        munmap(map, buf.dmabuf_size);
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::JobBase::load_tensor_layout(uint32_t tensor, const void* data,
+    const aipu_tensor_copy_t* copy)
+{
+    if ((nullptr == data) || (nullptr == copy))
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (tensor >= m_inputs.size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    /* Applications cannot load tensors if a job is not in the to-be-scheduled status */
+    if ((m_status != AIPU_JOB_STATUS_INIT) &&
+        (m_status != AIPU_JOB_STATUS_DONE) &&
+        (m_status != AIPU_JOB_STATUS_BIND))
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    return copy_io_layout(m_inputs[tensor], (void *)data, copy, true);
+}
+
+aipu_status_t aipudrv::JobBase::get_tensor_layout(aipu_tensor_type_t type, uint32_t tensor,
+    void* data, const aipu_tensor_copy_t* copy)
+{
+    std::vector<struct JobIOBuffer> *iobuffer_vec = nullptr;
+
+    if ((nullptr == data) || (nullptr == copy))
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    /* Applications cannot get tensors if a job is not done status */
+    if (m_status != AIPU_JOB_STATUS_DONE)
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (type == AIPU_TENSOR_TYPE_INPUT)
+        iobuffer_vec = &m_inputs;
+    else if (type == AIPU_TENSOR_TYPE_OUTPUT)
+        iobuffer_vec = &m_outputs;
+    else
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (tensor >= iobuffer_vec->size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    return copy_io_layout(iobuffer_vec->at(tensor), data, copy, false);
+}
+
+/**
+ * @brief decode the profiler buffer of this run into the profile report of the graph
+ */
+aipu_status_t aipudrv::JobBase::add_profile_run(const aipu_profile_layout_t* layout,
+    uint32_t* layer_cnt)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::vector<ProfileSample> samples;
+    std::vector<char> data;
+    ProfileRegions regions;
+
+    if (m_status != AIPU_JOB_STATUS_DONE)
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (m_profiler.empty())
+    {
+        LOG(LOG_ERR, "graph has no profiler buffer\n");
+        return AIPU_STATUS_ERROR_INVALID_OP;
+    }
+
+    data.resize(m_profiler[0].size);
+    if (m_profiler[0].dmabuf_fd < 0)
+        m_mem->read(m_profiler[0].pa, data.data(), data.size());
+    else
+        readwrite_dma_buf(m_profiler[0], data.data(), true);
+
+    m_graph.get_profile_regions(regions);
+    ret = decode_profile(data.data(), data.size(), regions, layout, samples);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    m_graph.get_profile_report().add(samples);
+    *layer_cnt = samples.size();
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::JobBase::set_printf_stream(aipu_printf_stream_t* stream)
+{
+    DEV_PA_64 pa = 0;
+
+    stream->lost_bytes = 0;
+    if (m_printf_stream != nullptr)
+    {
+        stream->lost_bytes = m_printf_stream->stop();
+        m_printf_stream.reset();
+    }
+
+    if (stream->sink == nullptr)
+        return AIPU_STATUS_SUCCESS;
+
+    if (m_printf.empty())
+    {
+        LOG(LOG_ERR, "graph has no printf buffer\n");
+        return AIPU_STATUS_ERROR_INVALID_OP;
+    }
+
+    /* reading a dma_buf maps it as a whole, which defeats polling the new text only */
+    if (m_printf[0].dmabuf_fd >= 0)
+        return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+
+    pa = m_printf[0].pa;
+    m_printf_stream.reset(new PrintfStream(
+        [this, pa](uint32_t offset, char *dest, uint32_t size) {
+            m_mem->read(pa + offset, dest, size);
+        }, m_printf[0].size, stream));
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::JobBase::load_tensor_float(uint32_t tensor, const float* data)
+{
+    if (nullptr == data)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (tensor >= m_inputs.size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    /* Applications cannot load tensors if a job is not in the to-be-scheduled status */
+    if ((m_status != AIPU_JOB_STATUS_INIT) &&
+        (m_status != AIPU_JOB_STATUS_DONE) &&
+        (m_status != AIPU_JOB_STATUS_BIND))
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    return quant_io_buffer(AIPU_TENSOR_TYPE_INPUT, tensor, m_inputs[tensor],
+        (void *)data, true, true);
+}
+
+aipu_status_t aipudrv::JobBase::get_tensor_float(aipu_tensor_type_t type, uint32_t tensor,
+    float* data)
+{
+    std::vector<struct JobIOBuffer> *iobuffer_vec = nullptr;
+
+    if (nullptr == data)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    /* Applications cannot get tensors if a job is not done status */
+    if (m_status != AIPU_JOB_STATUS_DONE)
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    /* only input/output tensors carry quantization parameters */
+    if (type == AIPU_TENSOR_TYPE_INPUT)
+        iobuffer_vec = &m_inputs;
+    else if (type == AIPU_TENSOR_TYPE_OUTPUT)
+        iobuffer_vec = &m_outputs;
+    else
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (tensor >= iobuffer_vec->size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    return quant_io_buffer(type, tensor, iobuffer_vec->at(tensor), data, false, true);
+}
+
+aipu_status_t aipudrv::JobBase::load_tensor_unpacked(uint32_t tensor, const void* data)
+{
+    if (nullptr == data)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (tensor >= m_inputs.size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    /* Applications cannot load tensors if a job is not in the to-be-scheduled status */
+    if ((m_status != AIPU_JOB_STATUS_INIT) &&
+        (m_status != AIPU_JOB_STATUS_DONE) &&
+        (m_status != AIPU_JOB_STATUS_BIND))
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    return quant_io_buffer(AIPU_TENSOR_TYPE_INPUT, tensor, m_inputs[tensor],
+        (void *)data, true, false);
+}
+
+aipu_status_t aipudrv::JobBase::get_tensor_unpacked(aipu_tensor_type_t type, uint32_t tensor,
+    void* data)
+{
+    std::vector<struct JobIOBuffer> *iobuffer_vec = nullptr;
+
+    if (nullptr == data)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    /* Applications cannot get tensors if a job is not done status */
+    if (m_status != AIPU_JOB_STATUS_DONE)
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (type == AIPU_TENSOR_TYPE_INPUT)
+        iobuffer_vec = &m_inputs;
+    else if (type == AIPU_TENSOR_TYPE_OUTPUT)
+        iobuffer_vec = &m_outputs;
+    else
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if (tensor >= iobuffer_vec->size())
+        return AIPU_STATUS_ERROR_INVALID_TENSOR_ID;
+
+    return quant_io_buffer(type, tensor, iobuffer_vec->at(tensor), data, false, false);
+}
+
+static bool iov_match_tensors(const std::vector<struct aipudrv::JobIOBuffer> &bufs,
+    const struct iovec *iov, uint32_t iov_cnt)
+{
+    uint64_t iov_size = 0;
+    uint64_t tensor_size = 0;
+
+    for (uint32_t i = 0; i < iov_cnt; i++)
+        iov_size += iov[i].iov_len;
+
+    for (auto &buf : bufs)
+        tensor_size += buf.size;
+
+    return iov_size == tensor_size;
+}
+
+/**
+ * @brief copy between the tensors and caller segments in order as if both
+ *        were concatenated, a segment with null base skips its length.
+ *        a dma_buf is mapped once and kept in 'dmabuf_va' for the caller
+ *        to unmap.
+ */
+aipu_status_t aipudrv::JobBase::copy_io_iov(std::vector<struct JobIOBuffer> &bufs,
+    const struct iovec *iov, uint32_t iov_cnt, bool read,
+    std::map<int, std::pair<char*, uint32_t>> &dmabuf_va)
+{
+    uint32_t tensor = 0;
+    uint64_t offset = 0;
+    JobTraceSpan span(read ? JOB_TRACE_GET_TENSOR : JOB_TRACE_LOAD_TENSOR, m_id, get_part_id());
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_COPY);
+
+    for (uint32_t i = 0; i < iov_cnt; i++)
+    {
+        char *base = (char *)iov[i].iov_base;
+        uint64_t left = iov[i].iov_len;
+
+        while (left > 0)
+        {
+            struct JobIOBuffer &buf = bufs[tensor];
+            uint64_t len = std::min(left, (uint64_t)buf.size - offset);
+
+            if (base != nullptr)
+            {
+                if (buf.dmabuf_fd < 0)
+                {
+                    if (read)
+                        m_mem->read(buf.pa + offset, base, len);
+                    else
+                        m_mem->write(buf.pa + offset, base, len);
+                } else {
+                    char *va = nullptr;
+
+                    if (dmabuf_va.count(buf.dmabuf_fd) == 0)
+                    {
+                        va = (char *)mmap(NULL, buf.dmabuf_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, buf.dmabuf_fd, 0);
+                        if (MAP_FAILED == va)
+                        {
+                            LOG(LOG_ERR, "%s: mmap dma_buf fail\n", __FUNCTION__);
+                            return AIPU_STATUS_ERROR_MAP_FILE_FAIL;
+                        }
+                        dmabuf_va[buf.dmabuf_fd] = std::make_pair(va, buf.dmabuf_size);
+                    }
+
+                    va = dmabuf_va[buf.dmabuf_fd].first + buf.offset_in_dmabuf + offset;
+                    if (read)
+                        memcpy(base, va, len);
+                    else
+                        memcpy(va, base, len);
+                }
+                base += len;
+            }
+
+            left -= len;
+            offset += len;
+            if (offset == buf.size)
+            {
+                tensor++;
+                offset = 0;
+            }
+        }
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+/**
+ * @brief load inputs, schedule, wait and fetch outputs in one call. the
+ *        outputs come either as one buffer per tensor or as segments, the
+ *        per tensor sizes are final only once a dynamic shape job is done.
+ */
+aipu_status_t aipudrv::JobBase::run_inner(const struct iovec *inputs, uint32_t input_cnt,
+    void* const outputs[], const struct iovec *out_iov, uint32_t output_cnt, int32_t time_out)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipu_job_status_t status = AIPU_JOB_STATUS_NO_STATUS;
+    std::map<int, std::pair<char*, uint32_t>> dmabuf_va;
+    std::vector<struct iovec> iov;
+
+    if ((m_status != AIPU_JOB_STATUS_INIT) &&
+        (m_status != AIPU_JOB_STATUS_DONE) &&
+        (m_status != AIPU_JOB_STATUS_BIND))
+        return AIPU_STATUS_ERROR_INVALID_OP;
+
+    if ((input_cnt != 0) && !iov_match_tensors(m_inputs, inputs, input_cnt))
+        return AIPU_STATUS_ERROR_INVALID_SIZE;
+
+    ret = copy_io_iov(m_inputs, inputs, input_cnt, false, dmabuf_va);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    ret = schedule();
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    ret = get_status_blocking(&status, time_out <= 0 ? -1 : time_out);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    if (status != AIPU_JOB_STATUS_DONE)
+    {
+        ret = AIPU_STATUS_ERROR_JOB_EXCEPTION;
+        goto finish;
+    }
+
+    if (outputs != nullptr)
+    {
+        for (uint32_t i = 0; i < m_outputs.size(); i++)
+            iov.push_back({outputs[i], m_outputs[i].size});
+        out_iov = iov.data();
+        output_cnt = iov.size();
+    } else if ((output_cnt != 0) && !iov_match_tensors(m_outputs, out_iov, output_cnt)) {
+        ret = AIPU_STATUS_ERROR_INVALID_SIZE;
+        goto finish;
+    }
+
+    ret = copy_io_iov(m_outputs, out_iov, output_cnt, true, dmabuf_va);
+
+finish:
+    for (auto &iter : dmabuf_va)
+        munmap(iter.second.first, iter.second.second);
+
+    return ret;
+}
+
+aipu_status_t aipudrv::JobBase::run(const void* const inputs[], void* const outputs[],
+    int32_t time_out)
+{
+    std::vector<struct iovec> in_iov;
+
+    if (inputs != nullptr)
+    {
+        for (uint32_t i = 0; i < m_inputs.size(); i++)
+            in_iov.push_back({(void *)inputs[i], m_inputs[i].size});
+    }
+
+    return run_inner(in_iov.data(), in_iov.size(), outputs, nullptr, 0, time_out);
+}
+
+aipu_status_t aipudrv::JobBase::run_iov(const struct iovec *inputs, uint32_t input_cnt,
+    const struct iovec *outputs, uint32_t output_cnt, int32_t time_out)
+{
+    if (((inputs == nullptr) && (input_cnt != 0)) || ((outputs == nullptr) && (output_cnt != 0)))
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    return run_inner(inputs, input_cnt, nullptr, outputs, output_cnt, time_out);
+}
+
 aipu_status_t aipudrv::JobBase::setup_rodata(
     const std::vector<struct GraphParamMapLoadDesc>& param_map,
     const std::vector<BufferDesc*>& reuse_buf,
@@ -745,3 +1342,101 @@ aipu_status_t aipudrv::JobBase::validate_schedule_status()
 
     return AIPU_STATUS_ERROR_INVALID_OP;
 }
+
+/**
+ * @brief make the on-demand BSS weight of grid m_wt_grid resident, point its
+ *        init TCB ASID1 base to where the BSS locates for this run and start
+ *        uploading the BSS of the next grid.
+ */
+aipu_status_t aipudrv::JobBase::acquire_weights()
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    Graph &graph = get_graph();
+    WeightGrid *grid = nullptr;
+    DEV_PA_64 asid_base = 0;
+    uint32_t asid[2] = {0};
+
+    if (m_wt_grid >= m_wt_grids.size())
+        return ret;
+
+    grid = &m_wt_grids[m_wt_grid];
+    if (!m_wt_acquired)
+    {
+        ret = graph.m_wt_residency->acquire(&graph, grid->bss_id);
+        if (ret != AIPU_STATUS_SUCCESS)
+            return ret;
+        m_wt_acquired = true;
+    }
+
+    /* the BSS is pinned, its buffer stays until release_weights() */
+    asid_base = graph.get_WeightBufferInfo(grid->bss_id).wb_asid_base;
+    asid[0] = get_low_32(asid_base) | ASID_RD | ASID_WR;
+    asid[1] = get_high_32(asid_base);
+    for (auto slot : grid->asid_slots)
+        m_mem->write(slot, (const char *)asid, sizeof(asid));
+
+    prefetch_weights(m_wt_grid + 1);
+    return ret;
+}
+
+void aipudrv::JobBase::release_weights()
+{
+    if (!m_wt_acquired)
+        return;
+
+    get_graph().m_wt_residency->release(&get_graph(), m_wt_grids[m_wt_grid].bss_id);
+    m_wt_acquired = false;
+}
+
+/**
+ * @brief append subgraph 'sg_id' to the grid list, subgraphs are added in
+ *        order and consecutive ones referring the same BSS share a grid.
+ */
+void aipudrv::JobBase::add_wt_grid_sg(uint32_t sg_id, uint32_t bss_id)
+{
+    if (m_wt_grids.empty() || (m_wt_grids.back().bss_id != bss_id))
+        m_wt_grids.push_back({bss_id, sg_id, 0, 0, 0, {}});
+
+    m_wt_grids.back().sg_cnt++;
+}
+
+aipudrv::JobBase::WeightGrid *aipudrv::JobBase::get_wt_grid(uint32_t sg_id)
+{
+    for (auto &grid : m_wt_grids)
+    {
+        if ((sg_id >= grid.sg_start) && (sg_id < grid.sg_start + grid.sg_cnt))
+            return &grid;
+    }
+
+    return nullptr;
+}
+
+void aipudrv::JobBase::prefetch_weights(uint32_t grid)
+{
+    if (grid < m_wt_grids.size())
+        get_graph().m_wt_residency->prefetch(&get_graph(), m_wt_grids[grid].bss_id);
+}
+
+/**
+ * @brief grid m_wt_grid is done, run the next one in its place
+ *
+ * @note  the job stays in AIPU_JOB_STATUS_SCHED until the last grid is done,
+ *        it ends with AIPU_JOB_STATUS_EXCEPTION if a grid can't be committed.
+ */
+aipu_status_t aipudrv::JobBase::next_grid()
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+    release_weights();
+    m_wt_grid++;
+
+    ret = schedule_grid();
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        LOG(LOG_ERR, "job 0x%lx schedule grid %u [fail]\n", m_id, m_wt_grid);
+        m_status = AIPU_JOB_STATUS_EXCEPTION;
+        cancel_commit();
+    }
+
+    return ret;
+}
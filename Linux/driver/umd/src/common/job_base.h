@@ -13,12 +13,18 @@
 
 #include <vector>
 #include <tuple>
+#include <map>
+#include <memory>
 #include <pthread.h>
+#include <sys/uio.h>
 #include "standard_api.h"
 #include "context.h"
 #include "graph.h"
 #include "device_base.h"
 #include "memory_base.h"
+#include "job_trace.h"
+#include "printf_stream.h"
+#include "utils/usdt.h"
 #include "type.h"
 
 namespace aipudrv
@@ -139,6 +145,40 @@ protected:
      */
     bool m_optimized_reuse_alloc = false;
 
+    /**
+     * with on-demand weight, the subgraphs referring one BSS run as a TCB
+     * chain of their own, so that only the BSS of the running grid is pinned
+     * and the next one can be uploaded meanwhile. empty for other graphs.
+     */
+    struct WeightGrid
+    {
+        uint32_t bss_id;
+        uint32_t sg_start;
+        uint32_t sg_cnt;
+        DEV_PA_64 head_pa; /* init TCB */
+        DEV_PA_64 tail_pa; /* last task TCB */
+
+        /* ASID1 base in the init TCBs, patched on schedule */
+        std::vector<DEV_PA_64> asid_slots;
+    };
+    std::vector<WeightGrid> m_wt_grids;
+    uint32_t m_wt_grid = 0;
+    bool m_wt_acquired = false;
+
+    /**
+     * job trace timestamps, 0 if not recorded: start of the init phases
+     * JOB_TRACE_INIT_ALLOC..JOB_TRACE_INIT_TCB and init end, commit of the
+     * latest schedule
+     */
+    uint64_t m_trace_init_ns[JOB_TRACE_INIT_TCB - JOB_TRACE_INIT_ALLOC + 2] = {0};
+    uint64_t m_trace_commit_ns = 0;
+
+    /* committed to the device and not seen done yet, for the metrics */
+    bool m_committed = false;
+
+    /* reader thread of the printf buffer, see aipu_printf_stream_t */
+    std::unique_ptr<PrintfStream> m_printf_stream;
+
 protected:
     const aipu_global_config_simulation_t *m_cfg = nullptr;
     const aipu_global_config_hw_t *m_hw_cfg = nullptr;
@@ -179,11 +219,59 @@ protected:
     void dump_single_buffer(DEV_PA_64 pa, uint32_t size, const char* name);
     void dump_share_buffer(struct JobIOBuffer &iobuf, const char* name, bool keep_name = false);
     int readwrite_dma_buf(struct JobIOBuffer &iobuf, void *data, bool read = true);
+    aipu_status_t copy_io_iov(std::vector<struct JobIOBuffer> &bufs, const struct iovec *iov,
+        uint32_t iov_cnt, bool read, std::map<int, std::pair<char*, uint32_t>> &dmabuf_va);
+    aipu_status_t run_inner(const struct iovec *inputs, uint32_t input_cnt,
+        void* const outputs[], const struct iovec *out_iov, uint32_t output_cnt, int32_t time_out);
     void dump_job_shared_buffers();
     void dump_job_private_buffers(BufferDesc& rodata, BufferDesc* descriptor);
     void dump_job_shared_buffers_after_run();
     void dump_job_private_buffers_after_run(BufferDesc& rodata, BufferDesc* descriptor);
     aipu_status_t validate_schedule_status();
+    aipu_status_t get_io_buffer_va(struct JobIOBuffer &buf, char **va, char **map);
+    aipu_status_t quant_io_buffer(aipu_tensor_type_t type, uint32_t tensor,
+        struct JobIOBuffer &buf, void *data, bool load, bool is_float);
+    aipu_status_t copy_io_layout(struct JobIOBuffer &buf, void *data,
+        const aipu_tensor_copy_t *copy, bool load);
+    aipu_status_t acquire_weights();
+    void release_weights();
+    void prefetch_weights(uint32_t grid);
+    aipu_status_t next_grid();
+    void add_wt_grid_sg(uint32_t sg_id, uint32_t bss_id);
+    WeightGrid *get_wt_grid(uint32_t sg_id);
+
+    /**
+     * @brief commit grid m_wt_grid of a job with on-demand weight
+     */
+    virtual aipu_status_t schedule_grid()
+    {
+        return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+    }
+    void trace_init_phase(uint32_t event)
+    {
+        /* the job ID isn't allocated during init */
+        UMD_USDT2(job_init_phase, m_graph.get_id(), event - JOB_TRACE_INIT_ALLOC);
+        if (JobTrace::enabled())
+            m_trace_init_ns[event - JOB_TRACE_INIT_ALLOC] = JobTrace::now();
+    }
+    void trace_init_end()
+    {
+        UMD_USDT2(job_init_phase, m_graph.get_id(), JOB_TRACE_INIT_TCB - JOB_TRACE_INIT_ALLOC + 1);
+        if (JobTrace::enabled())
+            m_trace_init_ns[JOB_TRACE_INIT_TCB - JOB_TRACE_INIT_ALLOC + 1] = JobTrace::now();
+    }
+    Metrics *get_metrics()
+    {
+        return (m_ctx != nullptr) ? &m_ctx->get_metrics() : nullptr;
+    }
+    void stop_printf_stream()
+    {
+        m_printf_stream.reset();
+    }
+    void mark_commit();
+    void cancel_commit();
+    void mark_done();
+    void end_commit(bool exception);
     virtual aipu_status_t get_runtime_err_code() const
     {
         return AIPU_STATUS_SUCCESS;
@@ -197,6 +285,18 @@ public:
     aipu_status_t load_tensor(uint32_t tensor, const void* data);
     aipu_status_t load_output_tensor(uint32_t tensor, const void* data);
     aipu_status_t get_tensor(aipu_tensor_type_t type, uint32_t tensor, void* data);
+    aipu_status_t load_tensor_float(uint32_t tensor, const float* data);
+    aipu_status_t get_tensor_float(aipu_tensor_type_t type, uint32_t tensor, float* data);
+    aipu_status_t load_tensor_unpacked(uint32_t tensor, const void* data);
+    aipu_status_t get_tensor_unpacked(aipu_tensor_type_t type, uint32_t tensor, void* data);
+    aipu_status_t load_tensor_layout(uint32_t tensor, const void* data, const aipu_tensor_copy_t* copy);
+    aipu_status_t get_tensor_layout(aipu_tensor_type_t type, uint32_t tensor, void* data,
+        const aipu_tensor_copy_t* copy);
+    aipu_status_t add_profile_run(const aipu_profile_layout_t* layout, uint32_t* layer_cnt);
+    aipu_status_t set_printf_stream(aipu_printf_stream_t* stream);
+    aipu_status_t run(const void* const inputs[], void* const outputs[], int32_t time_out);
+    aipu_status_t run_iov(const struct iovec *inputs, uint32_t input_cnt,
+        const struct iovec *outputs, uint32_t output_cnt, int32_t time_out);
     virtual aipu_status_t get_status(aipu_job_status_t* status);
     virtual aipu_status_t get_status_blocking(aipu_job_status_t* status, int32_t time_out);
     aipu_status_t config_mem_dump(uint64_t types, const aipu_job_config_dump_t* config);
@@ -234,11 +334,28 @@ public:
         return m_id;
     }
 
-    void update_job_status(uint32_t status)
+    /* grids are left to run after the current one, see m_wt_grids */
+    bool wt_grid_pending() const
     {
-        m_status = status;
+        return m_wt_grid + 1 < m_wt_grids.size();
     }
 
+    void update_job_status(uint32_t status);
+
+    virtual uint32_t get_part_id()
+    {
+        return 0;
+    }
+
+    virtual uint32_t get_qos()
+    {
+        return 0;
+    }
+
+    void trace_create(uint64_t begin_ns);
+    /* duration of an init phase of this job, 0 if the job trace was off */
+    uint64_t get_init_phase_ns(uint32_t event) const;
+
     uint32_t get_job_status()
     {
         return m_status;
@@ -0,0 +1,151 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  job_trace.cpp
+ * @brief AIPU User Mode Driver (UMD) job lifecycle trace implementation
+ */
+
+#include <unistd.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "job_trace.h"
+#include "utils/log.h"
+
+#define JOB_TRACE_RING_SIZE 4096
+
+namespace
+{
+struct TraceRecord
+{
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    uint64_t job_id;
+    uint32_t event;
+    uint32_t partition_id;
+};
+
+struct TraceRing
+{
+    std::atomic<uint64_t> head{0};
+    uint32_t tid = 0;
+    TraceRecord records[JOB_TRACE_RING_SIZE];
+};
+
+/* rings of exited threads are kept until their records are exported */
+std::mutex g_rings_lock;
+std::vector<std::shared_ptr<TraceRing>> g_rings;
+thread_local std::shared_ptr<TraceRing> t_ring;
+
+TraceRing *this_thread_ring()
+{
+    if (t_ring == nullptr)
+    {
+        t_ring = std::make_shared<TraceRing>();
+        t_ring->tid = gettid();
+
+        std::lock_guard<std::mutex> lock_(g_rings_lock);
+        g_rings.push_back(t_ring);
+    }
+
+    return t_ring.get();
+}
+}
+
+std::atomic<bool> aipudrv::JobTrace::m_enabled{false};
+
+void aipudrv::JobTrace::record(uint32_t event, uint64_t begin_ns, uint64_t end_ns,
+    JOB_ID job_id, uint32_t partition_id)
+{
+    TraceRing *ring = this_thread_ring();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    TraceRecord &rec = ring->records[head % JOB_TRACE_RING_SIZE];
+
+    rec.begin_ns = begin_ns;
+    rec.end_ns = end_ns;
+    rec.job_id = job_id;
+    rec.event = event;
+    rec.partition_id = partition_id;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+aipu_status_t aipudrv::JobTrace::dump_json(const char *path)
+{
+    static const char *event_name[JOB_TRACE_MAX] = {
+        "create_job", "init_alloc", "init_rodata", "init_tcb",
+        "load_tensor", "schedule", "npu_exec", "get_tensor"
+    };
+    std::ofstream ofs(path, std::ofstream::out | std::ofstream::trunc);
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    std::vector<TraceRecord> records;
+    bool first = true;
+    char buf[384] = {0};
+
+    if (!ofs.is_open())
+    {
+        LOG(LOG_ERR, "open %s [fail]\n", path);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock_(g_rings_lock);
+        rings = g_rings;
+    }
+
+    ofs << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    for (auto &ring : rings)
+    {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first_idx = (head > JOB_TRACE_RING_SIZE) ? head - JOB_TRACE_RING_SIZE : 0;
+
+        records.clear();
+        for (uint64_t i = first_idx; i < head; i++)
+            records.push_back(ring->records[i % JOB_TRACE_RING_SIZE]);
+
+        /**
+         * the owner thread keeps recording while the ring is copied, drop the
+         * records it may have overwritten meanwhile. the fence keeps the copy
+         * above from being read after the head below.
+         */
+        std::atomic_thread_fence(std::memory_order_acquire);
+        head = ring->head.load(std::memory_order_relaxed);
+        for (uint64_t i = first_idx; i < first_idx + records.size(); i++)
+        {
+            const TraceRecord &rec = records[i - first_idx];
+
+            if ((i + JOB_TRACE_RING_SIZE <= head) || (rec.event >= JOB_TRACE_MAX))
+                continue;
+
+            snprintf(buf, sizeof(buf),
+                "%s\n{\"name\": \"%s\", \"cat\": \"job\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                "\"pid\": %d, \"tid\": %u, \"args\": {\"job_id\": \"0x%lx\", \"graph_id\": \"0x%lx\", "
+                "\"partition_id\": %u}}",
+                first ? "" : ",", event_name[rec.event], rec.begin_ns / 1000.0,
+                (rec.end_ns - rec.begin_ns) / 1000.0, getpid(), ring->tid,
+                (unsigned long)rec.job_id, (unsigned long)job_id2graph_id(rec.job_id),
+                rec.partition_id);
+            ofs << buf;
+            first = false;
+        }
+    }
+    ofs << "\n]}\n";
+
+    /* release the rings of exited threads, their records are out */
+    {
+        std::lock_guard<std::mutex> lock_(g_rings_lock);
+        rings.clear();
+        for (auto iter = g_rings.begin(); iter != g_rings.end();)
+        {
+            if (iter->use_count() == 1)
+                iter = g_rings.erase(iter);
+            else
+                iter++;
+        }
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  job_trace.h
+ * @brief AIPU User Mode Driver (UMD) job lifecycle trace header
+ */
+
+#ifndef _JOB_TRACE_H_
+#define _JOB_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include "standard_api.h"
+#include "type.h"
+
+namespace aipudrv
+{
+typedef enum {
+    JOB_TRACE_CREATE_JOB = 0, /**< graph create_job, job init included */
+    JOB_TRACE_INIT_ALLOC,     /**< job init: buffer allocation and loading */
+    JOB_TRACE_INIT_RODATA,    /**< job init: rodata/dcr, remap and SegMMU setup */
+    JOB_TRACE_INIT_TCB,       /**< job init: TCB chain setup */
+    JOB_TRACE_LOAD_TENSOR,
+    JOB_TRACE_SCHEDULE,
+    JOB_TRACE_NPU_EXEC,       /**< from commit to the moment the completion is observed */
+    JOB_TRACE_GET_TENSOR,
+    JOB_TRACE_MAX
+} job_trace_event_t;
+
+/**
+ * @brief process wide job trace, records go into a ring buffer of the calling
+ *        thread and are exported as Chrome trace-event JSON on demand
+ *
+ * @note  a ring buffer only has one writer, recording takes no lock. the oldest
+ *        records of a thread are overwritten once its ring is full.
+ */
+class JobTrace
+{
+private:
+    static std::atomic<bool> m_enabled;
+
+public:
+    static bool enabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void enable(bool enable)
+    {
+        m_enabled.store(enable, std::memory_order_relaxed);
+    }
+    static void record(uint32_t event, uint64_t begin_ns, uint64_t end_ns,
+        JOB_ID job_id, uint32_t partition_id);
+    static aipu_status_t dump_json(const char *path);
+};
+
+/**
+ * @brief scoped trace of one job event, a no-op if the trace is off on entry
+ */
+class JobTraceSpan
+{
+private:
+    uint32_t m_event;
+    JOB_ID m_job_id;
+    uint32_t m_partition_id;
+    uint64_t m_begin = 0;
+
+public:
+    JobTraceSpan(uint32_t event, JOB_ID job_id, uint32_t partition_id):
+        m_event(event), m_job_id(job_id), m_partition_id(partition_id)
+    {
+        if (JobTrace::enabled())
+            m_begin = JobTrace::now();
+    }
+    ~JobTraceSpan()
+    {
+        if (m_begin != 0)
+            JobTrace::record(m_event, m_begin, JobTrace::now(), m_job_id, m_partition_id);
+    }
+    JobTraceSpan(const JobTraceSpan& span) = delete;
+    JobTraceSpan& operator=(const JobTraceSpan& span) = delete;
+};
+}
+
+#endif /* _JOB_TRACE_H_ */
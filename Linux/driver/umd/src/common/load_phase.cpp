@@ -0,0 +1,120 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  load_phase.cpp
+ * @brief AIPU User Mode Driver (UMD) graph load/unload phase statistics implementation
+ */
+
+#include <fstream>
+#include "load_phase.h"
+#include "utils/log.h"
+#include "utils/usdt.h"
+
+thread_local aipudrv::LoadPhase *aipudrv::LoadPhase::m_current = nullptr;
+
+void aipudrv::LoadPhase::begin(aipu_load_phase_stats_t *stats, uint32_t phase)
+{
+    if ((stats == nullptr) || (phase >= AIPU_LOAD_PHASE_MAX))
+        return;
+
+    m_stats = stats;
+    m_phase = phase;
+    m_outer = m_current;
+    m_start = std::chrono::steady_clock::now();
+    m_active = true;
+    m_current = this;
+    UMD_USDT1(load_phase_begin, phase);
+}
+
+void aipudrv::LoadPhase::end()
+{
+    uint64_t wall_ns = 0;
+
+    if (!m_active)
+        return;
+
+    wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_start).count();
+    m_stats[m_phase].wall_ns += wall_ns;
+    UMD_USDT2(load_phase_end, m_phase, wall_ns);
+    m_current = m_outer;
+    m_active = false;
+}
+
+void aipudrv::LoadPhase::account_alloc(uint64_t size, uint32_t asid, uint32_t region)
+{
+    if (asid >= AIPU_LOAD_STATS_ASID_CNT)
+        asid = 0;
+
+    if (region >= AIPU_LOAD_STATS_REGION_CNT)
+        region = AIPU_MEM_REGION_DEFAULT;
+
+    for (LoadPhase *phase = m_current; phase != nullptr; phase = phase->m_outer)
+    {
+        phase->m_stats[phase->m_phase].alloc_cnt++;
+        phase->m_stats[phase->m_phase].alloc_bytes[asid][region] += size;
+    }
+}
+
+void aipudrv::LoadPhase::account_free(uint64_t size)
+{
+    for (LoadPhase *phase = m_current; phase != nullptr; phase = phase->m_outer)
+    {
+        phase->m_stats[phase->m_phase].free_cnt++;
+        phase->m_stats[phase->m_phase].free_bytes += size;
+    }
+}
+
+void aipudrv::LoadPhase::account_write(uint64_t size)
+{
+    for (LoadPhase *phase = m_current; phase != nullptr; phase = phase->m_outer)
+        phase->m_stats[phase->m_phase].bytes_copied += size;
+}
+
+aipu_status_t aipudrv::dump_load_stats_json(const aipu_graph_load_stats_t *stats)
+{
+    static const char *phase_name[AIPU_LOAD_PHASE_MAX] = {
+        "create_graph", "load", "parse", "extract_gm", "alloc_weight", "unload"
+    };
+    static const char *region_name[AIPU_LOAD_STATS_REGION_CNT] = {
+        "default", "sram", "dtcm"
+    };
+    std::ofstream ofs(stats->json_path, std::ofstream::out | std::ofstream::trunc);
+
+    if (!ofs.is_open())
+    {
+        LOG(LOG_ERR, "open %s [fail]\n", stats->json_path);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    ofs << "{\n    \"graph_id\": " << stats->graph_id << ",\n    \"phases\": {\n";
+    for (uint32_t i = 0; i < AIPU_LOAD_PHASE_MAX; i++)
+    {
+        const aipu_load_phase_stats_t &phase = stats->phases[i];
+
+        ofs << "        \"" << phase_name[i] << "\": {\n"
+            << "            \"wall_ns\": " << phase.wall_ns << ",\n"
+            << "            \"bytes_copied\": " << phase.bytes_copied << ",\n"
+            << "            \"alloc_cnt\": " << phase.alloc_cnt << ",\n"
+            << "            \"free_cnt\": " << phase.free_cnt << ",\n"
+            << "            \"free_bytes\": " << phase.free_bytes << ",\n"
+            << "            \"alloc_bytes\": {";
+
+        for (uint32_t asid = 0; asid < AIPU_LOAD_STATS_ASID_CNT; asid++)
+        {
+            ofs << (asid == 0 ? "\n" : ",\n") << "                \"asid" << asid << "\": {";
+            for (uint32_t region = 0; region < AIPU_LOAD_STATS_REGION_CNT; region++)
+                ofs << (region == 0 ? " " : ", ") << "\"" << region_name[region] << "\": "
+                    << phase.alloc_bytes[asid][region];
+            ofs << " }";
+        }
+
+        ofs << "\n            }\n        }" << (i + 1 < AIPU_LOAD_PHASE_MAX ? ",\n" : "\n");
+    }
+    ofs << "    }\n}\n";
+
+    return AIPU_STATUS_SUCCESS;
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  load_phase.h
+ * @brief AIPU User Mode Driver (UMD) graph load/unload phase statistics header
+ */
+
+#ifndef _LOAD_PHASE_H_
+#define _LOAD_PHASE_H_
+
+#include <chrono>
+#include "standard_api.h"
+
+namespace aipudrv
+{
+/**
+ * @brief scoped recorder of one graph load/unload phase on the calling thread
+ *
+ * @note  a phase constructed with a stats array starts a report, a phase
+ *        constructed without one records into the report of the enclosing
+ *        phase and is a no-op if there's none. device memory operations are
+ *        accounted into every active phase of the thread.
+ */
+class LoadPhase
+{
+private:
+    aipu_load_phase_stats_t *m_stats = nullptr;
+    uint32_t m_phase = 0;
+    LoadPhase *m_outer = nullptr;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_active = false;
+
+private:
+    static thread_local LoadPhase *m_current;
+
+private:
+    void begin(aipu_load_phase_stats_t *stats, uint32_t phase);
+
+public:
+    void end();
+    static bool active()
+    {
+        return m_current != nullptr;
+    }
+    static void account_alloc(uint64_t size, uint32_t asid, uint32_t region);
+    static void account_free(uint64_t size);
+    static void account_write(uint64_t size);
+
+public:
+    LoadPhase(aipu_load_phase_stats_t *stats, uint32_t phase)
+    {
+        begin(stats, phase);
+    }
+    LoadPhase(uint32_t phase)
+    {
+        if (m_current != nullptr)
+            begin(m_current->m_stats, phase);
+    }
+    ~LoadPhase()
+    {
+        end();
+    }
+    LoadPhase(const LoadPhase& phase) = delete;
+    LoadPhase& operator=(const LoadPhase& phase) = delete;
+};
+
+aipu_status_t dump_load_stats_json(const aipu_graph_load_stats_t *stats);
+}
+
+#endif /* _LOAD_PHASE_H_ */
@@ -11,6 +11,7 @@
 #include <cstring>
 #include <mutex>
 #include "memory_base.h"
+#include "load_phase.h"
 #include "utils/log.h"
 #include "utils/helper.h"
 #include <unistd.h>
@@ -74,6 +75,41 @@ std::string aipudrv::MemoryBase::get_tracking_log(DEV_PA_64 pa) const
     return log;
 }
 
+void aipudrv::MemoryBase::get_buffer_slot(DEV_PA_64 pa, uint32_t *asid, uint32_t *region) const
+{
+    *asid = 0;
+    *region = AIPU_BUF_REGION_DEFAULT;
+
+    lock_rd();
+    for (auto pool : m_allocated_buf_map)
+    {
+        auto iter = pool->find(pa);
+        if (iter != pool->end())
+        {
+            *asid = iter->second.desc->asid;
+            *region = iter->second.desc->ram_region;
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&m_lock);
+}
+
+void aipudrv::MemoryBase::account_load_phase(DEV_PA_64 pa, uint64_t size, MemOperation op) const
+{
+    if (op == MemOperationAlloc)
+    {
+        uint32_t asid = 0;
+        uint32_t region = AIPU_BUF_REGION_DEFAULT;
+
+        get_buffer_slot(pa, &asid, &region);
+        LoadPhase::account_alloc(size, asid, region);
+    } else if (op == MemOperationFree) {
+        LoadPhase::account_free(size);
+    } else if (op == MemOperationWrite) {
+        LoadPhase::account_write(size);
+    }
+}
+
 void aipudrv::MemoryBase::add_tracking(DEV_PA_64 pa, uint64_t size, MemOperation op,
     const char* str, bool is_32_op, uint32_t data) const
 {
@@ -81,10 +117,24 @@ void aipudrv::MemoryBase::add_tracking(DEV_PA_64 pa, uint64_t size, MemOperation
     MemTracking tracking = {0};
     char f_log[1024] = {0};
 
+    if (op == MemOperationAlloc)
+    {
+        uint32_t asid = 0;
+        uint32_t region = AIPU_BUF_REGION_DEFAULT;
+
+        get_buffer_slot(pa, &asid, &region);
+        m_metrics.alloc(pa, size, asid, region);
+    } else if (op == MemOperationFree) {
+        m_metrics.free(pa, size);
+    }
+
+    if (LoadPhase::active())
+        account_load_phase(pa, size, op);
+
     if ((m_enable_mem_dump & (1 << op)) != (uint32_t)(1 << op))
         return;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     if (str == nullptr)
         log = get_tracking_log(pa);
     else
@@ -185,7 +235,7 @@ int aipudrv::MemoryBase::get_shared_buffer(uint64_t addr, uint64_t size, Buffer
     int ret = 0;
     auto iter = m_allocated.end();
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     iter = get_allocated_buffer((std::map<DEV_PA_64, Buffer> *)&m_allocated, addr);
     if (iter == m_allocated.end())
     {
@@ -208,7 +258,7 @@ int aipudrv::MemoryBase::pa_to_va(uint64_t addr, uint64_t size, char** va) const
     bool found = true;
     auto iter = m_allocated.end();
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     *va = nullptr;
 
     for (auto item : m_allocated_buf_map)
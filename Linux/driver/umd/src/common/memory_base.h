@@ -22,7 +22,9 @@
 #include "standard_api.h"
 #include "kmd/armchina_aipu.h"
 #include "type.h"
+#include "metrics.h"
 #include "utils/log.h"
+#include "utils/usdt.h"
 
 namespace aipudrv
 {
@@ -201,11 +203,26 @@ protected:
         (std::map<DEV_PA_64, Buffer>*)&m_reserved
     };
     mutable pthread_rwlock_t m_lock;
+    mutable MemMetrics m_metrics;
 
 private:
     std::string get_tracking_log(DEV_PA_64 pa) const;
+    void get_buffer_slot(DEV_PA_64 pa, uint32_t *asid, uint32_t *region) const;
+    void account_load_phase(DEV_PA_64 pa, uint64_t size, MemOperation op) const;
 
 protected:
+    void lock_rd() const
+    {
+        UMD_USDT1(mem_lock_wait, 0);
+        pthread_rwlock_rdlock(&m_lock);
+        UMD_USDT1(mem_lock_acquired, 0);
+    }
+    void lock_wr() const
+    {
+        UMD_USDT1(mem_lock_wait, 1);
+        pthread_rwlock_wrlock(&m_lock);
+        UMD_USDT1(mem_lock_acquired, 1);
+    }
     uint64_t get_page_cnt(uint64_t bytes) const
     {
         return ceil((double)bytes/AIPU_PAGE_SIZE);
@@ -228,6 +245,10 @@ public:
     void dump_tracking_log_end() const;
     void write_line(const char* log) const;
     int mem_bzero(uint64_t addr, size_t size);
+    MemMetrics& get_metrics() const
+    {
+        return m_metrics;
+    }
     void set_asid_base(int i, DEV_PA_64 base)
     {
         if (i == 0)
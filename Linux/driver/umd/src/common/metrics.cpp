@@ -0,0 +1,268 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  metrics.cpp
+ * @brief AIPU User Mode Driver (UMD) runtime metrics implementation
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "metrics.h"
+#include "utils/log.h"
+
+uint32_t aipudrv::LatencyHist::bucket(uint64_t ns)
+{
+    uint32_t msb = 0;
+    uint64_t idx = 0;
+
+    if (ns < 4)
+        return ns;
+
+    msb = 63 - __builtin_clzll(ns);
+    idx = (msb - 1) * 4 + ((ns >> (msb - 2)) & 3);
+    return (idx < AIPU_METRICS_HIST_BUCKETS) ? idx : AIPU_METRICS_HIST_BUCKETS - 1;
+}
+
+uint64_t aipudrv::LatencyHist::bucket_end(uint32_t idx)
+{
+    idx++;
+    if (idx < 4)
+        return idx;
+
+    return (uint64_t)(4 + idx % 4) << (idx / 4 - 1);
+}
+
+void aipudrv::LatencyHist::add(uint64_t ns)
+{
+    uint64_t max = m_max_ns.load(std::memory_order_relaxed);
+
+    m_buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    while ((ns > max) && !m_max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed));
+}
+
+void aipudrv::LatencyHist::read(aipu_latency_hist_t *hist) const
+{
+    hist->count = m_count.load(std::memory_order_relaxed);
+    hist->sum_ns = m_sum_ns.load(std::memory_order_relaxed);
+    hist->max_ns = m_max_ns.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < AIPU_METRICS_HIST_BUCKETS; i++)
+        hist->buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+}
+
+void aipudrv::JobCounters::read(aipu_job_counters_t *counters) const
+{
+    for (uint32_t i = 0; i < AIPU_METRICS_QOS_CNT; i++)
+    {
+        counters->created[i] = m_created[i].load(std::memory_order_relaxed);
+        counters->scheduled[i] = m_scheduled[i].load(std::memory_order_relaxed);
+        counters->completed[i] = m_completed[i].load(std::memory_order_relaxed);
+        counters->failed[i] = m_failed[i].load(std::memory_order_relaxed);
+    }
+}
+
+void aipudrv::MemMetrics::alloc(uint64_t pa, uint64_t size, uint32_t asid, uint32_t region)
+{
+    if (asid >= AIPU_LOAD_STATS_ASID_CNT)
+        asid = 0;
+
+    if (region >= AIPU_LOAD_STATS_REGION_CNT)
+        region = AIPU_MEM_REGION_DEFAULT;
+
+    std::lock_guard<std::mutex> lock_(m_lock);
+    m_slots[pa] = (asid << 8) | region;
+    m_bytes[asid][region] += size;
+    if (m_bytes[asid][region] > m_bytes_max[asid][region])
+        m_bytes_max[asid][region] = m_bytes[asid][region];
+}
+
+void aipudrv::MemMetrics::free(uint64_t pa, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    auto iter = m_slots.find(pa);
+    uint64_t *bytes = nullptr;
+
+    if (iter == m_slots.end())
+        return;
+
+    bytes = &m_bytes[iter->second >> 8][iter->second & 0xff];
+    *bytes -= (*bytes > size) ? size : *bytes;
+    m_slots.erase(iter);
+}
+
+void aipudrv::MemMetrics::read(aipu_metrics_t *metrics)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+
+    memcpy(metrics->mem_bytes, m_bytes, sizeof(m_bytes));
+    memcpy(metrics->mem_bytes_max, m_bytes_max, sizeof(m_bytes_max));
+    metrics->alloc_fail_cnt = m_alloc_fail_cnt.load(std::memory_order_relaxed);
+}
+
+void aipudrv::Metrics::commit(uint32_t qos, uint32_t partition_id)
+{
+    uint32_t idx = partition_idx(partition_id);
+    uint32_t depth = m_inflight[idx].fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t max = m_inflight_max[idx].load(std::memory_order_relaxed);
+
+    m_jobs.scheduled(qos);
+    while ((depth > max) &&
+        !m_inflight_max[idx].compare_exchange_weak(max, depth, std::memory_order_relaxed));
+}
+
+void aipudrv::Metrics::done(uint32_t qos, uint32_t partition_id, bool exception)
+{
+    m_inflight[partition_idx(partition_id)].fetch_sub(1, std::memory_order_relaxed);
+    m_jobs.done(qos, exception);
+}
+
+void aipudrv::Metrics::read(aipu_metrics_t *metrics) const
+{
+    m_jobs.read(&metrics->jobs);
+    for (uint32_t i = 0; i < AIPU_METRICS_PARTITION_CNT; i++)
+    {
+        metrics->inflight[i] = m_inflight[i].load(std::memory_order_relaxed);
+        metrics->inflight_max[i] = m_inflight_max[i].load(std::memory_order_relaxed);
+    }
+
+    for (uint32_t i = 0; i < AIPU_METRICS_LAT_MAX; i++)
+        m_latency[i].read(&metrics->latency[i]);
+}
+
+void aipudrv::MetricsExporter::start(uint32_t period_ms, std::function<void()> func)
+{
+    stop();
+
+    m_stop = false;
+    m_worker = std::thread([this, period_ms, func] {
+        std::unique_lock<std::mutex> lock_(m_lock);
+
+        while (!m_cv.wait_for(lock_, std::chrono::milliseconds(period_ms),
+            [this] { return m_stop; }))
+        {
+            lock_.unlock();
+            func();
+            lock_.lock();
+        }
+    });
+}
+
+void aipudrv::MetricsExporter::stop()
+{
+    if (!m_worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_worker.join();
+}
+
+static void write_job_counter(std::ofstream &ofs, const char *name, const char *graph,
+    const uint64_t *value)
+{
+    static const char *qos_name[AIPU_METRICS_QOS_CNT] = {"low", "high"};
+
+    for (uint32_t qos = 0; qos < AIPU_METRICS_QOS_CNT; qos++)
+        ofs << "aipu_umd_jobs_" << name << "_total{graph=\"" << graph << "\",qos=\""
+            << qos_name[qos] << "\"} " << value[qos] << "\n";
+}
+
+aipu_status_t aipudrv::write_metrics_prom(const char *path, const aipu_metrics_t *metrics,
+    const std::vector<std::pair<uint64_t, aipu_job_counters_t>> &graphs)
+{
+    static const char *region_name[AIPU_LOAD_STATS_REGION_CNT] = {
+        "default", "sram", "dtcm"
+    };
+    static const char *op_name[AIPU_METRICS_LAT_MAX] = {
+        "create", "schedule", "wait", "copy"
+    };
+    std::string tmp_path = std::string(path) + ".tmp";
+    std::ofstream ofs(tmp_path, std::ofstream::out | std::ofstream::trunc);
+    char graph_id[32] = {0};
+
+    if (!ofs.is_open())
+    {
+        LOG(LOG_ERR, "open %s [fail]\n", tmp_path.c_str());
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    /* samples of a metric family stay together */
+#define WRITE_JOB_COUNTER(field) \
+    ofs << "# TYPE aipu_umd_jobs_" #field "_total counter\n"; \
+    write_job_counter(ofs, #field, "all", metrics->jobs.field); \
+    for (auto &graph : graphs) \
+    { \
+        snprintf(graph_id, sizeof(graph_id), "0x%lx", (unsigned long)graph.first); \
+        write_job_counter(ofs, #field, graph_id, graph.second.field); \
+    }
+
+    WRITE_JOB_COUNTER(created);
+    WRITE_JOB_COUNTER(scheduled);
+    WRITE_JOB_COUNTER(completed);
+    WRITE_JOB_COUNTER(failed);
+#undef WRITE_JOB_COUNTER
+
+    ofs << "# TYPE aipu_umd_jobs_inflight gauge\n";
+    for (uint32_t i = 0; i < AIPU_METRICS_PARTITION_CNT; i++)
+        ofs << "aipu_umd_jobs_inflight{partition=\"" << i << "\"} " << metrics->inflight[i] << "\n";
+    ofs << "# TYPE aipu_umd_jobs_inflight_max gauge\n";
+    for (uint32_t i = 0; i < AIPU_METRICS_PARTITION_CNT; i++)
+        ofs << "aipu_umd_jobs_inflight_max{partition=\"" << i << "\"} "
+            << metrics->inflight_max[i] << "\n";
+
+    ofs << "# TYPE aipu_umd_mem_bytes gauge\n";
+    for (uint32_t asid = 0; asid < AIPU_LOAD_STATS_ASID_CNT; asid++)
+        for (uint32_t region = 0; region < AIPU_LOAD_STATS_REGION_CNT; region++)
+            ofs << "aipu_umd_mem_bytes{asid=\"" << asid << "\",region=\"" << region_name[region]
+                << "\"} " << metrics->mem_bytes[asid][region] << "\n";
+    ofs << "# TYPE aipu_umd_mem_bytes_max gauge\n";
+    for (uint32_t asid = 0; asid < AIPU_LOAD_STATS_ASID_CNT; asid++)
+        for (uint32_t region = 0; region < AIPU_LOAD_STATS_REGION_CNT; region++)
+            ofs << "aipu_umd_mem_bytes_max{asid=\"" << asid << "\",region=\"" << region_name[region]
+                << "\"} " << metrics->mem_bytes_max[asid][region] << "\n";
+    ofs << "# TYPE aipu_umd_alloc_failures_total counter\n"
+        << "aipu_umd_alloc_failures_total " << metrics->alloc_fail_cnt << "\n";
+
+    /* one cumulative bucket per power of 2 keeps the output short */
+    ofs << "# TYPE aipu_umd_latency_seconds histogram\n";
+    for (uint32_t op = 0; op < AIPU_METRICS_LAT_MAX; op++)
+    {
+        const aipu_latency_hist_t &hist = metrics->latency[op];
+        uint64_t cumulative = 0;
+
+        for (uint32_t i = 0; i < AIPU_METRICS_HIST_BUCKETS; i++)
+        {
+            cumulative += hist.buckets[i];
+            if (((i % 4) != 3) || (i == AIPU_METRICS_HIST_BUCKETS - 1))
+                continue;
+
+            ofs << "aipu_umd_latency_seconds_bucket{op=\"" << op_name[op] << "\",le=\""
+                << LatencyHist::bucket_end(i) / 1e9 << "\"} " << cumulative << "\n";
+        }
+        /* buckets and count aren't read at once, the buckets are taken as the count */
+        ofs << "aipu_umd_latency_seconds_bucket{op=\"" << op_name[op] << "\",le=\"+Inf\"} "
+            << cumulative << "\n"
+            << "aipu_umd_latency_seconds_sum{op=\"" << op_name[op] << "\"} "
+            << hist.sum_ns / 1e9 << "\n"
+            << "aipu_umd_latency_seconds_count{op=\"" << op_name[op] << "\"} "
+            << cumulative << "\n";
+    }
+
+    ofs.close();
+    if (ofs.fail() || (rename(tmp_path.c_str(), path) != 0))
+    {
+        LOG(LOG_ERR, "write %s [fail]\n", path);
+        remove(tmp_path.c_str());
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
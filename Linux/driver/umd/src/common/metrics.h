@@ -0,0 +1,231 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  metrics.h
+ * @brief AIPU User Mode Driver (UMD) runtime metrics header
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include "standard_api.h"
+
+namespace aipudrv
+{
+/**
+ * @brief latency histogram, the bucket layout is the one of aipu_latency_hist_t
+ */
+class LatencyHist
+{
+private:
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum_ns{0};
+    std::atomic<uint64_t> m_max_ns{0};
+    std::atomic<uint64_t> m_buckets[AIPU_METRICS_HIST_BUCKETS];
+
+public:
+    static uint32_t bucket(uint64_t ns);
+    static uint64_t bucket_end(uint32_t idx);
+    void add(uint64_t ns);
+    void read(aipu_latency_hist_t *hist) const;
+
+public:
+    LatencyHist()
+    {
+        for (uint32_t i = 0; i < AIPU_METRICS_HIST_BUCKETS; i++)
+            m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    LatencyHist(const LatencyHist& hist) = delete;
+    LatencyHist& operator=(const LatencyHist& hist) = delete;
+};
+
+/**
+ * @brief job counters per QoS level
+ */
+class JobCounters
+{
+private:
+    std::atomic<uint64_t> m_created[AIPU_METRICS_QOS_CNT];
+    std::atomic<uint64_t> m_scheduled[AIPU_METRICS_QOS_CNT];
+    std::atomic<uint64_t> m_completed[AIPU_METRICS_QOS_CNT];
+    std::atomic<uint64_t> m_failed[AIPU_METRICS_QOS_CNT];
+
+private:
+    static uint32_t qos_idx(uint32_t qos)
+    {
+        return (qos < AIPU_METRICS_QOS_CNT) ? qos : AIPU_METRICS_QOS_CNT - 1;
+    }
+
+public:
+    void created(uint32_t qos)
+    {
+        m_created[qos_idx(qos)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void scheduled(uint32_t qos)
+    {
+        m_scheduled[qos_idx(qos)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void done(uint32_t qos, bool exception)
+    {
+        if (exception)
+            m_failed[qos_idx(qos)].fetch_add(1, std::memory_order_relaxed);
+        else
+            m_completed[qos_idx(qos)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void read(aipu_job_counters_t *counters) const;
+
+public:
+    JobCounters()
+    {
+        for (uint32_t i = 0; i < AIPU_METRICS_QOS_CNT; i++)
+        {
+            m_created[i].store(0, std::memory_order_relaxed);
+            m_scheduled[i].store(0, std::memory_order_relaxed);
+            m_completed[i].store(0, std::memory_order_relaxed);
+            m_failed[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    JobCounters(const JobCounters& counters) = delete;
+    JobCounters& operator=(const JobCounters& counters) = delete;
+};
+
+/**
+ * @brief device memory in use per ASID and region with high-water marks
+ *
+ * @note  the ASID/region of a buffer is looked up on allocation and kept
+ *        until it's freed, frees of buffers not seen allocated are ignored.
+ */
+class MemMetrics
+{
+private:
+    std::mutex m_lock;
+    std::map<uint64_t, uint32_t> m_slots;
+    uint64_t m_bytes[AIPU_LOAD_STATS_ASID_CNT][AIPU_LOAD_STATS_REGION_CNT] = {};
+    uint64_t m_bytes_max[AIPU_LOAD_STATS_ASID_CNT][AIPU_LOAD_STATS_REGION_CNT] = {};
+    std::atomic<uint64_t> m_alloc_fail_cnt{0};
+
+public:
+    void alloc(uint64_t pa, uint64_t size, uint32_t asid, uint32_t region);
+    void free(uint64_t pa, uint64_t size);
+    void alloc_fail()
+    {
+        m_alloc_fail_cnt.fetch_add(1, std::memory_order_relaxed);
+    }
+    void read(aipu_metrics_t *metrics);
+};
+
+/**
+ * @brief job metrics of a context
+ */
+class Metrics
+{
+private:
+    JobCounters m_jobs;
+    std::atomic<uint32_t> m_inflight[AIPU_METRICS_PARTITION_CNT];
+    std::atomic<uint32_t> m_inflight_max[AIPU_METRICS_PARTITION_CNT];
+    LatencyHist m_latency[AIPU_METRICS_LAT_MAX];
+
+private:
+    static uint32_t partition_idx(uint32_t partition_id)
+    {
+        return (partition_id < AIPU_METRICS_PARTITION_CNT) ?
+            partition_id : AIPU_METRICS_PARTITION_CNT - 1;
+    }
+
+public:
+    JobCounters& jobs()
+    {
+        return m_jobs;
+    }
+    void add_latency(uint32_t op, uint64_t ns)
+    {
+        m_latency[op].add(ns);
+    }
+    void commit(uint32_t qos, uint32_t partition_id);
+    void done(uint32_t qos, uint32_t partition_id, bool exception);
+    void read(aipu_metrics_t *metrics) const;
+
+public:
+    Metrics()
+    {
+        for (uint32_t i = 0; i < AIPU_METRICS_PARTITION_CNT; i++)
+        {
+            m_inflight[i].store(0, std::memory_order_relaxed);
+            m_inflight_max[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    Metrics(const Metrics& metrics) = delete;
+    Metrics& operator=(const Metrics& metrics) = delete;
+};
+
+/**
+ * @brief scoped latency sample, a no-op without metrics
+ */
+class LatencyTimer
+{
+private:
+    Metrics *m_metrics;
+    uint32_t m_op;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    LatencyTimer(Metrics *metrics, uint32_t op): m_metrics(metrics), m_op(op)
+    {
+        if (m_metrics != nullptr)
+            m_start = std::chrono::steady_clock::now();
+    }
+    ~LatencyTimer()
+    {
+        if (m_metrics != nullptr)
+            m_metrics->add_latency(m_op, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+    }
+    LatencyTimer(const LatencyTimer& timer) = delete;
+    LatencyTimer& operator=(const LatencyTimer& timer) = delete;
+};
+
+/**
+ * @brief background thread calling 'func' every period until stopped
+ */
+class MetricsExporter
+{
+private:
+    std::thread m_worker;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+
+public:
+    void start(uint32_t period_ms, std::function<void()> func);
+    void stop();
+
+public:
+    MetricsExporter() {}
+    ~MetricsExporter()
+    {
+        stop();
+    }
+    MetricsExporter(const MetricsExporter& exporter) = delete;
+    MetricsExporter& operator=(const MetricsExporter& exporter) = delete;
+};
+
+/**
+ * @brief write metrics in Prometheus text exposition format, the file is
+ *        replaced atomically so a scraper never reads a partial one
+ */
+aipu_status_t write_metrics_prom(const char *path, const aipu_metrics_t *metrics,
+    const std::vector<std::pair<uint64_t, aipu_job_counters_t>> &graphs);
+}
+
+#endif /* _METRICS_H_ */
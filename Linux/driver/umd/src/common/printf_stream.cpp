@@ -0,0 +1,172 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  printf_stream.cpp
+ * @brief AIPU User Mode Driver (UMD) NPU printf stream implementation
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "printf_stream.h"
+#include "misc/aipu_printf.h"
+#include "utils/log.h"
+
+#define PRINTF_STREAM_POLL_MS  10
+#define PRINTF_STREAM_MAX_LINE 4096
+#define PRINTF_STREAM_CHUNK    (64 * 1024)
+
+aipudrv::PrintfRing::PrintfRing(PrintfReadFunc read, uint32_t buf_size):
+    m_read(read), m_cap((buf_size > LOG_HEADER_SZ) ? buf_size - LOG_HEADER_SZ : 0)
+{
+}
+
+void aipudrv::PrintfRing::consume(uint32_t begin, uint32_t end,
+    const std::function<void(const char *, uint32_t)> &emit)
+{
+    while (begin < end)
+    {
+        uint32_t len = std::min(end - begin, (uint32_t)PRINTF_STREAM_CHUNK);
+
+        m_chunk.resize(len);
+        m_read(LOG_HEADER_SZ + begin, m_chunk.data(), len);
+        begin += len;
+
+        for (char c : m_chunk)
+        {
+            if (c == '\0')
+                continue;
+
+            if (c == '\n')
+            {
+                /* the oldest text of a lapped ring starts in the middle of a line */
+                if (!m_drop_line)
+                    emit(m_line.c_str(), m_line.size());
+                m_drop_line = false;
+                m_line.clear();
+                continue;
+            }
+
+            if (m_drop_line)
+                continue;
+
+            m_line.push_back(c);
+            if (m_line.size() >= PRINTF_STREAM_MAX_LINE)
+            {
+                emit(m_line.c_str(), m_line.size());
+                m_line.clear();
+            }
+        }
+    }
+}
+
+uint32_t aipudrv::PrintfRing::poll(const std::function<void(const char *, uint32_t)> &emit)
+{
+    aipu_log_buffer_header_t header = {0};
+    uint32_t write_offset = 0;
+    bool overwrite = false;
+    bool first_wrap = false;
+    uint32_t cnt = 0;
+
+    if (m_cap == 0)
+        return 0;
+
+    m_read(0, (char *)&header, sizeof(header));
+    if ((header.write_offset < 0) || ((uint32_t)header.write_offset >= m_cap))
+        return 0;
+
+    write_offset = header.write_offset;
+    overwrite = (header.overwrite_flag != 0);
+
+    /* the header is zeroed on job init, the ring starts over */
+    if (!overwrite && (m_overwrite || (write_offset < m_offset)))
+    {
+        m_offset = 0;
+        m_overwrite = false;
+        m_drop_line = false;
+        m_line.clear();
+    }
+
+    first_wrap = overwrite && !m_overwrite;
+    if (first_wrap && (write_offset > m_offset))
+    {
+        /* wrapped past the read position, what's left from there is the oldest */
+        LOG(LOG_WARN, "printf ring overrun, %u bytes lost\n", write_offset - m_offset);
+        m_lost += write_offset - m_offset;
+        m_offset = write_offset;
+        m_drop_line = true;
+        m_line.clear();
+    }
+
+    if (!first_wrap && (write_offset >= m_offset))
+    {
+        cnt = write_offset - m_offset;
+        consume(m_offset, write_offset, emit);
+    } else {
+        cnt = m_cap - m_offset + write_offset;
+        consume(m_offset, m_cap, emit);
+        consume(0, write_offset, emit);
+    }
+
+    m_offset = write_offset;
+    m_overwrite = overwrite;
+    return cnt;
+}
+
+void aipudrv::PrintfRing::flush(const std::function<void(const char *, uint32_t)> &emit)
+{
+    if (!m_line.empty() && !m_drop_line)
+        emit(m_line.c_str(), m_line.size());
+
+    m_line.clear();
+}
+
+aipudrv::PrintfStream::PrintfStream(PrintfReadFunc read, uint32_t buf_size,
+    const aipu_printf_stream_t *stream):
+    m_ring(read, buf_size), m_job_id(stream->job_id), m_sink(stream->sink), m_arg(stream->arg),
+    m_poll_ms((stream->poll_ms != 0) ? stream->poll_ms : PRINTF_STREAM_POLL_MS)
+{
+    m_reader = std::thread(&PrintfStream::run, this);
+}
+
+aipudrv::PrintfStream::~PrintfStream()
+{
+    stop();
+}
+
+void aipudrv::PrintfStream::run()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+    auto emit = [this](const char *line, uint32_t len) { this->emit(line, len); };
+
+    while (!m_stop)
+    {
+        m_cv.wait_for(lock_, std::chrono::milliseconds(m_poll_ms), [this] { return m_stop; });
+
+        /* the sink may take a while, don't hold up stop() meanwhile */
+        lock_.unlock();
+        m_ring.poll(emit);
+        lock_.lock();
+    }
+
+    lock_.unlock();
+    m_ring.poll(emit);
+    m_ring.flush(emit);
+}
+
+uint64_t aipudrv::PrintfStream::stop()
+{
+    if (m_reader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock_(m_lock);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+        m_reader.join();
+    }
+
+    return m_ring.get_lost();
+}
@@ -0,0 +1,106 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  printf_stream.h
+ * @brief AIPU User Mode Driver (UMD) NPU printf stream header
+ */
+
+#ifndef _PRINTF_STREAM_H_
+#define _PRINTF_STREAM_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "standard_api.h"
+
+namespace aipudrv
+{
+/**
+ * @brief read 'size' bytes at 'offset' of a printf buffer
+ */
+typedef std::function<void(uint32_t offset, char *dest, uint32_t size)> PrintfReadFunc;
+
+/**
+ * @brief incremental reader of a printf ring: header {overwrite_flag, write_offset}
+ *        followed by the text the NPU writes from offset 0 again once it's full
+ *
+ * @note  only the bytes written since the previous poll are read. a lap of the writer
+ *        between two polls can't be told from the header, the poll period bounds it.
+ */
+class PrintfRing
+{
+private:
+    PrintfReadFunc m_read;
+    uint32_t m_cap;
+    uint32_t m_offset = 0;
+    bool m_overwrite = false;
+    bool m_drop_line = false;
+    uint64_t m_lost = 0;
+    std::string m_line;
+    std::vector<char> m_chunk;
+
+private:
+    void consume(uint32_t begin, uint32_t end,
+        const std::function<void(const char *, uint32_t)> &emit);
+
+public:
+    uint32_t poll(const std::function<void(const char *, uint32_t)> &emit);
+    void flush(const std::function<void(const char *, uint32_t)> &emit);
+    uint64_t get_lost()
+    {
+        return m_lost;
+    }
+
+public:
+    PrintfRing(PrintfReadFunc read, uint32_t buf_size);
+    PrintfRing(const PrintfRing& ring) = delete;
+    PrintfRing& operator=(const PrintfRing& ring) = delete;
+};
+
+/**
+ * @brief background thread polling the printf ring of a job and passing each
+ *        complete line to a sink
+ */
+class PrintfStream
+{
+private:
+    PrintfRing m_ring;
+    uint64_t m_job_id;
+    aipu_printf_sink_t m_sink;
+    void *m_arg;
+    uint32_t m_poll_ms;
+    std::thread m_reader;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+
+private:
+    void run();
+    void emit(const char *line, uint32_t len)
+    {
+        m_sink(m_job_id, line, len, m_arg);
+    }
+
+public:
+    /**
+     * @brief drain what's written so far, including an unterminated last line
+     *
+     * @retval bytes overwritten before being read
+     */
+    uint64_t stop();
+
+public:
+    PrintfStream(PrintfReadFunc read, uint32_t buf_size, const aipu_printf_stream_t *stream);
+    PrintfStream(const PrintfStream& stream) = delete;
+    PrintfStream& operator=(const PrintfStream& stream) = delete;
+    ~PrintfStream();
+};
+}
+
+#endif /* _PRINTF_STREAM_H_ */
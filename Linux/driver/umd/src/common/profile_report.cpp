@@ -0,0 +1,186 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  profile_report.cpp
+ * @brief AIPU User Mode Driver (UMD) per-layer profiling report implementation
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "profile_report.h"
+#include "utils/log.h"
+
+#define PROFILE_LATEST_RUNS 4096
+
+aipu_status_t aipudrv::decode_profile(const char *buf, uint64_t size, const ProfileRegions &regions,
+    const aipu_profile_layout_t *layout, std::vector<ProfileSample> &samples)
+{
+    if ((layout->record_size == 0) ||
+        (layout->layer_id_offset + sizeof(uint32_t) > layout->record_size) ||
+        (layout->start_offset + sizeof(uint64_t) > layout->record_size) ||
+        (layout->end_offset + sizeof(uint64_t) > layout->record_size))
+    {
+        LOG(LOG_ERR, "invalid profiler record layout\n");
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+    }
+
+    for (auto &region : regions)
+    {
+        uint64_t end = size;
+        uint64_t pos = (uint64_t)region.second + layout->header_size;
+
+        for (auto &next : regions)
+        {
+            if ((next.second > region.second) && (next.second < end))
+                end = next.second;
+        }
+
+        for (; pos + layout->record_size <= end; pos += layout->record_size)
+        {
+            ProfileSample sample = {region.first, 0, 0};
+            uint64_t start_cycle = 0;
+            uint64_t end_cycle = 0;
+
+            memcpy(&sample.layer_id, buf + pos + layout->layer_id_offset, sizeof(uint32_t));
+            memcpy(&start_cycle, buf + pos + layout->start_offset, sizeof(uint64_t));
+            memcpy(&end_cycle, buf + pos + layout->end_offset, sizeof(uint64_t));
+
+            /* the rest of the region isn't written by this run */
+            if (end_cycle == 0)
+                break;
+
+            if (end_cycle < start_cycle)
+            {
+                LOG(LOG_WARN, "subgraph %u layer %u: end cycle < start cycle, skipped\n",
+                    sample.sg_id, sample.layer_id);
+                continue;
+            }
+
+            sample.cycles = end_cycle - start_cycle;
+            samples.push_back(sample);
+        }
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+void aipudrv::ProfileReport::add(const std::vector<ProfileSample> &samples)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+
+    for (auto &sample : samples)
+    {
+        LayerRuns &layer = m_layers[std::make_pair(sample.sg_id, sample.layer_id)];
+
+        if (layer.latest.size() < PROFILE_LATEST_RUNS)
+            layer.latest.push_back(sample.cycles);
+        else
+            layer.latest[layer.runs % PROFILE_LATEST_RUNS] = sample.cycles;
+
+        layer.runs++;
+        layer.sum += sample.cycles;
+        layer.min = std::min(layer.min, sample.cycles);
+        layer.max = std::max(layer.max, sample.cycles);
+    }
+}
+
+void aipudrv::ProfileReport::read(std::vector<aipu_profile_layer_stats_t> &stats,
+    uint32_t freq_mhz, bool reset)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    std::vector<uint64_t> latest;
+
+    stats.clear();
+    for (auto &iter : m_layers)
+    {
+        const LayerRuns &layer = iter.second;
+        aipu_profile_layer_stats_t layer_stats = {0};
+        size_t p99_idx = 0;
+
+        /* nearest-rank percentile */
+        latest = layer.latest;
+        p99_idx = (latest.size() * 99 + 99) / 100 - 1;
+        std::nth_element(latest.begin(), latest.begin() + p99_idx, latest.end());
+
+        layer_stats.subgraph_id = iter.first.first;
+        layer_stats.layer_id = iter.first.second;
+        layer_stats.runs = layer.runs;
+        layer_stats.min_cycles = layer.min;
+        layer_stats.mean_cycles = layer.sum / layer.runs;
+        layer_stats.p99_cycles = latest[p99_idx];
+        layer_stats.max_cycles = layer.max;
+        if (freq_mhz != 0)
+        {
+            layer_stats.mean_us = (double)layer.sum / layer.runs / freq_mhz;
+            layer_stats.p99_us = (double)layer_stats.p99_cycles / freq_mhz;
+        }
+        stats.push_back(layer_stats);
+    }
+
+    if (reset)
+        m_layers.clear();
+}
+
+aipu_status_t aipudrv::write_profile_csv(const char *path,
+    const std::vector<aipu_profile_layer_stats_t> &stats)
+{
+    std::ofstream ofs(path, std::ofstream::out | std::ofstream::trunc);
+    char buf[256] = {0};
+
+    if (!ofs.is_open())
+    {
+        LOG(LOG_ERR, "open %s [fail]\n", path);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    ofs << "subgraph_id,layer_id,runs,min_cycles,mean_cycles,p99_cycles,max_cycles,mean_us,p99_us\n";
+    for (auto &layer : stats)
+    {
+        snprintf(buf, sizeof(buf), "%u,%u,%lu,%lu,%lu,%lu,%lu,%.3f,%.3f\n",
+            layer.subgraph_id, layer.layer_id, (unsigned long)layer.runs,
+            (unsigned long)layer.min_cycles, (unsigned long)layer.mean_cycles,
+            (unsigned long)layer.p99_cycles, (unsigned long)layer.max_cycles,
+            layer.mean_us, layer.p99_us);
+        ofs << buf;
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t aipudrv::write_profile_json(const char *path, uint64_t graph_id, uint32_t freq_mhz,
+    const std::vector<aipu_profile_layer_stats_t> &stats)
+{
+    std::ofstream ofs(path, std::ofstream::out | std::ofstream::trunc);
+    char buf[384] = {0};
+
+    if (!ofs.is_open())
+    {
+        LOG(LOG_ERR, "open %s [fail]\n", path);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    snprintf(buf, sizeof(buf), "{\"graph_id\": \"0x%lx\", \"freq_mhz\": %u, \"layers\": [",
+        (unsigned long)graph_id, freq_mhz);
+    ofs << buf;
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        const aipu_profile_layer_stats_t &layer = stats[i];
+
+        snprintf(buf, sizeof(buf),
+            "%s\n{\"subgraph_id\": %u, \"layer_id\": %u, \"runs\": %lu, \"min_cycles\": %lu, "
+            "\"mean_cycles\": %lu, \"p99_cycles\": %lu, \"max_cycles\": %lu, "
+            "\"mean_us\": %.3f, \"p99_us\": %.3f}",
+            (i == 0) ? "" : ",", layer.subgraph_id, layer.layer_id, (unsigned long)layer.runs,
+            (unsigned long)layer.min_cycles, (unsigned long)layer.mean_cycles,
+            (unsigned long)layer.p99_cycles, (unsigned long)layer.max_cycles,
+            layer.mean_us, layer.p99_us);
+        ofs << buf;
+    }
+    ofs << "\n]}\n";
+
+    return AIPU_STATUS_SUCCESS;
+}
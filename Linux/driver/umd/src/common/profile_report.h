@@ -0,0 +1,77 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  profile_report.h
+ * @brief AIPU User Mode Driver (UMD) per-layer profiling report header
+ */
+
+#ifndef _PROFILE_REPORT_H_
+#define _PROFILE_REPORT_H_
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "standard_api.h"
+
+namespace aipudrv
+{
+struct ProfileSample
+{
+    uint32_t sg_id;
+    uint32_t layer_id;
+    uint64_t cycles;
+};
+
+/**
+ * @brief subgraph ID and offset of its region in the profiler buffer
+ */
+typedef std::vector<std::pair<uint32_t, uint32_t>> ProfileRegions;
+
+/**
+ * @brief decode the layer records of every subgraph region in a profiler buffer
+ *
+ * @note a region ends at the next larger region offset or at the buffer end
+ */
+aipu_status_t decode_profile(const char *buf, uint64_t size, const ProfileRegions &regions,
+    const aipu_profile_layout_t *layout, std::vector<ProfileSample> &samples);
+
+/**
+ * @brief per-layer cycles aggregated over the runs of a graph
+ */
+class ProfileReport
+{
+private:
+    struct LayerRuns
+    {
+        uint64_t runs = 0;
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+        uint64_t sum = 0;
+        std::vector<uint64_t> latest; /**< ring of the latest runs for percentiles */
+    };
+
+private:
+    std::mutex m_lock;
+    std::map<std::pair<uint32_t, uint32_t>, LayerRuns> m_layers;
+
+public:
+    void add(const std::vector<ProfileSample> &samples);
+    void read(std::vector<aipu_profile_layer_stats_t> &stats, uint32_t freq_mhz, bool reset);
+
+public:
+    ProfileReport() {}
+    ProfileReport(const ProfileReport& report) = delete;
+    ProfileReport& operator=(const ProfileReport& report) = delete;
+};
+
+aipu_status_t write_profile_csv(const char *path,
+    const std::vector<aipu_profile_layer_stats_t> &stats);
+aipu_status_t write_profile_json(const char *path, uint64_t graph_id, uint32_t freq_mhz,
+    const std::vector<aipu_profile_layer_stats_t> &stats);
+}
+
+#endif /* _PROFILE_REPORT_H_ */
@@ -0,0 +1,79 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  reclaimer.cpp
+ * @brief AIPU User Mode Driver (UMD) deferred teardown reclaimer implementation
+ */
+
+#include "reclaimer.h"
+
+aipudrv::Reclaimer::~Reclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_exit = true;
+    }
+    m_cv.notify_all();
+
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+void aipudrv::Reclaimer::defer(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+
+    m_tasks.push_back(task);
+    if (!m_worker.joinable())
+        m_worker = std::thread(&Reclaimer::worker, this);
+    m_cv.notify_all();
+}
+
+/**
+ * @brief wait until all pending teardowns are done
+ *
+ * @retval true if there was any teardown pending
+ *
+ * @note  a no-op on the worker itself, teardowns deferred earlier are done already.
+ */
+bool aipudrv::Reclaimer::drain()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    if (std::this_thread::get_id() == m_worker.get_id())
+        return false;
+
+    if (m_tasks.empty() && (m_running == 0))
+        return false;
+
+    m_idle_cv.wait(lock_, [this] { return m_tasks.empty() && (m_running == 0); });
+    return true;
+}
+
+void aipudrv::Reclaimer::worker()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    while (true)
+    {
+        std::deque<std::function<void()>> batch;
+
+        m_cv.wait(lock_, [this] { return m_exit || !m_tasks.empty(); });
+        if (m_tasks.empty())
+            break;
+
+        batch.swap(m_tasks);
+        m_running = batch.size();
+        lock_.unlock();
+
+        for (auto &task : batch)
+            task();
+
+        lock_.lock();
+        m_running = 0;
+        m_idle_cv.notify_all();
+    }
+}
@@ -0,0 +1,63 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  reclaimer.h
+ * @brief AIPU User Mode Driver (UMD) deferred teardown reclaimer header
+ */
+
+#ifndef _RECLAIMER_H_
+#define _RECLAIMER_H_
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+namespace aipudrv
+{
+/**
+ * @brief process-wide background worker tearing down unloaded graphs and
+ *        cleaned jobs when AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN asks for it
+ *
+ * @note  teardowns run in FIFO order and are picked up in bulk. a failed device
+ *        memory allocation drains the pending teardowns and retries once, so
+ *        deferred buffers never make a following allocation fail.
+ */
+class Reclaimer
+{
+private:
+    std::deque<std::function<void()>> m_tasks;
+    uint32_t m_running = 0;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::condition_variable m_idle_cv;
+    std::thread m_worker;
+    bool m_exit = false;
+
+private:
+    void worker();
+
+public:
+    void defer(std::function<void()> task);
+    bool drain();
+
+public:
+    static Reclaimer& get_reclaimer()
+    {
+        static Reclaimer reclaimer;
+        return reclaimer;
+    }
+    ~Reclaimer();
+    Reclaimer(const Reclaimer& reclaimer) = delete;
+    Reclaimer& operator=(const Reclaimer& reclaimer) = delete;
+
+private:
+    Reclaimer() {};
+};
+}
+
+#endif /* _RECLAIMER_H_ */
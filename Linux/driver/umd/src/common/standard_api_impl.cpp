@@ -116,6 +116,12 @@ aipu_status_t aipu_init_context(aipu_ctx_handle_t** ctx)
 
     *ctx = nullptr;
     handle = ctx_map.create_ctx_ref();
+    if (handle == 0)
+    {
+        ret = AIPU_STATUS_ERROR_NO_FREE_HANDLE;
+        goto finish;
+    }
+
     p_ctx = ctx_map.get_ctx_ref(handle);
     if (p_ctx == nullptr)
     {
@@ -214,6 +220,73 @@ finish:
     return ret;
 }
 
+aipu_status_t aipu_load_graph_async(const aipu_ctx_handle_t* ctx, const char* graph_file,
+    uint64_t* id, aipu_load_graph_cfg_t *config, aipu_load_graph_progress_t progress, void *arg)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::CtxRefMap& ctx_map = aipudrv::CtxRefMap::get_ctx_map();
+    aipudrv::MainContext* p_ctx = nullptr;
+
+    if (ctx == nullptr)
+    {
+        ret = AIPU_STATUS_ERROR_NULL_PTR;
+        goto finish;
+    }
+
+    p_ctx = ctx_map.get_ctx_ref(ctx->handle);
+    if (p_ctx == nullptr)
+        ret = AIPU_STATUS_ERROR_INVALID_CTX;
+    else
+        ret = p_ctx->load_graph_async(graph_file, id, config, progress, arg);
+
+finish:
+    return ret;
+}
+
+aipu_status_t aipu_wait_graph_loaded(const aipu_ctx_handle_t* ctx, uint64_t graph, int32_t time_out)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::CtxRefMap& ctx_map = aipudrv::CtxRefMap::get_ctx_map();
+    aipudrv::MainContext* p_ctx = nullptr;
+
+    if (ctx == nullptr)
+    {
+        ret = AIPU_STATUS_ERROR_NULL_PTR;
+        goto finish;
+    }
+
+    p_ctx = ctx_map.get_ctx_ref(ctx->handle);
+    if (p_ctx == nullptr)
+        ret = AIPU_STATUS_ERROR_INVALID_CTX;
+    else
+        ret = p_ctx->wait_graph_loaded(graph, time_out);
+
+finish:
+    return ret;
+}
+
+aipu_status_t aipu_cancel_load_graph(const aipu_ctx_handle_t* ctx, uint64_t graph)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::CtxRefMap& ctx_map = aipudrv::CtxRefMap::get_ctx_map();
+    aipudrv::MainContext* p_ctx = nullptr;
+
+    if (ctx == nullptr)
+    {
+        ret = AIPU_STATUS_ERROR_NULL_PTR;
+        goto finish;
+    }
+
+    p_ctx = ctx_map.get_ctx_ref(ctx->handle);
+    if (p_ctx == nullptr)
+        ret = AIPU_STATUS_ERROR_INVALID_CTX;
+    else
+        ret = p_ctx->cancel_load_graph(graph);
+
+finish:
+    return ret;
+}
+
 aipu_status_t aipu_unload_graph(const aipu_ctx_handle_t* ctx, uint64_t graph)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
@@ -447,6 +520,159 @@ aipu_status_t aipu_get_tensor(const aipu_ctx_handle_t* ctx, uint64_t job_id, aip
     return job->get_tensor(type, tensor, data);
 }
 
+aipu_status_t aipu_load_tensor_float(const aipu_ctx_handle_t* ctx, uint64_t job_id, uint32_t tensor,
+    const float* data)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->load_tensor_float(tensor, data);
+}
+
+aipu_status_t aipu_get_tensor_float(const aipu_ctx_handle_t* ctx, uint64_t job_id, aipu_tensor_type_t type,
+    uint32_t tensor, float* data)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->get_tensor_float(type, tensor, data);
+}
+
+aipu_status_t aipu_load_tensor_unpacked(const aipu_ctx_handle_t* ctx, uint64_t job_id, uint32_t tensor,
+    const void* data)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->load_tensor_unpacked(tensor, data);
+}
+
+aipu_status_t aipu_get_tensor_unpacked(const aipu_ctx_handle_t* ctx, uint64_t job_id, aipu_tensor_type_t type,
+    uint32_t tensor, void* data)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->get_tensor_unpacked(type, tensor, data);
+}
+
+aipu_status_t aipu_load_tensor_layout(const aipu_ctx_handle_t* ctx, uint64_t job_id, uint32_t tensor,
+    const void* data, const aipu_tensor_copy_t* copy)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->load_tensor_layout(tensor, data, copy);
+}
+
+aipu_status_t aipu_get_tensor_layout(const aipu_ctx_handle_t* ctx, uint64_t job_id, aipu_tensor_type_t type,
+    uint32_t tensor, void* data, const aipu_tensor_copy_t* copy)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->get_tensor_layout(type, tensor, data, copy);
+}
+
+aipu_status_t aipu_run_job(const aipu_ctx_handle_t* ctx, uint64_t job_id,
+    const void* const inputs[], void* const outputs[], int32_t time_out)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->run(inputs, outputs, time_out);
+}
+
+aipu_status_t aipu_run_job_iov(const aipu_ctx_handle_t* ctx, uint64_t job_id,
+    const struct iovec* inputs, uint32_t input_cnt,
+    const struct iovec* outputs, uint32_t output_cnt, int32_t time_out)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipudrv::JobBase* job = nullptr;
+
+    if (ctx == nullptr)
+        return AIPU_STATUS_ERROR_NULL_PTR;
+
+    if (!aipudrv::valid_job_id(job_id))
+        return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+
+    ret = api_get_job(ctx, job_id, &job);
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
+    return job->run_iov(inputs, input_cnt, outputs, output_cnt, time_out);
+}
+
 aipu_status_t aipu_get_partition_count(const aipu_ctx_handle_t* ctx, uint32_t* cnt)
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
@@ -718,6 +944,18 @@ aipu_status_t aipu_config_global(const aipu_ctx_handle_t* ctx, uint64_t types, v
             goto finish;
 
         types &= ~AIPU_CONFIG_TYPE_SIMULATION;
+    } else if (types & AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY) {
+        ret = p_ctx->config_wt_residency((aipu_global_config_wt_residency_t*)config);
+        if (ret != AIPU_STATUS_SUCCESS)
+            goto finish;
+
+        types &= ~AIPU_GLOBAL_CONFIG_TYPE_WT_RESIDENCY;
+    } else if (types & AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN) {
+        ret = p_ctx->config_teardown((aipu_global_config_teardown_t*)config);
+        if (ret != AIPU_STATUS_SUCCESS)
+            goto finish;
+
+        types &= ~AIPU_GLOBAL_CONFIG_TYPE_TEARDOWN;
     }
 
     if (types & AIPU_GLOBAL_CONFIG_TYPE_DISABLE_VER_CHECK)
@@ -97,6 +97,12 @@ std::map<uint32_t, std::string> aipudrv::MainContext::umd_status_string =
         "Alloc Grip ID fail." },
     { AIPU_STATUS_ERROR_ALLOC_GROUP_ID,
         "Alloc Group ID fail." },
+    { AIPU_STATUS_ERROR_GRAPH_LOADING,
+        "The graph is still being loaded asynchronously." },
+    { AIPU_STATUS_ERROR_LOAD_CANCELED,
+        "The asynchronous graph loading was canceled." },
+    { AIPU_STATUS_ERROR_NO_FREE_HANDLE,
+        "No free context/graph/job ID, up to 65535 of each can be alive at once." },
     { AIPU_STATUS_MAX,
         "Status Max value which should not be returned to application." },
     /* AIPU layer library runtime error code */
@@ -43,6 +43,21 @@ inline GRAPH_ID get_graph_id(uint64_t id)
     return (id & (0xFFFFFFFFUL << 32));
 }
 
+inline GRAPH_ID graph_handle2id(uint32_t handle)
+{
+    return ((GRAPH_ID)handle << 32);
+}
+
+inline uint32_t graph_id2handle(GRAPH_ID id)
+{
+    return (id >> 32);
+}
+
+inline uint32_t job_id2handle(JOB_ID id)
+{
+    return (id & 0xFFFFFFFF);
+}
+
 inline bool valid_graph_id(GRAPH_ID id)
 {
     if (id >= (1UL << 32))
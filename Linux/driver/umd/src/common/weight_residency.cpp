@@ -0,0 +1,250 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  weight_residency.cpp
+ * @brief AIPU User Mode Driver (UMD) on-demand BSS weight residency manager implementation
+ */
+
+#include <algorithm>
+#include "weight_residency.h"
+#include "graph.h"
+#include "utils/log.h"
+
+aipudrv::WeightResidency::~WeightResidency()
+{
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_exit = true;
+    }
+    m_cv.notify_all();
+
+    if (m_worker.joinable())
+        m_worker.join();
+}
+
+void aipudrv::WeightResidency::set_budget(uint64_t budget)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    m_budget = budget;
+}
+
+void aipudrv::WeightResidency::add(Graph *graph, uint32_t bss_id, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    Entry entry = {graph, bss_id, size, BSS_EVICTED, 0, 0};
+
+    m_entries.push_back(entry);
+}
+
+void aipudrv::WeightResidency::remove(Graph *graph)
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    /* an in-flight upload still writes to the graph's buffers */
+    m_cv.wait(lock_, [this, graph] {
+        for (auto &entry : m_entries)
+        {
+            if ((entry.graph == graph) && (entry.state == BSS_LOADING))
+                return false;
+        }
+        return true;
+    });
+
+    m_prefetch_queue.erase(std::remove_if(m_prefetch_queue.begin(), m_prefetch_queue.end(),
+        [graph](Entry *entry) { return entry->graph == graph; }), m_prefetch_queue.end());
+
+    for (auto iter = m_entries.begin(); iter != m_entries.end();)
+    {
+        if (iter->graph != graph)
+        {
+            iter++;
+            continue;
+        }
+
+        /* the graph frees its own weight buffers on unload */
+        if (iter->state == BSS_RESIDENT)
+            m_resident_bytes -= iter->size;
+        iter = m_entries.erase(iter);
+    }
+}
+
+/**
+ * @brief evict the least recently used BSS which is not pinned by any job
+ *
+ * @note  called with m_lock held
+ */
+bool aipudrv::WeightResidency::evict_lru()
+{
+    Entry *victim = nullptr;
+
+    for (auto &entry : m_entries)
+    {
+        if ((entry.state != BSS_RESIDENT) || (entry.pin != 0))
+            continue;
+
+        if ((victim == nullptr) || (entry.last_use < victim->last_use))
+            victim = &entry;
+    }
+
+    if (victim == nullptr)
+        return false;
+
+    LOG(LOG_INFO, "evict graph 0x%lx BSS %u weight\n", victim->graph->m_id, victim->bss_id);
+    victim->graph->evict_bss_weight(victim->bss_id);
+    victim->state = BSS_EVICTED;
+    m_resident_bytes -= victim->size;
+    return true;
+}
+
+/**
+ * @brief evict idle BSS until 'size' more bytes fit in the budget
+ *
+ * @note  called with m_lock held
+ */
+bool aipudrv::WeightResidency::make_room(uint64_t size)
+{
+    while ((m_budget != 0) && (m_resident_bytes + size > m_budget))
+    {
+        if (!evict_lru())
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief upload an evicted BSS to device memory
+ *
+ * @note  the memory copy is done out of m_lock, other users of the same
+ *        entry wait for the state leaving BSS_LOADING. the new buffer is
+ *        published to jobs under m_lock.
+ */
+aipu_status_t aipudrv::WeightResidency::upload(std::unique_lock<std::mutex> &lock, Entry &entry)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    BufferDesc *weight = nullptr;
+
+    if (!make_room(entry.size))
+        LOG(LOG_WARN, "resident weight exceeds budget 0x%lx, all BSS are in use\n", m_budget);
+    entry.state = BSS_LOADING;
+    m_resident_bytes += entry.size;
+
+    lock.unlock();
+    ret = entry.graph->upload_bss_weight(entry.bss_id, &weight);
+    lock.lock();
+
+    /* device memory may be short even within budget, drop idle BSS and retry */
+    while ((ret == AIPU_STATUS_ERROR_BUF_ALLOC_FAIL) && evict_lru())
+    {
+        lock.unlock();
+        ret = entry.graph->upload_bss_weight(entry.bss_id, &weight);
+        lock.lock();
+    }
+
+    if (ret == AIPU_STATUS_SUCCESS)
+    {
+        entry.graph->set_bss_weight(entry.bss_id, weight);
+        entry.state = BSS_RESIDENT;
+    } else {
+        entry.state = BSS_EVICTED;
+        m_resident_bytes -= entry.size;
+    }
+    m_cv.notify_all();
+
+    return ret;
+}
+
+/**
+ * @note  called with m_lock held
+ */
+aipudrv::WeightResidency::Entry *aipudrv::WeightResidency::find(Graph *graph, uint32_t bss_id)
+{
+    for (auto &entry : m_entries)
+    {
+        if ((entry.graph == graph) && (entry.bss_id == bss_id))
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+aipu_status_t aipudrv::WeightResidency::acquire(Graph *graph, uint32_t bss_id)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::unique_lock<std::mutex> lock_(m_lock);
+    Entry *entry = find(graph, bss_id);
+
+    /* a BSS without weight has nothing to upload */
+    if (entry == nullptr)
+        return ret;
+
+    m_cv.wait(lock_, [entry] { return entry->state != BSS_LOADING; });
+
+    /* pin before upload so that no other upload evicts it once resident */
+    entry->pin++;
+    entry->last_use = ++m_tick;
+
+    if (entry->state == BSS_EVICTED)
+    {
+        ret = upload(lock_, *entry);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            LOG(LOG_ERR, "upload graph 0x%lx BSS %u weight [fail]\n", graph->m_id, bss_id);
+            entry->pin--;
+        }
+    }
+
+    return ret;
+}
+
+void aipudrv::WeightResidency::release(Graph *graph, uint32_t bss_id)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    Entry *entry = find(graph, bss_id);
+
+    if ((entry != nullptr) && (entry->pin > 0))
+        entry->pin--;
+}
+
+void aipudrv::WeightResidency::prefetch(Graph *graph, uint32_t bss_id)
+{
+    std::lock_guard<std::mutex> lock_(m_lock);
+    Entry *entry = find(graph, bss_id);
+
+    if ((entry == nullptr) || (entry->state != BSS_EVICTED))
+        return;
+
+    if (std::find(m_prefetch_queue.begin(), m_prefetch_queue.end(), entry) == m_prefetch_queue.end())
+        m_prefetch_queue.push_back(entry);
+
+    if (!m_worker.joinable())
+        m_worker = std::thread(&WeightResidency::prefetch_worker, this);
+    m_cv.notify_all();
+}
+
+void aipudrv::WeightResidency::prefetch_worker()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    while (true)
+    {
+        m_cv.wait(lock_, [this] { return m_exit || !m_prefetch_queue.empty(); });
+        if (m_exit)
+            break;
+
+        Entry *entry = m_prefetch_queue.front();
+        m_prefetch_queue.pop_front();
+        if (entry->state != BSS_EVICTED)
+            continue;
+
+        /* prefetch may drop idle BSS, but never one a running job pinned */
+        if (!make_room(entry->size))
+            continue;
+
+        entry->last_use = ++m_tick;
+        upload(lock_, *entry);
+    }
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  weight_residency.h
+ * @brief AIPU User Mode Driver (UMD) on-demand BSS weight residency manager header
+ */
+
+#ifndef _WEIGHT_RESIDENCY_H_
+#define _WEIGHT_RESIDENCY_H_
+
+#include <list>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "standard_api.h"
+
+namespace aipudrv
+{
+class Graph;
+
+/**
+ * @brief track the device residency of BSS weight buffers of graphs loaded with
+ *        'wt_on_demand', one instance per context.
+ *
+ * @note  a job runs the subgraphs of one BSS at a time, the BSS weight buffer is
+ *        uploaded before they are scheduled and pinned until they are done, while
+ *        the BSS of the next subgraphs gets prefetched. if resident weights exceed
+ *        the budget, unpinned BSS weight buffers are evicted in LRU order. budget 0
+ *        means no limit.
+ */
+class WeightResidency
+{
+private:
+    enum
+    {
+        BSS_EVICTED,
+        BSS_LOADING,
+        BSS_RESIDENT,
+    };
+
+    struct Entry
+    {
+        Graph *graph;
+        uint32_t bss_id;
+        uint64_t size;
+        uint32_t state;
+        uint32_t pin;
+        uint64_t last_use;
+    };
+
+private:
+    uint64_t m_budget = 0;
+    uint64_t m_resident_bytes = 0;
+    uint64_t m_tick = 0;
+    std::list<Entry> m_entries;
+    std::deque<Entry*> m_prefetch_queue;
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::thread m_worker;
+    bool m_exit = false;
+
+private:
+    Entry *find(Graph *graph, uint32_t bss_id);
+    bool evict_lru();
+    bool make_room(uint64_t size);
+    aipu_status_t upload(std::unique_lock<std::mutex> &lock, Entry &entry);
+    void prefetch_worker();
+
+public:
+    void set_budget(uint64_t budget);
+    void add(Graph *graph, uint32_t bss_id, uint64_t size);
+    void remove(Graph *graph);
+    aipu_status_t acquire(Graph *graph, uint32_t bss_id);
+    void release(Graph *graph, uint32_t bss_id);
+    void prefetch(Graph *graph, uint32_t bss_id);
+
+public:
+    WeightResidency() {};
+    ~WeightResidency();
+    WeightResidency(const WeightResidency& residency) = delete;
+    WeightResidency& operator=(const WeightResidency& residency) = delete;
+};
+}
+
+#endif /* _WEIGHT_RESIDENCY_H_ */
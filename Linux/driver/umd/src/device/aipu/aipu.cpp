@@ -19,6 +19,7 @@
 #include "ukmemory.h"
 #include "job_base.h"
 #include "helper.h"
+#include "usdt.h"
 
 aipudrv::Aipu* aipudrv::Aipu::m_aipu = nullptr;
 std::mutex aipudrv::Aipu::m_tex;
@@ -218,6 +219,7 @@ aipu_ll_status_t aipudrv::Aipu::get_status(uint32_t max_cnt, bool of_this_thread
     JobBase *job = (JobBase *)jobbase;
     JobBase *done_job = nullptr;
     aipu_job_callback_func_t job_callback_func = nullptr;
+    uint32_t state = 0;
 
     status_query.of_this_thread = of_this_thread;
     status_query.max_cnt = max_cnt;
@@ -242,15 +244,24 @@ aipu_ll_status_t aipudrv::Aipu::get_status(uint32_t max_cnt, bool of_this_thread
              * to toggle status. it's absolutely not a bottleneck.
              */
             while (done_job->get_job_status() != AIPU_JOB_STATUS_SCHED);
-            done_job->update_job_status(status_query.status[i].state);
-            job_callback_func = done_job->get_job_cb();
+            state = status_query.status[i].state;
 
-            /* deliver done job to backend timely. */
-            if (job_callback_func != nullptr)
+            /**
+             * a job with on-demand weight commits its next grid on a done grid,
+             * it stays scheduled unless that commit fails.
+             */
+            if ((state == AIPU_JOB_STATE_DONE) && done_job->wt_grid_pending())
             {
-                job_callback_func(status_query.status[i].job_id,
-                    (aipu_job_status_t)status_query.status[i].state);
+                done_job->update_job_status(state);
+                state = done_job->get_job_status();
+            } else {
+                done_job->update_job_status(state);
             }
+            job_callback_func = done_job->get_job_cb();
+
+            /* deliver done job to backend timely */
+            if ((job_callback_func != nullptr) && (state != AIPU_JOB_STATUS_SCHED))
+                job_callback_func(status_query.status[i].job_id, (aipu_job_status_t)state);
 
             if (done_job == job)
                 ret = AIPU_LL_STATUS_SUCCESS;
@@ -286,6 +297,7 @@ aipu_ll_status_t aipudrv::Aipu::poll_status(uint32_t max_cnt, int32_t time_out,
     if (job->get_job_status() == AIPU_JOB_STATUS_DONE)
         return ret;
 
+    UMD_USDT2(poll_enter, job->get_id(), time_out);
     poll_list.fd = m_fd;
     poll_list.events = POLLIN | POLLPRI;
 
@@ -303,9 +315,11 @@ aipu_ll_status_t aipudrv::Aipu::poll_status(uint32_t max_cnt, int32_t time_out,
         if (kret < 0)
         {
             LOG(LOG_ERR, "poll /dev/aipu [fail]");
-            return AIPU_LL_STATUS_ERROR_POLL_FAIL;
+            ret = AIPU_LL_STATUS_ERROR_POLL_FAIL;
+            goto out;
         } else if (kret == 0) {
-            return AIPU_LL_STATUS_ERROR_POLL_TIMEOUT;
+            ret = AIPU_LL_STATUS_ERROR_POLL_TIMEOUT;
+            goto out;
         }
 
         /* normally return */
@@ -313,10 +327,12 @@ aipu_ll_status_t aipudrv::Aipu::poll_status(uint32_t max_cnt, int32_t time_out,
         {
             ret = get_status(max_cnt, of_this_thread, jobbase);
             if (ret == AIPU_LL_STATUS_SUCCESS)
-                return ret;
+                goto out;
         }
     } while (time_out == -1);
 
+out:
+    UMD_USDT2(poll_exit, job->get_id(), ret);
     return ret;
 }
 
@@ -445,6 +461,7 @@ aipu_ll_status_t aipudrv::Aipu::ioctl_cmd(uint32_t cmd, void *arg)
             m_dma_buf_map[dma_buf.fd] = dma_buf;
             m_dram->add_tracking(dma_buf.pa, dma_buf.bytes,
                 MemOperationAlloc, name.c_str(), false, 0);
+            UMD_USDT3(dmabuf_alloc, dma_buf.fd, dma_buf.pa, dma_buf.bytes);
             }
             break;
 
@@ -468,6 +485,7 @@ aipu_ll_status_t aipudrv::Aipu::ioctl_cmd(uint32_t cmd, void *arg)
                 m_dma_buf_map.erase(dma_buf_fd);
                 close(dma_buf_fd);
             }
+            UMD_USDT1(dmabuf_free, dma_buf_fd);
             }
             break;
 
@@ -504,6 +522,7 @@ aipu_ll_status_t aipudrv::Aipu::ioctl_cmd(uint32_t cmd, void *arg)
                 m_dma_buf_map[dma_buf->fd] = *dma_buf;
                 m_dram->add_tracking(dma_buf->pa, dma_buf->bytes,
                     MemOperationAlloc, name.c_str(), false, 0);
+                UMD_USDT3(dmabuf_attach, dma_buf->fd, dma_buf->pa, dma_buf->bytes);
                 break;
             }
 
@@ -527,6 +546,7 @@ aipu_ll_status_t aipudrv::Aipu::ioctl_cmd(uint32_t cmd, void *arg)
                         MemOperationFree, name.c_str(), false, 0);
                     m_dma_buf_map.erase(dmabuf_fd);
                 }
+                UMD_USDT1(dmabuf_detach, dmabuf_fd);
                 break;
             }
         case AIPU_IOCTL_GET_VERSION:
@@ -17,6 +17,7 @@
 #include <cstring>
 #include "kmd/armchina_aipu.h"
 #include "ukmemory.h"
+#include "reclaimer.h"
 #include "utils/log.h"
 #include "utils/helper.h"
 
@@ -61,9 +62,16 @@ aipu_status_t aipudrv::UKMemory::malloc(uint32_t size, uint32_t align, BufferDes
         buf_req.data_type = AIPU_MM_DATA_TYPE_TCB;
 
     kret = ioctl(m_fd, cmd, &buf_req);
+
+    /* buffers of deferred teardowns may be on their way back */
+    if ((kret != 0) && Reclaimer::get_reclaimer().drain())
+        kret = ioctl(m_fd, cmd, &buf_req);
+
     if (kret != 0)
     {
         LOG(LOG_ALERT, "alloc buffer: size 0x%x [fail]", size);
+        UMD_USDT2(mem_alloc_fail, size, asid_mem_cfg);
+        m_metrics.alloc_fail();
         return AIPU_STATUS_ERROR_BUF_ALLOC_FAIL;
     }
 
@@ -72,6 +80,7 @@ aipu_status_t aipudrv::UKMemory::malloc(uint32_t size, uint32_t align, BufferDes
     if (ptr == MAP_FAILED)
     {
         ioctl(m_fd, free_cmd, &buf_req.desc);
+        m_metrics.alloc_fail();
         return AIPU_STATUS_ERROR_BUF_ALLOC_FAIL;
     }
 
@@ -88,13 +97,15 @@ aipu_status_t aipudrv::UKMemory::malloc(uint32_t size, uint32_t align, BufferDes
 
     (*desc)->init(base, buf_req.desc.pa,
         buf_req.desc.bytes, size, buf_req.desc.dev_offset,
-        buf_req.desc.region);
+        (buf_req.desc.asid << 8) | buf_req.desc.region);
 
     buf.init(ptr, *desc);
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     m_allocated[buf_req.desc.pa] = buf;
     pthread_rwlock_unlock(&m_lock);
     add_tracking(buf_req.desc.pa, size, MemOperationAlloc, str, false, 0);
+    UMD_USDT3(mem_alloc, buf_req.desc.pa, buf_req.desc.bytes,
+        (buf_req.desc.asid << 8) | buf_req.desc.region);
 
     return AIPU_STATUS_SUCCESS;
 }
@@ -112,7 +123,7 @@ aipu_status_t aipudrv::UKMemory::free(BufferDesc** desc, const char* str)
     if (*desc == nullptr)
         return AIPU_STATUS_ERROR_NULL_PTR;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     iter = m_allocated.find((*desc)->pa);
     if ((iter == m_allocated.end()) ||
         (iter->second.desc->size != (*desc)->size))
@@ -148,7 +159,11 @@ unlock:
     pthread_rwlock_unlock(&m_lock);
 
     if (ret == AIPU_STATUS_SUCCESS)
+    {
         add_tracking(pa, size, MemOperationFree, str, false, 0);
+        if (size != 0)
+            UMD_USDT2(mem_free, pa, size);
+    }
 
     return ret;
 }
@@ -166,7 +181,7 @@ aipu_status_t aipudrv::UKMemory::free_phybuffer(BufferDesc* desc, const char* st
     if (desc == nullptr)
         return AIPU_STATUS_ERROR_NULL_PTR;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     iter = m_allocated.find(desc->pa);
     if ((iter == m_allocated.end()) ||
         (iter->second.desc->size != desc->size))
@@ -199,7 +214,11 @@ unlock:
     pthread_rwlock_unlock(&m_lock);
 
     if (ret == AIPU_STATUS_SUCCESS)
+    {
         add_tracking(pa, size, MemOperationFree, str, false, 0);
+        if (size != 0)
+            UMD_USDT2(mem_free, pa, size);
+    }
 
     return ret;
 }
@@ -218,7 +237,7 @@ aipu_status_t aipudrv::UKMemory::free_all(void)
     DEV_PA_64 pa = 0;
     uint64_t size = 0;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     for (auto iter = m_allocated.begin(); iter != m_allocated.end(); iter++)
     {
         desc = iter->second.desc;
@@ -238,7 +257,7 @@ aipu_status_t aipudrv::UKMemory::free_all(void)
         desc = nullptr;
         pthread_rwlock_unlock(&m_lock);
         add_tracking(pa, size, MemOperationFree, "normal", false, 0);
-        pthread_rwlock_wrlock(&m_lock);
+        lock_wr();
     }
 
     m_allocated.clear();
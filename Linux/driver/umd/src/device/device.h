@@ -55,6 +55,12 @@ inline aipu_status_t test_get_device(uint32_t graph_version, DeviceBase** dev,
         (graph_version != AIPU_LOADABLE_GRAPH_ELF_V0))
         return AIPU_STATUS_ERROR_GVERSION_UNSUPPORTED;
 
+#ifdef UMD_TEST_HOOKS
+    /* a mock device set by the context owner serves any graph */
+    if ((*dev != nullptr) && ((*dev)->get_dev_type() == DEV_TYPE_MOCK))
+        return ret;
+#endif
+
 #if (defined SIMULATION)
     {
         std::lock_guard<std::mutex> lock_(m_tex);
@@ -515,8 +515,10 @@ aipu_ll_status_t aipudrv::SimulatorV3::poll_status(uint32_t max_cnt, int32_t tim
         {
             cmd_pool_erase_job(cmd_pool_id, job);
             m_done_queue.erase(jobbase);
-            job->update_job_status(AIPU_JOB_STATE_DONE);
             pthread_rwlock_unlock(&m_lock);
+
+            /* out of m_lock, it may schedule the next grid of the job */
+            job->update_job_status(AIPU_JOB_STATE_DONE);
             break;
         }
         pthread_rwlock_unlock(&m_lock);
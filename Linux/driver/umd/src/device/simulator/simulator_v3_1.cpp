@@ -428,8 +428,10 @@ aipu_ll_status_t aipudrv::SimulatorV3_1::poll_status(uint32_t max_cnt, int32_t t
         if (m_done_set.count(jobbase))
         {
             m_done_set.erase(jobbase);
-            job->update_job_status(AIPU_JOB_STATE_DONE);
             pthread_rwlock_unlock(&m_lock);
+
+            /* out of m_lock, it may schedule the next grid of the job */
+            job->update_job_status(AIPU_JOB_STATE_DONE);
             break;
         }
         pthread_rwlock_unlock(&m_lock);
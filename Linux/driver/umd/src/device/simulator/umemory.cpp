@@ -11,6 +11,7 @@
 #include <unistd.h>
 #include <cstring>
 #include "umemory.h"
+#include "reclaimer.h"
 #include "utils/log.h"
 #include "utils/helper.h"
 
@@ -194,7 +195,7 @@ aipu_status_t aipudrv::UMemory::malloc_internal(uint32_t size, uint32_t align, B
     if (malloc_page > m_memblock[asid][mem_region].bit_cnt)
         return AIPU_STATUS_ERROR_BUF_ALLOC_FAIL;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     i = get_next_alinged_page_no(0, align, (asid << 8) | mem_region);
     while ((i + malloc_page) < m_memblock[asid][mem_region].bit_cnt)
     {
@@ -237,6 +238,7 @@ aipu_status_t aipudrv::UMemory::malloc(uint32_t size, uint32_t align, BufferDesc
     aipu_status_t ret = AIPU_STATUS_ERROR_BUF_ALLOC_FAIL;
     uint32_t mem_region = asid_mem_cfg & 0xff;
     uint32_t asid = (asid_mem_cfg >> 8) & 0xff;
+    bool reclaimed = false;
 
     if (*desc == nullptr)
     {
@@ -253,6 +255,7 @@ aipu_status_t aipudrv::UMemory::malloc(uint32_t size, uint32_t align, BufferDesc
             mem_region = MEM_REGION_DDR;
     }
 
+retry:
     if (mem_region != MEM_REGION_DDR)
         ret = malloc_internal(size, align, *desc, str, (asid << 8) | mem_region);
 
@@ -266,6 +269,17 @@ aipu_status_t aipudrv::UMemory::malloc(uint32_t size, uint32_t align, BufferDesc
         }
     }
 
+    /* buffers of deferred teardowns may be on their way back */
+    if ((ret == AIPU_STATUS_ERROR_BUF_ALLOC_FAIL) && !reclaimed)
+    {
+        reclaimed = true;
+        if (Reclaimer::get_reclaimer().drain())
+            goto retry;
+    }
+
+    if (ret == AIPU_STATUS_ERROR_BUF_ALLOC_FAIL)
+        m_metrics.alloc_fail();
+
     return ret;
 }
 
@@ -284,7 +298,7 @@ aipu_status_t aipudrv::UMemory::free(BufferDesc** desc, const char* str)
     if ((*desc)->size == 0)
         return AIPU_STATUS_ERROR_INVALID_SIZE;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     iter = m_allocated.find((*desc)->pa);
     if (iter == m_allocated.end())
     {
@@ -347,7 +361,7 @@ aipu_status_t aipudrv::UMemory::free_phybuffer(BufferDesc* desc, const char* str
     if (desc->size == 0)
         return AIPU_STATUS_ERROR_INVALID_SIZE;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     iter = m_allocated.find(desc->pa);
     if (iter == m_allocated.end())
     {
@@ -410,7 +424,7 @@ aipu_status_t aipudrv::UMemory::reserve_mem(DEV_PA_32 addr, uint32_t size,
         (*desc)->reset();
     }
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
 
     if (addr > m_memblock[asid][MEM_REGION_SRAM].base && m_memblock[asid][MEM_REGION_SRAM].size != 0)
     {
@@ -500,7 +514,7 @@ aipu_status_t aipudrv::UMemory::free_all(void)
     DEV_PA_64 pa = 0;
     uint64_t size = 0;
 
-    pthread_rwlock_wrlock(&m_lock);
+    lock_wr();
     for (auto mem_map : m_allocated_buf_map)
     {
         for (auto iter = mem_map->begin(); iter != mem_map->end(); iter++)
@@ -531,7 +545,7 @@ aipu_status_t aipudrv::UMemory::free_all(void)
             pthread_rwlock_unlock(&m_lock);
             (mem_map == &m_reserved) ? promt = "rsv" : promt = "normal";
             add_tracking(pa, size, MemOperationFree, promt, false, 0);
-            pthread_rwlock_wrlock(&m_lock);
+            lock_wr();
         }
 
         mem_map->clear();
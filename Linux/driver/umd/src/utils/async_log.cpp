@@ -0,0 +1,376 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  async_log.cpp
+ * @brief UMD asynchronous logger implementation
+ */
+
+#include <pthread.h>
+#include <ctime>
+#include <cstdlib>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "standard_api.h"
+#include "log.h"
+
+#define UMD_LOG_RECORD_CNT 4096
+
+extern volatile char UMD_LOG_TIMESTAMP;
+
+static_assert(sizeof(LogRecord) == UMD_LOG_RECORD_SIZE, "log record size");
+
+namespace
+{
+/**
+ * @brief bounded multi-producer ring of log records drained by one writer thread
+ *
+ * @note  a record is free for claim ticket 'pos' when its seq is pos, ready to be
+ *        written when it's pos + 1. the writer frees it for the next round.
+ */
+class AsyncLogger
+{
+private:
+    LogRecord *m_ring = nullptr;
+    std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_waiting{false};
+    std::once_flag m_once;
+    std::thread m_writer;
+    std::mutex m_lock;
+    std::condition_variable m_ready_cv;
+    std::condition_variable m_written_cv;
+    bool m_stop = false;
+
+private:
+    void start();
+    void run();
+    bool ready()
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        return m_ring[head % UMD_LOG_RECORD_CNT].seq.load(std::memory_order_acquire) == head + 1;
+    }
+    void drain();
+    void wait_written(uint64_t pos);
+
+public:
+    LogRecord *claim();
+    void publish(LogRecord *rec);
+    void flush()
+    {
+        if (m_running.load(std::memory_order_acquire))
+            wait_written(m_tail.load(std::memory_order_acquire));
+    }
+    void stop();
+    void forked()
+    {
+        /* the writer thread isn't copied into a child process */
+        m_running.store(false, std::memory_order_release);
+    }
+
+public:
+    AsyncLogger() {}
+    ~AsyncLogger()
+    {
+        stop();
+    }
+};
+
+AsyncLogger g_logger;
+
+void AsyncLogger::start()
+{
+    const char *async_env = getenv("UMD_LOG_ASYNC");
+
+    if ((async_env != nullptr) && ((async_env[0] == 'n') || (async_env[0] == 'N')))
+        return;
+
+    m_ring = new LogRecord[UMD_LOG_RECORD_CNT];
+    for (uint64_t i = 0; i < UMD_LOG_RECORD_CNT; i++)
+        m_ring[i].seq.store(i, std::memory_order_relaxed);
+
+    pthread_atfork(nullptr, nullptr, [] { g_logger.forked(); });
+    m_writer = std::thread(&AsyncLogger::run, this);
+    m_running.store(true, std::memory_order_release);
+}
+
+void AsyncLogger::run()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    while (true)
+    {
+        lock_.unlock();
+        drain();
+        lock_.lock();
+        m_written_cv.notify_all();
+
+        if (m_stop)
+            break;
+
+        /* pairs with the fence in publish(), either side sees the other */
+        m_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready())
+            m_ready_cv.wait_for(lock_, std::chrono::milliseconds(100));
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::drain()
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    char buf[512] = {0};
+
+    while (true)
+    {
+        LogRecord *rec = &m_ring[head % UMD_LOG_RECORD_CNT];
+        int len = 0;
+
+        if (rec->seq.load(std::memory_order_acquire) != head + 1)
+            break;
+
+        len = rec->format(buf, sizeof(buf), rec->fmt, rec->args);
+        if (len >= (int)sizeof(buf))
+        {
+            std::vector<char> long_buf(len + 1);
+
+            rec->format(long_buf.data(), long_buf.size(), rec->fmt, rec->args);
+            umd_log_write(rec->level, rec->time_ns, rec->tid, rec->file, rec->line,
+                rec->func, long_buf.data());
+        } else {
+            umd_log_write(rec->level, rec->time_ns, rec->tid, rec->file, rec->line,
+                rec->func, buf);
+        }
+
+        rec->seq.store(head + UMD_LOG_RECORD_CNT, std::memory_order_release);
+        m_head.store(++head, std::memory_order_release);
+    }
+
+    fflush(stdout);
+}
+
+void AsyncLogger::wait_written(uint64_t pos)
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    m_ready_cv.notify_one();
+    m_written_cv.wait(lock_, [this, pos] {
+        return (m_head.load(std::memory_order_acquire) >= pos) ||
+            !m_running.load(std::memory_order_acquire);
+    });
+}
+
+LogRecord *AsyncLogger::claim()
+{
+    uint64_t pos = 0;
+
+    if (!m_running.load(std::memory_order_acquire))
+    {
+        std::call_once(m_once, &AsyncLogger::start, this);
+        if (!m_running.load(std::memory_order_acquire))
+            return nullptr;
+    }
+
+    pos = m_tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        LogRecord *rec = &m_ring[pos % UMD_LOG_RECORD_CNT];
+        uint64_t seq = rec->seq.load(std::memory_order_acquire);
+
+        if (seq == pos)
+        {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return rec;
+        } else if (seq < pos) {
+            /* full: the record of the previous round isn't written yet */
+            if (!m_running.load(std::memory_order_acquire))
+                return nullptr;
+            m_ready_cv.notify_one();
+            std::this_thread::yield();
+            pos = m_tail.load(std::memory_order_relaxed);
+        } else {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogger::publish(LogRecord *rec)
+{
+    uint64_t pos = rec->seq.load(std::memory_order_relaxed);
+
+    rec->seq.store(pos + 1, std::memory_order_release);
+
+    if (rec->level == LOG_ERR)
+    {
+        wait_written(pos + 1);
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_ready_cv.notify_one();
+    }
+}
+
+void AsyncLogger::stop()
+{
+    if (!m_writer.joinable())
+        return;
+
+    if (m_running.load(std::memory_order_acquire))
+    {
+        {
+            std::lock_guard<std::mutex> lock_(m_lock);
+            m_stop = true;
+        }
+        m_ready_cv.notify_one();
+        m_writer.join();
+    } else {
+        m_writer.detach();
+    }
+
+    /* later logs are written synchronously, m_ring stays for a claim in progress */
+    m_running.store(false, std::memory_order_release);
+}
+}
+
+LogRecord *umd_log_claim()
+{
+    return g_logger.claim();
+}
+
+void umd_log_publish(LogRecord *rec)
+{
+    g_logger.publish(rec);
+}
+
+void umd_log_flush()
+{
+    g_logger.flush();
+}
+
+int32_t umd_log_tid()
+{
+    static thread_local int32_t tid = 0;
+
+    if (tid == 0)
+        tid = gettid();
+
+    return tid;
+}
+
+/**
+ * @brief the time stamp of umd_timestamp_helper(4), the date part is formatted once a second
+ */
+static const char *log_timestamp(uint64_t time_ns)
+{
+    static thread_local time_t last_sec = -1;
+    static thread_local char date[32];
+    static thread_local char stamp[48];
+    time_t sec = time_ns / 1000000000;
+
+    if (UMD_LOG_TIMESTAMP == 'n' || UMD_LOG_TIMESTAMP == 'N')
+        return "";
+
+    if (sec != last_sec)
+    {
+        struct tm now_tm = {0};
+
+        localtime_r(&sec, &now_tm);
+        strftime(date, sizeof(date), "%F %T", &now_tm);
+        last_sec = sec;
+    }
+
+    snprintf(stamp, sizeof(stamp), "%s:%lu", date,
+        (unsigned long)(time_ns % 1000000000 / 1000));
+    return stamp;
+}
+
+void umd_log_write(int32_t level, uint64_t time_ns, int32_t tid, const char *file,
+    int32_t line, const char *func, const char *msg)
+{
+    static const char *level_flag[] = {
+        "[UMD ERR] ", "[UMD WAR] ", "[UMD ALT]", "[UMD INF]", "[UMD DBG]"
+    };
+    char out[640] = {0};
+    int len = 0;
+
+    /* the line layout is the one of the synchronous printf() LOG() used before */
+    switch (level)
+    {
+        case LOG_ERR:
+        case LOG_WARN:
+            len = snprintf(out, sizeof(out), "%s%s%s:%d:%s: %s\n", log_timestamp(time_ns),
+                level_flag[level], file, line, func, msg);
+            break;
+
+        case LOG_ALERT:
+        case LOG_INFO:
+        case LOG_DEBUG:
+            len = snprintf(out, sizeof(out), "%s %s <%d> %s\n", log_timestamp(time_ns),
+                level_flag[level], tid, msg);
+            break;
+
+        case LOG_DEFAULT:
+            len = snprintf(out, sizeof(out), "%s\n", msg);
+            break;
+
+        default:
+            return;
+    }
+
+    if (len < (int)sizeof(out))
+    {
+        fwrite(out, 1, len, stdout);
+        return;
+    }
+
+    /* too long for the line buffer, 'msg' is the bulk of it */
+    len -= strlen(msg) + 1;
+    if (len >= (int)sizeof(out))
+        len = sizeof(out) - 1;
+
+    flockfile(stdout);
+    fwrite(out, 1, len, stdout);
+    fputs(msg, stdout);
+    fputc('\n', stdout);
+    funlockfile(stdout);
+}
+
+uint32_t umd_log_scan_convs(const char *fmt, char *convs, uint32_t max)
+{
+    uint32_t cnt = 0;
+
+    while ((*fmt != '\0') && (cnt < max))
+    {
+        if (*fmt++ != '%')
+            continue;
+
+        if (*fmt == '%')
+        {
+            fmt++;
+            continue;
+        }
+
+        /* flags, width, precision and length modifier up to the conversion */
+        while ((*fmt != '\0') && (strchr("diouxXeEfFgGaAcspn", *fmt) == nullptr))
+        {
+            if ((*fmt == '*') && (cnt < max))
+                convs[cnt++] = '*';
+            fmt++;
+        }
+
+        if ((*fmt != '\0') && (cnt < max))
+            convs[cnt++] = *fmt++;
+    }
+
+    return cnt;
+}
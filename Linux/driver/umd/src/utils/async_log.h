@@ -0,0 +1,291 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  async_log.h
+ * @brief UMD asynchronous logger header
+ */
+
+#ifndef _ASYNC_LOG_H_
+#define _ASYNC_LOG_H_
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define UMD_LOG_RECORD_SIZE 256
+
+typedef int (*umd_log_format_t)(char *buf, size_t size, const char *fmt, const char *args);
+
+/**
+ * @brief a log line whose arguments are kept binary until the writer thread formats it
+ *
+ * @note  file/func/fmt are string literals, they're referred to instead of copied
+ */
+struct LogRecord
+{
+    std::atomic<uint64_t> seq;
+    uint64_t time_ns;
+    const char *file;
+    const char *func;
+    const char *fmt;
+    umd_log_format_t format;
+    int32_t level;
+    int32_t line;
+    int32_t tid;
+    char args[UMD_LOG_RECORD_SIZE - 60];
+};
+
+/**
+ * @brief This function is used to claim a free record of the async logger
+ *
+ * @retval nullptr if the async logger is off, the caller then logs synchronously
+ *
+ * @note it waits for the writer thread if all records are in use, nothing is dropped
+ */
+LogRecord *umd_log_claim();
+
+/**
+ * @brief This function is used to hand a claimed record to the writer thread
+ *
+ * @note an error record is written before returning so it's not lost on a crash
+ */
+void umd_log_publish(LogRecord *rec);
+
+/**
+ * @brief This function is used to wait until the records published so far are written
+ */
+void umd_log_flush();
+
+/**
+ * @brief This function is used to write a formatted log line with its level prefix
+ */
+void umd_log_write(int32_t level, uint64_t time_ns, int32_t tid, const char *file,
+    int32_t line, const char *func, const char *msg);
+
+/**
+ * @brief This function is used to get the conversion of each argument of a printf format,
+ *        '*' for a width or precision argument
+ *
+ * @retval argument count found, at most 'max'
+ */
+uint32_t umd_log_scan_convs(const char *fmt, char *convs, uint32_t max);
+
+/**
+ * @brief This function is used to get the kernel thread ID of the caller, cached per thread
+ */
+int32_t umd_log_tid();
+
+namespace async_log
+{
+/**
+ * @brief binary encoding of a printf argument; a char pointer printed with %s is
+ *        copied since it may be gone by the time the record is formatted
+ */
+template<typename T, bool IsStr = std::is_same<typename std::decay<T>::type, char *>::value ||
+    std::is_same<typename std::decay<T>::type, const char *>::value>
+struct Codec
+{
+    static_assert(std::is_trivially_copyable<T>::value, "log argument not trivially copyable");
+
+    typedef T type;
+    static constexpr size_t fixed = sizeof(T);
+
+    static bool encode(char *&p, size_t &, T v, char)
+    {
+        memcpy(p, &v, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+    static T decode(const char *&p)
+    {
+        T v;
+
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+};
+
+template<typename T>
+struct Codec<T, true>
+{
+    typedef const char *type;
+    static constexpr size_t fixed = 1 + sizeof(const char *);
+
+    /* a string takes its fixed bytes plus what's spare, it fails beyond that */
+    static bool encode(char *&p, size_t &spare, const char *v, char conv)
+    {
+        size_t len = 0;
+
+        if ((conv != 's') || (v == nullptr))
+        {
+            *p++ = 0;
+            memcpy(p, &v, sizeof(v));
+            p += sizeof(v);
+            return true;
+        }
+
+        len = strnlen(v, fixed + spare - 1);
+        if (len + 2 > fixed + spare)
+            return false;
+
+        *p++ = 1;
+        memcpy(p, v, len);
+        p[len] = '\0';
+        p += len + 1;
+        if (len + 2 > fixed)
+            spare -= len + 2 - fixed;
+        return true;
+    }
+    static const char *decode(const char *&p)
+    {
+        const char *v = nullptr;
+
+        if (*p++ == 0)
+        {
+            memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            return v;
+        }
+
+        v = p;
+        p += strlen(v) + 1;
+        return v;
+    }
+};
+
+template<typename... Args>
+struct FixedSize
+{
+    static constexpr size_t value = 0;
+};
+
+template<typename T, typename... Args>
+struct FixedSize<T, Args...>
+{
+    static constexpr size_t value = Codec<T>::fixed + FixedSize<Args...>::value;
+};
+
+template<typename Tuple, size_t... I>
+int format_tuple(char *buf, size_t size, const char *fmt, const Tuple &args,
+    std::index_sequence<I...>)
+{
+    /* the trailing 0 is never read, it only keeps a format without arguments non-literal */
+    return snprintf(buf, size, fmt, std::get<I>(args)..., 0);
+}
+
+/**
+ * @brief format the arguments encoded by encode() with the same 'Args'
+ */
+template<typename... Args>
+int format(char *buf, size_t size, const char *fmt, const char *args)
+{
+    /* braced initialization decodes from left to right */
+    std::tuple<typename Codec<Args>::type...> values{Codec<Args>::decode(args)...};
+
+    return format_tuple(buf, size, fmt, values, std::index_sequence_for<Args...>());
+}
+
+/**
+ * @retval false if the arguments, %s strings included, don't fit in 'size' bytes
+ */
+template<typename... Args>
+bool encode(char *buf, size_t size, const char *fmt, Args... args)
+{
+    constexpr size_t fixed = FixedSize<Args...>::value;
+    char convs[sizeof...(Args) + 1] = {0};
+    size_t spare = size - fixed;
+    uint32_t idx = 0;
+    bool fit = true;
+
+    if (fixed > size)
+        return false;
+
+    umd_log_scan_convs(fmt, convs, sizeof...(Args));
+    (void)spare;
+    (void)idx;
+    (void)std::initializer_list<int>{
+        (fit = fit && Codec<Args>::encode(buf, spare, args, convs[idx++]), 0)...
+    };
+    return fit;
+}
+
+/**
+ * @brief format in the calling thread, when the async logger is off or the arguments
+ *        don't fit in a record
+ *
+ * @note  the records queued before are written first, so that the lines of a thread
+ *        keep their order.
+ */
+template<typename... Args>
+void write_sync(int32_t level, uint64_t time_ns, const char *file, int32_t line,
+    const char *func, const char *fmt, Args... args)
+{
+    char msg[512] = {0};
+    int len = snprintf(msg, sizeof(msg), fmt, args..., 0);
+
+    umd_log_flush();
+
+    if (len >= (int)sizeof(msg))
+    {
+        std::vector<char> long_msg(len + 1);
+
+        snprintf(long_msg.data(), long_msg.size(), fmt, args..., 0);
+        umd_log_write(level, time_ns, umd_log_tid(), file, line, func, long_msg.data());
+        return;
+    }
+
+    umd_log_write(level, time_ns, umd_log_tid(), file, line, func, msg);
+}
+}
+
+/**
+ * @brief This function is used to log a line through the async logger
+ *
+ * @note only the time stamp is taken and the arguments are copied in the calling thread,
+ *       the writer thread formats the line. a line whose arguments (e.g. a long %s)
+ *       don't fit in a record is formatted in the calling thread instead, so it's never
+ *       cut. see LOG() for the level check.
+ */
+template<typename... Args>
+void umd_log(int32_t level, const char *file, int32_t line, const char *func,
+    const char *fmt, Args... args)
+{
+    uint64_t time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    LogRecord *rec = nullptr;
+    char encoded[sizeof(rec->args)] = {0};
+
+    /* encoded before claiming, a claimed record can't be given back */
+    if (async_log::encode(encoded, sizeof(encoded), fmt, args...))
+        rec = umd_log_claim();
+
+    if (rec == nullptr)
+    {
+        async_log::write_sync(level, time_ns, file, line, func, fmt, args...);
+        return;
+    }
+
+    rec->time_ns = time_ns;
+    rec->file = file;
+    rec->func = func;
+    rec->fmt = fmt;
+    rec->format = async_log::format<Args...>;
+    rec->level = level;
+    rec->line = line;
+    rec->tid = umd_log_tid();
+    memcpy(rec->args, encoded, sizeof(rec->args));
+    umd_log_publish(rec);
+}
+
+#endif /* _ASYNC_LOG_H_ */
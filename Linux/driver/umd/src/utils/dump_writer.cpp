@@ -0,0 +1,502 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  dump_writer.cpp
+ * @brief UMD buffer dump writer implementation
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "standard_api.h"
+#include "log.h"
+#include "dump_writer.h"
+
+#define DUMP_WRITER_PENDING_MB 512
+#define LZ4_BLOCK_SIZE         (4 << 20)
+#define LZ4_HASH_BITS          12
+#define LZ4_MIN_MATCH          4
+#define LZ4_MF_LIMIT           12 /**< a match starts at least this far from the block end */
+#define LZ4_LAST_LITERALS      5  /**< a block ends with at least this many literals */
+
+namespace
+{
+struct DumpTask
+{
+    std::string fname;
+    std::vector<char> data;
+    bool compress;
+    bool dedup;
+};
+
+/**
+ * @brief a file written with some content, it's only linked to while it's still the same inode
+ */
+struct DumpFile
+{
+    std::string path;
+    dev_t dev;
+    ino_t ino;
+};
+
+class DumpWriter
+{
+private:
+    std::mutex m_lock;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_space_cv;
+    std::deque<DumpTask*> m_queue;
+    uint64_t m_pending = 0;  /**< bytes queued or being written */
+    uint32_t m_fail_cnt = 0;
+    aipu_dump_writer_cfg_t m_cfg = {0};
+    uint64_t m_max_pending = (uint64_t)DUMP_WRITER_PENDING_MB << 20;
+    std::atomic<bool> m_active{false};
+    std::thread m_thread;
+    bool m_stop = false;
+
+    std::mutex m_dedup_lock;
+    std::map<std::pair<uint64_t, uint64_t>, DumpFile> m_written; /**< by <size, hash> */
+
+private:
+    void run();
+    aipu_status_t write_dump(const std::string &fname, const char *data, uint64_t size,
+        bool compress, bool dedup);
+
+public:
+    void config(const aipu_dump_writer_cfg_t *cfg);
+    bool active()
+    {
+        return m_active.load(std::memory_order_relaxed);
+    }
+    aipu_status_t write(const char *fname, const void *src, uint32_t size);
+    aipu_status_t flush();
+
+public:
+    DumpWriter() {}
+    ~DumpWriter();
+};
+
+DumpWriter g_dump_writer;
+
+uint64_t dump_hash(const char *data, uint64_t size)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+    uint64_t w = 0;
+    uint64_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        memcpy(&w, data + i, 8);
+        h ^= w * 0xff51afd7ed558ccdULL;
+        h = ((h << 27) | (h >> 37)) * 0xc4ceb9fe1a85ec53ULL;
+    }
+
+    w = 0;
+    memcpy(&w, data + i, size - i);
+    h ^= w * 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+aipu_status_t write_file(const std::string &path, const char *data, uint64_t size)
+{
+    int fd = -1;
+
+    /* a new inode, 'path' may be a hard link made by dedup */
+    unlink(path.c_str());
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU | S_IRWXG | S_IRWXO);
+    if (fd == -1)
+    {
+        LOG(LOG_ERR, "create bin file failed: %s! (errno = %d)\n", path.c_str(), errno);
+        return AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+    }
+
+    while (size > 0)
+    {
+        ssize_t wbytes = ::write(fd, data, size);
+
+        if (wbytes <= 0)
+        {
+            if ((wbytes < 0) && (errno == EINTR))
+                continue;
+
+            LOG(LOG_ERR, "write bin file %s failed, 0x%lx bytes left (errno = %d)!\n",
+                path.c_str(), (unsigned long)size, errno);
+            close(fd);
+            return AIPU_STATUS_ERROR_WRITE_FILE_FAIL;
+        }
+
+        data += wbytes;
+        size -= wbytes;
+    }
+
+    close(fd);
+    return AIPU_STATUS_SUCCESS;
+}
+
+/**
+ * @brief whether the file at 'path' holds exactly 'size' bytes of 'data'
+ */
+bool file_equals(const std::string &path, const char *data, uint64_t size)
+{
+    char buf[16 << 10];
+    int fd = open(path.c_str(), O_RDONLY);
+    bool equal = (fd != -1);
+
+    while (equal)
+    {
+        ssize_t rbytes = ::read(fd, buf, sizeof(buf));
+
+        if ((rbytes < 0) && (errno == EINTR))
+            continue;
+
+        if (rbytes <= 0)
+        {
+            equal = (rbytes == 0) && (size == 0);
+            break;
+        }
+
+        equal = ((uint64_t)rbytes <= size) && (memcmp(buf, data, rbytes) == 0);
+        data += rbytes;
+        size -= equal ? rbytes : 0;
+    }
+
+    if (fd != -1)
+        close(fd);
+    return equal;
+}
+
+uint32_t xxh32_short(const uint8_t *p, uint32_t len)
+{
+    const uint32_t prime1 = 2654435761U, prime2 = 2246822519U, prime3 = 3266489917U;
+    const uint32_t prime4 = 668265263U, prime5 = 374761393U;
+    uint32_t h = prime5 + len;
+    uint32_t w = 0;
+
+    /* only inputs shorter than 16 bytes, as the frame descriptor */
+    for (; len >= 4; p += 4, len -= 4)
+    {
+        memcpy(&w, p, 4);
+        h += w * prime3;
+        h = ((h << 17) | (h >> 15)) * prime4;
+    }
+
+    for (; len > 0; p++, len--)
+    {
+        h += *p * prime5;
+        h = ((h << 11) | (h >> 21)) * prime1;
+    }
+
+    h ^= h >> 15;
+    h *= prime2;
+    h ^= h >> 13;
+    h *= prime3;
+    h ^= h >> 16;
+    return h;
+}
+
+void lz4_put_len(uint8_t *&op, uint32_t len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = len;
+}
+
+void lz4_put_sequence(uint8_t *&op, const uint8_t *lit, uint32_t lit_len,
+    uint32_t offset, uint32_t match_len)
+{
+    uint8_t *token = op++;
+
+    *token = (lit_len < 15 ? lit_len : 15) << 4;
+    if (lit_len >= 15)
+        lz4_put_len(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    /* the last sequence of a block only has literals */
+    if (match_len == 0)
+        return;
+
+    op[0] = offset & 0xff;
+    op[1] = offset >> 8;
+    op += 2;
+
+    match_len -= LZ4_MIN_MATCH;
+    *token |= (match_len < 15 ? match_len : 15);
+    if (match_len >= 15)
+        lz4_put_len(op, match_len - 15);
+}
+
+/**
+ * @brief greedy LZ4 block compression
+ *
+ * @note 'dst' holds at least size + size / 255 + 16 bytes
+ */
+uint32_t lz4_compress_block(const uint8_t *src, uint32_t size, uint8_t *dst)
+{
+    std::vector<uint32_t> table(1 << LZ4_HASH_BITS, 0);
+    uint8_t *op = dst;
+    uint32_t anchor = 0;
+    uint32_t ip = 0;
+
+    while (size > LZ4_MF_LIMIT && ip < size - LZ4_MF_LIMIT)
+    {
+        uint32_t seq = 0;
+        uint32_t hash = 0;
+        uint32_t ref = 0;
+
+        memcpy(&seq, src + ip, 4);
+        hash = (seq * 2654435761U) >> (32 - LZ4_HASH_BITS);
+        ref = table[hash];
+        table[hash] = ip + 1;
+
+        if ((ref != 0) && (ip - (ref - 1) <= 0xffff) && (memcmp(src + ref - 1, src + ip, 4) == 0))
+        {
+            uint32_t match = ref - 1;
+            uint32_t len = LZ4_MIN_MATCH;
+            uint32_t max_len = size - LZ4_LAST_LITERALS - ip;
+
+            while ((len < max_len) && (src[ip + len] == src[match + len]))
+                len++;
+
+            while ((ip > anchor) && (match > 0) && (src[ip - 1] == src[match - 1]))
+            {
+                ip--;
+                match--;
+                len++;
+            }
+
+            lz4_put_sequence(op, src + anchor, ip - anchor, ip - match, len);
+            ip += len;
+            anchor = ip;
+            continue;
+        }
+
+        /* skip faster through data that doesn't compress */
+        ip += 1 + ((ip - anchor) >> 6);
+    }
+
+    lz4_put_sequence(op, src + anchor, size - anchor, 0, 0);
+    return op - dst;
+}
+
+void DumpWriter::run()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+
+    while (true)
+    {
+        DumpTask *task = nullptr;
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        m_work_cv.wait(lock_, [this] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty())
+            break;
+
+        task = m_queue.front();
+        m_queue.pop_front();
+        lock_.unlock();
+
+        ret = write_dump(task->fname, task->data.data(), task->data.size(),
+            task->compress, task->dedup);
+
+        lock_.lock();
+        if (ret != AIPU_STATUS_SUCCESS)
+            m_fail_cnt++;
+        m_pending -= task->data.size();
+        delete task;
+        m_space_cv.notify_all();
+    }
+}
+
+aipu_status_t DumpWriter::write_dump(const std::string &fname, const char *data, uint64_t size,
+    bool compress, bool dedup)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::string path = compress ? fname + ".lz4" : fname;
+    std::pair<uint64_t, uint64_t> key;
+    std::vector<char> frame;
+    const char *out = data;
+    uint64_t out_size = size;
+    struct stat st;
+
+    if (compress)
+    {
+        umd_lz4_compress_frame(data, size, frame);
+        out = frame.data();
+        out_size = frame.size();
+    }
+
+    /* the hash only finds a candidate, the file is linked if its bytes are the same */
+    if (dedup)
+    {
+        std::lock_guard<std::mutex> lock_(m_dedup_lock);
+        auto iter = m_written.end();
+
+        key = std::make_pair(size, dump_hash(data, size));
+        iter = m_written.find(key);
+        if ((iter != m_written.end()) && (stat(iter->second.path.c_str(), &st) == 0) &&
+            (st.st_dev == iter->second.dev) && (st.st_ino == iter->second.ino) &&
+            file_equals(iter->second.path, out, out_size))
+        {
+            if (iter->second.path == path)
+                return AIPU_STATUS_SUCCESS;
+
+            unlink(path.c_str());
+            if (link(iter->second.path.c_str(), path.c_str()) == 0)
+                return AIPU_STATUS_SUCCESS;
+        }
+    }
+
+    ret = write_file(path, out, out_size);
+    if (dedup && (ret == AIPU_STATUS_SUCCESS) && (stat(path.c_str(), &st) == 0))
+    {
+        std::lock_guard<std::mutex> lock_(m_dedup_lock);
+
+        m_written[key] = DumpFile{path, st.st_dev, st.st_ino};
+    }
+
+    return ret;
+}
+
+void DumpWriter::config(const aipu_dump_writer_cfg_t *cfg)
+{
+    if (!cfg->async)
+        flush();
+
+    std::lock_guard<std::mutex> lock_(m_lock);
+    m_cfg = *cfg;
+    m_max_pending = (uint64_t)(cfg->max_pending_mb ? cfg->max_pending_mb : DUMP_WRITER_PENDING_MB) << 20;
+    if (cfg->async && !m_thread.joinable())
+        m_thread = std::thread(&DumpWriter::run, this);
+    m_active.store(cfg->async || cfg->compress || cfg->dedup, std::memory_order_relaxed);
+}
+
+aipu_status_t DumpWriter::write(const char *fname, const void *src, uint32_t size)
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+    aipu_dump_writer_cfg_t cfg = m_cfg;
+    DumpTask *task = nullptr;
+
+    if (!cfg.async)
+    {
+        lock_.unlock();
+        return write_dump(fname, (const char *)src, size,
+            cfg.compress == AIPU_DUMP_COMPRESS_LZ4, cfg.dedup != 0);
+    }
+
+    /* a dump larger than the limit waits until it's the only one */
+    m_space_cv.wait(lock_, [this, size] {
+        return (m_pending == 0) || (m_pending + size <= m_max_pending);
+    });
+    m_pending += size;
+    lock_.unlock();
+
+    /* the snapshot is taken outside the lock, the source may be device memory */
+    task = new DumpTask{fname, std::vector<char>((const char *)src, (const char *)src + size),
+        cfg.compress == AIPU_DUMP_COMPRESS_LZ4, cfg.dedup != 0};
+
+    lock_.lock();
+    m_queue.push_back(task);
+    m_work_cv.notify_one();
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t DumpWriter::flush()
+{
+    std::unique_lock<std::mutex> lock_(m_lock);
+    uint32_t fail_cnt = 0;
+
+    m_space_cv.wait(lock_, [this] { return m_pending == 0; });
+    fail_cnt = m_fail_cnt;
+    m_fail_cnt = 0;
+
+    return (fail_cnt == 0) ? AIPU_STATUS_SUCCESS : AIPU_STATUS_ERROR_WRITE_FILE_FAIL;
+}
+
+DumpWriter::~DumpWriter()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock_(m_lock);
+        m_stop = true;
+    }
+    m_work_cv.notify_one();
+    m_thread.join();
+}
+}
+
+void umd_dump_writer_config(const aipu_dump_writer_cfg_t *cfg)
+{
+    g_dump_writer.config(cfg);
+}
+
+bool umd_dump_writer_active()
+{
+    return g_dump_writer.active();
+}
+
+aipu_status_t umd_dump_writer_write(const char *fname, const void *src, uint32_t size)
+{
+    return g_dump_writer.write(fname, src, size);
+}
+
+aipu_status_t umd_dump_writer_flush()
+{
+    return g_dump_writer.flush();
+}
+
+void umd_lz4_compress_frame(const void *src, uint64_t size, std::vector<char> &frame)
+{
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t *op = nullptr;
+    uint32_t magic = 0x184D2204;
+
+    /* header, block independence and content size set, 4MB blocks, 4-byte size per block */
+    frame.resize(19 + size + size / 255 + (size / LZ4_BLOCK_SIZE + 1) * 20 + 4);
+    op = (uint8_t *)frame.data();
+    memcpy(op, &magic, 4);
+    op[4] = 0x68;
+    op[5] = 0x70;
+    memcpy(op + 6, &size, 8);
+    op[14] = (xxh32_short(op + 4, 10) >> 8) & 0xff;
+    op += 15;
+
+    for (uint64_t pos = 0; pos < size; pos += LZ4_BLOCK_SIZE)
+    {
+        uint32_t len = (size - pos < LZ4_BLOCK_SIZE) ? (size - pos) : LZ4_BLOCK_SIZE;
+        uint32_t csize = lz4_compress_block(in + pos, len, op + 4);
+
+        if (csize >= len)
+        {
+            csize = len | 0x80000000U;
+            memcpy(op + 4, in + pos, len);
+            len = csize & 0x7fffffffU;
+        } else {
+            len = csize;
+        }
+
+        memcpy(op, &csize, 4);
+        op += 4 + len;
+    }
+
+    memset(op, 0, 4);
+    op += 4;
+    frame.resize(op - (uint8_t *)frame.data());
+}
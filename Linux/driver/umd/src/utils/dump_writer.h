@@ -0,0 +1,53 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  dump_writer.h
+ * @brief UMD buffer dump writer header
+ */
+
+#ifndef _DUMP_WRITER_H_
+#define _DUMP_WRITER_H_
+
+#include <stdint.h>
+#include <vector>
+#include "standard_api.h"
+
+/**
+ * @brief This function is used to configure how umd_dump_file_helper writes dump files,
+ *        process wide
+ *
+ * @note turning async off waits for the queued dumps to be written
+ */
+void umd_dump_writer_config(const aipu_dump_writer_cfg_t *cfg);
+
+/**
+ * @retval true if umd_dump_file_helper goes through the dump writer
+ */
+bool umd_dump_writer_active();
+
+/**
+ * @brief This function is used to write a dump with the configured compression and dedup,
+ *        from a snapshot in the background if async
+ *
+ * @retval AIPU_STATUS_SUCCESS once the snapshot is queued if async
+ * @retval AIPU_STATUS_ERROR_OPEN_FILE_FAIL
+ * @retval AIPU_STATUS_ERROR_WRITE_FILE_FAIL
+ */
+aipu_status_t umd_dump_writer_write(const char *fname, const void *src, uint32_t size);
+
+/**
+ * @brief This function is used to wait until the queued dumps are written
+ *
+ * @retval AIPU_STATUS_ERROR_WRITE_FILE_FAIL if a dump failed since the previous flush
+ */
+aipu_status_t umd_dump_writer_flush();
+
+/**
+ * @brief This function is used to compress data into an LZ4 frame, readable by `lz4 -d`
+ */
+void umd_lz4_compress_frame(const void *src, uint64_t size, std::vector<char> &frame);
+
+#endif /* _DUMP_WRITER_H_ */
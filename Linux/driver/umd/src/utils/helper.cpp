@@ -26,6 +26,7 @@
 #include "standard_api.h"
 #include "log.h"
 #include "helper.h"
+#include "dump_writer.h"
 
 aipu_status_t umd_dump_file_helper(const char* fname, const void* src, unsigned int size)
 {
@@ -45,6 +46,9 @@ aipu_status_t umd_dump_file_helper(const char* fname, const void* src, unsigned
         goto finish;
     }
 
+    if (umd_dump_writer_active())
+        return umd_dump_writer_write(fname, src, size);
+
     fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, S_IRWXU | S_IRWXG | S_IRWXO);
     if (fd == -1)
     {
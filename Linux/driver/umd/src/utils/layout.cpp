@@ -0,0 +1,271 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  layout.cpp
+ * @brief UMD tensor layout copy helper implementation
+ */
+
+#include <cstring>
+#include <algorithm>
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#include "layout.h"
+
+#define TRANSPOSE_TILE 32
+
+struct CopyDims
+{
+    uint32_t cnt;
+    uint64_t shape[AIPU_TENSOR_COPY_MAX_DIMS];
+    uint64_t src[AIPU_TENSOR_COPY_MAX_DIMS];
+    uint64_t dest[AIPU_TENSOR_COPY_MAX_DIMS];
+};
+
+aipu_status_t umd_check_tensor_copy(const aipu_tensor_copy_t *copy, uint64_t tensor_size)
+{
+    uint64_t end = 0;
+
+    if ((copy->dim_cnt == 0) || (copy->dim_cnt > AIPU_TENSOR_COPY_MAX_DIMS))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    if ((copy->elem_size != 1) && (copy->elem_size != 2) &&
+        (copy->elem_size != 4) && (copy->elem_size != 8))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    end = copy->elem_size;
+    for (uint32_t i = 0; i < copy->dim_cnt; i++)
+    {
+        uint64_t last = copy->shape[i] - 1;
+
+        if (copy->shape[i] == 0)
+            return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+        if ((last != 0) && (copy->tensor_strides[i] > (UINT64_MAX - end) / last))
+            return AIPU_STATUS_ERROR_INVALID_SIZE;
+        end += last * copy->tensor_strides[i];
+    }
+
+    if ((copy->tensor_offset > tensor_size) || (end > tensor_size - copy->tensor_offset))
+        return AIPU_STATUS_ERROR_INVALID_SIZE;
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+/**
+ * @brief drop single element dimensions and merge a dimension into its inner
+ *        one when both sides are contiguous across them
+ */
+static void simplify(CopyDims &dims, const uint64_t *src_strides, const uint64_t *dest_strides,
+    const uint64_t *shape, uint32_t dim_cnt)
+{
+    dims.cnt = 0;
+    for (uint32_t i = 0; i < dim_cnt; i++)
+    {
+        uint32_t last = dims.cnt - 1;
+
+        if (shape[i] == 1)
+            continue;
+
+        if ((dims.cnt > 0) &&
+            (dims.src[last] == shape[i] * src_strides[i]) &&
+            (dims.dest[last] == shape[i] * dest_strides[i]))
+        {
+            dims.shape[last] *= shape[i];
+            dims.src[last] = src_strides[i];
+            dims.dest[last] = dest_strides[i];
+            continue;
+        }
+
+        dims.shape[dims.cnt] = shape[i];
+        dims.src[dims.cnt] = src_strides[i];
+        dims.dest[dims.cnt] = dest_strides[i];
+        dims.cnt++;
+    }
+}
+
+/**
+ * @brief call 'func' with the offsets of every index of the dimensions not in 'skip'
+ */
+template <typename F>
+static void walk(const CopyDims &dims, uint32_t skip, F func)
+{
+    uint64_t idx[AIPU_TENSOR_COPY_MAX_DIMS] = {0};
+    uint64_t src_off = 0;
+    uint64_t dest_off = 0;
+    int32_t i = 0;
+
+    while (true)
+    {
+        func(src_off, dest_off);
+
+        for (i = dims.cnt - 1; i >= 0; i--)
+        {
+            if (skip & (1U << i))
+                continue;
+
+            src_off += dims.src[i];
+            dest_off += dims.dest[i];
+            if (++idx[i] < dims.shape[i])
+                break;
+
+            src_off -= dims.src[i] * dims.shape[i];
+            dest_off -= dims.dest[i] * dims.shape[i];
+            idx[i] = 0;
+        }
+
+        if (i < 0)
+            return;
+    }
+}
+
+static inline void copy_elem(char *dest, const char *src, uint32_t elem_size)
+{
+    switch (elem_size)
+    {
+        case 1:
+            *dest = *src;
+            break;
+
+        case 2:
+            memcpy(dest, src, 2);
+            break;
+
+        case 4:
+            memcpy(dest, src, 4);
+            break;
+
+        default:
+            memcpy(dest, src, 8);
+            break;
+    }
+}
+
+/**
+ * @brief 4x4 tile of 4 byte elements, src rows are 'src_stride' apart and
+ *        dest rows 'dest_stride' apart
+ */
+static inline void transpose_4x4(const char *src, uint64_t src_stride, char *dest,
+    uint64_t dest_stride)
+{
+#if defined(__x86_64__)
+    __m128i r0 = _mm_loadu_si128((const __m128i *)src);
+    __m128i r1 = _mm_loadu_si128((const __m128i *)(src + src_stride));
+    __m128i r2 = _mm_loadu_si128((const __m128i *)(src + src_stride * 2));
+    __m128i r3 = _mm_loadu_si128((const __m128i *)(src + src_stride * 3));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+    _mm_storeu_si128((__m128i *)dest, _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *)(dest + dest_stride), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *)(dest + dest_stride * 2), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i *)(dest + dest_stride * 3), _mm_unpackhi_epi64(t2, t3));
+#elif defined(__aarch64__)
+    uint32x4x2_t p = vtrnq_u32(vld1q_u32((const uint32_t *)src),
+        vld1q_u32((const uint32_t *)(src + src_stride)));
+    uint32x4x2_t q = vtrnq_u32(vld1q_u32((const uint32_t *)(src + src_stride * 2)),
+        vld1q_u32((const uint32_t *)(src + src_stride * 3)));
+
+    vst1q_u32((uint32_t *)dest, vcombine_u32(vget_low_u32(p.val[0]), vget_low_u32(q.val[0])));
+    vst1q_u32((uint32_t *)(dest + dest_stride), vcombine_u32(vget_low_u32(p.val[1]), vget_low_u32(q.val[1])));
+    vst1q_u32((uint32_t *)(dest + dest_stride * 2), vcombine_u32(vget_high_u32(p.val[0]), vget_high_u32(q.val[0])));
+    vst1q_u32((uint32_t *)(dest + dest_stride * 3), vcombine_u32(vget_high_u32(p.val[1]), vget_high_u32(q.val[1])));
+#else
+    for (uint32_t j = 0; j < 4; j++)
+        for (uint32_t i = 0; i < 4; i++)
+            memcpy(dest + i * dest_stride + j * 4, src + j * src_stride + i * 4, 4);
+#endif
+}
+
+/**
+ * @brief dest[i * dest_a + j] = src[i + j * src_b], i along 'na' is contiguous in
+ *        src and j along 'nb' is contiguous in dest. tiles keep the strided side
+ *        in cache.
+ */
+static void transpose_2d(const char *src, char *dest, uint64_t na, uint64_t nb,
+    uint64_t src_b, uint64_t dest_a, uint32_t elem_size)
+{
+    for (uint64_t j0 = 0; j0 < nb; j0 += TRANSPOSE_TILE)
+    {
+        uint64_t j1 = std::min<uint64_t>(nb, j0 + TRANSPOSE_TILE);
+
+        for (uint64_t i0 = 0; i0 < na; i0 += TRANSPOSE_TILE)
+        {
+            uint64_t i1 = std::min<uint64_t>(na, i0 + TRANSPOSE_TILE);
+            uint64_t i4 = i0;
+            uint64_t j4 = j0;
+
+            if (elem_size == 4)
+            {
+                i4 = i0 + (i1 - i0) / 4 * 4;
+                j4 = j0 + (j1 - j0) / 4 * 4;
+                for (uint64_t j = j0; j < j4; j += 4)
+                    for (uint64_t i = i0; i < i4; i += 4)
+                        transpose_4x4(src + j * src_b + i * 4, src_b, dest + i * dest_a + j * 4, dest_a);
+            }
+
+            /* tile edges SIMD can't cover */
+            for (uint64_t j = j0; j < j1; j++)
+                for (uint64_t i = (j < j4) ? i4 : i0; i < i1; i++)
+                    copy_elem(dest + i * dest_a + j * elem_size, src + j * src_b + i * elem_size,
+                        elem_size);
+        }
+    }
+}
+
+void umd_strided_copy(const char *src, const uint64_t *src_strides, char *dest,
+    const uint64_t *dest_strides, const uint64_t *shape, uint32_t dim_cnt, uint32_t elem_size)
+{
+    CopyDims dims;
+    uint32_t inner = 0;
+    int32_t a = -1;
+    int32_t b = -1;
+
+    simplify(dims, src_strides, dest_strides, shape, dim_cnt);
+    if (dims.cnt == 0)
+    {
+        copy_elem(dest, src, elem_size);
+        return;
+    }
+
+    inner = dims.cnt - 1;
+    if ((dims.src[inner] == elem_size) && (dims.dest[inner] == elem_size))
+    {
+        uint64_t row = dims.shape[inner] * elem_size;
+
+        walk(dims, 1U << inner, [&](uint64_t src_off, uint64_t dest_off) {
+            memcpy(dest + dest_off, src + src_off, row);
+        });
+        return;
+    }
+
+    for (int32_t i = inner; i >= 0; i--)
+    {
+        if ((a < 0) && (dims.src[i] == elem_size))
+            a = i;
+        if ((b < 0) && (dims.dest[i] == elem_size))
+            b = i;
+    }
+
+    if ((a >= 0) && (b >= 0) && (a != b))
+    {
+        walk(dims, (1U << a) | (1U << b), [&](uint64_t src_off, uint64_t dest_off) {
+            transpose_2d(src + src_off, dest + dest_off, dims.shape[a], dims.shape[b],
+                dims.src[b], dims.dest[a], elem_size);
+        });
+        return;
+    }
+
+    walk(dims, 1U << inner, [&](uint64_t src_off, uint64_t dest_off) {
+        for (uint64_t i = 0; i < dims.shape[inner]; i++)
+            copy_elem(dest + dest_off + i * dims.dest[inner], src + src_off + i * dims.src[inner],
+                elem_size);
+    });
+}
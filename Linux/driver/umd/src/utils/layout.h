@@ -0,0 +1,47 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  layout.h
+ * @brief UMD tensor layout copy helper header
+ */
+
+#ifndef _LAYOUT_H_
+#define _LAYOUT_H_
+
+#include <stdint.h>
+#include "standard_api.h"
+
+/**
+ * @brief This function is used to check a tensor copy descriptor against a tensor buffer
+ *
+ * @param[in] copy        Tensor copy descriptor
+ * @param[in] tensor_size Tensor buffer byte size
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_INVALID_CONFIG
+ * @retval AIPU_STATUS_ERROR_INVALID_SIZE
+ */
+aipu_status_t umd_check_tensor_copy(const aipu_tensor_copy_t *copy, uint64_t tensor_size);
+
+/**
+ * @brief This function is used to copy elements between two strided buffers
+ *
+ * @param[in]  src          Source of the first element
+ * @param[in]  src_strides  Source byte stride per dimension
+ * @param[out] dest         Destination of the first element
+ * @param[in]  dest_strides Destination byte stride per dimension
+ * @param[in]  shape        Element count per dimension
+ * @param[in]  dim_cnt      Dimension count, at most AIPU_TENSOR_COPY_MAX_DIMS
+ * @param[in]  elem_size    Element byte size: 1, 2, 4 or 8
+ *
+ * @note contiguous dimensions are merged first. row copies are used when both
+ *       innermost strides are the element size, a blocked transpose when the
+ *       contiguous dimensions differ (4x4 SIMD tiles for 4 byte elements).
+ */
+void umd_strided_copy(const char *src, const uint64_t *src_strides, char *dest,
+    const uint64_t *dest_strides, const uint64_t *shape, uint32_t dim_cnt, uint32_t elem_size);
+
+#endif /* _LAYOUT_H_ */
@@ -33,10 +33,14 @@ enum LogLevel
     LOG_CLOSE    /**< close logging messages printing */
 };
 
+/**
+ * @brief Levels above this one are compiled out, set by BUILD_UMD_LOG_LEVEL
+ */
+#ifndef UMD_LOG_LEVEL_MAX
+#define UMD_LOG_LEVEL_MAX LOG_DEFAULT
+#endif
+
 extern volatile int32_t UMD_LOG_LEVEL;
-#define LOG_DETAILED(flag, FMT, ARGS...) \
-    printf("%s%s%s:%d:%s: " FMT "\n", umd_timestamp_helper(4).c_str(), \
-        (flag), __FILE__, __LINE__, __PRETTY_FUNCTION__, ## ARGS);
 /**
  * @brief Log macro
  * @param LogLevel log level
@@ -47,7 +51,7 @@ extern volatile int32_t UMD_LOG_LEVEL;
 #include <android/log.h>
 #include <sys/system_properties.h>
 #define LOG(LogLevel, FMT, ARGS...) do { \
-    if (LogLevel > UMD_LOG_LEVEL) \
+    if ((LogLevel > UMD_LOG_LEVEL_MAX) || (LogLevel > UMD_LOG_LEVEL)) \
         break; \
     if (LogLevel==LOG_ERR) \
         __android_log_print(ANDROID_LOG_ERROR, "UMD", "[%s:%d:%s]" FMT, __FUNCTION__, __LINE__, __PRETTY_FUNCTION__, ## ARGS); \
@@ -63,21 +67,14 @@ extern volatile int32_t UMD_LOG_LEVEL;
         __android_log_print(ANDROID_LOG_INFO, "UMD", "[%ld]" FMT, gettid(), ## ARGS); \
     } while (0)
 #else
+#include "async_log.h"
+/* printf() is never called, it keeps the format checked against the arguments */
 #define LOG(LogLevel, FMT, ARGS...) do { \
-    if (LogLevel > UMD_LOG_LEVEL) \
+    if ((LogLevel > UMD_LOG_LEVEL_MAX) || (LogLevel > UMD_LOG_LEVEL)) \
         break; \
-    if (LogLevel==LOG_ERR) \
-        LOG_DETAILED("[UMD ERR] ", FMT, ## ARGS) \
-    else if (LogLevel==LOG_WARN) \
-        LOG_DETAILED("[UMD WAR] ", FMT, ## ARGS) \
-    else if (LogLevel==LOG_ALERT) \
-        printf("%s [UMD ALT] <%ld> " FMT "\n", umd_timestamp_helper(4).c_str(), gettid(), ## ARGS); \
-    else if (LogLevel==LOG_INFO) \
-        printf("%s [UMD INF] <%ld> " FMT "\n", umd_timestamp_helper(4).c_str(), gettid(), ## ARGS); \
-    else if (LogLevel==LOG_DEBUG) \
-        printf("%s [UMD DBG] <%ld> " FMT "\n", umd_timestamp_helper(4).c_str(), gettid(), ## ARGS); \
-    else if (LogLevel==LOG_DEFAULT) \
-        printf("" FMT "\n", ## ARGS); \
+    if (false) \
+        printf(FMT, ## ARGS); \
+    umd_log(LogLevel, __FILE__, __LINE__, __PRETTY_FUNCTION__, FMT, ## ARGS); \
     } while (0)
 #endif
 #endif /* _LOG_H_ */
\ No newline at end of file
@@ -0,0 +1,1226 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  quant.cpp
+ * @brief UMD tensor quantization helper implementation
+ *
+ * @note  every SIMD kernel converts whole blocks and returns the element count
+ *        done, the scalar code finishes the tail. the kernels use the same
+ *        operation order as the scalar code so the results are identical.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#include "quant.h"
+
+#define BF16_NAN_BIT 0x40
+#define PACK_CHUNK   256
+
+/**
+ * @brief 4/12-bit tensor layout, aligned ones keep one element per byte/half-word
+ *        with the upper bits zero, compact ones put element 2n in the low bits
+ */
+struct PackedType
+{
+    uint32_t bits;
+    bool is_signed;
+    bool compact;
+};
+
+/**
+ * @brief float to IEEE half with round to nearest even
+ */
+static uint16_t float_to_half(float f)
+{
+    uint32_t x = 0;
+    uint32_t sign = 0;
+    uint32_t abs_x = 0;
+
+    memcpy(&x, &f, sizeof(x));
+    sign = (x >> 16) & 0x8000;
+    abs_x = x & 0x7FFFFFFF;
+
+    /* inf/nan, nan is quieted */
+    if (abs_x >= 0x7F800000)
+        return sign | 0x7C00 | ((abs_x > 0x7F800000) ? (0x200 | ((abs_x >> 13) & 0x3FF)) : 0);
+
+    /* >= 65520 */
+    if (abs_x >= 0x477FF000)
+        return sign | 0x7C00;
+
+    /* half subnormal */
+    if (abs_x < 0x38800000)
+    {
+        uint32_t exp = abs_x >> 23;
+        uint32_t mant = (abs_x & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - exp;
+        uint32_t half = 0;
+        uint32_t rem = 0;
+
+        if (exp < 102)
+            return sign;
+
+        half = mant >> shift;
+        rem = mant & ((1U << shift) - 1);
+        if ((rem > (1U << (shift - 1))) || ((rem == (1U << (shift - 1))) && (half & 1)))
+            half++;
+        return sign | half;
+    }
+
+    abs_x -= 0x38000000;
+    return sign | ((abs_x + 0xFFF + ((abs_x >> 13) & 1)) >> 13);
+}
+
+static float half_to_float(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+    uint32_t x = 0;
+    float f = 0;
+
+    if (exp == 0x1F)
+    {
+        x = sign | 0x7F800000 | (mant << 13) | (mant ? 0x400000 : 0);
+    } else if (exp != 0) {
+        x = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (mant == 0) {
+        x = sign;
+    } else {
+        exp = 113;
+        while ((mant & 0x400) == 0)
+        {
+            mant <<= 1;
+            exp--;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+    }
+
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+static uint16_t float_to_bf16(float f)
+{
+    uint32_t x = 0;
+
+    memcpy(&x, &f, sizeof(x));
+    if (f != f)
+        return (x >> 16) | BF16_NAN_BIT;
+
+    return (x + 0x7FFF + ((x >> 16) & 1)) >> 16;
+}
+
+static float bf16_to_float(uint16_t h)
+{
+    uint32_t x = (uint32_t)h << 16;
+    float f = 0;
+
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+template <typename T>
+static void quant_int(const float *src, T *dest, uint64_t cnt, float scale, float zp,
+    float lo, float hi)
+{
+    for (uint64_t i = 0; i < cnt; i++)
+    {
+        float v = nearbyintf(src[i] * scale) - zp;
+
+        v = (v > lo) ? v : lo;
+        v = (v < hi) ? v : hi;
+        dest[i] = (T)(int32_t)v;
+    }
+}
+
+template <typename T>
+static void dequant_int(const T *src, float *dest, uint64_t cnt, float scale, int32_t zp)
+{
+    for (uint64_t i = 0; i < cnt; i++)
+        dest[i] = (float)((int32_t)src[i] + zp) / scale;
+}
+
+static bool get_packed_type(aipu_data_type_t type, PackedType &pt)
+{
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_ALIGNED_U4:
+            pt = {4, false, false};
+            return true;
+
+        case AIPU_DATA_TYPE_ALIGNED_S4:
+            pt = {4, true, false};
+            return true;
+
+        case AIPU_DATA_TYPE_ALIGNED_U12:
+            pt = {12, false, false};
+            return true;
+
+        case AIPU_DATA_TYPE_ALIGNED_S12:
+            pt = {12, true, false};
+            return true;
+
+        case AIPU_DATA_TYPE_COMPACT_U4:
+            pt = {4, false, true};
+            return true;
+
+        case AIPU_DATA_TYPE_COMPACT_S4:
+            pt = {4, true, true};
+            return true;
+
+        case AIPU_DATA_TYPE_COMPACT_U12:
+            pt = {12, false, true};
+            return true;
+
+        case AIPU_DATA_TYPE_COMPACT_S12:
+            pt = {12, true, true};
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static uint64_t packed_bytes(const PackedType &pt, uint64_t cnt)
+{
+    if (pt.compact)
+        return (cnt * pt.bits + 7) / 8;
+
+    return cnt * ((pt.bits + 7) / 8);
+}
+
+/**
+ * @brief unpacked data is int8/uint8 for 4-bit types and int16/uint16 for 12-bit ones,
+ *        it's saturated to the packed range
+ */
+static void pack_scalar(const void *src, void *dest, uint64_t begin, uint64_t cnt,
+    const PackedType &pt)
+{
+    int32_t lo = pt.is_signed ? -(1 << (pt.bits - 1)) : 0;
+    int32_t hi = pt.is_signed ? (1 << (pt.bits - 1)) - 1 : (1 << pt.bits) - 1;
+    uint32_t mask = (1U << pt.bits) - 1;
+    uint8_t *d = (uint8_t *)dest;
+
+    for (uint64_t i = begin; i < cnt; i++)
+    {
+        int32_t v = 0;
+        uint32_t q = 0;
+
+        if (pt.bits == 4)
+            v = pt.is_signed ? ((const int8_t *)src)[i] : ((const uint8_t *)src)[i];
+        else
+            v = pt.is_signed ? ((const int16_t *)src)[i] : ((const uint16_t *)src)[i];
+        q = (uint32_t)std::min(std::max(v, lo), hi) & mask;
+
+        if (!pt.compact && (pt.bits == 4))
+        {
+            d[i] = q;
+        } else if (!pt.compact) {
+            ((uint16_t *)dest)[i] = q;
+        } else if (pt.bits == 4) {
+            if (i & 1)
+                d[i / 2] |= q << 4;
+            else
+                d[i / 2] = q;
+        } else {
+            uint8_t *p = d + i / 2 * 3;
+
+            if (i & 1)
+            {
+                p[1] |= q << 4;
+                p[2] = q >> 4;
+            } else {
+                p[0] = q;
+                p[1] = q >> 8;
+            }
+        }
+    }
+}
+
+static void unpack_scalar(const void *src, void *dest, uint64_t begin, uint64_t cnt,
+    const PackedType &pt)
+{
+    uint32_t sign_bit = 1U << (pt.bits - 1);
+    const uint8_t *s = (const uint8_t *)src;
+
+    for (uint64_t i = begin; i < cnt; i++)
+    {
+        uint32_t q = 0;
+        int32_t v = 0;
+
+        if (!pt.compact && (pt.bits == 4))
+        {
+            q = s[i] & 0xF;
+        } else if (!pt.compact) {
+            q = ((const uint16_t *)src)[i] & 0xFFF;
+        } else if (pt.bits == 4) {
+            q = (s[i / 2] >> ((i & 1) * 4)) & 0xF;
+        } else {
+            const uint8_t *p = s + i / 2 * 3;
+
+            if (i & 1)
+                q = (p[1] >> 4) | ((uint32_t)p[2] << 4);
+            else
+                q = p[0] | ((uint32_t)(p[1] & 0xF) << 8);
+        }
+        v = pt.is_signed ? (int32_t)(q ^ sign_bit) - (int32_t)sign_bit : (int32_t)q;
+
+        if (pt.bits == 4)
+            ((uint8_t *)dest)[i] = (uint8_t)v;
+        else
+            ((uint16_t *)dest)[i] = (uint16_t)v;
+    }
+}
+
+#if defined(__x86_64__)
+#define AVX2_FUNC __attribute__((target("avx2,f16c")))
+
+static bool has_avx2()
+{
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+    return has;
+}
+
+AVX2_FUNC static inline __m256i avx2_quant8(const float *src, __m256 scale, __m256 zp,
+    __m256 lo, __m256 hi)
+{
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src), scale);
+
+    v = _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    v = _mm256_sub_ps(v, zp);
+    v = _mm256_max_ps(v, lo); /* nan -> lo as the scalar code */
+    v = _mm256_min_ps(v, hi);
+    return _mm256_cvtps_epi32(v);
+}
+
+AVX2_FUNC static uint64_t simd_quant_8bit(const float *src, void *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi, bool is_signed)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256 vz = _mm256_set1_ps(zp);
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vhi = _mm256_set1_ps(hi);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 32 <= cnt; i += 32)
+    {
+        __m256i ab = _mm256_packs_epi32(avx2_quant8(src + i, vs, vz, vlo, vhi),
+            avx2_quant8(src + i + 8, vs, vz, vlo, vhi));
+        __m256i cd = _mm256_packs_epi32(avx2_quant8(src + i + 16, vs, vz, vlo, vhi),
+            avx2_quant8(src + i + 24, vs, vz, vlo, vhi));
+        __m256i r = is_signed ? _mm256_packs_epi16(ab, cd) : _mm256_packus_epi16(ab, cd);
+
+        _mm256_storeu_si256((__m256i *)((uint8_t *)dest + i), _mm256_permutevar8x32_epi32(r, order));
+    }
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_quant_s16(const float *src, int16_t *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256 vz = _mm256_set1_ps(zp);
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vhi = _mm256_set1_ps(hi);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 16 <= cnt; i += 16)
+    {
+        __m256i r = _mm256_packs_epi32(avx2_quant8(src + i, vs, vz, vlo, vhi),
+            avx2_quant8(src + i + 8, vs, vz, vlo, vhi));
+
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(r, 0xD8));
+    }
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_to_f16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        _mm_storeu_si128((__m128i *)(dest + i),
+            _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+
+    return i;
+}
+
+AVX2_FUNC static inline __m256i avx2_bf16(const float *src)
+{
+    __m256 v = _mm256_loadu_ps(src);
+    __m256i x = _mm256_castps_si256(v);
+    __m256i hi = _mm256_srli_epi32(x, 16);
+    __m256i r = _mm256_add_epi32(x, _mm256_set1_epi32(0x7FFF));
+    __m256i nan = _mm256_or_si256(hi, _mm256_set1_epi32(BF16_NAN_BIT));
+
+    r = _mm256_srli_epi32(_mm256_add_epi32(r, _mm256_and_si256(hi, _mm256_set1_epi32(1))), 16);
+    return _mm256_blendv_epi8(r, nan, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+}
+
+AVX2_FUNC static uint64_t simd_to_bf16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 16 <= cnt; i += 16)
+    {
+        __m256i r = _mm256_packus_epi32(avx2_bf16(src + i), avx2_bf16(src + i + 8));
+
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(r, 0xD8));
+    }
+
+    return i;
+}
+
+AVX2_FUNC static inline void avx2_dequant8(__m256i q, float *dest, __m256i zp, __m256 scale)
+{
+    _mm256_storeu_ps(dest, _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(q, zp)), scale));
+}
+
+AVX2_FUNC static uint64_t simd_dequant_s8(const int8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256i vz = _mm256_set1_epi32(zp);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        avx2_dequant8(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(src + i))),
+            dest + i, vz, vs);
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_dequant_u8(const uint8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256i vz = _mm256_set1_epi32(zp);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        avx2_dequant8(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i))),
+            dest + i, vz, vs);
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_dequant_s16(const int16_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const __m256 vs = _mm256_set1_ps(scale);
+    const __m256i vz = _mm256_set1_epi32(zp);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        avx2_dequant8(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + i))),
+            dest + i, vz, vs);
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_from_f16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_from_bf16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    for (; i + 8 <= cnt; i += 8)
+    {
+        __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        _mm256_storeu_ps(dest + i, _mm256_castsi256_ps(_mm256_slli_epi32(x, 16)));
+    }
+
+    return i;
+}
+
+AVX2_FUNC static inline __m256i avx2_clamp4(__m256i x, bool is_signed)
+{
+    if (is_signed)
+        x = _mm256_min_epi8(_mm256_max_epi8(x, _mm256_set1_epi8(-8)), _mm256_set1_epi8(7));
+    else
+        x = _mm256_min_epu8(x, _mm256_set1_epi8(15));
+
+    return _mm256_and_si256(x, _mm256_set1_epi8(0xF));
+}
+
+AVX2_FUNC static inline __m256i avx2_clamp12(__m256i x, bool is_signed)
+{
+    if (is_signed)
+        x = _mm256_min_epi16(_mm256_max_epi16(x, _mm256_set1_epi16(-2048)), _mm256_set1_epi16(2047));
+    else
+        x = _mm256_min_epu16(x, _mm256_set1_epi16(4095));
+
+    return _mm256_and_si256(x, _mm256_set1_epi16(0xFFF));
+}
+
+AVX2_FUNC static inline void sse_store12(uint8_t *dest, __m128i x)
+{
+    uint32_t tail = _mm_extract_epi32(x, 2);
+
+    _mm_storel_epi64((__m128i *)dest, x);
+    memcpy(dest + 8, &tail, sizeof(tail));
+}
+
+AVX2_FUNC static uint64_t simd_pack(const void *src, void *dest, uint64_t cnt,
+    const PackedType &pt)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t *d = (uint8_t *)dest;
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    if (!pt.compact && (pt.bits == 4))
+    {
+        for (; i + 32 <= cnt; i += 32)
+            _mm256_storeu_si256((__m256i *)(d + i),
+                avx2_clamp4(_mm256_loadu_si256((const __m256i *)(s + i)), pt.is_signed));
+    } else if (!pt.compact) {
+        for (; i + 16 <= cnt; i += 16)
+            _mm256_storeu_si256((__m256i *)(d + i * 2),
+                avx2_clamp12(_mm256_loadu_si256((const __m256i *)(s + i * 2)), pt.is_signed));
+    } else if (pt.bits == 4) {
+        const __m256i low = _mm256_set1_epi16(0xFF);
+
+        for (; i + 64 <= cnt; i += 64)
+        {
+            __m256i a = avx2_clamp4(_mm256_loadu_si256((const __m256i *)(s + i)), pt.is_signed);
+            __m256i b = avx2_clamp4(_mm256_loadu_si256((const __m256i *)(s + i + 32)), pt.is_signed);
+
+            /* odd element into the high nibble of the even one */
+            a = _mm256_or_si256(_mm256_and_si256(a, low), _mm256_slli_epi16(_mm256_srli_epi16(a, 8), 4));
+            b = _mm256_or_si256(_mm256_and_si256(b, low), _mm256_slli_epi16(_mm256_srli_epi16(b, 8), 4));
+            _mm256_storeu_si256((__m256i *)(d + i / 2),
+                _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+        }
+    } else {
+        const __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+        for (; i + 16 <= cnt; i += 16)
+        {
+            __m256i x = avx2_clamp12(_mm256_loadu_si256((const __m256i *)(s + i * 2)), pt.is_signed);
+
+            /* element pair into the low 24 bits of a word, then drop the top bytes */
+            x = _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi32(0xFFFF)),
+                _mm256_slli_epi32(_mm256_srli_epi32(x, 16), 12));
+            x = _mm256_shuffle_epi8(x, shuf);
+            sse_store12(d + i / 2 * 3, _mm256_castsi256_si128(x));
+            sse_store12(d + i / 2 * 3 + 12, _mm256_extracti128_si256(x, 1));
+        }
+    }
+
+    return i;
+}
+
+AVX2_FUNC static uint64_t simd_unpack(const void *src, void *dest, uint64_t cnt,
+    const PackedType &pt)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t *d = (uint8_t *)dest;
+    const __m128i sign4 = _mm_set1_epi8(8);
+    const __m128i mask4 = _mm_set1_epi8(0xF);
+    uint64_t i = 0;
+
+    if (!has_avx2())
+        return 0;
+
+    if (!pt.compact && (pt.bits == 4))
+    {
+        for (; i + 32 <= cnt; i += 32)
+        {
+            __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(s + i)),
+                _mm256_set1_epi8(0xF));
+
+            if (pt.is_signed)
+                x = _mm256_sub_epi8(_mm256_xor_si256(x, _mm256_set1_epi8(8)), _mm256_set1_epi8(8));
+            _mm256_storeu_si256((__m256i *)(d + i), x);
+        }
+    } else if (!pt.compact) {
+        for (; i + 16 <= cnt; i += 16)
+        {
+            __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(s + i * 2)),
+                _mm256_set1_epi16(0xFFF));
+
+            if (pt.is_signed)
+                x = _mm256_srai_epi16(_mm256_slli_epi16(x, 4), 4);
+            _mm256_storeu_si256((__m256i *)(d + i * 2), x);
+        }
+    } else if (pt.bits == 4) {
+        for (; i + 32 <= cnt; i += 32)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(s + i / 2));
+            __m128i lo = _mm_and_si128(x, mask4);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), mask4);
+
+            if (pt.is_signed)
+            {
+                lo = _mm_sub_epi8(_mm_xor_si128(lo, sign4), sign4);
+                hi = _mm_sub_epi8(_mm_xor_si128(hi, sign4), sign4);
+            }
+            _mm_storeu_si128((__m128i *)(d + i), _mm_unpacklo_epi8(lo, hi));
+            _mm_storeu_si128((__m128i *)(d + i + 16), _mm_unpackhi_epi8(lo, hi));
+        }
+    } else {
+        const __m128i shuf = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i mask12 = _mm_set1_epi32(0xFFF);
+
+        for (; i + 8 <= cnt; i += 8)
+        {
+            const uint8_t *p = s + i / 2 * 3;
+            int32_t tail = 0;
+            __m128i x;
+
+            /* 12 bytes exactly, never read past the tensor */
+            memcpy(&tail, p + 8, sizeof(tail));
+            x = _mm_insert_epi32(_mm_loadl_epi64((const __m128i *)p), tail, 2);
+            x = _mm_shuffle_epi8(x, shuf);
+            x = _mm_or_si128(_mm_and_si128(x, mask12),
+                _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(x, 12), mask12), 16));
+            if (pt.is_signed)
+                x = _mm_srai_epi16(_mm_slli_epi16(x, 4), 4);
+            _mm_storeu_si128((__m128i *)(d + i * 2), x);
+        }
+    }
+
+    return i;
+}
+
+#elif defined(__aarch64__)
+
+static inline int32x4_t neon_quant4(const float *src, float32x4_t scale, float32x4_t zp,
+    float32x4_t lo, float32x4_t hi)
+{
+    float32x4_t v = vsubq_f32(vrndnq_f32(vmulq_f32(vld1q_f32(src), scale)), zp);
+
+    /* vmaxq/vminq propagate nan, select as the scalar code instead */
+    v = vbslq_f32(vcgtq_f32(v, lo), v, lo);
+    v = vbslq_f32(vcltq_f32(v, hi), v, hi);
+    return vcvtq_s32_f32(v);
+}
+
+static inline int16x8_t neon_quant8(const float *src, float32x4_t scale, float32x4_t zp,
+    float32x4_t lo, float32x4_t hi)
+{
+    return vcombine_s16(vmovn_s32(neon_quant4(src, scale, zp, lo, hi)),
+        vmovn_s32(neon_quant4(src + 4, scale, zp, lo, hi)));
+}
+
+static uint64_t simd_quant_8bit(const float *src, void *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi, bool is_signed)
+{
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const float32x4_t vz = vdupq_n_f32(zp);
+    const float32x4_t vlo = vdupq_n_f32(lo);
+    const float32x4_t vhi = vdupq_n_f32(hi);
+    uint64_t i = 0;
+
+    for (; i + 16 <= cnt; i += 16)
+    {
+        int16x8_t a = neon_quant8(src + i, vs, vz, vlo, vhi);
+        int16x8_t b = neon_quant8(src + i + 8, vs, vz, vlo, vhi);
+
+        /* in range already, narrowing keeps the low byte */
+        vst1q_u8((uint8_t *)dest + i, vcombine_u8(vmovn_u16(vreinterpretq_u16_s16(a)),
+            vmovn_u16(vreinterpretq_u16_s16(b))));
+    }
+
+    return i;
+}
+
+static uint64_t simd_quant_s16(const float *src, int16_t *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi)
+{
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const float32x4_t vz = vdupq_n_f32(zp);
+    const float32x4_t vlo = vdupq_n_f32(lo);
+    const float32x4_t vhi = vdupq_n_f32(hi);
+    uint64_t i = 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        vst1q_s16(dest + i, neon_quant8(src + i, vs, vz, vlo, vhi));
+
+    return i;
+}
+
+static uint64_t simd_to_f16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    for (; i + 4 <= cnt; i += 4)
+        vst1_u16(dest + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+
+    return i;
+}
+
+static uint64_t simd_to_bf16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    for (; i + 4 <= cnt; i += 4)
+    {
+        float32x4_t v = vld1q_f32(src + i);
+        uint32x4_t x = vreinterpretq_u32_f32(v);
+        uint32x4_t hi = vshrq_n_u32(x, 16);
+        uint32x4_t r = vaddq_u32(vaddq_u32(x, vdupq_n_u32(0x7FFF)), vandq_u32(hi, vdupq_n_u32(1)));
+        uint32x4_t nan = vorrq_u32(hi, vdupq_n_u32(BF16_NAN_BIT));
+
+        r = vbslq_u32(vmvnq_u32(vceqq_f32(v, v)), nan, vshrq_n_u32(r, 16));
+        vst1_u16(dest + i, vmovn_u32(r));
+    }
+
+    return i;
+}
+
+static inline void neon_dequant4(int32x4_t q, float *dest, int32x4_t zp, float32x4_t scale)
+{
+    vst1q_f32(dest, vdivq_f32(vcvtq_f32_s32(vaddq_s32(q, zp)), scale));
+}
+
+static inline void neon_dequant8(int16x8_t q, float *dest, int32x4_t zp, float32x4_t scale)
+{
+    neon_dequant4(vmovl_s16(vget_low_s16(q)), dest, zp, scale);
+    neon_dequant4(vmovl_s16(vget_high_s16(q)), dest + 4, zp, scale);
+}
+
+static uint64_t simd_dequant_s8(const int8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t vz = vdupq_n_s32(zp);
+    uint64_t i = 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        neon_dequant8(vmovl_s8(vld1_s8(src + i)), dest + i, vz, vs);
+
+    return i;
+}
+
+static uint64_t simd_dequant_u8(const uint8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t vz = vdupq_n_s32(zp);
+    uint64_t i = 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        neon_dequant8(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src + i))), dest + i, vz, vs);
+
+    return i;
+}
+
+static uint64_t simd_dequant_s16(const int16_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    const float32x4_t vs = vdupq_n_f32(scale);
+    const int32x4_t vz = vdupq_n_s32(zp);
+    uint64_t i = 0;
+
+    for (; i + 8 <= cnt; i += 8)
+        neon_dequant8(vld1q_s16(src + i), dest + i, vz, vs);
+
+    return i;
+}
+
+static uint64_t simd_from_f16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    for (; i + 4 <= cnt; i += 4)
+        vst1q_f32(dest + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+
+    return i;
+}
+
+static uint64_t simd_from_bf16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    uint64_t i = 0;
+
+    for (; i + 4 <= cnt; i += 4)
+        vst1q_f32(dest + i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(src + i), 16)));
+
+    return i;
+}
+
+static inline uint8x16_t neon_clamp4(uint8x16_t x, bool is_signed)
+{
+    if (is_signed)
+        x = vreinterpretq_u8_s8(vminq_s8(vmaxq_s8(vreinterpretq_s8_u8(x), vdupq_n_s8(-8)),
+            vdupq_n_s8(7)));
+    else
+        x = vminq_u8(x, vdupq_n_u8(15));
+
+    return vandq_u8(x, vdupq_n_u8(0xF));
+}
+
+static inline uint16x8_t neon_clamp12(uint16x8_t x, bool is_signed)
+{
+    if (is_signed)
+        x = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vreinterpretq_s16_u16(x), vdupq_n_s16(-2048)),
+            vdupq_n_s16(2047)));
+    else
+        x = vminq_u16(x, vdupq_n_u16(4095));
+
+    return vandq_u16(x, vdupq_n_u16(0xFFF));
+}
+
+static inline uint8x16_t neon_sext4(uint8x16_t x, bool is_signed)
+{
+    if (!is_signed)
+        return x;
+
+    return vreinterpretq_u8_s8(vshrq_n_s8(vshlq_n_s8(vreinterpretq_s8_u8(x), 4), 4));
+}
+
+static inline uint16x8_t neon_sext12(uint16x8_t x, bool is_signed)
+{
+    if (!is_signed)
+        return x;
+
+    return vreinterpretq_u16_s16(vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(x), 4), 4));
+}
+
+static uint64_t simd_pack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t *d = (uint8_t *)dest;
+    uint64_t i = 0;
+
+    if (!pt.compact && (pt.bits == 4))
+    {
+        for (; i + 16 <= cnt; i += 16)
+            vst1q_u8(d + i, neon_clamp4(vld1q_u8(s + i), pt.is_signed));
+    } else if (!pt.compact) {
+        for (; i + 8 <= cnt; i += 8)
+            vst1q_u16((uint16_t *)d + i,
+                neon_clamp12(vld1q_u16((const uint16_t *)s + i), pt.is_signed));
+    } else if (pt.bits == 4) {
+        for (; i + 32 <= cnt; i += 32)
+        {
+            uint8x16x2_t x = vld2q_u8(s + i);
+
+            vst1q_u8(d + i / 2, vorrq_u8(neon_clamp4(x.val[0], pt.is_signed),
+                vshlq_n_u8(neon_clamp4(x.val[1], pt.is_signed), 4)));
+        }
+    } else {
+        for (; i + 16 <= cnt; i += 16)
+        {
+            uint16x8x2_t x = vld2q_u16((const uint16_t *)s + i);
+            uint16x8_t even = neon_clamp12(x.val[0], pt.is_signed);
+            uint16x8_t odd = neon_clamp12(x.val[1], pt.is_signed);
+            uint8x8x3_t r;
+
+            r.val[0] = vmovn_u16(even);
+            r.val[1] = vmovn_u16(vorrq_u16(vshrq_n_u16(even, 8), vshlq_n_u16(odd, 4)));
+            r.val[2] = vmovn_u16(vshrq_n_u16(odd, 4));
+            vst3_u8(d + i / 2 * 3, r);
+        }
+    }
+
+    return i;
+}
+
+static uint64_t simd_unpack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    const uint8_t *s = (const uint8_t *)src;
+    uint8_t *d = (uint8_t *)dest;
+    uint64_t i = 0;
+
+    if (!pt.compact && (pt.bits == 4))
+    {
+        for (; i + 16 <= cnt; i += 16)
+            vst1q_u8(d + i, neon_sext4(vandq_u8(vld1q_u8(s + i), vdupq_n_u8(0xF)), pt.is_signed));
+    } else if (!pt.compact) {
+        for (; i + 8 <= cnt; i += 8)
+            vst1q_u16((uint16_t *)d + i, neon_sext12(vandq_u16(vld1q_u16((const uint16_t *)s + i),
+                vdupq_n_u16(0xFFF)), pt.is_signed));
+    } else if (pt.bits == 4) {
+        for (; i + 32 <= cnt; i += 32)
+        {
+            uint8x16_t x = vld1q_u8(s + i / 2);
+            uint8x16x2_t r;
+
+            r.val[0] = neon_sext4(vandq_u8(x, vdupq_n_u8(0xF)), pt.is_signed);
+            r.val[1] = neon_sext4(vshrq_n_u8(x, 4), pt.is_signed);
+            vst2q_u8(d + i, r);
+        }
+    } else {
+        for (; i + 16 <= cnt; i += 16)
+        {
+            uint8x8x3_t x = vld3_u8(s + i / 2 * 3);
+            uint16x8x2_t r;
+
+            r.val[0] = vorrq_u16(vmovl_u8(x.val[0]),
+                vshlq_n_u16(vmovl_u8(vand_u8(x.val[1], vdup_n_u8(0xF))), 8));
+            r.val[1] = vorrq_u16(vmovl_u8(vshr_n_u8(x.val[1], 4)),
+                vshlq_n_u16(vmovl_u8(x.val[2]), 4));
+            r.val[0] = neon_sext12(r.val[0], pt.is_signed);
+            r.val[1] = neon_sext12(r.val[1], pt.is_signed);
+            vst2q_u16((uint16_t *)d + i, r);
+        }
+    }
+
+    return i;
+}
+
+#else
+
+static uint64_t simd_quant_8bit(const float *src, void *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi, bool is_signed)
+{
+    return 0;
+}
+
+static uint64_t simd_quant_s16(const float *src, int16_t *dest, uint64_t cnt,
+    float scale, float zp, float lo, float hi)
+{
+    return 0;
+}
+
+static uint64_t simd_to_f16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    return 0;
+}
+
+static uint64_t simd_to_bf16(const float *src, uint16_t *dest, uint64_t cnt)
+{
+    return 0;
+}
+
+static uint64_t simd_dequant_s8(const int8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    return 0;
+}
+
+static uint64_t simd_dequant_u8(const uint8_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    return 0;
+}
+
+static uint64_t simd_dequant_s16(const int16_t *src, float *dest, uint64_t cnt,
+    float scale, int32_t zp)
+{
+    return 0;
+}
+
+static uint64_t simd_from_f16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    return 0;
+}
+
+static uint64_t simd_from_bf16(const uint16_t *src, float *dest, uint64_t cnt)
+{
+    return 0;
+}
+
+static uint64_t simd_pack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    return 0;
+}
+
+static uint64_t simd_unpack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    return 0;
+}
+#endif
+
+static void pack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    pack_scalar(src, dest, simd_pack(src, dest, cnt, pt), cnt, pt);
+}
+
+static void unpack(const void *src, void *dest, uint64_t cnt, const PackedType &pt)
+{
+    unpack_scalar(src, dest, simd_unpack(src, dest, cnt, pt), cnt, pt);
+}
+
+/**
+ * @brief quantize a chunk into an int8/int16 stack buffer clamped to the packed
+ *        range, then pack it while it's still in cache
+ */
+static void quantize_packed(const float *src, void *dest, uint64_t cnt, const PackedType &pt,
+    float scale, float zp)
+{
+    float lo = pt.is_signed ? -(float)(1 << (pt.bits - 1)) : 0.0f;
+    float hi = (float)((pt.is_signed ? (1 << (pt.bits - 1)) : (1 << pt.bits)) - 1);
+    int16_t tmp[PACK_CHUNK];
+
+    for (uint64_t i = 0; i < cnt; i += PACK_CHUNK)
+    {
+        uint64_t n = std::min<uint64_t>(PACK_CHUNK, cnt - i);
+        uint64_t done = 0;
+
+        if (pt.bits == 4)
+        {
+            done = simd_quant_8bit(src + i, tmp, n, scale, zp, lo, hi, pt.is_signed);
+            quant_int(src + i + done, (int8_t *)tmp + done, n - done, scale, zp, lo, hi);
+        } else {
+            done = simd_quant_s16(src + i, tmp, n, scale, zp, lo, hi);
+            quant_int(src + i + done, tmp + done, n - done, scale, zp, lo, hi);
+        }
+        pack(tmp, (uint8_t *)dest + packed_bytes(pt, i), n, pt);
+    }
+}
+
+static void dequantize_packed(const void *src, float *dest, uint64_t cnt, const PackedType &pt,
+    float scale, int32_t zp)
+{
+    int16_t tmp[PACK_CHUNK];
+
+    for (uint64_t i = 0; i < cnt; i += PACK_CHUNK)
+    {
+        uint64_t n = std::min<uint64_t>(PACK_CHUNK, cnt - i);
+        uint64_t done = 0;
+
+        unpack((const uint8_t *)src + packed_bytes(pt, i), tmp, n, pt);
+        if ((pt.bits == 4) && pt.is_signed)
+        {
+            done = simd_dequant_s8((const int8_t *)tmp, dest + i, n, scale, zp);
+            dequant_int((const int8_t *)tmp + done, dest + i + done, n - done, scale, zp);
+        } else if (pt.bits == 4) {
+            done = simd_dequant_u8((const uint8_t *)tmp, dest + i, n, scale, zp);
+            dequant_int((const uint8_t *)tmp + done, dest + i + done, n - done, scale, zp);
+        } else {
+            /* u12 fits int16 */
+            done = simd_dequant_s16(tmp, dest + i, n, scale, zp);
+            dequant_int(tmp + done, dest + i + done, n - done, scale, zp);
+        }
+    }
+}
+
+uint32_t umd_quant_elem_size(aipu_data_type_t type)
+{
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_S8:
+        case AIPU_DATA_TYPE_U8:
+        case AIPU_DATA_TYPE_ALIGNED_U4:
+        case AIPU_DATA_TYPE_ALIGNED_S4:
+        case AIPU_DATA_TYPE_COMPACT_U4:
+        case AIPU_DATA_TYPE_COMPACT_S4:
+            return 1;
+
+        case AIPU_DATA_TYPE_S16:
+        case AIPU_DATA_TYPE_U16:
+        case AIPU_DATA_TYPE_F16:
+        case AIPU_DATA_TYPE_BF16:
+        case AIPU_DATA_TYPE_ALIGNED_U12:
+        case AIPU_DATA_TYPE_ALIGNED_S12:
+        case AIPU_DATA_TYPE_COMPACT_U12:
+        case AIPU_DATA_TYPE_COMPACT_S12:
+            return 2;
+
+        case AIPU_DATA_TYPE_F32:
+            return 4;
+
+        default:
+            return 0;
+    }
+}
+
+uint64_t umd_quant_elem_cnt(aipu_data_type_t type, uint64_t size)
+{
+    PackedType pt;
+
+    if (get_packed_type(type, pt) && pt.compact)
+        return size * 8 / pt.bits;
+
+    if (umd_quant_elem_size(type) == 0)
+        return 0;
+
+    return size / umd_quant_elem_size(type);
+}
+
+aipu_status_t umd_pack(const void *src, void *dest, uint64_t cnt, aipu_data_type_t type)
+{
+    PackedType pt;
+
+    if (get_packed_type(type, pt))
+        pack(src, dest, cnt, pt);
+    else if (umd_quant_elem_size(type) != 0)
+        memcpy(dest, src, cnt * umd_quant_elem_size(type));
+    else
+        return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t umd_unpack(const void *src, void *dest, uint64_t cnt, aipu_data_type_t type)
+{
+    PackedType pt;
+
+    if (get_packed_type(type, pt))
+        unpack(src, dest, cnt, pt);
+    else if (umd_quant_elem_size(type) != 0)
+        memcpy(dest, src, cnt * umd_quant_elem_size(type));
+    else
+        return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t umd_quantize(const float *src, void *dest, uint64_t cnt,
+    aipu_data_type_t type, float scale, int32_t zero_point)
+{
+    float zp = (float)zero_point;
+    uint64_t i = 0;
+    PackedType pt;
+
+    if (scale == 0)
+        scale = 1.0f;
+
+    if (get_packed_type(type, pt))
+    {
+        quantize_packed(src, dest, cnt, pt, scale, zp);
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_S8:
+            i = simd_quant_8bit(src, dest, cnt, scale, zp, -128.0f, 127.0f, true);
+            quant_int(src + i, (int8_t *)dest + i, cnt - i, scale, zp, -128.0f, 127.0f);
+            break;
+
+        case AIPU_DATA_TYPE_U8:
+            i = simd_quant_8bit(src, dest, cnt, scale, zp, 0.0f, 255.0f, false);
+            quant_int(src + i, (uint8_t *)dest + i, cnt - i, scale, zp, 0.0f, 255.0f);
+            break;
+
+        case AIPU_DATA_TYPE_S16:
+            i = simd_quant_s16(src, (int16_t *)dest, cnt, scale, zp, -32768.0f, 32767.0f);
+            quant_int(src + i, (int16_t *)dest + i, cnt - i, scale, zp, -32768.0f, 32767.0f);
+            break;
+
+        case AIPU_DATA_TYPE_U16:
+            quant_int(src, (uint16_t *)dest, cnt, scale, zp, 0.0f, 65535.0f);
+            break;
+
+        case AIPU_DATA_TYPE_F16:
+            for (i = simd_to_f16(src, (uint16_t *)dest, cnt); i < cnt; i++)
+                ((uint16_t *)dest)[i] = float_to_half(src[i]);
+            break;
+
+        case AIPU_DATA_TYPE_BF16:
+            for (i = simd_to_bf16(src, (uint16_t *)dest, cnt); i < cnt; i++)
+                ((uint16_t *)dest)[i] = float_to_bf16(src[i]);
+            break;
+
+        case AIPU_DATA_TYPE_F32:
+            memcpy(dest, src, cnt * sizeof(float));
+            break;
+
+        default:
+            return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
+
+aipu_status_t umd_dequantize(const void *src, float *dest, uint64_t cnt,
+    aipu_data_type_t type, float scale, int32_t zero_point)
+{
+    uint64_t i = 0;
+    PackedType pt;
+
+    if (scale == 0)
+        scale = 1.0f;
+
+    if (get_packed_type(type, pt))
+    {
+        dequantize_packed(src, dest, cnt, pt, scale, zero_point);
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_S8:
+            i = simd_dequant_s8((const int8_t *)src, dest, cnt, scale, zero_point);
+            dequant_int((const int8_t *)src + i, dest + i, cnt - i, scale, zero_point);
+            break;
+
+        case AIPU_DATA_TYPE_U8:
+            i = simd_dequant_u8((const uint8_t *)src, dest, cnt, scale, zero_point);
+            dequant_int((const uint8_t *)src + i, dest + i, cnt - i, scale, zero_point);
+            break;
+
+        case AIPU_DATA_TYPE_S16:
+            i = simd_dequant_s16((const int16_t *)src, dest, cnt, scale, zero_point);
+            dequant_int((const int16_t *)src + i, dest + i, cnt - i, scale, zero_point);
+            break;
+
+        case AIPU_DATA_TYPE_U16:
+            dequant_int((const uint16_t *)src, dest, cnt, scale, zero_point);
+            break;
+
+        case AIPU_DATA_TYPE_F16:
+            for (i = simd_from_f16((const uint16_t *)src, dest, cnt); i < cnt; i++)
+                dest[i] = half_to_float(((const uint16_t *)src)[i]);
+            break;
+
+        case AIPU_DATA_TYPE_BF16:
+            for (i = simd_from_bf16((const uint16_t *)src, dest, cnt); i < cnt; i++)
+                dest[i] = bf16_to_float(((const uint16_t *)src)[i]);
+            break;
+
+        case AIPU_DATA_TYPE_F32:
+            memcpy(dest, src, cnt * sizeof(float));
+            break;
+
+        default:
+            return AIPU_STATUS_ERROR_OP_NOT_SUPPORTED;
+    }
+
+    return AIPU_STATUS_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  quant.h
+ * @brief UMD tensor quantization helper header
+ */
+
+#ifndef _QUANT_H_
+#define _QUANT_H_
+
+#include <stdint.h>
+#include "standard_api.h"
+
+/**
+ * @brief This function is used to get the element size of unpacked data of a
+ *        data type the helpers support
+ *
+ * @param[in] type Tensor data type
+ *
+ * @retval element byte size, 1 for 4-bit and 2 for 12-bit types, 0 if the type isn't supported
+ */
+uint32_t umd_quant_elem_size(aipu_data_type_t type);
+
+/**
+ * @brief This function is used to get the element count of a tensor buffer
+ *
+ * @param[in] type Tensor data type
+ * @param[in] size Tensor buffer byte size
+ *
+ * @retval element count, 0 if the type isn't supported
+ *
+ * @note a compact 4-bit tensor of odd element count has one more padding element
+ */
+uint64_t umd_quant_elem_cnt(aipu_data_type_t type, uint64_t size);
+
+/**
+ * @brief This function is used to pack unpacked integer data into a tensor buffer
+ *
+ * @param[in]  src  Unpacked data: int8/uint8 for 4-bit types, int16/uint16 for 12-bit types
+ * @param[out] dest Tensor buffer
+ * @param[in]  cnt  Element count
+ * @param[in]  type Tensor data type
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note values out of the 4/12-bit range saturate. aligned types keep one element
+ *       per byte/half-word with the upper bits zero, compact types store element
+ *       2n in the low bits: two 4-bit elements per byte, two 12-bit ones per 3 bytes.
+ *       the other types umd_quant_elem_size supports are copied as they are.
+ */
+aipu_status_t umd_pack(const void *src, void *dest, uint64_t cnt, aipu_data_type_t type);
+
+/**
+ * @brief This function is used to unpack a tensor buffer into integer data, signed
+ *        types are sign extended
+ *
+ * @param[in]  src  Tensor buffer
+ * @param[out] dest Unpacked data, see umd_pack
+ * @param[in]  cnt  Element count
+ * @param[in]  type Tensor data type
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ */
+aipu_status_t umd_unpack(const void *src, void *dest, uint64_t cnt, aipu_data_type_t type);
+
+/**
+ * @brief This function is used to quantize float data into a tensor buffer
+ *
+ * @param[in]  src        Float data
+ * @param[out] dest       Tensor buffer of 'cnt' elements of 'type'
+ * @param[in]  cnt        Element count
+ * @param[in]  type       Tensor data type: S8/U8/S16/U16 and 4/12-bit ones are quantized,
+ *                        F16/BF16/F32 converted
+ * @param[in]  scale      Tensor scale, 0 is taken as 1
+ * @param[in]  zero_point Tensor zero point
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note q = clamp(round_half_even(f * scale) - zero_point), NaN gives the type minimum.
+ *       AVX2/NEON kernels are used when the CPU has them, results equal the scalar ones.
+ */
+aipu_status_t umd_quantize(const float *src, void *dest, uint64_t cnt,
+    aipu_data_type_t type, float scale, int32_t zero_point);
+
+/**
+ * @brief This function is used to dequantize a tensor buffer into float data
+ *
+ * @param[in]  src        Tensor buffer of 'cnt' elements of 'type'
+ * @param[out] dest       Float data
+ * @param[in]  cnt        Element count
+ * @param[in]  type       Tensor data type, see umd_quantize
+ * @param[in]  scale      Tensor scale, 0 is taken as 1
+ * @param[in]  zero_point Tensor zero point
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_OP_NOT_SUPPORTED
+ *
+ * @note f = (q + zero_point) / scale
+ */
+aipu_status_t umd_dequantize(const void *src, float *dest, uint64_t cnt,
+    aipu_data_type_t type, float scale, int32_t zero_point);
+
+#endif /* _QUANT_H_ */
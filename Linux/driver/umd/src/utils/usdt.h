@@ -0,0 +1,80 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  usdt.h
+ * @brief UMD statically defined tracepoints (USDT)
+ *
+ * @note  a probe is a nop plus a SystemTap SDT ELF note (.note.stapsdt) describing where
+ *        its arguments are, the format <sys/sdt.h> emits, so bpftrace/perf/bcc attach to
+ *        it without the header installed:
+ *            bpftrace -e 'usdt:libaipudrv.so:aipu_umd:job_schedule { @[arg1] = count(); }'
+ *        arguments are passed as 64-bit registers. build with -DUMD_USDT_DISABLE to drop
+ *        the probes.
+ */
+
+#ifndef _USDT_H_
+#define _USDT_H_
+
+#include <stdint.h>
+
+#define UMD_USDT_PROVIDER "aipu_umd"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)) && \
+    !defined(UMD_USDT_DISABLE)
+
+#define UMD_USDT_ASM(name, fmt, ...) \
+    __asm__ __volatile__ ( \
+        "990: nop\n" \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+        ".balign 4\n" \
+        ".4byte 992f-991f, 994f-993f, 3\n" \
+        "991: .asciz \"stapsdt\"\n" \
+        "992: .balign 4\n" \
+        "993: .8byte 990b\n" \
+        ".8byte _.stapsdt.base\n" \
+        ".8byte 0\n" \
+        ".asciz \"" UMD_USDT_PROVIDER "\"\n" \
+        ".asciz \"" #name "\"\n" \
+        ".asciz \"" fmt "\"\n" \
+        "994: .balign 4\n" \
+        ".popsection\n" \
+        ".ifndef _.stapsdt.base\n" \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n" \
+        ".hidden _.stapsdt.base\n" \
+        "_.stapsdt.base: .space 1\n" \
+        ".size _.stapsdt.base, 1\n" \
+        ".popsection\n" \
+        ".endif\n" \
+        :: __VA_ARGS__)
+
+#define UMD_USDT_ARG(n, v) [a##n] "r" ((uint64_t)(v))
+
+#define UMD_USDT0(name) \
+    UMD_USDT_ASM(name, "", )
+#define UMD_USDT1(name, a1) \
+    UMD_USDT_ASM(name, "8@%[a1]", UMD_USDT_ARG(1, a1))
+#define UMD_USDT2(name, a1, a2) \
+    UMD_USDT_ASM(name, "8@%[a1] 8@%[a2]", UMD_USDT_ARG(1, a1), UMD_USDT_ARG(2, a2))
+#define UMD_USDT3(name, a1, a2, a3) \
+    UMD_USDT_ASM(name, "8@%[a1] 8@%[a2] 8@%[a3]", UMD_USDT_ARG(1, a1), UMD_USDT_ARG(2, a2), \
+        UMD_USDT_ARG(3, a3))
+#define UMD_USDT4(name, a1, a2, a3, a4) \
+    UMD_USDT_ASM(name, "8@%[a1] 8@%[a2] 8@%[a3] 8@%[a4]", UMD_USDT_ARG(1, a1), \
+        UMD_USDT_ARG(2, a2), UMD_USDT_ARG(3, a3), UMD_USDT_ARG(4, a4))
+
+#else
+
+#define UMD_USDT0(name) do {} while (0)
+#define UMD_USDT1(name, a1) do { (void)(a1); } while (0)
+#define UMD_USDT2(name, a1, a2) do { (void)(a1); (void)(a2); } while (0)
+#define UMD_USDT3(name, a1, a2, a3) do { (void)(a1); (void)(a2); (void)(a3); } while (0)
+#define UMD_USDT4(name, a1, a2, a3, a4) \
+    do { (void)(a1); (void)(a2); (void)(a3); (void)(a4); } while (0)
+
+#endif
+
+#endif /* _USDT_H_ */
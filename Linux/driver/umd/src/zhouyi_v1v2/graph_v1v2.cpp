@@ -36,6 +36,13 @@ aipu_status_t aipudrv::GraphV12::create_job(JOB_ID* id, const aipu_global_config
 
     ret = job->init(cfg, hw_cfg);
     *id = add_job(job);
+    if (*id == 0)
+    {
+        job->destroy();
+        delete job;
+        return AIPU_STATUS_ERROR_NO_FREE_HANDLE;
+    }
+
     return ret;
 }
 
@@ -368,6 +368,8 @@ aipu_status_t aipudrv::JobV12::free_job_buffers()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
 
+    stop_printf_stream();
+
     if (m_rodata && m_rodata->size != 0)
         m_mem->free(&m_rodata);
 
@@ -408,6 +410,7 @@ aipu_status_t aipudrv::JobV12::schedule()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     JobDesc desc = {0};
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_SCHEDULE);
 
     ret = validate_schedule_status();
     if (ret != AIPU_STATUS_SUCCESS)
@@ -523,11 +526,12 @@ aipu_status_t aipudrv::JobV12::schedule()
     if (get_graph().m_sram_flag)
         desc.kdesc.exec_flag |= AIPU_JOB_EXEC_FLAG_SRAM_MUTEX;
 
+    mark_commit();
     ret = m_dev->schedule(desc);
     if (ret == AIPU_STATUS_SUCCESS)
     {
 #if (defined SIMULATION)
-        m_status = AIPU_JOB_STATUS_DONE;
+        update_job_status(AIPU_JOB_STATUS_DONE);
 #else
     if ((m_is_defer_run == true) && (m_do_trigger == false))
         m_status = AIPU_JOB_STATUS_BIND;
@@ -535,6 +539,7 @@ aipu_status_t aipudrv::JobV12::schedule()
         m_status = AIPU_JOB_STATUS_SCHED;
 #endif
     } else {
+        cancel_commit();
         m_status = AIPU_JOB_STATUS_EXCEPTION;
     }
 
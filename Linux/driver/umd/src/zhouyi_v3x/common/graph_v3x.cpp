@@ -19,6 +19,7 @@
 #endif
 
 #include "parser_elf.h"
+#include "load_phase.h"
 #include "utils/helper.h"
 #include "utils/log.h"
 
@@ -106,6 +107,7 @@ aipu_status_t aipudrv::GraphV3X::extract_gm_info(int sg_id)
     GMConfig *gmconfig = nullptr;
     GM_info_desc gm_info_desc = {0};
     uint32_t gm_buffer_cnt = 0;
+    LoadPhase phase(AIPU_LOAD_PHASE_EXTRACT_GM);
 
     if (m_gmconfig.size() == 0)
         goto out;
@@ -200,6 +202,7 @@ aipu_status_t aipudrv::GraphV3X::create_job(JOB_ID* id, const aipu_global_config
     JobV3_1 *job = nullptr;
 #endif
     uint32_t part_cnt = 0;
+    uint64_t trace_begin = JobTrace::enabled() ? JobTrace::now() : 0;
 
     if (job_config == nullptr)
         return AIPU_STATUS_ERROR_NULL_PTR;
@@ -234,6 +237,15 @@ aipu_status_t aipudrv::GraphV3X::create_job(JOB_ID* id, const aipu_global_config
 #endif
     ret = job->init(glb_sim_cfg, hw_cfg);
     *id = add_job(job);
+    if (*id == 0)
+    {
+        job->destroy();
+        delete job;
+        return AIPU_STATUS_ERROR_NO_FREE_HANDLE;
+    }
+
+    if (trace_begin != 0)
+        job->trace_create(trace_begin);
     return ret;
 }
 
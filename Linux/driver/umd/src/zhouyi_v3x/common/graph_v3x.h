@@ -198,6 +198,19 @@ public:
         return m_subgraphs[sg_id];
     }
 
+    /* a subgraph's profiler data starts at its profiler_buf_size, see setup_task_tcb */
+    void get_profile_regions(ProfileRegions &regions)
+    {
+        if (get_subgraph_cnt() == 0)
+        {
+            regions.push_back(std::make_pair(0, 0));
+            return;
+        }
+
+        for (auto &sg : m_subgraphs)
+            regions.push_back(std::make_pair(sg.id, sg.profiler_buf_size));
+    }
+
     void set_bss(struct BSS bss)
     {
         m_bss_vec.push_back(bss);
@@ -16,6 +16,7 @@
 #include "job_v3.h"
 #include "../common/graph_v3x.h"
 #include "parser_base.h"
+#include "weight_residency.h"
 #include "utils/helper.h"
 
 #if defined(SIMULATION)
@@ -52,6 +53,10 @@ aipudrv::JobV3::JobV3(MainContext* ctx, GraphBase& graph, DeviceBase* dev, aipu_
     if (m_same_asid && m_mem->get_asid_base(0) != m_mem->get_asid_base(1))
         m_same_asid = false;
 
+    /* on-demand BSS weight may locate anywhere on each schedule */
+    if (get_graph().is_wt_on_demand())
+        m_same_asid = false;
+
     if (config->fm_idxes)
     {
         for (int i = 0; i < config->fm_idxes_cnt; i++)
@@ -848,6 +853,7 @@ aipu_status_t aipudrv::JobV3::alloc_load_job_buffers()
         goto finish;
 
     /* 7. setup rodata & dcr, update entry for all subgraphs in global RO/DCR section */
+    trace_init_phase(JOB_TRACE_INIT_RODATA);
     ret = setup_rodata_sg(0, get_graph().get_bss(0).param_map,
         m_bss_buffer_vec[0].reuses, *m_bss_buffer_vec[0].weights);
     if (ret != AIPU_STATUS_SUCCESS)
@@ -1045,6 +1051,8 @@ aipu_status_t aipudrv::JobV3::free_job_buffers()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
 
+    stop_printf_stream();
+
     if (m_model_global_param && m_model_global_param->size != 0)
         m_mem->free(&m_model_global_param, "modelparam");
 
@@ -1076,7 +1084,7 @@ aipu_status_t aipudrv::JobV3::free_job_buffers()
         m_sg_job[i].reset(i, -1);
     }
 
-    for (uint32_t bss_idx = 0; bss_idx < get_graph().get_bss_cnt(); bss_idx++)
+    for (uint32_t bss_idx = 0; bss_idx < m_bss_buffer_vec.size(); bss_idx++)
     {
         if (m_top_reuse_buf != nullptr && m_top_reuse_buf->size > 0)
         {
@@ -1125,10 +1133,20 @@ aipu_status_t aipudrv::JobV3::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
     Task& task = m_sg_job[sg_id].tasks[task_id];
     tcb_t tcb;
     TCB* next_tcb = nullptr;
+    const WeightGrid *wt_grid = get_wt_grid(sg_id);
+    uint32_t sg_cnt = m_sg_cnt;
+    uint32_t sg_end = m_sg_cnt;
+
+    /* a grid of on-demand weight is a TCB chain of its own */
+    if (wt_grid != nullptr)
+    {
+        sg_cnt = wt_grid->sg_cnt;
+        sg_end = wt_grid->sg_start + wt_grid->sg_cnt;
+    }
 
     if (task_id != (m_task_per_sg - 1))
         next_tcb = &m_sg_job[sg_id].tasks[task_id + 1].tcb;
-    else if (sg_id != (m_sg_cnt - 1))
+    else if (sg_id != (sg_end - 1))
         next_tcb = &m_sg_job[sg_id + 1].tasks[0].tcb;
     else
         next_tcb = nullptr;
@@ -1139,7 +1157,7 @@ aipu_status_t aipudrv::JobV3::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
 
     if (task_id == (m_task_per_sg - 1)) {
         tcb.flag |= TCB_FLAG_END_TYPE_GROUP_END;
-        if (!next_tcb && m_sg_cnt == 1)
+        if (!next_tcb && sg_cnt == 1)
             tcb.interrupt |= EN_INTERRUPT_CORE;
     }
 
@@ -1155,7 +1173,7 @@ aipu_status_t aipudrv::JobV3::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
         tcb.interrupt |= EN_INTERRUPT_CLUSTER;
 
 #ifndef SIMULATION
-        if (m_sg_cnt == 1)
+        if (sg_cnt == 1)
             tcb.flag &= ~TCB_FLAG_END_TYPE_GRID_END;
 #endif
     }
@@ -1181,7 +1199,7 @@ aipu_status_t aipudrv::JobV3::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
         }
 
         /* to parallel model which runs only on single core, unset depend-all flag */
-        if (m_sg_cnt == 1)
+        if (sg_cnt == 1)
             tcb.flag &= ~TCB_FLAG_DEP_TYPE_PRE_ALL;
     }
 
@@ -1330,6 +1348,14 @@ aipu_status_t aipudrv::JobV3::setup_tcb_chain()
     bool is_new_grid = false;
     uint32_t tmp_segmmu_tcb_skip = 0;
 
+    m_wt_grids.clear();
+    m_wt_grid = 0;
+    if (get_graph().is_wt_on_demand() && (get_graph().m_bweight.size() > 0))
+    {
+        for (uint32_t i = 0; i < get_graph().get_subgraph_cnt(); i++)
+            add_wt_grid_sg(i, get_graph().get_subgraph(i).bss_idx);
+    }
+
     for (uint32_t i = 0; i < get_graph().get_subgraph_cnt(); i++)
     {
         /**
@@ -1388,7 +1414,21 @@ aipu_status_t aipudrv::JobV3::setup_tcb_chain()
              */
             if (get_graph().m_bweight.size() > 0)
             {
-                DEV_PA_64 asid1_base = get_graph().get_WeightBufferInfo(prev_bss_idx).wb_asid_base;
+                DEV_PA_64 asid1_base = 0;
+
+                /**
+                 * on-demand BSS may be uploaded or evicted at any time, patch
+                 * ASID1 on schedule once the BSS is pinned.
+                 */
+                if (get_graph().is_wt_on_demand())
+                {
+                    m_wt_grids[init_tcb_cnt - 1].head_pa = next_init_tcb_pa;
+                    m_wt_grids[init_tcb_cnt - 1].asid_slots.push_back(next_init_tcb_pa
+                        + ((char *)&tcb.asids[1] - (char *)&tcb));
+                } else {
+                    asid1_base = get_graph().get_WeightBufferInfo(prev_bss_idx).wb_asid_base;
+                }
+
                 tcb.asids[1].v32.lo = get_low_32(asid1_base | ASID_RD | ASID_WR);
                 tcb.asids[1].v32.hi = get_high_32(asid1_base);
             } else {
@@ -1415,6 +1455,10 @@ aipu_status_t aipudrv::JobV3::setup_tcb_chain()
         if (ret != AIPU_STATUS_SUCCESS)
             return ret;
 
+        if (!m_wt_grids.empty())
+            m_wt_grids[init_tcb_cnt - 1].tail_pa =
+                m_sg_job[get_graph().get_subgraph(i).id].tasks[m_task_per_sg - 1].tcb.pa;
+
         if (++core_id >= m_core_cnt)
             core_id = 0;
 
@@ -1468,6 +1512,7 @@ aipu_status_t aipudrv::JobV3::init(const aipu_global_config_simulation_t* cfg,
         get_graph().m_remap_flag, m_core_cnt, get_graph().get_bss_cnt());
 
     /* allocate and load job buffers */
+    trace_init_phase(JOB_TRACE_INIT_ALLOC);
     ret = alloc_load_job_buffers();
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
@@ -1482,13 +1527,18 @@ aipu_status_t aipudrv::JobV3::init(const aipu_global_config_simulation_t* cfg,
         goto finish;
     }
 
+    trace_init_phase(JOB_TRACE_INIT_TCB);
     ret = setup_tcb_chain();
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
+    trace_init_end();
 
     if (m_backup_tcb != nullptr)
         m_mem->read(m_init_tcb.pa, m_backup_tcb.get(), m_tot_tcb_cnt * sizeof(tcb_t));
 
+    /* start uploading on-demand weight of the first grid ahead of schedule */
+    prefetch_weights(0);
+
 finish:
     return ret;
 }
@@ -1496,7 +1546,8 @@ finish:
 aipu_status_t aipudrv::JobV3::schedule()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
-    JobDesc desc;
+    JobTraceSpan span(JOB_TRACE_SCHEDULE, m_id, m_partition_id);
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_SCHEDULE);
 
     ret = validate_schedule_status();
     if (ret != AIPU_STATUS_SUCCESS)
@@ -1516,6 +1567,10 @@ aipu_status_t aipudrv::JobV3::schedule()
         m_mem->write(m_init_tcb.pa, m_backup_tcb.get(), m_tot_tcb_cnt * sizeof(tcb_t));
     m_backup_tcb_used = true;
 
+    /* the last grid of a done job nobody got the status of is still pinned */
+    release_weights();
+    m_wt_grid = 0;
+
     ret = dump_for_emulation();
     if (ret != AIPU_STATUS_SUCCESS)
         return ret;
@@ -1524,6 +1579,32 @@ aipu_status_t aipudrv::JobV3::schedule()
     dump_job_private_buffers(*m_rodata, m_descriptor);
     dump_specific_buffers();
 
+    return schedule_grid();
+}
+
+/**
+ * @brief commit the TCB chain of grid m_wt_grid, or the whole TCB chain if
+ *        the graph weight isn't on demand.
+ */
+aipu_status_t aipudrv::JobV3::schedule_grid()
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    JobDesc desc;
+    DEV_PA_64 head_pa = m_init_tcb.pa;
+    DEV_PA_64 tail_pa = m_init_tcb.pa + (m_tot_tcb_cnt - 1) * sizeof(tcb_t);
+    uint32_t sg_cnt = m_sg_cnt;
+
+    if (m_wt_grid < m_wt_grids.size())
+    {
+        head_pa = m_wt_grids[m_wt_grid].head_pa;
+        tail_pa = m_wt_grids[m_wt_grid].tail_pa;
+        sg_cnt = m_wt_grids[m_wt_grid].sg_cnt;
+    }
+
+    ret = acquire_weights();
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
     memset(&desc.kdesc, 0, sizeof(desc.kdesc));
 
     /* for simulation */
@@ -1531,10 +1612,10 @@ aipu_status_t aipudrv::JobV3::schedule()
     desc.kdesc.version_compatible = !get_graph().m_do_vcheck;
     desc.kdesc.aipu_config = get_graph().m_hw_config;
     desc.jobbase = this;
-    desc.tcb_head = m_init_tcb.pa;
+    desc.tcb_head = head_pa;
 
     /* last task tcb pa for sim */
-    desc.tcb_tail = m_init_tcb.pa + (m_tot_tcb_cnt - 1) * sizeof(tcb_t);
+    desc.tcb_tail = tail_pa;
 
     /* for HW */
     desc.kdesc.exec_flag = (m_qos == AIPU_JOB_QOS_HIGH)
@@ -1562,13 +1643,13 @@ aipu_status_t aipudrv::JobV3::schedule()
     desc.kdesc.exec_flag |= (m_segmmu_num > 0) ?
         AIPU_JOB_EXEC_FLAG_SEG_MMU : 0;
 
-    desc.kdesc.exec_flag |= (m_sg_cnt == 1) ?
+    desc.kdesc.exec_flag |= (sg_cnt == 1) ?
         AIPU_JOB_EXEC_FLAG_SINGLE_GROUP : AIPU_JOB_EXEC_FLAG_MULTI_GROUP;
 
-    desc.kdesc.head_tcb_pa = m_init_tcb.pa;
-    desc.kdesc.first_task_tcb_pa = m_init_tcb.pa + sizeof(tcb_t);
-    desc.kdesc.last_task_tcb_pa = m_init_tcb.pa + (m_tot_tcb_cnt - 1) * sizeof(tcb_t);
-    desc.kdesc.tail_tcb_pa = m_init_tcb.pa + (m_tot_tcb_cnt - 1) * sizeof(tcb_t);
+    desc.kdesc.head_tcb_pa = head_pa;
+    desc.kdesc.first_task_tcb_pa = head_pa + sizeof(tcb_t);
+    desc.kdesc.last_task_tcb_pa = tail_pa;
+    desc.kdesc.tail_tcb_pa = tail_pa;
 
     /* for debugger */
     desc.kdesc.is_defer_run = m_is_defer_run;
@@ -1577,9 +1658,17 @@ aipu_status_t aipudrv::JobV3::schedule()
     if (get_graph().m_text->size == 0)
         LOG(LOG_WARN, "Graph text size is 0\n");
     else {
+        /* the job is committed once for all its grids */
+        if (m_wt_grid == 0)
+            mark_commit();
         ret = m_dev->schedule(desc);
         if (ret != AIPU_STATUS_SUCCESS)
+        {
+            if (m_wt_grid == 0)
+                cancel_commit();
+            release_weights();
             return ret;
+        }
     }
 
     if ((m_is_defer_run == true) && (m_do_trigger == false))
@@ -1654,6 +1743,13 @@ aipu_status_t aipudrv::JobV3::dump_for_emulation()
     if (m_dump_emu == false)
         return AIPU_STATUS_SUCCESS;
 
+    /* on-demand weight is only resident grid by grid */
+    if (!m_wt_grids.empty())
+    {
+        LOG(LOG_WARN, "no emulation dump for on-demand weight\n");
+        return AIPU_STATUS_SUCCESS;
+    }
+
     FileWrapper ofs(runtime_cfg, std::ios_base::in | std::ios_base::out | std::ios_base::trunc);
     FileWrapper ofsmt(metadata_txt, std::ios_base::in | std::ios_base::out | std::ios_base::trunc);
     if (!ofs.is_open() || !ofsmt.is_open())
@@ -2032,7 +2128,7 @@ void aipudrv::JobV3::dumpcfg_alljob()
     std::vector<uint32_t> cluster_id[4];
     uint32_t count = 0, cmdpool_mask = 0;
     MainContext *ctx = static_cast<MainContext *>(get_graph().m_ctx);
-    GraphTable &graphs = ctx->get_graphtable();
+    GraphTable graphs = ctx->get_graphtable();
     GraphV3X *graph = nullptr;
     std::ostringstream oss;
     SimulatorV3 *sim = static_cast<SimulatorV3 *>(m_dev);
@@ -2070,8 +2166,9 @@ void aipudrv::JobV3::dumpcfg_alljob()
     {
         graph_iter++;
         graph = static_cast<GraphV3X *>(g.second);
-        auto job_iter = graph->m_jobs.begin();
-        for (auto item: graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        auto job_iter = jobs.begin();
+        for (auto item: jobs)
         {
             job_iter++;
             job = static_cast<JobV3 *>(item.second);
@@ -2092,7 +2189,7 @@ void aipudrv::JobV3::dumpcfg_alljob()
                         std::get<2>(job->m_dump_tcb_info[i]));
                 } else {
                     if ((graph_iter != graphs.end()) ||
-                        (graph_iter == graphs.end() && job_iter != graph->m_jobs.end()))
+                        (graph_iter == graphs.end() && job_iter != jobs.end()))
                     {
                         void *addr = nullptr;
                         uint64_t size = 0;
@@ -2127,7 +2224,8 @@ void aipudrv::JobV3::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item: graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item: jobs)
         {
             job = static_cast<JobV3 *>(item.second);
             if (cmdpool_mask & (1 << job->m_bind_cmdpool_id))
@@ -2168,7 +2266,8 @@ void aipudrv::JobV3::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item: graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item: jobs)
         {
             job = static_cast<JobV3 *>(item.second);
             for (uint32_t i = 0; i < job->m_dumpcfg_output.size(); i++)
@@ -2192,7 +2291,8 @@ void aipudrv::JobV3::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item: graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item: jobs)
         {
             job = static_cast<JobV3 *>(item.second);
             ofsmt << job->m_dumpcfg_meta;
@@ -221,6 +221,7 @@ public:
     aipu_status_t init(const aipu_global_config_simulation_t* cfg,
         const aipu_global_config_hw_t* hw_cfg);
     aipu_status_t schedule();
+    aipu_status_t schedule_grid();
     aipu_status_t destroy();
     aipu_status_t bind_core(uint32_t core_id);
     aipu_status_t debugger_run();
@@ -15,6 +15,7 @@
 #include "job_v3_1.h"
 #include "../common/graph_v3x.h"
 #include "parser_base.h"
+#include "weight_residency.h"
 #include "utils/helper.h"
 
 #if defined(SIMULATION)
@@ -701,6 +702,7 @@ aipu_status_t aipudrv::JobV3_1::alloc_load_job_buffers()
         goto finish;
 
     /* 7. setup rodata & dcr, update entry for all subgraphs in global RO/DCR section */
+    trace_init_phase(JOB_TRACE_INIT_RODATA);
     ret = setup_rodata_sg(0, get_graph().get_bss(0).param_map, m_bss_buffer_vec[0].reuses, *m_bss_buffer_vec[0].weights);
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
@@ -901,6 +903,8 @@ aipu_status_t aipudrv::JobV3_1::free_job_buffers()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
 
+    stop_printf_stream();
+
     if (m_model_global_param && m_model_global_param->size != 0)
         m_mem->free(&m_model_global_param, "modelparam");
 
@@ -924,7 +928,7 @@ aipu_status_t aipudrv::JobV3_1::free_job_buffers()
         m_sg_job[i].reset(i, -1);
     }
 
-    for (uint32_t bss_idx = 0; bss_idx < get_graph().get_bss_cnt(); bss_idx++)
+    for (uint32_t bss_idx = 0; bss_idx < m_bss_buffer_vec.size(); bss_idx++)
     {
         if (m_top_reuse_buf != nullptr && m_top_reuse_buf->size > 0)
         {
@@ -1005,9 +1009,10 @@ aipu_status_t aipudrv::JobV3_1::config_tcb_deps(tcb_t &tcb, uint32_t sg_id)
 
         case 1 ... 4:
             {
+                const WeightGrid *wt_grid = get_wt_grid(sg_id);
                 uint16_t dep_group_id = 0;
+                uint32_t dep_cnt = 0;
 
-                tcb.flag |= TCB_FLAG_DEP_TYPE_GROUP;
                 for (int32_t i = 0; i < graph.get_subgraph(sg_id).precursor_cnt; i++)
                 {
                     if (graph.get_subgraph(sg_id).precursors[i] > 0x7fff)
@@ -1017,10 +1022,16 @@ aipu_status_t aipudrv::JobV3_1::config_tcb_deps(tcb_t &tcb, uint32_t sg_id)
                         return AIPU_STATUS_ERROR_INVALID_GBIN;
                     }
 
+                    /* groups of former on-demand weight grids are done before this grid starts */
+                    if ((wt_grid != nullptr) && (graph.get_subgraph(sg_id).precursors[i] < wt_grid->sg_start))
+                        continue;
+
                     dep_group_id = graph.get_subgraph(sg_id).precursors[i] + m_start_group_id;
                     dep_group_id &= 0x7FFF; // 15 bits group id field
-                    tcb.group_deps[i] = EN_GROUP_DEPEND | dep_group_id;
+                    tcb.group_deps[dep_cnt++] = EN_GROUP_DEPEND | dep_group_id;
                 }
+
+                tcb.flag |= (dep_cnt != 0) ? TCB_FLAG_DEP_TYPE_GROUP : TCB_FLAG_DEP_TYPE_NONE;
             }
             break;
 
@@ -1043,6 +1054,8 @@ aipu_status_t aipudrv::JobV3_1::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
     GraphV3X &graph = get_graph();
     Task &task = m_sg_job[sg_id].tasks[task_id];
     tcb_t tcb;
+    const WeightGrid *wt_grid = get_wt_grid(sg_id);
+    uint32_t sg_end = (wt_grid != nullptr) ? (wt_grid->sg_start + wt_grid->sg_cnt) : m_sg_cnt;
 
     memset(&tcb, 0, sizeof(tcb_t));
     tcb.interrupt_en = EN_INTERRUPT_TEC_ALL;
@@ -1051,7 +1064,8 @@ aipu_status_t aipudrv::JobV3_1::setup_task_tcb(uint32_t sg_id, uint32_t grid_id,
     if (task_id == (m_task_per_sg - 1))
         tcb.flag |= TCB_FLAG_END_TYPE_GROUP_END;
 
-    if ((sg_id == (m_sg_cnt - 1)) && (task_id == (m_task_per_sg - 1)))
+    /* a grid of on-demand weight is a TCB chain of its own */
+    if ((sg_id == (sg_end - 1)) && (task_id == (m_task_per_sg - 1)))
         tcb.flag |= TCB_FLAG_END_TYPE_GRID_END;
 
     /* It is assumed that subgraphs are topology sorted. */
@@ -1127,25 +1141,39 @@ aipu_status_t aipudrv::JobV3_1::setup_tcb_group(uint32_t sg_id, uint32_t grid_id
     return ret;
 }
 
+void aipudrv::JobV3_1::setup_grid_init_tcb(tcb_t &tcb, uint32_t sg_start, uint32_t sg_cnt)
+{
+    memset(&tcb, 0, sizeof(tcb_t));
+    tcb.flag = TCB_FLAG_TASK_TYPE_GRID_INIT | TCB_FLAG_L2D_FLUSH;
+    tcb.group_num = sg_cnt;
+    tcb.grid_intrrupt_en = EN_INTERRUPT_GRID_ALL;
+    tcb.grid_gridid = m_grid_id;
+    tcb.grid_groupid = m_start_group_id + sg_start;
+}
+
 aipu_status_t aipudrv::JobV3_1::setup_tcb_chain()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
     tcb_t tcb;
     uint32_t core_id = 0;
 
-    /* Grid init TCB */
-    memset(&tcb, 0, sizeof(tcb_t));
-    tcb.flag = TCB_FLAG_TASK_TYPE_GRID_INIT | TCB_FLAG_L2D_FLUSH;
-    tcb.group_num = m_sg_cnt;
-    tcb.grid_intrrupt_en = EN_INTERRUPT_GRID_ALL;
-    tcb.grid_gridid = m_grid_id;
-    tcb.grid_groupid = m_group_id_idx;
+    m_wt_grids.clear();
+    m_wt_grid = 0;
+    if (get_graph().is_wt_on_demand() && (get_graph().m_bweight.size() > 0))
+    {
+        for (uint32_t i = 0; i < get_graph().get_subgraph_cnt(); i++)
+            add_wt_grid_sg(i, get_graph().get_subgraph(i).bss_idx);
+    }
 
+    /* Grid init TCB */
+    setup_grid_init_tcb(tcb, 0, m_wt_grids.empty() ? m_sg_cnt : m_wt_grids[0].sg_cnt);
     setup_gm_sync_from_ddr(tcb);
     m_mem->write(m_init_tcb.pa, (const char *)&tcb, sizeof(tcb_t));
 
     for (uint32_t i = 0; i < get_graph().get_subgraph_cnt(); i++)
     {
+        WeightGrid *wt_grid = get_wt_grid(i);
+
         /* Group init TCB */
         memset(&tcb, 0, sizeof(tcb_t));
         tcb.flag = TCB_FLAG_TASK_TYPE_GROUP_INIT | TCB_FLAG_GRID_INIT;
@@ -1175,7 +1203,19 @@ aipu_status_t aipudrv::JobV3_1::setup_tcb_chain()
         if (get_graph().m_bweight.size() > 0)
         {
             uint32_t bss_idx = get_graph().get_subgraph(i).bss_idx;
-            DEV_PA_64 asid1_base = get_graph().get_WeightBufferInfo(bss_idx).wb_asid_base;
+            DEV_PA_64 asid1_base = 0;
+
+            /**
+             * on-demand BSS may be uploaded or evicted at any time, patch
+             * ASID1 on schedule once the BSS is pinned.
+             */
+            if (get_graph().is_wt_on_demand())
+                wt_grid->asid_slots.push_back(m_init_tcb.pa + sizeof(tcb_t)
+                    + (m_task_per_sg + 1) * i * sizeof(tcb_t)
+                    + ((char *)&tcb.asids[2] - (char *)&tcb));
+            else
+                asid1_base = get_graph().get_WeightBufferInfo(bss_idx).wb_asid_base;
+
             tcb.asids[2] = get_low_32(asid1_base | ASID_RD | ASID_WR);
             tcb.asids[3] = get_high_32(asid1_base);
         } else {
@@ -1196,6 +1236,19 @@ aipu_status_t aipudrv::JobV3_1::setup_tcb_chain()
         if (ret != AIPU_STATUS_SUCCESS)
             return ret;
 
+        /**
+         * the grid init TCB of a later on-demand weight grid is written on
+         * schedule in place of the last task TCB of the grid before, which
+         * is done by then. see schedule_grid().
+         */
+        if (wt_grid != nullptr)
+        {
+            if (i == wt_grid->sg_start)
+                wt_grid->head_pa = (i == 0) ? m_init_tcb.pa
+                    : m_sg_job[i - 1].tasks[m_task_per_sg - 1].tcb.pa;
+            wt_grid->tail_pa = m_sg_job[i].tasks[m_task_per_sg - 1].tcb.pa;
+        }
+
         if (++core_id >= m_core_cnt)
             core_id = 0;
     }
@@ -1252,6 +1305,7 @@ aipu_status_t aipudrv::JobV3_1::init(const aipu_global_config_simulation_t *cfg,
     m_group_id_idx = m_start_group_id;
 
     /* allocate and load job buffers */
+    trace_init_phase(JOB_TRACE_INIT_ALLOC);
     ret = alloc_load_job_buffers();
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
@@ -1266,13 +1320,18 @@ aipu_status_t aipudrv::JobV3_1::init(const aipu_global_config_simulation_t *cfg,
         goto finish;
     }
 
+    trace_init_phase(JOB_TRACE_INIT_TCB);
     ret = setup_tcb_chain();
     if (ret != AIPU_STATUS_SUCCESS)
         goto finish;
+    trace_init_end();
 
     if (m_backup_tcb != nullptr)
         m_mem->read(m_init_tcb.pa, m_backup_tcb.get(), m_tot_tcb_cnt * sizeof(tcb_t));
 
+    /* start uploading on-demand weight of the first grid ahead of schedule */
+    prefetch_weights(0);
+
 finish:
     return ret;
 }
@@ -1280,7 +1339,8 @@ finish:
 aipu_status_t aipudrv::JobV3_1::schedule()
 {
     aipu_status_t ret = AIPU_STATUS_SUCCESS;
-    JobDesc desc;
+    JobTraceSpan span(JOB_TRACE_SCHEDULE, m_id, m_partition_id);
+    LatencyTimer timer(get_metrics(), AIPU_METRICS_LAT_SCHEDULE);
 
     ret = validate_schedule_status();
     if (ret != AIPU_STATUS_SUCCESS)
@@ -1300,10 +1360,47 @@ aipu_status_t aipudrv::JobV3_1::schedule()
         m_mem->write(m_init_tcb.pa, m_backup_tcb.get(), m_tot_tcb_cnt * sizeof(tcb_t));
     m_backup_tcb_used = true;
 
+    /* the last grid of a done job nobody got the status of is still pinned */
+    release_weights();
+    m_wt_grid = 0;
+
     dump_job_shared_buffers();
     dump_job_private_buffers(*m_rodata, m_descriptor);
     dump_specific_buffers();
 
+    return schedule_grid();
+}
+
+/**
+ * @brief commit the TCB chain of grid m_wt_grid, or the whole TCB chain if
+ *        the graph weight isn't on demand.
+ */
+aipu_status_t aipudrv::JobV3_1::schedule_grid()
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    JobDesc desc;
+    DEV_PA_64 head_pa = m_init_tcb.pa;
+    DEV_PA_64 tail_pa = m_sg_job[m_sg_cnt - 1].tasks[m_task_per_sg - 1].tcb.pa;
+    uint32_t sg_cnt = m_sg_cnt;
+    tcb_t tcb;
+
+    if (m_wt_grid < m_wt_grids.size())
+    {
+        head_pa = m_wt_grids[m_wt_grid].head_pa;
+        tail_pa = m_wt_grids[m_wt_grid].tail_pa;
+        sg_cnt = m_wt_grids[m_wt_grid].sg_cnt;
+
+        if (m_wt_grid != 0)
+        {
+            setup_grid_init_tcb(tcb, m_wt_grids[m_wt_grid].sg_start, sg_cnt);
+            m_mem->write(head_pa, (const char *)&tcb, sizeof(tcb_t));
+        }
+    }
+
+    ret = acquire_weights();
+    if (ret != AIPU_STATUS_SUCCESS)
+        return ret;
+
     memset(&desc.kdesc, 0, sizeof(desc.kdesc));
 
     /* for simulation */
@@ -1311,9 +1408,9 @@ aipu_status_t aipudrv::JobV3_1::schedule()
     desc.kdesc.version_compatible = !get_graph().m_do_vcheck;
     desc.kdesc.aipu_config = get_graph().m_hw_config;
     desc.jobbase = this;
-    desc.tcb_number = m_tot_tcb_cnt;
-    desc.tcb_head = m_init_tcb.pa;
-    desc.tcb_tail = m_sg_job[m_sg_cnt - 1].tasks[m_task_per_sg - 1].tcb.pa;
+    desc.tcb_number = 1 + sg_cnt * (m_task_per_sg + 1);
+    desc.tcb_head = head_pa;
+    desc.tcb_tail = tail_pa;
 
     /* for HW */
     desc.kdesc.exec_flag = (m_qos == AIPU_JOB_QOS_HIGH)
@@ -1333,9 +1430,9 @@ aipu_status_t aipudrv::JobV3_1::schedule()
     desc.kdesc.enable_poll_opt = !m_hw_cfg->poll_in_commit_thread;
     desc.kdesc.aipu_version = get_graph().m_hw_version;
     desc.kdesc.partition_id = m_partition_id;
-    desc.kdesc.head_tcb_pa = m_init_tcb.pa;
-    desc.kdesc.tail_tcb_pa = m_sg_job[m_sg_cnt - 1].tasks[m_task_per_sg - 1].tcb.pa;
-    desc.kdesc.last_task_tcb_pa = m_sg_job[m_sg_cnt - 1].tasks[m_task_per_sg - 1].tcb.pa;
+    desc.kdesc.head_tcb_pa = head_pa;
+    desc.kdesc.tail_tcb_pa = tail_pa;
+    desc.kdesc.last_task_tcb_pa = tail_pa;
 
     /* for debugger */
     desc.kdesc.is_defer_run = m_is_defer_run;
@@ -1343,12 +1440,22 @@ aipu_status_t aipudrv::JobV3_1::schedule()
 
     if (get_graph().m_text->size == 0)
         LOG(LOG_WARN, "Graph text size is 0\n");
-    else
+    else {
+        /* the job is committed once for all its grids */
+        if (m_wt_grid == 0)
+            mark_commit();
         ret = m_dev->schedule(desc);
+    }
 
-    dump_for_emulation();
+    if (m_wt_grid == 0)
+        dump_for_emulation();
     if (ret != AIPU_STATUS_SUCCESS)
+    {
+        if (m_wt_grid == 0)
+            cancel_commit();
+        release_weights();
         return ret;
+    }
 
     if ((m_is_defer_run == true) && (m_do_trigger == false))
         m_status = AIPU_JOB_STATUS_BIND;
@@ -1416,6 +1523,13 @@ aipu_status_t aipudrv::JobV3_1::dump_for_emulation()
     if (m_dump_emu == false)
         return AIPU_STATUS_SUCCESS;
 
+    /* on-demand weight is only resident grid by grid */
+    if (!m_wt_grids.empty())
+    {
+        LOG(LOG_WARN, "no emulation dump for on-demand weight\n");
+        return AIPU_STATUS_SUCCESS;
+    }
+
     FileWrapper ofs(runtime_cfg, std::ios_base::in | std::ios_base::out | std::ios_base::trunc);
     FileWrapper ofsmt(metadata_txt, std::ios_base::in | std::ios_base::out | std::ios_base::trunc);
     if (!ofs.is_open() || !ofsmt.is_open())
@@ -1818,7 +1932,7 @@ void aipudrv::JobV3_1::dumpcfg_alljob()
     std::vector<uint32_t> cluster_id[4];
     uint32_t count = 0, cmdpool_mask = 0;
     MainContext *ctx = static_cast<MainContext *>(get_graph().m_ctx);
-    GraphTable &graphs = ctx->get_graphtable();
+    GraphTable graphs = ctx->get_graphtable();
     GraphV3X *graph = nullptr;
     std::ostringstream oss;
     static bool dump_done = false;
@@ -1849,8 +1963,9 @@ void aipudrv::JobV3_1::dumpcfg_alljob()
     {
         graph_iter++;
         graph = static_cast<GraphV3X *>(g.second);
-        auto job_iter = graph->m_jobs.begin();
-        for (auto item : graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        auto job_iter = jobs.begin();
+        for (auto item : jobs)
         {
             job_iter++;
             job = static_cast<JobV3_1 *>(item.second);
@@ -1874,7 +1989,8 @@ void aipudrv::JobV3_1::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item : graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item : jobs)
         {
             job = static_cast<JobV3_1 *>(item.second);
             if (cmdpool_mask & (1 << job->m_bind_cmdpool_id))
@@ -1914,7 +2030,8 @@ void aipudrv::JobV3_1::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item : graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item : jobs)
         {
             job = static_cast<JobV3_1 *>(item.second);
             for (uint32_t i = 0; i < job->m_dumpcfg_output.size(); i++)
@@ -1938,7 +2055,8 @@ void aipudrv::JobV3_1::dumpcfg_alljob()
     for (auto g : graphs)
     {
         graph = static_cast<GraphV3X *>(g.second);
-        for (auto item : graph->m_jobs)
+        std::map<JOB_ID, JobBase*> jobs = graph->get_jobs();
+        for (auto item : jobs)
         {
             job = static_cast<JobV3_1 *>(item.second);
             ofsmt << job->m_dumpcfg_meta;
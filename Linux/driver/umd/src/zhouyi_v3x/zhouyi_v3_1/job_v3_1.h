@@ -187,6 +187,7 @@ private:
     int alloc_subgraph_buffers_optimized();
     aipu_status_t alloc_subgraph_buffers();
     aipu_status_t init_per_task_data();
+    void setup_grid_init_tcb(tcb_t &tcb, uint32_t sg_start, uint32_t sg_cnt);
     aipu_status_t setup_tcb_chain();
     aipu_status_t config_tcb_smmu(tcb_t &tcb);
     aipu_status_t config_tcb_deps(tcb_t &tcb, uint32_t sg_id);
@@ -201,6 +202,7 @@ public:
     aipu_status_t init(const aipu_global_config_simulation_t* cfg,
         const aipu_global_config_hw_t* hw_cfg);
     aipu_status_t schedule();
+    aipu_status_t schedule_grid();
     aipu_status_t destroy();
     aipu_status_t bind_core(uint32_t core_id);
     aipu_status_t debugger_run();
@@ -0,0 +1,167 @@
+
+#!/bin/env python3
+import os
+import sys
+import time
+import threading
+import numpy as np
+from common.helper import *
+from common.log import *
+
+#
+# hw_mt_finish.py:
+# 	this script is for measuring how inference throughput scales with python threads
+# 	in hardware board. each thread owns one job of the same graph and runs frames via
+# 	finish job sync mode, the blocking UMD calls release the GIL so jobs of different
+# 	threads are in flight together.
+#
+# usage:
+#   python3 hw_mt_finish.py  -s /home/benchmark/resnet50 -l bin/juno/debug/
+#
+# note:
+#   resnet50 {aipu.bin, input0.bin, output.bin}
+#   bin/juno/debug/: libaipudrv.so path
+#
+
+# global switch
+THREAD_CNT_LIST = [1, 2, 4, 8]
+FRAME_CNT = 100
+
+log = Log(EM_LOG_TYPE_ERR | EM_LOG_TYPE_ALT | EM_LOG_TYPE_WAR | EM_LOG_TYPE_INF)
+parseCmdline_obj = Parse_Cmdline(log)
+helper_obj = Help(log)
+hw_env_check(log)
+
+# run here to ensure libaipudrv.so's path is added after cmdline arguments parsed
+from libaipudrv import *
+
+load_cfg = {
+	"wt_mem_region": 0
+}
+wt_idxes = []
+
+job_cfg = {
+	"partition_id" : 0,
+	"dbg_dispatch" : 0,
+	"dbg_core_id" : 0,
+	"qos_level" : 0
+}
+fm_idxes = []
+
+def run_frames(npu, job_id, input_data, output_cnt, result):
+	for frame in range(FRAME_CNT):
+		for i in range(len(input_data)):
+			ret = npu.aipu_load_tensor(job_id, i, input_data[i])
+			if ret != AIPU_STATUS_SUCCESS:
+				result["ret"] = ret
+				return
+
+		ret = npu.aipu_finish_job(job_id, -1)
+		if ret != AIPU_STATUS_SUCCESS:
+			result["ret"] = ret
+			return
+
+		for i in range(output_cnt):
+			retmap = npu.aipu_get_tensor(job_id, AIPU_TENSOR_TYPE_OUTPUT, i)
+			if retmap["ret"] != AIPU_STATUS_SUCCESS:
+				result["ret"] = retmap["ret"]
+				return
+
+	result["ret"] = AIPU_STATUS_SUCCESS
+
+npu = NPU()
+ret = npu.aipu_init_context()
+if ret != AIPU_STATUS_SUCCESS:
+	errmsg = npu.aipu_get_error_message(ret)
+	log.error(f'aipu_init_context [fail], err: {errmsg}')
+	exit(-1)
+else:
+	log.debug('aipu_init_context [ok]')
+
+# loop all benchmarks
+for benchmark in parseCmdline_obj.m_benchmarks_list:
+	log.debug(f'Test: <{benchmark["model"]}>')
+
+	aipu_bin = benchmark["model"]
+	input_bins = benchmark["input_bins"]
+
+	retmap = npu.aipu_load_graph(aipu_bin, load_cfg, wt_idxes)
+	if retmap["ret"] != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(retmap["ret"])
+		log.error(f'aipu_load_graph [fail], err: {errmsg}')
+		npu.aipu_deinit_context()
+		exit(-1)
+	else:
+		graph_id = retmap["data"]
+		log.info(f'load model: {aipu_bin}, {graph_id:x}')
+
+	retmap = npu.aipu_get_tensor_count(graph_id, AIPU_TENSOR_TYPE_OUTPUT)
+	if retmap["ret"] != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(retmap["ret"])
+		log.error(f'aipu_get_tensor_count [fail], err: {errmsg}')
+		npu.aipu_unload_graph(graph_id)
+		npu.aipu_deinit_context()
+		exit(-1)
+	else:
+		output_cnt = retmap["data"]
+
+	input_data = []
+	for i in range(len(input_bins)):
+		with open(input_bins[i], mode='rb') as filp:
+			input_data.append(filp.read())
+
+	job_ids = []
+	for t in range(max(THREAD_CNT_LIST)):
+		retmap = npu.aipu_create_job(graph_id, job_cfg, fm_idxes)
+		if retmap["ret"] != AIPU_STATUS_SUCCESS:
+			errmsg = npu.aipu_get_error_message(retmap["ret"])
+			log.error(f'aipu_create_job [fail], err: {errmsg}')
+			for job_id in job_ids:
+				npu.aipu_clean_job(job_id)
+			npu.aipu_unload_graph(graph_id)
+			npu.aipu_deinit_context()
+			exit(-1)
+		job_ids.append(retmap["data"])
+
+	fail = False
+	for thread_cnt in THREAD_CNT_LIST:
+		results = [{} for t in range(thread_cnt)]
+		threads = [threading.Thread(target=run_frames,
+			args=(npu, job_ids[t], input_data, output_cnt, results[t])) for t in range(thread_cnt)]
+
+		start = time.perf_counter()
+		for thread in threads:
+			thread.start()
+		for thread in threads:
+			thread.join()
+		elapsed = time.perf_counter() - start
+
+		for result in results:
+			if result.get("ret") != AIPU_STATUS_SUCCESS:
+				errmsg = npu.aipu_get_error_message(result.get("ret", AIPU_STATUS_ERROR_JOB_EXCEPTION))
+				log.error(f'threads {thread_cnt} [fail], err: {errmsg}')
+				fail = True
+
+		log.info(f'threads {thread_cnt}: {thread_cnt * FRAME_CNT / elapsed:.1f} frames/s')
+
+	for job_id in job_ids:
+		npu.aipu_clean_job(job_id)
+
+	ret = npu.aipu_unload_graph(graph_id)
+	if ret != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(ret)
+		log.error(f'aipu_unload_graph [fail], err: {errmsg}')
+		npu.aipu_deinit_context()
+		exit(-1)
+
+	if fail:
+		npu.aipu_deinit_context()
+		exit(-1)
+
+ret = npu.aipu_deinit_context()
+if ret != AIPU_STATUS_SUCCESS:
+	errmsg = npu.aipu_get_error_message(ret)
+	log.error(f'aipu_deinit_context [fail], err: {errmsg}')
+	exit(-1)
+else:
+	log.debug(f'aipu_deinit_context [ok]')
@@ -0,0 +1,165 @@
+
+#!/bin/env python3
+import os
+import sys
+import asyncio
+import numpy as np
+from common.helper import *
+from common.log import *
+
+#
+# sim_async_run.py:
+# 	this script is for running in simulation environment via asyncio. several jobs of
+# 	one graph are kept in flight on a single event loop by aipu_run_job_async, then the
+# 	outputs of each job are checked.
+#
+# usage:
+#   python3 sim_async_run.py  -s /home/benchmark/resnet50 -l bin/sim/debug/ -e ./aipu_simulator_x1 -d ./output
+#
+# note:
+#   resnet50 {aipu.bin, input0.bin, output.bin}
+#   bin/sim/debug/: libaipudrv.so path
+#
+
+# global switch
+JOB_CNT = 4
+
+log = Log(EM_LOG_TYPE_ERR | EM_LOG_TYPE_ALT | EM_LOG_TYPE_WAR | EM_LOG_TYPE_INF)
+parseCmdline_obj = Parse_Cmdline(log)
+helper_obj = Help(log)
+
+# run here to ensure libaipudrv.so's path is added after cmdline arguments parsed
+from libaipudrv import *
+
+# "simulator" just for aipu v1/v2
+global_cfg = {
+	"simulator" : parseCmdline_obj.m_emulator_path,
+	"log_file_path" : parseCmdline_obj.m_dump_path,
+	"log_level" : "0",
+	"verbose" : "0",
+	"enable_avx" : "0",
+	"enable_calloc" : "0",
+	"en_eval" : "1"
+}
+
+load_cfg = {
+	"wt_mem_region" : 0
+}
+wt_idxes = []
+
+job_cfg = {
+	"partition_id" : 0,
+	"dbg_dispatch" : 0,
+	"dbg_core_id" : 0,
+	"qos_level" : 0
+}
+fm_idxes = []
+
+async def run_jobs(npu, job_ids, input_data):
+	return await asyncio.gather(*[npu.aipu_run_job_async(job_id, input_data) for job_id in job_ids])
+
+npu = NPU()
+ret = npu.aipu_init_context()
+if ret != AIPU_STATUS_SUCCESS:
+	errmsg = npu.aipu_get_error_message(ret)
+	log.error(f'aipu_init_context [fail], err: {errmsg}')
+	exit(-1)
+else:
+	log.debug('aipu_init_context [ok]')
+
+ret = npu.aipu_config_global(AIPU_CONFIG_TYPE_SIMULATION, global_cfg)
+if ret != AIPU_STATUS_SUCCESS:
+	errmsg = npu.aipu_get_error_message(ret)
+	log.error(f'aipu_config_global [fail], err: {errmsg}')
+	exit(-1)
+else:
+	log.debug('aipu_config_global [ok]')
+
+# loop all benchmarks
+for benchmark in parseCmdline_obj.m_benchmarks_list:
+	log.debug(f'Test: <{benchmark["model"]}>')
+
+	aipu_bin = benchmark["model"]
+	check_bin = benchmark["check_bin"]
+	check_bin_size = benchmark["check_bin_size"]
+	input_bins = benchmark["input_bins"]
+
+	retmap = npu.aipu_load_graph(aipu_bin, load_cfg, wt_idxes)
+	if retmap["ret"] != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(retmap["ret"])
+		log.error(f'aipu_load_graph [fail], err: {errmsg}')
+		npu.aipu_deinit_context()
+		exit(-1)
+	else:
+		graph_id = retmap["data"]
+		log.info(f'load model: {aipu_bin}, {graph_id:x}')
+
+	retmap = npu.aipu_get_tensor_count(graph_id, AIPU_TENSOR_TYPE_OUTPUT)
+	if retmap["ret"] != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(retmap["ret"])
+		log.error(f'aipu_get_tensor_count [fail], err: {errmsg}')
+		npu.aipu_unload_graph(graph_id)
+		npu.aipu_deinit_context()
+		exit(-1)
+	else:
+		output_cnt = retmap["data"]
+
+	output_desc = []
+	for i in range(output_cnt):
+		output_desc.append(npu.aipu_get_tensor_descriptor(graph_id, AIPU_TENSOR_TYPE_OUTPUT, i))
+
+	input_data = []
+	for i in range(len(input_bins)):
+		with open(input_bins[i], mode='rb') as filp:
+			input_data.append(filp.read())
+
+	job_ids = []
+	for j in range(JOB_CNT):
+		retmap = npu.aipu_create_job(graph_id, job_cfg, fm_idxes)
+		if retmap["ret"] != AIPU_STATUS_SUCCESS:
+			errmsg = npu.aipu_get_error_message(retmap["ret"])
+			log.error(f'aipu_create_job [fail], err: {errmsg}')
+			for job_id in job_ids:
+				npu.aipu_clean_job(job_id)
+			npu.aipu_unload_graph(graph_id)
+			npu.aipu_deinit_context()
+			exit(-1)
+		job_ids.append(retmap["data"])
+
+	fail = False
+	rets = asyncio.run(run_jobs(npu, job_ids, input_data))
+	for j in range(JOB_CNT):
+		if rets[j] != AIPU_STATUS_SUCCESS:
+			errmsg = npu.aipu_get_error_message(rets[j])
+			log.error(f'aipu_run_job_async job {j} [fail], err: {errmsg}')
+			fail = True
+			continue
+
+		output_data = []
+		for i in range(output_cnt):
+			retmap = npu.aipu_get_tensor(job_ids[j], AIPU_TENSOR_TYPE_OUTPUT, i, D_UINT8)
+			output_data.append(retmap["data"])
+
+		helper_obj.check_result_helper(output_data, output_desc, check_bin, check_bin_size)
+
+	for job_id in job_ids:
+		npu.aipu_clean_job(job_id)
+
+	ret = npu.aipu_unload_graph(graph_id)
+	if ret != AIPU_STATUS_SUCCESS:
+		errmsg = npu.aipu_get_error_message(ret)
+		log.error(f'aipu_unload_graph [fail], err: {errmsg}')
+		npu.aipu_deinit_context()
+		exit(-1)
+
+	if fail:
+		npu.aipu_deinit_context()
+		exit(-1)
+
+ret = npu.aipu_deinit_context()
+if ret != AIPU_STATUS_SUCCESS:
+	errmsg = npu.aipu_get_error_message(ret)
+	log.error(f'aipu_deinit_context [fail], err: {errmsg}')
+	exit(-1)
+else:
+	log.debug(f'aipu_deinit_context [ok]')
@@ -0,0 +1,195 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  main.cpp
+ * @brief measure the per-call overhead of UMD APIs with multiple threads
+ *
+ * @note
+ *        aipu_api_overhead_test -b aipu.bin -i input0.bin -c output.bin -d ./
+ *
+ *        each thread owns one job of the same graph and calls cheap APIs in a
+ *        tight loop, so the cost is dominated by resolving the ctx/graph/job
+ *        handles. the average ns per call is reported for 1..THREAD_MAX threads.
+ */
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include "standard_api.h"
+#include "common/cmd_line_parsing.h"
+#include "common/helper.h"
+#include "common/dbg.hpp"
+
+using namespace std;
+
+#define THREAD_MAX 8
+#define CALL_CNT   200000
+
+aipu_ctx_handle_t* ctx = nullptr;
+cmd_opt_t opt;
+std::atomic<int> g_start{0};
+std::atomic<int> g_fail{0};
+
+/**
+ * @brief graph handle path: ctx -> graph
+ */
+static void count_tensors(uint64_t job_id, uint64_t *ns)
+{
+    uint32_t cnt = 0;
+
+    while (g_start.load() == 0)
+        ;
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < CALL_CNT; i++)
+    {
+        if (aipu_get_tensor_count(ctx, job_id, AIPU_TENSOR_TYPE_INPUT, &cnt) != AIPU_STATUS_SUCCESS)
+        {
+            g_fail++;
+            break;
+        }
+    }
+    *ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+}
+
+/**
+ * @brief job handle path: ctx -> graph -> job, plus copying the first input
+ */
+static void load_tensor(uint64_t job_id, uint64_t *ns)
+{
+    while (g_start.load() == 0)
+        ;
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < CALL_CNT; i++)
+    {
+        if (aipu_load_tensor(ctx, job_id, 0, opt.inputs[0]) != AIPU_STATUS_SUCCESS)
+        {
+            g_fail++;
+            break;
+        }
+    }
+    *ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+}
+
+static void run_case(const char *name, void (*func)(uint64_t, uint64_t*),
+    vector<uint64_t> &job_ids)
+{
+    for (uint32_t thread_cnt = 1; thread_cnt <= THREAD_MAX; thread_cnt *= 2)
+    {
+        vector<thread> threads;
+        vector<uint64_t> ns(thread_cnt, 0);
+        uint64_t tot_ns = 0;
+
+        g_start = 0;
+        for (uint32_t i = 0; i < thread_cnt; i++)
+            threads.push_back(thread(func, job_ids[i], &ns[i]));
+        g_start = 1;
+
+        for (uint32_t i = 0; i < thread_cnt; i++)
+        {
+            threads[i].join();
+            tot_ns += ns[i];
+        }
+
+        AIPU_CRIT()("%-16s threads %u: %.1f ns/call\n", name, thread_cnt,
+            (double)tot_ns / thread_cnt / CALL_CNT);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipu_create_job_cfg_t create_job_cfg = {0};
+    aipu_global_config_simulation_t sim_glb_config = {0};
+    vector<uint64_t> job_ids;
+    const char* msg = nullptr;
+    uint64_t graph_id = 0;
+    int pass = -1;
+
+    if (init_test_bench(argc, argv, &opt, "api_overhead_test"))
+    {
+        AIPU_ERR()("invalid command line options/args\n");
+        goto finish;
+    }
+
+    ret = aipu_init_context(&ctx);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_init_context: %s\n", msg);
+        goto finish;
+    }
+
+    if (access("/dev/aipu", F_OK) != 0)
+    {
+        sim_glb_config.simulator = opt.simulator;
+        sim_glb_config.log_level = opt.log_level_set ? opt.log_level : 0;
+        ret = aipu_config_global(ctx, AIPU_CONFIG_TYPE_SIMULATION, &sim_glb_config);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(ctx, ret, &msg);
+            AIPU_ERR()("aipu_config_global: %s\n", msg);
+            goto deinit_ctx;
+        }
+    }
+
+    ret = aipu_load_graph(ctx, opt.bin_files[0].c_str(), &graph_id);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_load_graph: %s\n", msg);
+        goto deinit_ctx;
+    }
+
+    for (uint32_t i = 0; i < THREAD_MAX; i++)
+    {
+        uint64_t job_id = 0;
+
+        ret = aipu_create_job(ctx, graph_id, &job_id, &create_job_cfg);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(ctx, ret, &msg);
+            AIPU_ERR()("aipu_create_job: %s\n", msg);
+            goto unload_graph;
+        }
+        job_ids.push_back(job_id);
+    }
+
+    run_case("get_tensor_count", count_tensors, job_ids);
+    run_case("load_tensor", load_tensor, job_ids);
+    pass = (g_fail == 0) ? 0 : -1;
+
+unload_graph:
+    for (auto job_id : job_ids)
+        aipu_clean_job(ctx, job_id);
+
+    ret = aipu_unload_graph(ctx, graph_id);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_unload_graph: %s\n", msg);
+    }
+
+deinit_ctx:
+    ret = aipu_deinit_context(ctx);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_deinit_ctx: %s\n", msg);
+    }
+
+finish:
+    if (pass != 0)
+        AIPU_ERR()("api_overhead_test [fail]\n");
+    deinit_test_bench(&opt);
+    return pass;
+}
@@ -0,0 +1,478 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/**
+ * @file  main.cpp
+ * @brief measure float tensor load/get throughput of the fused quantize APIs
+ *
+ * @note
+ *        aipu_quant_bench_test -b aipu.bin -i input0.bin -c output.bin -d ./
+ *
+ *        aipu_load_tensor_float/aipu_get_tensor_float quantize straight into and
+ *        out of the tensor buffer. they are compared with quantizing into a
+ *        staging buffer in scalar code plus aipu_load_tensor/aipu_get_tensor.
+ *        MB/s is counted on the float data.
+ *
+ *        for 4/12-bit tensors aipu_load_tensor_unpacked/aipu_get_tensor_unpacked
+ *        are compared with bit packing in scalar code the same way, MB/s is
+ *        counted on the unpacked int8/int16 data.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <string.h>
+#include <unistd.h>
+#include "standard_api.h"
+#include "common/cmd_line_parsing.h"
+#include "common/helper.h"
+#include "common/dbg.hpp"
+
+using namespace std;
+
+#define LOOP_CNT 200
+
+aipu_ctx_handle_t* ctx = nullptr;
+cmd_opt_t opt;
+
+static uint32_t int_elem_size(aipu_data_type_t type)
+{
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_S8:
+        case AIPU_DATA_TYPE_U8:
+            return 1;
+
+        case AIPU_DATA_TYPE_S16:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief bits of a 4/12-bit data type, 0 for the other types
+ */
+static uint32_t packed_bits(aipu_data_type_t type, bool *compact)
+{
+    *compact = (type >= AIPU_DATA_TYPE_COMPACT_U4);
+    switch (type)
+    {
+        case AIPU_DATA_TYPE_ALIGNED_U4:
+        case AIPU_DATA_TYPE_ALIGNED_S4:
+        case AIPU_DATA_TYPE_COMPACT_U4:
+        case AIPU_DATA_TYPE_COMPACT_S4:
+            return 4;
+
+        case AIPU_DATA_TYPE_ALIGNED_U12:
+        case AIPU_DATA_TYPE_ALIGNED_S12:
+        case AIPU_DATA_TYPE_COMPACT_U12:
+        case AIPU_DATA_TYPE_COMPACT_S12:
+            return 12;
+
+        default:
+            return 0;
+    }
+}
+
+static uint32_t packed_cnt(const aipu_tensor_desc_t &desc)
+{
+    bool compact = false;
+    uint32_t bits = packed_bits(desc.data_type, &compact);
+
+    if (compact)
+        return desc.size * 8 / bits;
+
+    return desc.size / ((bits == 4) ? 1 : 2);
+}
+
+/**
+ * @brief the bit twiddling loop an application would write, values are masked
+ *        but not saturated
+ */
+static void naive_pack(const int16_t *src, uint8_t *dest, uint32_t cnt, aipu_data_type_t type)
+{
+    bool compact = false;
+    uint32_t bits = packed_bits(type, &compact);
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        uint32_t q = src[i] & ((1 << bits) - 1);
+
+        if (!compact && (bits == 4))
+        {
+            dest[i] = q;
+        } else if (!compact) {
+            ((uint16_t *)dest)[i] = q;
+        } else if (bits == 4) {
+            dest[i / 2] = (i & 1) ? (dest[i / 2] | (q << 4)) : q;
+        } else if (i & 1) {
+            dest[i / 2 * 3 + 1] |= q << 4;
+            dest[i / 2 * 3 + 2] = q >> 4;
+        } else {
+            dest[i / 2 * 3] = q;
+            dest[i / 2 * 3 + 1] = q >> 8;
+        }
+    }
+}
+
+static void naive_unpack(const uint8_t *src, int16_t *dest, uint32_t cnt, aipu_data_type_t type)
+{
+    bool compact = false;
+    uint32_t bits = packed_bits(type, &compact);
+    bool is_signed = (type & 1) != 0;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        int32_t q = 0;
+
+        if (!compact && (bits == 4))
+            q = src[i] & 0xF;
+        else if (!compact)
+            q = ((const uint16_t *)src)[i] & 0xFFF;
+        else if (bits == 4)
+            q = (src[i / 2] >> ((i & 1) * 4)) & 0xF;
+        else if (i & 1)
+            q = (src[i / 2 * 3 + 1] >> 4) | (src[i / 2 * 3 + 2] << 4);
+        else
+            q = src[i / 2 * 3] | ((src[i / 2 * 3 + 1] & 0xF) << 8);
+
+        if (is_signed && (q >> (bits - 1)))
+            q -= 1 << bits;
+        dest[i] = q;
+    }
+}
+
+static void naive_quant(const float *src, void *dest, uint32_t cnt, const aipu_tensor_desc_t &desc)
+{
+    float scale = (desc.scale == 0) ? 1.0f : desc.scale;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        float v = nearbyintf(src[i] * scale) - desc.zero_point;
+
+        if (desc.data_type == AIPU_DATA_TYPE_S8)
+            ((int8_t *)dest)[i] = (int8_t)fminf(fmaxf(v, -128.0f), 127.0f);
+        else if (desc.data_type == AIPU_DATA_TYPE_U8)
+            ((uint8_t *)dest)[i] = (uint8_t)fminf(fmaxf(v, 0.0f), 255.0f);
+        else
+            ((int16_t *)dest)[i] = (int16_t)fminf(fmaxf(v, -32768.0f), 32767.0f);
+    }
+}
+
+static void naive_dequant(const void *src, float *dest, uint32_t cnt, const aipu_tensor_desc_t &desc)
+{
+    float scale = (desc.scale == 0) ? 1.0f : desc.scale;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        int32_t q = 0;
+
+        if (desc.data_type == AIPU_DATA_TYPE_S8)
+            q = ((const int8_t *)src)[i];
+        else if (desc.data_type == AIPU_DATA_TYPE_U8)
+            q = ((const uint8_t *)src)[i];
+        else
+            q = ((const int16_t *)src)[i];
+        dest[i] = (float)(q + desc.zero_point) / scale;
+    }
+}
+
+static void report(const char *name, uint64_t ns, uint32_t cnt)
+{
+    AIPU_CRIT()("%-24s %10.1f MB/s\n", name,
+        (double)cnt * sizeof(float) * LOOP_CNT * 1000 / ns);
+}
+
+static void report_packed(const char *name, uint64_t ns, uint32_t cnt, uint32_t bits)
+{
+    AIPU_CRIT()("%-24s %10.1f MB/s\n", name,
+        (double)cnt * ((bits == 4) ? 1 : 2) * LOOP_CNT * 1000 / ns);
+}
+
+static int bench_load_packed(uint64_t job_id, const aipu_tensor_desc_t &desc)
+{
+    bool compact = false;
+    uint32_t bits = packed_bits(desc.data_type, &compact);
+    uint32_t cnt = packed_cnt(desc);
+    vector<int8_t> data8(cnt);
+    vector<int16_t> data16(cnt);
+    const void *data = (bits == 4) ? (const void *)data8.data() : (const void *)data16.data();
+    vector<uint8_t> staging(desc.size);
+    uint64_t ns = 0;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        data16[i] = (int16_t)((i * 37) & ((1 << bits) - 1));
+        data8[i] = (int8_t)data16[i];
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        naive_pack(data16.data(), staging.data(), cnt, desc.data_type);
+        if (aipu_load_tensor(ctx, job_id, 0, staging.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report_packed("pack + load_tensor", ns, cnt, bits);
+
+    t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_load_tensor_unpacked(ctx, job_id, 0, data) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report_packed("load_tensor_unpacked", ns, cnt, bits);
+
+    return 0;
+}
+
+static int bench_get_packed(uint64_t job_id, const aipu_tensor_desc_t &desc)
+{
+    bool compact = false;
+    uint32_t bits = packed_bits(desc.data_type, &compact);
+    uint32_t cnt = packed_cnt(desc);
+    vector<int16_t> ref(cnt), data(cnt);
+    vector<uint8_t> staging(desc.size);
+    uint64_t ns = 0;
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_get_tensor(ctx, job_id, AIPU_TENSOR_TYPE_OUTPUT, 0, staging.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+        naive_unpack(staging.data(), ref.data(), cnt, desc.data_type);
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report_packed("get_tensor + unpack", ns, cnt, bits);
+
+    t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_get_tensor_unpacked(ctx, job_id, AIPU_TENSOR_TYPE_OUTPUT, 0, data.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report_packed("get_tensor_unpacked", ns, cnt, bits);
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        int32_t v = data[i];
+
+        /* 4-bit data is unpacked to one byte per element, odd types are signed */
+        if (bits == 4)
+            v = (desc.data_type & 1) ? ((int8_t *)data.data())[i] : ((uint8_t *)data.data())[i];
+        if (v != ref[i])
+        {
+            AIPU_ERR()("get_tensor_unpacked result mismatch\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int bench_load(uint64_t job_id, const aipu_tensor_desc_t &desc)
+{
+    uint32_t esize = int_elem_size(desc.data_type);
+    uint32_t cnt = desc.size / esize;
+    vector<float> data(cnt);
+    vector<char> staging(desc.size);
+    uint64_t ns = 0;
+
+    for (uint32_t i = 0; i < cnt; i++)
+        data[i] = sinf(i * 0.01f) * 100;
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        naive_quant(data.data(), staging.data(), cnt, desc);
+        if (aipu_load_tensor(ctx, job_id, 0, staging.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report("quantize + load_tensor", ns, cnt);
+
+    t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_load_tensor_float(ctx, job_id, 0, data.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report("load_tensor_float", ns, cnt);
+
+    return 0;
+}
+
+static int bench_get(uint64_t job_id, const aipu_tensor_desc_t &desc)
+{
+    uint32_t esize = int_elem_size(desc.data_type);
+    uint32_t cnt = desc.size / esize;
+    vector<float> data(cnt), ref(cnt);
+    vector<char> staging(desc.size);
+    uint64_t ns = 0;
+
+    auto t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_get_tensor(ctx, job_id, AIPU_TENSOR_TYPE_OUTPUT, 0, staging.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+        naive_dequant(staging.data(), ref.data(), cnt, desc);
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report("get_tensor + dequantize", ns, cnt);
+
+    t0 = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < LOOP_CNT; i++)
+    {
+        if (aipu_get_tensor_float(ctx, job_id, AIPU_TENSOR_TYPE_OUTPUT, 0, data.data()) != AIPU_STATUS_SUCCESS)
+            return -1;
+    }
+    ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+    report("get_tensor_float", ns, cnt);
+
+    if (memcmp(data.data(), ref.data(), cnt * sizeof(float)) != 0)
+    {
+        AIPU_ERR()("get_tensor_float result mismatch\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    aipu_create_job_cfg_t create_job_cfg = {0};
+    aipu_global_config_simulation_t sim_glb_config = {0};
+    aipu_tensor_desc_t in_desc, out_desc;
+    const char* msg = nullptr;
+    uint64_t graph_id = 0, job_id = 0;
+    bool compact = false;
+    int pass = -1;
+
+    if (init_test_bench(argc, argv, &opt, "quant_bench_test"))
+    {
+        AIPU_ERR()("invalid command line options/args\n");
+        goto finish;
+    }
+
+    ret = aipu_init_context(&ctx);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_init_context: %s\n", msg);
+        goto finish;
+    }
+
+    if (access("/dev/aipu", F_OK) != 0)
+    {
+        sim_glb_config.simulator = opt.simulator;
+        sim_glb_config.log_level = opt.log_level_set ? opt.log_level : 0;
+        ret = aipu_config_global(ctx, AIPU_CONFIG_TYPE_SIMULATION, &sim_glb_config);
+        if (ret != AIPU_STATUS_SUCCESS)
+        {
+            aipu_get_error_message(ctx, ret, &msg);
+            AIPU_ERR()("aipu_config_global: %s\n", msg);
+            goto deinit_ctx;
+        }
+    }
+
+    ret = aipu_load_graph(ctx, opt.bin_files[0].c_str(), &graph_id);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_load_graph: %s\n", msg);
+        goto deinit_ctx;
+    }
+
+    ret = aipu_get_tensor_descriptor(ctx, graph_id, AIPU_TENSOR_TYPE_INPUT, 0, &in_desc);
+    if (ret == AIPU_STATUS_SUCCESS)
+        ret = aipu_get_tensor_descriptor(ctx, graph_id, AIPU_TENSOR_TYPE_OUTPUT, 0, &out_desc);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_get_tensor_descriptor: %s\n", msg);
+        goto unload_graph;
+    }
+
+    ret = aipu_create_job(ctx, graph_id, &job_id, &create_job_cfg);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_create_job: %s\n", msg);
+        goto unload_graph;
+    }
+
+    pass = 0;
+    if (int_elem_size(in_desc.data_type) != 0)
+        pass = bench_load(job_id, in_desc);
+    else if (packed_bits(in_desc.data_type, &compact) != 0)
+        pass = bench_load_packed(job_id, in_desc);
+    else
+        AIPU_CRIT()("input0 data type %u not measured\n", in_desc.data_type);
+
+    if (pass != 0)
+        goto clean_job;
+
+    for (uint32_t i = 0; i < opt.inputs.size(); i++)
+    {
+        ret = aipu_load_tensor(ctx, job_id, i, opt.inputs[i]);
+        if (ret == AIPU_STATUS_SUCCESS)
+            continue;
+
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_load_tensor: %s\n", msg);
+        pass = -1;
+        goto clean_job;
+    }
+
+    ret = aipu_finish_job(ctx, job_id, -1);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_finish_job: %s\n", msg);
+        pass = -1;
+        goto clean_job;
+    }
+
+    if (int_elem_size(out_desc.data_type) != 0)
+        pass = bench_get(job_id, out_desc);
+    else if (packed_bits(out_desc.data_type, &compact) != 0)
+        pass = bench_get_packed(job_id, out_desc);
+    else
+        AIPU_CRIT()("output0 data type %u not measured\n", out_desc.data_type);
+
+clean_job:
+    aipu_clean_job(ctx, job_id);
+
+unload_graph:
+    ret = aipu_unload_graph(ctx, graph_id);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_unload_graph: %s\n", msg);
+    }
+
+deinit_ctx:
+    ret = aipu_deinit_context(ctx);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        aipu_get_error_message(ctx, ret, &msg);
+        AIPU_ERR()("aipu_deinit_ctx: %s\n", msg);
+    }
+
+finish:
+    if (pass != 0)
+        AIPU_ERR()("quant_bench_test [fail]\n");
+    deinit_test_bench(&opt);
+    return pass;
+}
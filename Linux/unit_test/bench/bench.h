@@ -0,0 +1,263 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  bench.h
+ * @brief UMD microbenchmark harness
+ *
+ * @note  a case is calibrated to run at least min_ms per repetition, warmed up
+ *        once and then repeated; each repetition gives one ns/op sample. the
+ *        statistics over the samples are written as JSON so that two builds
+ *        can be compared by tools.
+ */
+
+#ifndef _UMD_BENCH_H_
+#define _UMD_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "standard_api.h"
+
+namespace umd_bench
+{
+/**
+ * @brief nanoseconds spent in named sub-phases of the timed operations
+ */
+typedef std::map<std::string, uint64_t> BenchPhases;
+
+class BenchCase
+{
+public:
+    std::string m_name;
+    std::vector<std::pair<std::string, uint64_t>> m_params;
+
+public:
+    /**
+     * @brief prepare the state run() works on, not timed
+     */
+    virtual aipu_status_t setup()
+    {
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    /**
+     * @brief run the benchmarked operation 'iters' times
+     */
+    virtual aipu_status_t run(uint64_t iters, BenchPhases &phases) = 0;
+    virtual void teardown() {}
+
+public:
+    BenchCase(const std::string &name): m_name(name) {}
+    virtual ~BenchCase() {}
+};
+
+struct BenchStats
+{
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double median = 0;
+    double stddev = 0;
+
+    void compute(std::vector<double> samples)
+    {
+        double sum = 0, var = 0;
+
+        if (samples.empty())
+            return;
+
+        std::sort(samples.begin(), samples.end());
+        for (double s : samples)
+            sum += s;
+
+        min = samples.front();
+        max = samples.back();
+        mean = sum / samples.size();
+        median = (samples.size() % 2) ? samples[samples.size() / 2] :
+            (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+
+        for (double s : samples)
+            var += (s - mean) * (s - mean);
+        stddev = (samples.size() > 1) ? std::sqrt(var / (samples.size() - 1)) : 0;
+    }
+};
+
+struct BenchResult
+{
+    BenchCase *bench = nullptr;
+    aipu_status_t status = AIPU_STATUS_SUCCESS;
+    uint64_t iters = 0;
+    std::vector<double> samples;
+    BenchStats stats;
+    std::map<std::string, BenchStats> phases;
+};
+
+class BenchRunner
+{
+private:
+    uint32_t m_reps;
+    uint32_t m_min_ms;
+    uint64_t m_max_iters;
+
+private:
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    aipu_status_t run_once(BenchCase &bench, uint64_t iters, BenchPhases &phases,
+        uint64_t &ns)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        uint64_t begin = now();
+
+        ret = bench.run(iters, phases);
+        ns = now() - begin;
+        return ret;
+    }
+
+public:
+    BenchResult run(BenchCase &bench)
+    {
+        BenchResult result;
+        BenchPhases phases;
+        std::map<std::string, std::vector<double>> phase_samples;
+        uint64_t iters = 1;
+        uint64_t ns = 0;
+
+        result.bench = &bench;
+        result.status = bench.setup();
+        if (result.status != AIPU_STATUS_SUCCESS)
+            goto teardown;
+
+        /* grow the batch until a repetition is long enough to time, this warms up as well */
+        while (true)
+        {
+            phases.clear();
+            result.status = run_once(bench, iters, phases, ns);
+            if (result.status != AIPU_STATUS_SUCCESS)
+                goto teardown;
+
+            if ((ns >= (uint64_t)m_min_ms * 1000000) || (iters >= m_max_iters))
+                break;
+
+            iters = (ns == 0) ? iters * 10 :
+                std::min(m_max_iters, std::max(iters * 2, iters * m_min_ms * 1100000 / ns));
+        }
+        result.iters = iters;
+
+        for (uint32_t rep = 0; rep < m_reps; rep++)
+        {
+            phases.clear();
+            result.status = run_once(bench, iters, phases, ns);
+            if (result.status != AIPU_STATUS_SUCCESS)
+                goto teardown;
+
+            result.samples.push_back((double)ns / iters);
+            for (auto &phase : phases)
+                phase_samples[phase.first].push_back((double)phase.second / iters);
+        }
+
+        result.stats.compute(result.samples);
+        for (auto &phase : phase_samples)
+            result.phases[phase.first].compute(phase.second);
+
+    teardown:
+        bench.teardown();
+        return result;
+    }
+
+public:
+    BenchRunner(uint32_t reps, uint32_t min_ms, uint64_t max_iters):
+        m_reps(reps), m_min_ms(min_ms), m_max_iters(max_iters) {}
+};
+
+inline std::string json_string(const std::string &str)
+{
+    std::string out = "\"";
+    char buf[8];
+
+    for (char c : str)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+
+    return out + "\"";
+}
+
+inline void write_stats(FILE *fp, const BenchStats &stats)
+{
+    fprintf(fp, "{\"min\": %.2f, \"median\": %.2f, \"mean\": %.2f, \"max\": %.2f, "
+        "\"stddev\": %.2f}", stats.min, stats.median, stats.mean, stats.max, stats.stddev);
+}
+
+/**
+ * @brief write the results as one JSON document
+ *
+ * @note  {"context": {...}, "results": [{"name", "params", "status", "iters", "reps",
+ *        "unit": "ns/op", "samples", "stats", "phases"}]}
+ */
+inline void write_json(FILE *fp, const std::vector<std::pair<std::string, std::string>> &context,
+    const std::vector<BenchResult> &results)
+{
+    fprintf(fp, "{\n  \"context\": {");
+    for (uint32_t i = 0; i < context.size(); i++)
+        fprintf(fp, "%s%s: %s", (i == 0) ? "" : ", ", json_string(context[i].first).c_str(),
+            json_string(context[i].second).c_str());
+    fprintf(fp, "},\n  \"results\": [");
+
+    for (uint32_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results[i];
+        const BenchCase &bench = *result.bench;
+
+        fprintf(fp, "%s\n    {\"name\": %s, \"params\": {", (i == 0) ? "" : ",",
+            json_string(bench.m_name).c_str());
+        for (uint32_t j = 0; j < bench.m_params.size(); j++)
+            fprintf(fp, "%s%s: %lu", (j == 0) ? "" : ", ",
+                json_string(bench.m_params[j].first).c_str(), bench.m_params[j].second);
+        fprintf(fp, "}, \"status\": %u", result.status);
+
+        if (result.status == AIPU_STATUS_SUCCESS)
+        {
+            fprintf(fp, ", \"iters\": %lu, \"reps\": %zu, \"unit\": \"ns/op\", \"samples\": [",
+                result.iters, result.samples.size());
+            for (uint32_t j = 0; j < result.samples.size(); j++)
+                fprintf(fp, "%s%.2f", (j == 0) ? "" : ", ", result.samples[j]);
+            fprintf(fp, "], \"stats\": ");
+            write_stats(fp, result.stats);
+
+            fprintf(fp, ", \"phases\": {");
+            for (auto iter = result.phases.begin(); iter != result.phases.end(); iter++)
+            {
+                fprintf(fp, "%s%s: ", (iter == result.phases.begin()) ? "" : ", ",
+                    json_string(iter->first).c_str());
+                write_stats(fp, iter->second);
+            }
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+}
+}
+
+#endif /* _UMD_BENCH_H_ */
@@ -0,0 +1,152 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  histogram.h
+ * @brief latency histogram with a bounded relative error
+ *
+ * @note  the buckets are log-linear as in HdrHistogram: values below 128 are
+ *        exact, above that every power of two is split into 64 buckets, so a
+ *        recorded value is known within 1/64 (two significant digits) for the
+ *        whole uint64_t range in 3776 counters. histograms of several threads
+ *        are merged by adding them.
+ */
+
+#ifndef _UMD_HISTOGRAM_H_
+#define _UMD_HISTOGRAM_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace umd_bench
+{
+class Histogram
+{
+private:
+    static const uint32_t LINEAR_CNT = 128;
+    static const uint32_t SUB_BITS = 6;
+    static const uint32_t SUB_CNT = 1 << SUB_BITS;
+    static const uint32_t BUCKET_CNT = LINEAR_CNT + (64 - SUB_BITS - 1) * SUB_CNT;
+
+private:
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+    double m_sum = 0;
+
+private:
+    static uint32_t index_of(uint64_t value)
+    {
+        uint32_t shift = 0;
+
+        if (value < LINEAR_CNT)
+            return value;
+
+        /* value >> shift is in [SUB_CNT, 2 * SUB_CNT) */
+        shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return LINEAR_CNT + (shift - 1) * SUB_CNT + (uint32_t)(value >> shift) - SUB_CNT;
+    }
+
+    /**
+     * @brief the largest value that falls into bucket 'idx'
+     */
+    static uint64_t highest_of(uint32_t idx)
+    {
+        uint32_t shift = 0;
+
+        if (idx < LINEAR_CNT)
+            return idx;
+
+        shift = (idx - LINEAR_CNT) / SUB_CNT + 1;
+        return ((((uint64_t)(idx - LINEAR_CNT) % SUB_CNT + SUB_CNT + 1) << shift) - 1);
+    }
+
+public:
+    void record(uint64_t value)
+    {
+        m_counts[index_of(value)]++;
+        m_total++;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+        m_sum += value;
+    }
+
+    void merge(const Histogram &other)
+    {
+        for (uint32_t i = 0; i < BUCKET_CNT; i++)
+            m_counts[i] += other.m_counts[i];
+        m_total += other.m_total;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        m_sum += other.m_sum;
+    }
+
+    uint64_t count() const
+    {
+        return m_total;
+    }
+
+    uint64_t min() const
+    {
+        return (m_total == 0) ? 0 : m_min;
+    }
+
+    uint64_t max() const
+    {
+        return m_max;
+    }
+
+    double mean() const
+    {
+        return (m_total == 0) ? 0 : m_sum / m_total;
+    }
+
+    /**
+     * @brief the value 'percentile' percent of the recorded values are less than or
+     *        equal to, within the bucket precision and never above max()
+     */
+    uint64_t percentile(double percentile) const
+    {
+        uint64_t rank = 0, seen = 0;
+
+        if (m_total == 0)
+            return 0;
+
+        rank = std::max<uint64_t>(1, (uint64_t)std::ceil(percentile / 100 * m_total));
+        for (uint32_t i = 0; i < BUCKET_CNT; i++)
+        {
+            seen += m_counts[i];
+            if (seen >= rank)
+                return std::min(highest_of(i), m_max);
+        }
+
+        return m_max;
+    }
+
+    /**
+     * @brief the non-empty buckets as (highest value, count), for tools to re-merge
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> buckets() const
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> out;
+
+        for (uint32_t i = 0; i < BUCKET_CNT; i++)
+        {
+            if (m_counts[i] != 0)
+                out.push_back(std::make_pair(highest_of(i), m_counts[i]));
+        }
+
+        return out;
+    }
+
+public:
+    Histogram(): m_counts(BUCKET_CNT, 0) {}
+};
+}
+
+#endif /* _UMD_HISTOGRAM_H_ */
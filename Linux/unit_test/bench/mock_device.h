@@ -0,0 +1,173 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  mock_device.h
+ * @brief host-only device for measuring the UMD without an NPU or simulator
+ *
+ * @note  buffers live in the userspace memory of the simulation build and
+ *        nothing is executed. a scheduled job completes at once, so what is
+ *        timed through it is driver overhead only, unless an execution time is
+ *        set: then each partition serves its jobs first come first served on
+ *        its cores, each job taking that time, QoS levels aren't modelled.
+ */
+
+#ifndef _MOCK_DEVICE_H_
+#define _MOCK_DEVICE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "device_base.h"
+#include "job_base.h"
+#include "simulator/umemory.h"
+
+#ifndef UMD_TEST_HOOKS
+#error "the mock device needs the UMD test hooks, build with -DUMD_TEST_HOOKS"
+#endif
+
+namespace umd_bench
+{
+class MockDevice: public aipudrv::DeviceBase
+{
+private:
+    std::atomic<uint64_t> m_sched_cnt{0};
+    uint64_t m_exec_ns = 0;
+    std::mutex m_exec_lock;
+    std::vector<std::vector<uint64_t>> m_core_idle_at;
+    std::map<void *, uint64_t> m_done_at;
+
+private:
+    static uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    bool has_target(uint32_t arch, uint32_t version, uint32_t config, uint32_t rev)
+    {
+        for (auto &cap : m_part_caps)
+        {
+            cap.arch = arch;
+            cap.version = version;
+            cap.config = config;
+        }
+        return true;
+    }
+
+    aipu_status_t schedule(const aipudrv::JobDesc& job)
+    {
+        m_sched_cnt++;
+        if ((m_exec_ns == 0) || (job.jobbase == nullptr))
+            return AIPU_STATUS_SUCCESS;
+
+        std::lock_guard<std::mutex> lock_(m_exec_lock);
+        std::vector<uint64_t> &cores = m_core_idle_at[job.kdesc.partition_id % m_partition_cnt];
+        auto core = std::min_element(cores.begin(), cores.end());
+
+        *core = std::max(*core, now()) + m_exec_ns;
+        m_done_at[job.jobbase] = *core;
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    aipu_ll_status_t get_status(std::vector<aipu_job_status_desc>& jobs_status,
+        uint32_t max_cnt, void *jobbase)
+    {
+        aipu_job_status_desc desc = {0};
+
+        desc.state = AIPU_JOB_STATE_DONE;
+        jobs_status.push_back(desc);
+        return AIPU_LL_STATUS_SUCCESS;
+    }
+
+    aipu_ll_status_t poll_status(uint32_t max_cnt, int32_t time_out,
+        bool of_this_thread, void *jobbase)
+    {
+        uint64_t done_at = 0, cur = 0;
+
+        if (jobbase == nullptr)
+            return AIPU_LL_STATUS_SUCCESS;
+
+        if (m_exec_ns != 0)
+        {
+            std::unique_lock<std::mutex> lock_(m_exec_lock);
+            auto iter = m_done_at.find(jobbase);
+
+            if (iter != m_done_at.end())
+                done_at = iter->second;
+            lock_.unlock();
+
+            cur = now();
+            if ((time_out >= 0) && (done_at > cur + (uint64_t)time_out * 1000000))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(time_out));
+                return AIPU_LL_STATUS_ERROR_POLL_TIMEOUT;
+            }
+            if (done_at > cur)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(done_at - cur));
+
+            lock_.lock();
+            m_done_at.erase(jobbase);
+        }
+
+        static_cast<aipudrv::JobBase *>(jobbase)->update_job_status(AIPU_JOB_STATE_DONE);
+        return AIPU_LL_STATUS_SUCCESS;
+    }
+
+    uint64_t get_sched_cnt()
+    {
+        return m_sched_cnt;
+    }
+
+    /**
+     * @brief let every scheduled job take 'ns' of a core, 0 completes them at once
+     *
+     * @note  set before any job is scheduled
+     */
+    void set_exec_ns(uint64_t ns)
+    {
+        m_exec_ns = ns;
+    }
+
+public:
+    /**
+     * @brief 'part_cnt' partitions of one cluster with 'core_cnt' cores of 4 TECs
+     */
+    MockDevice(uint32_t core_cnt = 1, uint32_t part_cnt = 1)
+    {
+        aipu_partition_cap cap = {0};
+
+        cap.arch = AIPU_ARCH_ZHOUYI;
+#if (defined ZHOUYI_V3_1)
+        cap.version = AIPU_ISA_VERSION_ZHOUYI_V3_1;
+#else
+        cap.version = AIPU_ISA_VERSION_ZHOUYI_V3;
+#endif
+        cap.cluster_cnt = 1;
+        cap.clusters[0].core_cnt = core_cnt;
+        cap.clusters[0].en_core_cnt = core_cnt;
+        cap.clusters[0].tec_cnt = 4;
+        for (uint32_t i = 0; i < part_cnt; i++)
+        {
+            cap.id = i;
+            m_part_caps.push_back(cap);
+            m_core_idle_at.push_back(std::vector<uint64_t>(core_cnt, 0));
+        }
+
+        m_dev_type = aipudrv::DEV_TYPE_MOCK;
+        m_dram = aipudrv::UMemory::get_memory();
+        m_partition_cnt = part_cnt;
+        m_cluster_cnt = 1;
+        m_core_cnt = core_cnt;
+    }
+    MockDevice(const MockDevice& dev) = delete;
+    MockDevice& operator=(const MockDevice& dev) = delete;
+};
+}
+
+#endif /* _MOCK_DEVICE_H_ */
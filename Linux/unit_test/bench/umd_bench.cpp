@@ -0,0 +1,830 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  umd_bench.cpp
+ * @brief microbenchmarks of UMD internals on a mock device
+ *
+ * @note  usage: umd_bench [-r reps] [-t min_ms] [-f filter] [-g aipu.bin] [-s scales]
+ *        [-o out.json] [-l]
+ *        the memory, rodata and handle cases need no graph; the job cases run
+ *        on the graph given by -g, or else on a generated one. the load and
+ *        create_job cases are also run on generated graphs 'scale' times the
+ *        size of a typical model, see graph_gen::scaled_config().
+ */
+
+#include <getopt.h>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include "bench.h"
+#include "mock_device.h"
+#include "graph_gen/graph_gen.h"
+#include "context.h"
+#include "graph_base.h"
+#include "handle_table.h"
+#include "job_trace.h"
+#if (defined ZHOUYI_V3) || (defined ZHOUYI_V3_1)
+#include "graph_v3x.h"
+#else
+#include "graph_v1v2.h"
+#endif
+
+using namespace aipudrv;
+using namespace umd_bench;
+
+/**
+ * @brief deterministic pseudo random indexes, the same sequence on every run
+ */
+static std::vector<uint32_t> random_indexes(uint32_t cnt, uint32_t range)
+{
+    std::vector<uint32_t> idx(cnt);
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+
+    for (uint32_t i = 0; i < cnt; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        idx[i] = (uint32_t)(seed >> 33) % range;
+    }
+
+    return idx;
+}
+
+/**
+ * @brief MemoryBase::pa_to_va with N live buffers
+ */
+class PaToVaBench: public BenchCase
+{
+private:
+    MockDevice &m_dev;
+    uint32_t m_buf_cnt;
+    std::vector<BufferDesc> m_bufs;
+    std::vector<DEV_PA_64> m_addrs;
+
+public:
+    aipu_status_t setup()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        UMemory *mem = static_cast<UMemory *>(m_dev.get_mem());
+
+        /* the memory keeps pointers to the descriptors, no reallocation */
+        m_bufs.resize(m_buf_cnt);
+        for (uint32_t i = 0; i < m_buf_cnt; i++)
+        {
+            ret = mem->malloc_internal(AIPU_PAGE_SIZE, 1, &m_bufs[i], "bench");
+            if (ret != AIPU_STATUS_SUCCESS)
+            {
+                m_bufs.resize(i);
+                return ret;
+            }
+        }
+
+        for (auto idx : random_indexes(1024, m_buf_cnt))
+            m_addrs.push_back(m_bufs[idx].pa + 64);
+
+        return ret;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        MemoryBase *mem = m_dev.get_mem();
+        char *va = nullptr;
+
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            if (mem->pa_to_va(m_addrs[i & 1023], 4, &va) != 0)
+                return AIPU_STATUS_ERROR_OUT_OF_MEM_RANGE;
+        }
+
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    void teardown()
+    {
+        for (auto &buf : m_bufs)
+            m_dev.get_mem()->free_phybuffer(&buf, "bench");
+        m_bufs.clear();
+        m_addrs.clear();
+    }
+
+public:
+    PaToVaBench(MockDevice &dev, uint32_t buf_cnt):
+        BenchCase("mem.pa_to_va"), m_dev(dev), m_buf_cnt(buf_cnt)
+    {
+        m_params.push_back(std::make_pair("buffers", buf_cnt));
+    }
+};
+
+/**
+ * @brief UMemory::malloc_internal plus free of one buffer, with 'live' pages
+ *        in use below it, packed or as one-page holes the buffer doesn't fit in
+ */
+class MallocBench: public BenchCase
+{
+private:
+    MockDevice &m_dev;
+    uint32_t m_live;
+    bool m_holes;
+    std::vector<BufferDesc> m_bufs;
+
+public:
+    aipu_status_t setup()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        UMemory *mem = static_cast<UMemory *>(m_dev.get_mem());
+        uint32_t cnt = m_holes ? m_live * 2 : m_live;
+
+        m_bufs.resize(cnt);
+        for (uint32_t i = 0; i < cnt; i++)
+        {
+            ret = mem->malloc_internal(AIPU_PAGE_SIZE, 1, &m_bufs[i], "bench");
+            if (ret != AIPU_STATUS_SUCCESS)
+            {
+                m_bufs.resize(i);
+                return ret;
+            }
+        }
+
+        /* free every other page, the one-page holes are skipped by two-page requests */
+        if (m_holes)
+        {
+            for (uint32_t i = 1; i < cnt; i += 2)
+            {
+                mem->free_phybuffer(&m_bufs[i], "bench");
+                m_bufs[i].reset();
+            }
+        }
+
+        return ret;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        UMemory *mem = static_cast<UMemory *>(m_dev.get_mem());
+        uint32_t size = m_holes ? 2 * AIPU_PAGE_SIZE : AIPU_PAGE_SIZE;
+        BufferDesc desc;
+
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            desc.reset();
+            ret = mem->malloc_internal(size, 1, &desc, "bench");
+            if (ret != AIPU_STATUS_SUCCESS)
+                break;
+            mem->free_phybuffer(&desc, "bench");
+        }
+
+        return ret;
+    }
+
+    void teardown()
+    {
+        for (auto &buf : m_bufs)
+        {
+            if (buf.size != 0)
+                m_dev.get_mem()->free_phybuffer(&buf, "bench");
+        }
+        m_bufs.clear();
+    }
+
+public:
+    MallocBench(MockDevice &dev, uint32_t live, bool holes):
+        BenchCase("mem.malloc_free"), m_dev(dev), m_live(live), m_holes(holes)
+    {
+        m_params.push_back(std::make_pair("live_pages", live));
+        m_params.push_back(std::make_pair("holes", holes ? 1 : 0));
+    }
+};
+
+/**
+ * @brief a job with no graph behind it, only to reach JobBase::setup_rodata
+ */
+class RodataJob: public JobBase
+{
+private:
+    std::vector<BufferDesc*> m_reuse;
+
+public:
+    using JobBase::setup_rodata;
+    uint32_t get_subgraph_cnt()
+    {
+        return 0;
+    }
+    const std::vector<BufferDesc*> & get_reuse()
+    {
+        return m_reuse;
+    }
+    aipu_status_t init(const aipu_global_config_simulation_t* cfg,
+       const aipu_global_config_hw_t* hw_cfg)
+    {
+        return AIPU_STATUS_SUCCESS;
+    }
+    aipu_status_t schedule()
+    {
+        return AIPU_STATUS_SUCCESS;
+    }
+    aipu_status_t destroy()
+    {
+        return AIPU_STATUS_SUCCESS;
+    }
+    aipu_status_t bind_core(uint32_t core_id)
+    {
+        return AIPU_STATUS_SUCCESS;
+    }
+
+public:
+    RodataJob(GraphBase& graph, DeviceBase* dev): JobBase(nullptr, graph, dev) {}
+};
+
+/**
+ * @brief JobBase::setup_rodata relocating a param map of N entries, half into
+ *        reuse and half into static sections
+ */
+class RodataBench: public BenchCase
+{
+private:
+    static const uint32_t SECTION_CNT = 16;
+    static const uint32_t SECTION_SIZE = 64 * 1024;
+
+private:
+    MockDevice &m_dev;
+    uint32_t m_entries;
+    std::unique_ptr<GraphBase> m_graph;
+    std::unique_ptr<RodataJob> m_job;
+    std::vector<BufferDesc> m_bufs;
+    std::vector<BufferDesc*> m_reuse;
+    std::vector<BufferDesc*> m_static;
+    std::vector<struct GraphParamMapLoadDesc> m_param_map;
+
+public:
+    aipu_status_t setup()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        UMemory *mem = static_cast<UMemory *>(m_dev.get_mem());
+
+#if (defined ZHOUYI_V3) || (defined ZHOUYI_V3_1)
+        m_graph.reset(new GraphV3X(nullptr, 0, &m_dev));
+#else
+        m_graph.reset(new GraphV12(nullptr, 0, &m_dev));
+#endif
+        m_job.reset(new RodataJob(*m_graph, &m_dev));
+
+        /* rodata, then the reuse and static sections */
+        m_bufs.resize(1 + 2 * SECTION_CNT);
+        ret = mem->malloc_internal(m_entries * 4, 1, &m_bufs[0], "rodata");
+        for (uint32_t i = 1; (i < m_bufs.size()) && (ret == AIPU_STATUS_SUCCESS); i++)
+        {
+            ret = mem->malloc_internal(SECTION_SIZE, 1, &m_bufs[i], "section");
+            if (i <= SECTION_CNT)
+                m_reuse.push_back(&m_bufs[i]);
+            else
+                m_static.push_back(&m_bufs[i]);
+        }
+        if (ret != AIPU_STATUS_SUCCESS)
+            return ret;
+
+        m_param_map.resize(m_entries);
+        for (uint32_t i = 0; i < m_entries; i++)
+            m_param_map[i].init(i * 4,
+                (i % 2) ? PARAM_MAP_LOAD_TYPE_STATIC : PARAM_MAP_LOAD_TYPE_REUSE,
+                0, (i / 2) % SECTION_CNT, 0, (i * 64) % SECTION_SIZE, 0xffffffff);
+
+        return ret;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        for (uint64_t i = 0; (i < iters) && (ret == AIPU_STATUS_SUCCESS); i++)
+            ret = m_job->setup_rodata(m_param_map, m_reuse, m_static, m_bufs[0], nullptr);
+
+        return ret;
+    }
+
+    void teardown()
+    {
+        for (auto &buf : m_bufs)
+        {
+            if (buf.size != 0)
+                m_dev.get_mem()->free_phybuffer(&buf, "bench");
+        }
+        m_bufs.clear();
+        m_reuse.clear();
+        m_static.clear();
+        m_param_map.clear();
+        m_job.reset();
+        m_graph.reset();
+    }
+
+public:
+    RodataBench(MockDevice &dev, uint32_t entries):
+        BenchCase("job.setup_rodata"), m_dev(dev), m_entries(entries)
+    {
+        m_params.push_back(std::make_pair("entries", entries));
+    }
+};
+
+/**
+ * @brief HandleTable::get, the lookup behind every graph and job ID, with N live handles
+ */
+class HandleBench: public BenchCase
+{
+private:
+    uint32_t m_cnt;
+    HandleTable<int> m_table;
+    int m_obj = 0;
+    std::vector<uint32_t> m_handles;
+
+public:
+    aipu_status_t setup()
+    {
+        std::vector<uint32_t> handles;
+
+        for (uint32_t i = 0; i < m_cnt; i++)
+        {
+            uint32_t handle = m_table.alloc(&m_obj);
+            if (handle == 0)
+                return AIPU_STATUS_ERROR_BUF_ALLOC_FAIL;
+            handles.push_back(handle);
+        }
+
+        for (auto idx : random_indexes(1024, m_cnt))
+            m_handles.push_back(handles[idx]);
+
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            if (m_table.get(m_handles[i & 1023]) == nullptr)
+                return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+        }
+
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    void teardown()
+    {
+        for (auto handle : m_handles)
+            m_table.release(handle);
+        m_handles.clear();
+    }
+
+public:
+    HandleBench(uint32_t cnt): BenchCase("ctx.handle_get"), m_cnt(cnt)
+    {
+        m_params.push_back(std::make_pair("handles", cnt));
+    }
+};
+
+/**
+ * @brief a context on the mock device with one graph loaded, shared by the job cases
+ */
+class GraphFixture
+{
+public:
+    MainContext m_ctx;
+    GRAPH_ID m_id = 0;
+    GraphBase *m_graph = nullptr;
+    aipu_create_job_cfg_t m_job_cfg = {0};
+    std::string m_bin;
+    std::vector<std::pair<std::string, uint64_t>> m_params;
+
+public:
+    aipu_status_t load(const char *file)
+    {
+        aipu_status_t ret = m_ctx.load_graph(file, &m_id);
+
+        if (ret == AIPU_STATUS_SUCCESS)
+            m_graph = m_ctx.get_graph_object(m_id);
+        return ret;
+    }
+
+    /**
+     * @brief generate the graph of 'scale' and load it, the binary is kept for reloading
+     */
+    aipu_status_t load(uint32_t scale)
+    {
+        graph_gen::Config cfg = graph_gen::scaled_config(scale);
+        aipu_status_t ret = graph_gen::generate(cfg, m_bin);
+
+        m_params.push_back(std::make_pair("scale", scale));
+        m_params.push_back(std::make_pair("params", graph_gen::param_entry_cnt(cfg)));
+        if (ret == AIPU_STATUS_SUCCESS)
+            ret = m_ctx.load_graph(m_bin.data(), m_bin.size(), &m_id);
+        if (ret == AIPU_STATUS_SUCCESS)
+            m_graph = m_ctx.get_graph_object(m_id);
+        return ret;
+    }
+
+public:
+    GraphFixture(MockDevice &dev)
+    {
+        m_ctx.set_dev(&dev);
+    }
+    ~GraphFixture()
+    {
+        m_ctx.deinit();
+    }
+};
+
+/**
+ * @brief MainContext::load_graph plus unload of a generated graph, with the load phases
+ */
+class LoadGraphBench: public BenchCase
+{
+private:
+    GraphFixture &m_fix;
+
+public:
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        GRAPH_ID id = 0;
+
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            ret = m_fix.m_ctx.load_graph(m_fix.m_bin.data(), m_fix.m_bin.size(), &id);
+            if (ret != AIPU_STATUS_SUCCESS)
+                break;
+
+            aipu_load_phase_stats_t *stats = m_fix.m_ctx.get_graph_object(id)->get_load_stats();
+            phases["parse"] += stats[AIPU_LOAD_PHASE_PARSE].wall_ns;
+            phases["alloc_weight"] += stats[AIPU_LOAD_PHASE_ALLOC_WEIGHT].wall_ns;
+
+            ret = m_fix.m_ctx.unload_graph(id);
+            if (ret != AIPU_STATUS_SUCCESS)
+                break;
+        }
+
+        return ret;
+    }
+
+public:
+    LoadGraphBench(GraphFixture &fix): BenchCase("graph.load_unload"), m_fix(fix)
+    {
+        m_params = fix.m_params;
+    }
+};
+
+/**
+ * @brief MainContext::create_job plus destroy, with the init phases from the job trace
+ */
+class CreateJobBench: public BenchCase
+{
+private:
+    GraphFixture &m_fix;
+    bool m_trace = false;
+
+public:
+    aipu_status_t setup()
+    {
+        m_trace = JobTrace::enabled();
+        JobTrace::enable(true);
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        JOB_ID id = 0;
+
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            ret = m_fix.m_ctx.create_job(m_fix.m_id, &id, &m_fix.m_job_cfg);
+            if (ret != AIPU_STATUS_SUCCESS)
+                break;
+
+            JobBase *job = m_fix.m_graph->get_job(id);
+            phases["init_alloc"] += job->get_init_phase_ns(JOB_TRACE_INIT_ALLOC);
+            phases["init_rodata"] += job->get_init_phase_ns(JOB_TRACE_INIT_RODATA);
+            phases["init_tcb"] += job->get_init_phase_ns(JOB_TRACE_INIT_TCB);
+
+            ret = m_fix.m_graph->destroy_job(id);
+            if (ret != AIPU_STATUS_SUCCESS)
+                break;
+        }
+
+        return ret;
+    }
+
+    void teardown()
+    {
+        JobTrace::enable(m_trace);
+    }
+
+public:
+    CreateJobBench(GraphFixture &fix): BenchCase("job.create_destroy"), m_fix(fix)
+    {
+        m_params = fix.m_params;
+    }
+};
+
+/**
+ * @brief MainContext::get_job_object with N jobs of the graph alive
+ */
+class JobLookupBench: public BenchCase
+{
+private:
+    GraphFixture &m_fix;
+    uint32_t m_cnt;
+    std::vector<JOB_ID> m_jobs;
+    std::vector<JOB_ID> m_ids;
+
+public:
+    aipu_status_t setup()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        JOB_ID id = 0;
+
+        for (uint32_t i = 0; i < m_cnt; i++)
+        {
+            ret = m_fix.m_ctx.create_job(m_fix.m_id, &id, &m_fix.m_job_cfg);
+            if (ret != AIPU_STATUS_SUCCESS)
+                return ret;
+            m_jobs.push_back(id);
+        }
+
+        for (auto idx : random_indexes(1024, m_cnt))
+            m_ids.push_back(m_jobs[idx]);
+
+        return ret;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            if (m_fix.m_ctx.get_job_object(m_ids[i & 1023]) == nullptr)
+                return AIPU_STATUS_ERROR_INVALID_JOB_ID;
+        }
+
+        return AIPU_STATUS_SUCCESS;
+    }
+
+    void teardown()
+    {
+        for (auto id : m_jobs)
+            m_fix.m_graph->destroy_job(id);
+        m_jobs.clear();
+        m_ids.clear();
+    }
+
+public:
+    JobLookupBench(GraphFixture &fix, uint32_t cnt):
+        BenchCase("ctx.get_job_object"), m_fix(fix), m_cnt(cnt)
+    {
+        m_params.push_back(std::make_pair("jobs", cnt));
+    }
+};
+
+/**
+ * @brief MainContext::run_batch over a queue of N batches, one op is one whole queue
+ */
+class RunBatchBench: public BenchCase
+{
+private:
+    GraphFixture &m_fix;
+    uint32_t m_batches;
+    uint32_t m_queue = 0;
+    std::vector<std::vector<char>> m_data;
+    std::vector<char *> m_inputs;
+    std::vector<char *> m_outputs;
+
+private:
+    aipu_status_t alloc_tensors(aipu_tensor_type_t type, std::vector<char *> &ptrs)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        aipu_tensor_desc_t desc;
+        uint32_t cnt = 0;
+
+        ret = m_fix.m_graph->get_tensor_count(type, &cnt);
+        for (uint32_t i = 0; (i < cnt) && (ret == AIPU_STATUS_SUCCESS); i++)
+        {
+            ret = m_fix.m_graph->get_tensor_descriptor(type, i, &desc);
+            m_data.push_back(std::vector<char>(desc.size));
+        }
+
+        return ret;
+    }
+
+public:
+    aipu_status_t setup()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        uint32_t in_cnt = 0;
+
+        ret = m_fix.m_graph->get_batch_queue_id(&m_queue);
+        if (ret == AIPU_STATUS_SUCCESS)
+            ret = alloc_tensors(AIPU_TENSOR_TYPE_INPUT, m_inputs);
+        in_cnt = m_data.size();
+        if (ret == AIPU_STATUS_SUCCESS)
+            ret = alloc_tensors(AIPU_TENSOR_TYPE_OUTPUT, m_outputs);
+
+        /* pointers are taken once m_data doesn't grow anymore */
+        for (uint32_t i = 0; i < m_data.size(); i++)
+            ((i < in_cnt) ? m_inputs : m_outputs).push_back(m_data[i].data());
+
+        return ret;
+    }
+
+    aipu_status_t run(uint64_t iters, BenchPhases &phases)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        for (uint64_t i = 0; (i < iters) && (ret == AIPU_STATUS_SUCCESS); i++)
+        {
+            for (uint32_t j = 0; (j < m_batches) && (ret == AIPU_STATUS_SUCCESS); j++)
+                ret = m_fix.m_graph->add_batch(m_queue, m_inputs.data(), m_inputs.size(),
+                    m_outputs.data(), m_outputs.size());
+
+            if (ret == AIPU_STATUS_SUCCESS)
+                ret = m_fix.m_ctx.run_batch(*m_fix.m_graph, m_queue, &m_fix.m_job_cfg);
+        }
+
+        return ret;
+    }
+
+    void teardown()
+    {
+        m_fix.m_graph->clean_batch_queue(m_queue);
+        m_data.clear();
+        m_inputs.clear();
+        m_outputs.clear();
+    }
+
+public:
+    RunBatchBench(GraphFixture &fix, uint32_t batches):
+        BenchCase("ctx.run_batch"), m_fix(fix), m_batches(batches)
+    {
+        m_params.push_back(std::make_pair("batches", batches));
+    }
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-r reps] [-t min_ms] [-f filter] [-g aipu.bin] [-s scales] "
+        "[-o out.json] [-l]\n"
+        "  -r  repetitions per case, default 10\n"
+        "  -t  minimum duration of one repetition in ms, default 20\n"
+        "  -f  only run the cases whose name contains 'filter'\n"
+        "  -g  graph binary for the job cases, a generated graph is used without it\n"
+        "  -s  comma separated scales of the generated graphs, default 1,10,100\n"
+        "  -o  write the JSON results to a file instead of stdout\n"
+        "  -l  list the cases\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t reps = 10;
+    uint32_t min_ms = 20;
+    const char *filter = nullptr;
+    const char *graph_file = nullptr;
+    const char *out_file = nullptr;
+    std::vector<uint32_t> scales = {1, 10, 100};
+    bool list = false;
+    int opt = 0;
+    MockDevice dev;
+    std::vector<std::unique_ptr<GraphFixture>> fixes;
+    GraphFixture *fix = nullptr;
+    aipu_status_t status = AIPU_STATUS_SUCCESS;
+    std::vector<std::unique_ptr<BenchCase>> cases;
+    std::vector<BenchResult> results;
+    std::vector<std::pair<std::string, std::string>> context;
+    FILE *fp = stdout;
+    int ret = 0;
+
+    while ((opt = getopt(argc, argv, "r:t:f:g:s:o:lh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r': reps = std::max(1, atoi(optarg)); break;
+            case 't': min_ms = std::max(1, atoi(optarg)); break;
+            case 'f': filter = optarg; break;
+            case 'g': graph_file = optarg; break;
+            case 's':
+                scales.clear();
+                for (char *tok = strtok(optarg, ","); tok != nullptr; tok = strtok(nullptr, ","))
+                    scales.push_back(std::max(1, atoi(tok)));
+                break;
+            case 'o': out_file = optarg; break;
+            case 'l': list = true; break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    for (uint32_t cnt : {16, 256, 4096})
+        cases.emplace_back(new PaToVaBench(dev, cnt));
+    for (uint32_t live : {0, 1024, 16384})
+        cases.emplace_back(new MallocBench(dev, live, false));
+    for (uint32_t live : {1024, 16384})
+        cases.emplace_back(new MallocBench(dev, live, true));
+    for (uint32_t entries : {100, 10000, 100000})
+        cases.emplace_back(new RodataBench(dev, entries));
+    for (uint32_t cnt : {16, 4096})
+        cases.emplace_back(new HandleBench(cnt));
+
+    for (uint32_t scale : scales)
+    {
+        fixes.emplace_back(new GraphFixture(dev));
+        status = fixes.back()->load(scale);
+        if (status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "load generated graph of scale %u [fail] status 0x%x\n", scale, status);
+            return 1;
+        }
+
+        cases.emplace_back(new LoadGraphBench(*fixes.back()));
+        cases.emplace_back(new CreateJobBench(*fixes.back()));
+    }
+
+    /* the job cases run on the given graph, or on the smallest generated one */
+    if (graph_file != nullptr)
+    {
+        fixes.emplace_back(new GraphFixture(dev));
+        status = fixes.back()->load(graph_file);
+        if (status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "load graph %s [fail] status 0x%x\n", graph_file, status);
+            return 1;
+        }
+
+        fix = fixes.back().get();
+        cases.emplace_back(new CreateJobBench(*fix));
+    } else if (!fixes.empty()) {
+        fix = fixes.front().get();
+    }
+
+    if (fix != nullptr)
+    {
+        for (uint32_t cnt : {16, 256})
+            cases.emplace_back(new JobLookupBench(*fix, cnt));
+        for (uint32_t batches : {1, 16})
+            cases.emplace_back(new RunBatchBench(*fix, batches));
+    }
+
+    if (list)
+    {
+        for (auto &bench : cases)
+        {
+            fprintf(stdout, "%s", bench->m_name.c_str());
+            for (auto &param : bench->m_params)
+                fprintf(stdout, " %s=%lu", param.first.c_str(), param.second);
+            fprintf(stdout, "\n");
+        }
+        return 0;
+    }
+
+    BenchRunner runner(reps, min_ms, 100000000);
+    for (auto &bench : cases)
+    {
+        if ((filter != nullptr) && (bench->m_name.find(filter) == std::string::npos))
+            continue;
+
+        fprintf(stderr, "%s", bench->m_name.c_str());
+        for (auto &param : bench->m_params)
+            fprintf(stderr, " %s=%lu", param.first.c_str(), param.second);
+        fprintf(stderr, " ...");
+        results.push_back(runner.run(*bench));
+        if (results.back().status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, " [fail] status 0x%x\n", results.back().status);
+            ret = 1;
+        } else {
+            fprintf(stderr, " %.1f ns/op\n", results.back().stats.median);
+        }
+    }
+
+    context.push_back(std::make_pair("umd_version", MACRO_UMD_VERSION));
+#if (defined SIMULATION)
+    context.push_back(std::make_pair("platform", "sim"));
+#else
+    context.push_back(std::make_pair("platform", "hw"));
+#endif
+    context.push_back(std::make_pair("device", "mock"));
+    context.push_back(std::make_pair("reps", std::to_string(reps)));
+    context.push_back(std::make_pair("min_ms", std::to_string(min_ms)));
+    context.push_back(std::make_pair("graph", (graph_file != nullptr) ? graph_file : ""));
+
+    if (out_file != nullptr)
+    {
+        fp = fopen(out_file, "w");
+        if (fp == nullptr)
+        {
+            fprintf(stderr, "open %s [fail]\n", out_file);
+            return 1;
+        }
+    }
+
+    write_json(fp, context, results);
+    if (fp != stdout)
+        fclose(fp);
+
+    return ret;
+}
@@ -0,0 +1,671 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  umd_loadgen.cpp
+ * @brief load generator: throughput and latency percentiles of a job mix
+ *
+ * @note  usage: umd_loadgen [-d mock|hw|sim] -g spec [-g spec ...] [-m closed|open]
+ *        [-n threads] [-j inflight] [-r rate] [-w warmup_ms] [-t duration_ms]
+ *        [-o out] [-f json|csv], see usage().
+ *        every thread owns 'inflight' jobs of each graph of the mix and keeps
+ *        at most 'inflight' of them scheduled; a request picks its graph by
+ *        weight. closed loop issues a request whenever one completes. open loop
+ *        issues them at Poisson arrival times, 'rate' requests/s over all the
+ *        threads, and measures latency from the arrival time, so the wait for a
+ *        free job is counted. jobs are waited on in the order they were
+ *        scheduled; only requests arriving in the measured window, after the
+ *        warm-up, are recorded.
+ */
+
+#include <getopt.h>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <thread>
+#include "bench.h"
+#include "histogram.h"
+#include "mock_device.h"
+#include "graph_gen/graph_gen.h"
+#include "context.h"
+#include "graph_base.h"
+#include "job_base.h"
+
+using namespace aipudrv;
+using namespace umd_bench;
+
+static uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void sleep_until(uint64_t ns)
+{
+    uint64_t cur = now();
+
+    if (ns > cur)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns - cur));
+}
+
+struct LoadConfig
+{
+    bool open_loop = false;
+    uint32_t threads = 1;
+    uint32_t inflight = 1;
+    double rate = 1000;       /**< open loop requests/s over all the threads */
+    uint32_t warmup_ms = 500;
+    uint32_t duration_ms = 5000;
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief one graph of the mix, from a spec 'file|gen:scale[,w=N][,qos=slow|high][,part=N]'
+ */
+struct MixEntry
+{
+    std::string name;
+    std::string bin;          /**< the generated graph, empty for a file */
+    uint32_t weight = 1;
+    uint32_t qos = AIPU_JOB_QOS_SLOW;
+    uint32_t partition = 0;
+    GRAPH_ID id = 0;
+
+    bool parse(const std::string &spec)
+    {
+        std::vector<std::string> fields;
+        size_t begin = 0, end = 0;
+
+        do {
+            end = spec.find(',', begin);
+            fields.push_back(spec.substr(begin, end - begin));
+            begin = end + 1;
+        } while (end != std::string::npos);
+
+        name = fields[0];
+        if (name.empty())
+            return false;
+
+        if (name.compare(0, 4, "gen:") == 0)
+        {
+            uint32_t scale = strtoul(name.c_str() + 4, nullptr, 0);
+
+            if ((scale == 0) || (graph_gen::generate(graph_gen::scaled_config(scale), bin) !=
+                AIPU_STATUS_SUCCESS))
+                return false;
+        }
+
+        for (uint32_t i = 1; i < fields.size(); i++)
+        {
+            const std::string &field = fields[i];
+
+            if (field.compare(0, 2, "w=") == 0)
+                weight = strtoul(field.c_str() + 2, nullptr, 0);
+            else if (field == "qos=slow")
+                qos = AIPU_JOB_QOS_SLOW;
+            else if (field == "qos=high")
+                qos = AIPU_JOB_QOS_HIGH;
+            else if (field.compare(0, 5, "part=") == 0)
+                partition = strtoul(field.c_str() + 5, nullptr, 0);
+            else
+                return false;
+        }
+
+        return weight != 0;
+    }
+};
+
+struct MixStats
+{
+    Histogram latency;        /**< arrival to completion seen, ns */
+    Histogram sched;          /**< JobBase::schedule call, ns */
+    uint64_t errors = 0;
+};
+
+/**
+ * @brief the requests of one thread
+ */
+class Worker
+{
+private:
+    struct Request
+    {
+        uint32_t entry;
+        JOB_ID id;
+        uint64_t arrival;
+    };
+
+    MainContext &m_ctx;
+    const LoadConfig &m_cfg;
+    const std::vector<MixEntry> &m_mix;
+    std::vector<std::vector<JOB_ID>> m_jobs;
+    std::vector<std::vector<JOB_ID>> m_free;
+    std::deque<Request> m_inflight;
+    std::mt19937_64 m_rng;
+    std::discrete_distribution<uint32_t> m_pick;
+    uint64_t m_begin = 0;
+    uint64_t m_end = 0;
+
+public:
+    std::vector<MixStats> m_stats;
+    uint64_t m_last_done = 0;     /**< completion of the last recorded request */
+    aipu_status_t m_status = AIPU_STATUS_SUCCESS;
+
+private:
+    bool measured(uint64_t arrival)
+    {
+        return (arrival >= m_begin) && (arrival < m_end);
+    }
+
+    aipu_status_t submit(uint64_t arrival)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        uint32_t entry = m_pick(m_rng);
+        JOB_ID id = m_free[entry].back();
+        JobBase *job = m_ctx.get_job_object(id);
+        uint64_t begin = now();
+
+        ret = (job != nullptr) ? job->schedule() : AIPU_STATUS_ERROR_INVALID_JOB_ID;
+        if (measured(arrival))
+        {
+            m_stats[entry].sched.record(now() - begin);
+            if (ret != AIPU_STATUS_SUCCESS)
+                m_stats[entry].errors++;
+        }
+
+        if (ret == AIPU_STATUS_SUCCESS)
+        {
+            m_free[entry].pop_back();
+            m_inflight.push_back({entry, id, arrival});
+        }
+        return ret;
+    }
+
+    /**
+     * @brief wait for the oldest scheduled job, AIPU_STATUS_ERROR_TIMEOUT leaves it scheduled
+     */
+    aipu_status_t retire(int32_t time_out)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        aipu_job_status_t status = AIPU_JOB_STATUS_NO_STATUS;
+        Request req = m_inflight.front();
+        JobBase *job = m_ctx.get_job_object(req.id);
+
+        ret = (job != nullptr) ? job->get_status_blocking(&status, time_out) :
+            AIPU_STATUS_ERROR_INVALID_JOB_ID;
+        if (ret == AIPU_STATUS_ERROR_TIMEOUT)
+            return ret;
+
+        if ((ret == AIPU_STATUS_SUCCESS) && (status != AIPU_JOB_STATUS_DONE))
+            ret = AIPU_STATUS_ERROR_JOB_EXCEPTION;
+
+        if (measured(req.arrival))
+        {
+            m_last_done = now();
+            if (ret == AIPU_STATUS_SUCCESS)
+                m_stats[req.entry].latency.record(m_last_done - req.arrival);
+            else
+                m_stats[req.entry].errors++;
+        }
+
+        m_inflight.pop_front();
+        m_free[req.entry].push_back(req.id);
+        return ret;
+    }
+
+    aipu_status_t run_closed()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        while ((ret == AIPU_STATUS_SUCCESS) && (now() < m_end))
+        {
+            while ((ret == AIPU_STATUS_SUCCESS) && (m_inflight.size() < m_cfg.inflight))
+                ret = submit(now());
+
+            if (ret == AIPU_STATUS_SUCCESS)
+                ret = retire(-1);
+        }
+
+        return ret;
+    }
+
+    aipu_status_t run_open(uint64_t start)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        std::exponential_distribution<double> gap(m_cfg.rate / m_cfg.threads / 1e9);
+        uint64_t next = start + (uint64_t)gap(m_rng);
+        uint64_t cur = 0;
+
+        while ((ret == AIPU_STATUS_SUCCESS) && (next < m_end))
+        {
+            cur = now();
+            if ((m_inflight.size() < m_cfg.inflight) && (cur >= next))
+            {
+                ret = submit(next);
+                next += (uint64_t)gap(m_rng);
+            } else if (m_inflight.size() >= m_cfg.inflight) {
+                ret = retire(-1);
+            } else if (m_inflight.empty()) {
+                sleep_until(next);
+            } else {
+                /**
+                 * reap while waiting for the next arrival; the wait is in ms, below
+                 * that the oldest job is polled every 100us so its completion isn't
+                 * seen late
+                 */
+                ret = retire((next - cur) / 1000000);
+                if (ret == AIPU_STATUS_ERROR_TIMEOUT)
+                {
+                    ret = AIPU_STATUS_SUCCESS;
+                    if (next - cur < 1000000)
+                        sleep_until(std::min(next, cur + 100000));
+                }
+            }
+        }
+
+        return ret;
+    }
+
+public:
+    /**
+     * @brief create the jobs of every graph of the mix, not timed
+     */
+    aipu_status_t create_jobs()
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+        std::vector<double> weights;
+        JOB_ID id = 0;
+
+        for (uint32_t i = 0; i < m_mix.size(); i++)
+        {
+            aipu_create_job_cfg_t cfg = {0};
+
+            cfg.partition_id = m_mix[i].partition;
+            cfg.qos_level = m_mix[i].qos;
+            for (uint32_t j = 0; j < m_cfg.inflight; j++)
+            {
+                ret = m_ctx.create_job(m_mix[i].id, &id, &cfg);
+                if (ret != AIPU_STATUS_SUCCESS)
+                    return ret;
+                m_jobs[i].push_back(id);
+            }
+
+            m_free[i] = m_jobs[i];
+            weights.push_back(m_mix[i].weight);
+        }
+
+        m_pick = std::discrete_distribution<uint32_t>(weights.begin(), weights.end());
+        return ret;
+    }
+
+    void destroy_jobs()
+    {
+        for (uint32_t i = 0; i < m_mix.size(); i++)
+        {
+            for (auto id : m_jobs[i])
+                m_ctx.get_graph_object(m_mix[i].id)->destroy_job(id);
+            m_jobs[i].clear();
+        }
+    }
+
+    /**
+     * @brief the thread body, requests arrive from 'start' and are recorded from 'begin' to 'end'
+     */
+    void run(uint64_t start, uint64_t begin, uint64_t end)
+    {
+        aipu_status_t ret = AIPU_STATUS_SUCCESS;
+
+        m_begin = begin;
+        m_end = end;
+        sleep_until(start);
+        m_status = m_cfg.open_loop ? run_open(start) : run_closed();
+
+        /* drain, the jobs are in the measured window */
+        while (!m_inflight.empty())
+        {
+            ret = retire(-1);
+            if (m_status == AIPU_STATUS_SUCCESS)
+                m_status = ret;
+        }
+    }
+
+public:
+    Worker(MainContext &ctx, const LoadConfig &cfg, const std::vector<MixEntry> &mix, uint32_t idx):
+        m_ctx(ctx), m_cfg(cfg), m_mix(mix), m_jobs(mix.size()), m_free(mix.size()),
+        m_rng(cfg.seed + idx), m_stats(mix.size()) {}
+};
+
+static void write_hist_json(FILE *fp, const Histogram &hist)
+{
+    fprintf(fp, "{\"min\": %lu, \"mean\": %.1f, \"p50\": %lu, \"p90\": %lu, \"p99\": %lu, "
+        "\"p999\": %lu, \"max\": %lu}", hist.min(), hist.mean(), hist.percentile(50),
+        hist.percentile(90), hist.percentile(99), hist.percentile(99.9), hist.max());
+}
+
+/**
+ * @brief write the results as one JSON document
+ *
+ * @note  {"context": {...}, "results": [{"name", "weight", "qos", "partition", "jobs",
+ *        "errors", "throughput", "unit": "ns", "latency", "schedule", "histogram"}]},
+ *        the last result being the "total" of the mix. throughput is the completed
+ *        jobs/s from the end of the warm-up to the last recorded completion, which
+ *        is past the measured window when the device is saturated. histogram holds
+ *        the latency buckets as [highest value, count] pairs.
+ */
+static void write_json(FILE *fp, const std::vector<std::pair<std::string, std::string>> &context,
+    const std::vector<MixEntry> &mix, const std::vector<MixStats> &stats, double seconds)
+{
+    fprintf(fp, "{\n  \"context\": {");
+    for (uint32_t i = 0; i < context.size(); i++)
+        fprintf(fp, "%s%s: %s", (i == 0) ? "" : ", ", json_string(context[i].first).c_str(),
+            json_string(context[i].second).c_str());
+    fprintf(fp, "},\n  \"results\": [");
+
+    for (uint32_t i = 0; i < stats.size(); i++)
+    {
+        const MixStats &stat = stats[i];
+        bool total = (i == mix.size());
+        auto buckets = stat.latency.buckets();
+
+        fprintf(fp, "%s\n    {\"name\": %s", (i == 0) ? "" : ",",
+            json_string(total ? "total" : mix[i].name).c_str());
+        if (!total)
+            fprintf(fp, ", \"weight\": %u, \"qos\": %u, \"partition\": %u",
+                mix[i].weight, mix[i].qos, mix[i].partition);
+        fprintf(fp, ", \"jobs\": %lu, \"errors\": %lu, \"throughput\": %.1f, \"unit\": \"ns\", "
+            "\"latency\": ", stat.latency.count(), stat.errors, stat.latency.count() / seconds);
+        write_hist_json(fp, stat.latency);
+        fprintf(fp, ", \"schedule\": ");
+        write_hist_json(fp, stat.sched);
+        fprintf(fp, ", \"histogram\": [");
+        for (uint32_t j = 0; j < buckets.size(); j++)
+            fprintf(fp, "%s[%lu, %lu]", (j == 0) ? "" : ", ", buckets[j].first, buckets[j].second);
+        fprintf(fp, "]}");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+/**
+ * @brief write one CSV row per graph of the mix plus the total, latencies in ns
+ */
+static void write_csv(FILE *fp, const std::vector<MixEntry> &mix,
+    const std::vector<MixStats> &stats, double seconds)
+{
+    fprintf(fp, "name,weight,qos,partition,jobs,errors,throughput,lat_min,lat_mean,lat_p50,"
+        "lat_p90,lat_p99,lat_p999,lat_max,sched_p50,sched_p99\n");
+    for (uint32_t i = 0; i < stats.size(); i++)
+    {
+        const MixStats &stat = stats[i];
+        bool total = (i == mix.size());
+
+        if (total)
+            fprintf(fp, "total,,,,");
+        else
+            fprintf(fp, "%s,%u,%u,%u,", mix[i].name.c_str(), mix[i].weight, mix[i].qos,
+                mix[i].partition);
+        fprintf(fp, "%lu,%lu,%.1f,%lu,%.1f,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", stat.latency.count(),
+            stat.errors, stat.latency.count() / seconds, stat.latency.min(), stat.latency.mean(),
+            stat.latency.percentile(50), stat.latency.percentile(90), stat.latency.percentile(99),
+            stat.latency.percentile(99.9), stat.latency.max(), stat.sched.percentile(50),
+            stat.sched.percentile(99));
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-d mock|hw|sim] -g spec [-g spec ...] [options]\n"
+        "  -d  device, mock (default) or the one of this build, hw or sim\n"
+        "  -g  a graph of the mix: file|gen:scale[,w=weight][,qos=slow|high][,part=id]\n"
+        "      gen:scale is a generated graph, see graph_gen::scaled_config(), mock only\n"
+        "  -m  closed (default) or open loop\n"
+        "  -n  threads, default 1\n"
+        "  -j  jobs in flight per thread, default 1\n"
+        "  -r  open loop arrival rate over all the threads in requests/s, default 1000\n"
+        "  -w  warm-up in ms, default 500\n"
+        "  -t  measured duration in ms, default 5000\n"
+        "  -S  random seed, default 1\n"
+        "  -o  write the results to a file instead of stdout\n"
+        "  -f  json (default) or csv\n"
+        "  --cores N        mock cores per partition, default 1\n"
+        "  --partitions N   mock partitions, default 1\n"
+        "  --exec-us N      mock execution time of a job, default 0\n"
+        "  --sim-arch DESC  simulator npu_arch_desc\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    enum { OPT_CORES = 0x100, OPT_PARTITIONS, OPT_EXEC_US, OPT_SIM_ARCH };
+    const struct option opts[] = {
+        {"cores",      required_argument, nullptr, OPT_CORES},
+        {"partitions", required_argument, nullptr, OPT_PARTITIONS},
+        {"exec-us",    required_argument, nullptr, OPT_EXEC_US},
+        {"sim-arch",   required_argument, nullptr, OPT_SIM_ARCH},
+        {"help",       no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+#if (defined SIMULATION)
+    const std::string target = "sim";
+#else
+    const std::string target = "hw";
+#endif
+    std::string device = "mock";
+    LoadConfig cfg;
+    std::vector<MixEntry> mix;
+    uint32_t core_cnt = 1, part_cnt = 1, exec_us = 0;
+    const char *sim_arch = nullptr;
+    const char *out_file = nullptr;
+    bool csv = false;
+    std::unique_ptr<MockDevice> mock;
+    MainContext ctx;
+    aipu_status_t status = AIPU_STATUS_SUCCESS;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::vector<MixStats> stats;
+    std::vector<std::pair<std::string, std::string>> context;
+    uint32_t loaded = 0;
+    uint64_t start = 0, begin = 0, end = 0, last_done = 0;
+    double seconds = 0;
+    FILE *fp = stdout;
+    int opt = 0;
+    int ret = 0;
+
+    while ((opt = getopt_long(argc, argv, "d:g:m:n:j:r:w:t:S:o:f:h", opts, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': device = optarg; break;
+            case 'g':
+                mix.push_back(MixEntry());
+                if (!mix.back().parse(optarg))
+                {
+                    fprintf(stderr, "invalid graph spec %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'm': cfg.open_loop = (strcmp(optarg, "open") == 0); break;
+            case 'n': cfg.threads = std::max(1, atoi(optarg)); break;
+            case 'j': cfg.inflight = std::max(1, atoi(optarg)); break;
+            case 'r': cfg.rate = std::max(1.0, atof(optarg)); break;
+            case 'w': cfg.warmup_ms = std::max(0, atoi(optarg)); break;
+            case 't': cfg.duration_ms = std::max(1, atoi(optarg)); break;
+            case 'S': cfg.seed = strtoull(optarg, nullptr, 0); break;
+            case 'o': out_file = optarg; break;
+            case 'f': csv = (strcmp(optarg, "csv") == 0); break;
+            case OPT_CORES: core_cnt = std::max(1, atoi(optarg)); break;
+            case OPT_PARTITIONS: part_cnt = std::min(4, std::max(1, atoi(optarg))); break;
+            case OPT_EXEC_US: exec_us = std::max(0, atoi(optarg)); break;
+            case OPT_SIM_ARCH: sim_arch = optarg; break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (mix.empty() || ((device != "mock") && (device != target)))
+    {
+        if (!mix.empty())
+            fprintf(stderr, "this build drives a %s device, not %s\n", target.c_str(),
+                device.c_str());
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (device == "mock")
+    {
+        mock.reset(new MockDevice(core_cnt, part_cnt));
+        mock->set_exec_ns((uint64_t)exec_us * 1000);
+        ctx.set_dev(mock.get());
+    } else {
+        status = ctx.init();
+#if (defined SIMULATION)
+        aipu_global_config_simulation_t sim_cfg;
+
+        memset(&sim_cfg, 0, sizeof(sim_cfg));
+        sim_cfg.npu_arch_desc = sim_arch;
+        sim_cfg.enable_calloc = true;
+        if (status == AIPU_STATUS_SUCCESS)
+            status = ctx.config_simulation(AIPU_CONFIG_TYPE_SIMULATION, &sim_cfg);
+#endif
+        if (status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "init %s context [fail] status 0x%x\n", device.c_str(), status);
+            return 1;
+        }
+    }
+
+    for (; (loaded < mix.size()) && (status == AIPU_STATUS_SUCCESS); loaded++)
+    {
+        MixEntry &entry = mix[loaded];
+
+        if (!entry.bin.empty() && (device != "mock"))
+        {
+            fprintf(stderr, "generated graph %s only runs on the mock device\n",
+                entry.name.c_str());
+            status = AIPU_STATUS_ERROR_INVALID_CONFIG;
+        } else if (!entry.bin.empty()) {
+            status = ctx.load_graph(entry.bin.data(), entry.bin.size(), &entry.id);
+        } else {
+            status = ctx.load_graph(entry.name.c_str(), &entry.id);
+        }
+
+        if (status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "load graph %s [fail] status 0x%x\n", entry.name.c_str(), status);
+            break;
+        }
+
+        ctx.get_partition_count(&part_cnt);
+        if (entry.partition >= part_cnt)
+        {
+            fprintf(stderr, "graph %s: partition %u of %u [fail]\n", entry.name.c_str(),
+                entry.partition, part_cnt);
+            status = AIPU_STATUS_ERROR_INVALID_PARTITION_ID;
+        }
+    }
+
+    for (uint32_t i = 0; (i < cfg.threads) && (status == AIPU_STATUS_SUCCESS); i++)
+    {
+        workers.emplace_back(new Worker(ctx, cfg, mix, i));
+        status = workers.back()->create_jobs();
+        if (status != AIPU_STATUS_SUCCESS)
+            fprintf(stderr, "create jobs of thread %u [fail] status 0x%x\n", i, status);
+    }
+
+    if (status == AIPU_STATUS_SUCCESS)
+    {
+        /* all threads arrive from the same start, after they are spawned */
+        start = now() + 10000000;
+        begin = start + (uint64_t)cfg.warmup_ms * 1000000;
+        end = begin + (uint64_t)cfg.duration_ms * 1000000;
+        for (auto &worker : workers)
+            threads.emplace_back(&Worker::run, worker.get(), start, begin, end);
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    stats.resize(mix.size() + 1);
+    for (auto &worker : workers)
+    {
+        for (uint32_t i = 0; i < mix.size(); i++)
+        {
+            for (MixStats *stat : {&stats[i], &stats[mix.size()]})
+            {
+                stat->latency.merge(worker->m_stats[i].latency);
+                stat->sched.merge(worker->m_stats[i].sched);
+                stat->errors += worker->m_stats[i].errors;
+            }
+        }
+
+        if (worker->m_status != AIPU_STATUS_SUCCESS)
+        {
+            fprintf(stderr, "thread status 0x%x\n", worker->m_status);
+            ret = 1;
+        }
+        last_done = std::max(last_done, worker->m_last_done);
+        worker->destroy_jobs();
+    }
+
+    for (uint32_t i = 0; i < loaded; i++)
+        ctx.unload_graph(mix[i].id);
+    ctx.deinit();
+
+    if (status != AIPU_STATUS_SUCCESS)
+        return 1;
+
+    /* past the window when the requests queued up, the whole window when none completed */
+    seconds = (std::max(last_done, end) - begin) / 1e9;
+
+    for (uint32_t i = 0; i < stats.size(); i++)
+    {
+        fprintf(stderr, "%-24s %10.1f jobs/s  p50 %8.1f us  p99 %8.1f us  p999 %8.1f us  "
+            "errors %lu\n", (i == mix.size()) ? "total" : mix[i].name.c_str(),
+            stats[i].latency.count() / seconds,
+            stats[i].latency.percentile(50) / 1e3, stats[i].latency.percentile(99) / 1e3,
+            stats[i].latency.percentile(99.9) / 1e3, stats[i].errors);
+        if (stats[i].errors != 0)
+            ret = 1;
+    }
+
+    context.push_back(std::make_pair("umd_version", MACRO_UMD_VERSION));
+    context.push_back(std::make_pair("platform", target));
+    context.push_back(std::make_pair("device", device));
+    context.push_back(std::make_pair("mode", cfg.open_loop ? "open" : "closed"));
+    context.push_back(std::make_pair("threads", std::to_string(cfg.threads)));
+    context.push_back(std::make_pair("inflight", std::to_string(cfg.inflight)));
+    if (cfg.open_loop)
+        context.push_back(std::make_pair("rate", std::to_string(cfg.rate)));
+    context.push_back(std::make_pair("warmup_ms", std::to_string(cfg.warmup_ms)));
+    context.push_back(std::make_pair("duration_ms", std::to_string(cfg.duration_ms)));
+    context.push_back(std::make_pair("seed", std::to_string(cfg.seed)));
+    if (sim_arch != nullptr)
+        context.push_back(std::make_pair("sim_arch", sim_arch));
+    if (device == "mock")
+    {
+        context.push_back(std::make_pair("mock_cores", std::to_string(core_cnt)));
+        context.push_back(std::make_pair("mock_partitions", std::to_string(part_cnt)));
+        context.push_back(std::make_pair("mock_exec_us", std::to_string(exec_us)));
+    }
+
+    if (out_file != nullptr)
+    {
+        fp = fopen(out_file, "w");
+        if (fp == nullptr)
+        {
+            fprintf(stderr, "open %s [fail]\n", out_file);
+            return 1;
+        }
+    }
+
+    if (csv)
+        write_csv(fp, mix, stats, seconds);
+    else
+        write_json(fp, context, mix, stats, seconds);
+    if (fp != stdout)
+        fclose(fp);
+
+    return ret;
+}
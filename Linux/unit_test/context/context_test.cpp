@@ -3,9 +3,20 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include "context_test.h"
 #include "standard_api.h"
 #include "aipu.h"
+#include "utils/log.h"
+#if (defined ZHOUYI_V3)
+#include "graph.h"
+#include "graph_gen/graph_gen.h"
+#include "bench/mock_device.h"
+#endif
 
 TEST_CASE_FIXTURE(ContextTest, "init")
 {
@@ -87,6 +98,410 @@ TEST_CASE_FIXTURE(ContextTest, "unload_graph")
     CHECK(ret == AIPU_STATUS_SUCCESS);
 }
 
+TEST_CASE_FIXTURE(ContextTest, "unload_graph_deferred")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    aipu_global_config_teardown_t teardown_config = {0};
+    aipu_create_job_cfg create_job_cfg = {0};
+    JOB_ID job_id = 0;
+    aipudrv::GraphBase *graph = nullptr;
+    aipu_status_t ret;
+    uint64_t graph_id;
+
+    p_ctx->init();
+
+    teardown_config.deferred = true;
+    ret = p_ctx->config_teardown(&teardown_config);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    ret = p_ctx->create_job(graph_id, &job_id, &create_job_cfg);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    graph = p_ctx->get_graph_object(graph_id);
+    REQUIRE(graph != nullptr);
+
+    /* handles are invalid at once, the buffers are freed in background */
+    ret = graph->destroy_job(job_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(p_ctx->get_job_object(job_id) == nullptr);
+
+    ret = p_ctx->unload_graph(graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(p_ctx->get_graph_object(graph_id) == nullptr);
+
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    ret = p_ctx->unload_graph(graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+}
+
+TEST_CASE_FIXTURE(ContextTest, "stale_graph_id")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    aipu_create_job_cfg create_job_cfg = {0};
+    JOB_ID job_id[2] = {0};
+    aipudrv::GraphBase *graph = nullptr;
+    aipu_status_t ret;
+    uint64_t graph_id[2];
+
+    p_ctx->init();
+
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id[0]);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    ret = p_ctx->create_job(graph_id[0], &job_id[0], &create_job_cfg);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    graph = p_ctx->get_graph_object(graph_id[0]);
+    REQUIRE(graph != nullptr);
+    ret = graph->destroy_job(job_id[0]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    /* the reused job slot gets a new generation */
+    ret = p_ctx->create_job(graph_id[0], &job_id[1], &create_job_cfg);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(job_id[0] != job_id[1]);
+    CHECK(p_ctx->get_job_object(job_id[0]) == nullptr);
+    CHECK(p_ctx->get_job_object(job_id[1]) != nullptr);
+
+    ret = p_ctx->unload_graph(graph_id[0]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    /* the reused graph slot gets a new generation */
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id[1]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(graph_id[0] != graph_id[1]);
+    CHECK(p_ctx->get_graph_object(graph_id[0]) == nullptr);
+    CHECK(p_ctx->get_job_object(job_id[1]) == nullptr);
+
+    ret = p_ctx->unload_graph(graph_id[1]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+}
+
+TEST_CASE_FIXTURE(ContextTest, "create_job_stress")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> fail{0};
+    aipudrv::GraphBase *graph = nullptr;
+    aipu_status_t ret;
+    uint64_t graph_id = 0;
+
+    p_ctx->init();
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    graph = p_ctx->get_graph_object(graph_id);
+    REQUIRE(graph != nullptr);
+
+    /* create/clean jobs from several threads while looking up stale IDs */
+    for (uint32_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, graph] {
+            aipu_create_job_cfg create_job_cfg = {0};
+            JOB_ID stale = 0;
+
+            for (uint32_t i = 0; i < 200; i++)
+            {
+                JOB_ID job_id = 0;
+
+                if ((p_ctx->create_job(graph_id, &job_id, &create_job_cfg) != AIPU_STATUS_SUCCESS)
+                    || (p_ctx->get_job_object(job_id) == nullptr)
+                    || ((stale != 0) && (p_ctx->get_job_object(stale) != nullptr))
+                    || (graph->destroy_job(job_id) != AIPU_STATUS_SUCCESS))
+                    fail++;
+
+                stale = job_id;
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+    CHECK(fail == 0);
+    CHECK(graph->get_jobs().empty());
+
+    ret = p_ctx->unload_graph(graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+}
+
+TEST_CASE("handle_table_full")
+{
+    HandleTable<int> table;
+    std::vector<uint32_t> handles;
+    uint32_t max_cnt = HandleTable<int>::MAX_CNT;
+    int obj = 0;
+    uint32_t handle = 0;
+
+    for (uint32_t i = 0; i < max_cnt; i++)
+    {
+        handle = table.alloc(&obj);
+        if (handle == 0)
+            break;
+        handles.push_back(handle);
+    }
+    REQUIRE(handles.size() == max_cnt);
+
+    /* a full table fails instead of handing out a live handle */
+    CHECK(table.alloc(&obj) == 0);
+    CHECK(table.size() == max_cnt);
+
+    /* a released slot is usable again, under a new handle */
+    CHECK(table.release(handles[0]) == &obj);
+    handle = table.alloc(&obj);
+    CHECK(handle != 0);
+    CHECK(handle != handles[0]);
+    CHECK(table.get(handles[0]) == nullptr);
+    CHECK(table.get(handle) == &obj);
+    CHECK(table.alloc(&obj) == 0);
+}
+
+TEST_CASE("handle_table_generation_wrap")
+{
+    HandleTable<int> table;
+    int obj = 0;
+    uint32_t first = 0, stale = 0, handle = 0;
+    uint32_t fail = 0;
+
+    /* a single slot is reused on every alloc, its generation wraps after 65536 releases */
+    first = table.alloc(&obj);
+    REQUIRE(first != 0);
+    stale = first;
+    table.release(first);
+    for (uint32_t i = 1; i < (1U << (32 - HandleTable<int>::SLOT_BITS)); i++)
+    {
+        handle = table.alloc(&obj);
+        if ((handle == 0) || (handle == stale) || (handle == first)
+            || ((handle & HandleTable<int>::SLOT_MASK) != (first & HandleTable<int>::SLOT_MASK))
+            || (table.get(stale) != nullptr) || (table.get(handle) != &obj))
+            fail++;
+        stale = handle;
+        table.release(handle);
+    }
+    CHECK(fail == 0);
+
+    /* wrapped: the first handle of the slot comes back, still a valid one */
+    handle = table.alloc(&obj);
+    CHECK(handle == first);
+    CHECK(table.get(stale) == nullptr);
+    CHECK(table.get(handle) == &obj);
+}
+
+static void load_progress(uint64_t graph_id, uint64_t bytes_done, uint64_t bytes_total, void *arg)
+{
+    *(uint64_t *)arg = bytes_done;
+}
+
+TEST_CASE_FIXTURE(ContextTest, "load_graph_async")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    aipu_status_t ret;
+    uint64_t graph_id[2];
+    uint64_t bytes_done = 0;
+
+    p_ctx->init();
+
+    ret = p_ctx->load_graph_async(nullptr, &graph_id[0], nullptr, nullptr, nullptr);
+    CHECK(ret == AIPU_STATUS_ERROR_NULL_PTR);
+
+    ret = p_ctx->wait_graph_loaded(0, -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_GRAPH_ID);
+
+    ret = p_ctx->load_graph_async(graph_file.c_str(), &graph_id[0], nullptr,
+        load_progress, &bytes_done);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    ret = p_ctx->load_graph_async(graph_file.c_str(), &graph_id[1], nullptr, nullptr, nullptr);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(graph_id[0] != graph_id[1]);
+
+    ret = p_ctx->wait_graph_loaded(graph_id[0], -1);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(bytes_done > 0);
+    CHECK(p_ctx->get_graph_object(graph_id[0]) != nullptr);
+
+    /* finished or canceled, the graph ID is reaped by unload either way */
+    p_ctx->cancel_load_graph(graph_id[1]);
+    ret = p_ctx->unload_graph(graph_id[1]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(p_ctx->get_graph_object(graph_id[1]) == nullptr);
+
+    ret = p_ctx->unload_graph(graph_id[0]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+}
+
+TEST_CASE_FIXTURE(ContextTest, "load_graph_wt_on_demand")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    aipu_global_config_wt_residency_t wt_residency = {0};
+    aipu_load_graph_cfg_t load_cfg = {0};
+    aipu_create_job_cfg create_job_cfg = {0};
+    JOB_ID job_id = 0;
+    aipu_status_t ret;
+    uint64_t graph_id;
+
+    p_ctx->init();
+
+    /* tiny budget: every schedule has to evict the other idle BSS weight */
+    wt_residency.budget = 1;
+    ret = p_ctx->config_wt_residency(&wt_residency);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    load_cfg.wt_on_demand = 1;
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id, &load_cfg);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    ret = p_ctx->create_job(graph_id, &job_id, &create_job_cfg);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    ret = p_ctx->unload_graph(graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+}
+
+#if (defined ZHOUYI_V3)
+/**
+ * @brief whether the weight of BSS 'bss_id' of graph 'id' is resident and holds
+ *        what graph_gen put in its static sections
+ */
+static bool wt_resident(MainContext &ctx, umd_bench::MockDevice &dev, GRAPH_ID id, uint32_t bss_id)
+{
+    Graph *graph = static_cast<Graph *>(ctx.get_graph_object(id));
+    BufferDesc *weight = graph->get_WeightBufferInfo(bss_id).wb_weight;
+    std::vector<struct GraphSectionDesc> &sections = graph->get_static_section_ref(bss_id);
+
+    if (weight == nullptr)
+        return false;
+
+    for (uint32_t i = 0; i < sections.size(); i++)
+    {
+        std::vector<char> data(sections[i].size);
+
+        dev.get_mem()->read(weight->pa + sections[i].relative_addr, data.data(), data.size());
+        if (std::count(data.begin(), data.end(), (char)(i + 1)) != (int64_t)data.size())
+            return false;
+    }
+
+    return true;
+}
+
+TEST_CASE("run_wt_on_demand")
+{
+    umd_bench::MockDevice dev;
+    MainContext ctx;
+    graph_gen::Config cfg;
+    std::string bin[2];
+    aipu_global_config_hw_t hw_config = {0};
+    aipu_global_config_wt_residency_t wt_residency = {0};
+    aipu_load_graph_cfg_t load_cfg = {0};
+    aipu_create_job_cfg_t create_job_cfg = {0};
+    GRAPH_ID graph_id[2] = {0};
+    uint32_t bss_cnt[2] = {1, 2};
+    JOB_ID job_id[2] = {0};
+    JobBase *job[2] = {nullptr};
+    uint32_t size = 0;
+    uint64_t sched_cnt = 0;
+
+    /**
+     * graph 0 has a single BSS, graph 1 runs as 2 grids, one per BSS. the budget
+     * fits no BSS, so only the BSS of the last grid run stays resident, every
+     * other one is evicted once idle.
+     */
+    cfg.static_cnt = 2;
+    size = cfg.reuse_size;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        cfg.subgraph_cnt = bss_cnt[i];
+        cfg.bss_cnt = bss_cnt[i];
+        REQUIRE(graph_gen::generate(cfg, bin[i]) == AIPU_STATUS_SUCCESS);
+    }
+
+    ctx.set_dev(&dev);
+    wt_residency.budget = 1;
+    REQUIRE(ctx.config_wt_residency(&wt_residency) == AIPU_STATUS_SUCCESS);
+
+    /* HW config leaves the budget as it is */
+    hw_config.poll_in_commit_thread = true;
+    REQUIRE(ctx.config_hw(AIPU_CONFIG_TYPE_HW, &hw_config) == AIPU_STATUS_SUCCESS);
+    load_cfg.wt_on_demand = 1;
+    for (uint32_t i = 0; i < 2; i++)
+        REQUIRE(ctx.load_graph(bin[i].data(), bin[i].size(), &graph_id[i], &load_cfg) ==
+            AIPU_STATUS_SUCCESS);
+
+    std::vector<char> in_data(size), out_data(size), fetched(size);
+    const void *inputs[1] = {in_data.data()};
+    void *outputs[1] = {out_data.data()};
+
+    /* graph 0, graph 1 evicting graph 0, then graph 0 uploading its BSS again */
+    for (uint32_t run = 0; run < 3; run++)
+    {
+        uint32_t cur = run % 2;
+
+        /* create_job prefetches, do it right before the first run to keep the order above */
+        if (job[cur] == nullptr)
+        {
+            REQUIRE(ctx.create_job(graph_id[cur], &job_id[cur], &create_job_cfg) == AIPU_STATUS_SUCCESS);
+            job[cur] = ctx.get_job_object(job_id[cur]);
+            REQUIRE(job[cur] != nullptr);
+        }
+        for (uint32_t i = 0; i < size; i++)
+            in_data[i] = (char)(i * 5 + run);
+        std::fill(out_data.begin(), out_data.end(), 0x5a);
+        sched_cnt = dev.get_sched_cnt();
+
+        REQUIRE(job[cur]->run(inputs, outputs, -1) == AIPU_STATUS_SUCCESS);
+        CHECK(dev.get_sched_cnt() - sched_cnt == bss_cnt[cur]);
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            for (uint32_t bss_id = 0; bss_id < bss_cnt[i]; bss_id++)
+                CHECK(wt_resident(ctx, dev, graph_id[i], bss_id) ==
+                    ((i == cur) && (bss_id == bss_cnt[i] - 1)));
+        }
+
+        CHECK(job[cur]->get_tensor(AIPU_TENSOR_TYPE_INPUT, 0, fetched.data()) == AIPU_STATUS_SUCCESS);
+        CHECK(fetched == in_data);
+        CHECK(job[cur]->get_tensor(AIPU_TENSOR_TYPE_OUTPUT, 0, fetched.data()) == AIPU_STATUS_SUCCESS);
+        CHECK(fetched == out_data);
+    }
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        CHECK(ctx.get_graph_object(graph_id[i])->destroy_job(job_id[i]) == AIPU_STATUS_SUCCESS);
+        CHECK(ctx.unload_graph(graph_id[i]) == AIPU_STATUS_SUCCESS);
+    }
+    ctx.deinit();
+}
+#endif
+
+TEST_CASE_FIXTURE(ContextTest, "get_graph_load_stats")
+{
+    string graph_file = "./benchmark/aipu.bin";
+    aipu_graph_load_stats_t stats = {0};
+    aipu_status_t ret;
+    uint64_t graph_id;
+
+    p_ctx->init();
+
+    stats.graph_id = 0;
+    ret = p_ctx->ioctl_cmd(AIPU_IOCTL_GET_GRAPH_LOAD_STATS, &stats);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_GRAPH_ID);
+
+    ret = p_ctx->load_graph(graph_file.c_str(), &graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    stats.graph_id = graph_id;
+    ret = p_ctx->ioctl_cmd(AIPU_IOCTL_GET_GRAPH_LOAD_STATS, &stats);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(stats.phases[AIPU_LOAD_PHASE_CREATE_GRAPH].wall_ns > 0);
+    CHECK(stats.phases[AIPU_LOAD_PHASE_CREATE_GRAPH].wall_ns >=
+        stats.phases[AIPU_LOAD_PHASE_LOAD].wall_ns);
+    CHECK(stats.phases[AIPU_LOAD_PHASE_CREATE_GRAPH].alloc_cnt > 0);
+
+    /* the latest unloaded graph keeps its report */
+    ret = p_ctx->unload_graph(graph_id);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    stats.json_path = "./load_stats.json";
+    ret = p_ctx->ioctl_cmd(AIPU_IOCTL_GET_GRAPH_LOAD_STATS, &stats);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(stats.phases[AIPU_LOAD_PHASE_UNLOAD].free_cnt > 0);
+}
+
 TEST_CASE_FIXTURE(ContextTest, "create_job")
 {
     string graph_file = "./benchmark/aipu.bin";
@@ -260,3 +675,63 @@ TEST_CASE_FIXTURE(ContextTest, "get_core_info")
 }
 
 #endif
+
+TEST_CASE("async_log")
+{
+    char convs[8] = {0};
+    char record[64] = {0};
+    char out[128] = {0};
+    char expected[128] = {0};
+    char name[16] = "weight";
+    const char *ptr = name;
+
+    CHECK(umd_log_scan_convs("a %d %%s %-8.*lx %p %s", convs, 8) == 5);
+    CHECK(std::string(convs, 5) == "d*xps");
+    CHECK(umd_log_scan_convs("%d %d %d", convs, 2) == 2);
+
+    /* a %s argument is copied, other char pointers are kept as pointers */
+    CHECK(async_log::encode(record, sizeof(record), "%s %p %*d", name, ptr, 4, 7));
+    name[0] = 'W';
+    async_log::format<char *, const char *, int, int>(out, sizeof(out), "%s %p %*d", record);
+    snprintf(expected, sizeof(expected), "weight %p    7", (const void *)ptr);
+    CHECK(std::string(out) == expected);
+
+    /* strings are never truncated, a record too small makes the line logged synchronously */
+    CHECK(async_log::encode(record, 16, "%s", "0123456789abcd"));
+    async_log::format<const char *>(out, sizeof(out), "[%s]", record);
+    CHECK(std::string(out) == "[0123456789abcd]");
+    CHECK(!async_log::encode(record, 16, "%s", "0123456789abcde"));
+    CHECK(!async_log::encode(record, 16, "%d %s", 1, "0123456789a"));
+    CHECK(!async_log::encode(record, 16, "%lu %lu %lu", 1UL, 2UL, 3UL));
+}
+
+TEST_CASE("async_log_order")
+{
+    std::string path = "./async_log_order.txt";
+    std::string long_arg(1024, 'x');
+    std::string text;
+    int saved = dup(STDOUT_FILENO);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    REQUIRE(saved >= 0);
+    REQUIRE(fd >= 0);
+    fflush(stdout);
+    dup2(fd, STDOUT_FILENO);
+
+    /* queued lines first, then one whose %s doesn't fit in a record */
+    for (int i = 0; i < 64; i++)
+        umd_log(LOG_DEFAULT, __FILE__, __LINE__, __func__, "queued %d", i);
+    umd_log(LOG_DEFAULT, __FILE__, __LINE__, __func__, "sync %s", long_arg.c_str());
+
+    umd_log_flush();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(fd);
+
+    std::ifstream ifs(path);
+    text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    REQUIRE(text.find("sync ") != std::string::npos);
+    CHECK(text.find("queued 63") < text.find("sync "));
+    remove(path.c_str());
+}
@@ -5,6 +5,10 @@
 #include <stdlib.h>
 #include "graph_test.h"
 #include "aipu.h"
+#include "extra_weight_cache.h"
+#if (defined ZHOUYI_V3)
+#include "bench/mock_device.h"
+#endif
 
 TEST_CASE_FIXTURE(GraphTest, "load")
 {
@@ -26,6 +30,90 @@ TEST_CASE_FIXTURE(GraphTest, "unload")
     CHECK(ret == AIPU_STATUS_SUCCESS);
 }
 
+TEST_CASE("extra_weight_cache")
+{
+    ExtraWeightCache &cache = ExtraWeightCache::get_cache();
+    ExtraWeightFile *file[3] = {nullptr};
+    string path = "./extra_weight_cache_test.bin";
+    std::vector<char> data(1024 * 1024 + 3, 0x5a);
+    aipu_status_t ret;
+
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+
+    ret = cache.open("./no_such_extra_weight.bin", "ew", "0", &file[0]);
+    CHECK(ret == AIPU_STATUS_ERROR_OPEN_FILE_FAIL);
+
+    /* same name+hash and content: one mapping */
+    ret = cache.open(path, "ew", "0", &file[0]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    ret = cache.open(path, "ew", "0", &file[1]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(file[0] == file[1]);
+    CHECK(file[0]->size == data.size());
+
+    /* rewritten content under the same name+hash isn't shared */
+    data[7] = 0;
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+    ret = cache.open(path, "ew", "0", &file[2]);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(file[2] != file[0]);
+    CHECK(file[2]->digest != file[0]->digest);
+
+    cache.close(file[0]);
+    cache.close(file[1]);
+    cache.close(file[2]);
+    remove(path.c_str());
+}
+
+#if (defined ZHOUYI_V3)
+TEST_CASE("extra_weight_shared_buffer")
+{
+    umd_bench::MockDevice dev;
+    ExtraWeightCache &cache = ExtraWeightCache::get_cache();
+    ExtraWeightFile *file = nullptr;
+    SharedWeightLayout layout[2];
+    BufferDesc *buf[3] = {nullptr};
+    string path = "./extra_weight_shared_test.bin";
+    std::vector<char> data(4096, 0x5a);
+    uint32_t fill_cnt = 0;
+    auto fill = [&](BufferDesc *) { fill_cnt++; };
+
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+    REQUIRE(cache.open(path, "ew", "0", &file) == AIPU_STATUS_SUCCESS);
+
+    /* layouts which only differ in how sections map, they used to hash the same */
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        layout[i].size = 4096;
+        layout[i].region = (1 << 8) | AIPU_MEM_REGION_DEFAULT;
+    }
+    layout[0].sections.push_back(std::make_tuple(0, 31, 16));
+    layout[1].sections.push_back(std::make_tuple(1, 0, 16));
+
+    CHECK(cache.acquire_buffer(file, dev.get_mem(), layout[0], fill, &buf[0]) == AIPU_STATUS_SUCCESS);
+    CHECK(cache.acquire_buffer(file, dev.get_mem(), layout[1], fill, &buf[1]) == AIPU_STATUS_SUCCESS);
+    CHECK(cache.acquire_buffer(file, dev.get_mem(), layout[0], fill, &buf[2]) == AIPU_STATUS_SUCCESS);
+    CHECK(buf[0] != buf[1]);
+    CHECK(buf[0] == buf[2]);
+    CHECK(fill_cnt == 2);
+
+    /* a different region is another buffer */
+    layout[1].region = AIPU_MEM_REGION_DEFAULT;
+    CHECK(cache.acquire_buffer(file, dev.get_mem(), layout[1], fill, &buf[2]) == AIPU_STATUS_SUCCESS);
+    CHECK(buf[2] != buf[1]);
+    CHECK(fill_cnt == 3);
+
+    cache.release_buffer(file, dev.get_mem(), layout[1]);
+    layout[1].region = layout[0].region;
+    cache.release_buffer(file, dev.get_mem(), layout[1]);
+    cache.release_buffer(file, dev.get_mem(), layout[0]);
+    cache.release_buffer(file, dev.get_mem(), layout[0]);
+    CHECK(file->buffers.empty());
+    cache.close(file);
+    remove(path.c_str());
+}
+#endif
+
 TEST_CASE_FIXTURE(GraphTest, "create_job")
 {
     aipu_status_t ret;
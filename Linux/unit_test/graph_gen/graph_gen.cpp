@@ -0,0 +1,334 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  graph_gen.cpp
+ * @brief synthetic aipu v3 ELF graph binary generator implementation
+ */
+
+#include <fstream>
+#include <sstream>
+#include "graph_gen.h"
+#include "parser_elf.h"
+
+using namespace aipudrv;
+
+namespace
+{
+/* the intermediate type of a sub-section, see SubSectionDesc */
+const uint32_t SUB_SECTION_TYPE_INTERMEDIATE = 3;
+const uint32_t SECTION_ALIGN_BYTES = 4096;
+const uint32_t STACK_SIZE = 4096;
+const uint16_t ELF_MACHINE_AIPU = 0x29a;
+
+template<typename T>
+void append(std::string &buf, const T &val)
+{
+    buf.append((const char *)&val, sizeof(T));
+}
+
+class Builder
+{
+private:
+    const graph_gen::Config &m_cfg;
+    uint32_t m_ro_entry = 0;
+    uint32_t m_ro_slice = 0;
+
+public:
+    std::string m_rodata;
+    std::string m_weight;
+    std::string m_fmlist;
+    std::string m_subgraphs;
+    std::string m_compilermsg;
+    std::string m_globalparam;
+    std::string m_constraint;
+
+private:
+    /**
+     * @brief the sub-sections of one section, only the first one may be an IO tensor
+     */
+    void add_sub_sections(std::string &buf, uint32_t sec_size, uint32_t first_type,
+        uint32_t io_id)
+    {
+        uint32_t sub_size = sec_size / m_cfg.sub_section_cnt;
+
+        for (uint32_t i = 0; i < m_cfg.sub_section_cnt; i++)
+        {
+            SubSectionDesc desc = {0};
+
+            desc.offset_in_section_exec = i * sub_size;
+            desc.size = sub_size;
+            desc.type = (i == 0) ? first_type : SUB_SECTION_TYPE_INTERMEDIATE;
+            desc.id = (i == 0) ? io_id : 0;
+            desc.data_type = AIPU_DATA_TYPE_U8;
+            desc.scale = 1.0;
+            desc.addr_mask = 0xffffffff;
+            desc.offset_in_ro_cnt = m_cfg.param_cnt;
+            append(buf, desc);
+
+            for (uint32_t j = 0; j < desc.offset_in_ro_cnt; j++)
+                append(buf, (uint32_t)(m_ro_entry++ * sizeof(uint32_t)));
+        }
+    }
+
+    void add_reuse_section(std::string &buf, uint32_t size, uint32_t first_type,
+        uint32_t io_id)
+    {
+        BSSReuseSectionDesc desc = {0};
+
+        desc.size = size;
+        desc.align_bytes = SECTION_ALIGN_BYTES;
+        desc.sub_section_cnt = m_cfg.sub_section_cnt;
+        append(buf, desc);
+        add_sub_sections(buf, size, first_type, io_id);
+    }
+
+    void add_bss(uint32_t bss_id)
+    {
+        BSSHeader header = {0};
+        uint32_t in_cnt = (bss_id == 0) ? m_cfg.input_cnt : 0;
+        uint32_t io_cnt = (bss_id == 0) ? (m_cfg.input_cnt + m_cfg.output_cnt) : 0;
+
+        header.stack_size = STACK_SIZE;
+        header.stack_align_bytes = SECTION_ALIGN_BYTES;
+        header.static_section_desc_cnt = (bss_id == 0) ? m_cfg.static_cnt : 0;
+        header.reuse_section_desc_cnt = io_cnt + m_cfg.reuse_cnt;
+        append(m_fmlist, header);
+
+        for (uint32_t i = 0; i < header.static_section_desc_cnt; i++)
+        {
+            BSSStaticSectionDesc desc = {0};
+
+            desc.offset_in_file = m_weight.size();
+            desc.size = m_cfg.static_size;
+            desc.align_bytes = SECTION_ALIGN_BYTES;
+            desc.sub_section_cnt = m_cfg.sub_section_cnt;
+            append(m_fmlist, desc);
+            add_sub_sections(m_fmlist, m_cfg.static_size, SUB_SECTION_TYPE_INTERMEDIATE, 0);
+            m_weight.append(m_cfg.static_size, (char)(i + 1));
+        }
+
+        for (uint32_t i = 0; i < header.reuse_section_desc_cnt; i++)
+        {
+            if (i < in_cnt)
+                add_reuse_section(m_fmlist, m_cfg.reuse_size, SECTION_TYPE_INPUT, i);
+            else if (i < io_cnt)
+                add_reuse_section(m_fmlist, m_cfg.reuse_size, SECTION_TYPE_OUTPUT, i - in_cnt);
+            else
+                add_reuse_section(m_fmlist, m_cfg.reuse_size, SUB_SECTION_TYPE_INTERMEDIATE, 0);
+        }
+    }
+
+    void add_subgraph(uint32_t sg_id)
+    {
+        ElfSubGraphDesc desc = {0};
+
+        desc.id = sg_id;
+        desc.text_offset = sg_id * m_cfg.text_size;
+        desc.fm_desc_offset = (uint64_t)sg_id * m_cfg.bss_cnt / m_cfg.subgraph_cnt;
+        desc.rodata_offset = sg_id * m_ro_slice;
+        desc.rodata_size = m_ro_slice;
+        desc.private_data_size = m_cfg.data_size;
+        desc.precursor_cnt = (m_cfg.chain && (sg_id > 0)) ? SUBG_DEPEND_IMMEDIATE : SUBG_DEPEND_NONE;
+
+        /* private_buffer_cnt follows the precursor list, see ParserELF::parse_subgraph */
+        m_subgraphs.append((const char *)&desc, sizeof(desc) - sizeof(int32_t));
+        if (desc.precursor_cnt > 0)
+        {
+            ElfPrecursorDesc pre = {sg_id - 1};
+            append(m_subgraphs, pre);
+        }
+
+        append(m_subgraphs, (int32_t)m_cfg.private_cnt);
+        for (uint32_t i = 0; i < m_cfg.private_cnt; i++)
+            add_reuse_section(m_subgraphs, m_cfg.private_size, SUB_SECTION_TYPE_INTERMEDIATE, 0);
+    }
+
+    void add_dynamic_shape()
+    {
+        DS_ModelGlobalParam param = {0};
+
+        /* the shapes configured at create_job are written after the header */
+        param.input_shape_offset = sizeof(param);
+        append(m_globalparam, param);
+        m_globalparam.append(m_cfg.input_cnt * m_cfg.shape_dim * sizeof(uint32_t), 0);
+
+        /* a min and a max shape per input */
+        append(m_constraint, m_cfg.input_cnt * 2);
+        for (uint32_t i = 0; i < m_cfg.input_cnt * 2; i++)
+        {
+            append(m_constraint, m_cfg.shape_dim);
+            for (uint32_t j = 0; j < m_cfg.shape_dim; j++)
+            {
+                uint32_t dim = 1;
+
+                if ((i % 2 == 1) && (j == m_cfg.shape_dim - 1))
+                    dim = m_cfg.reuse_size / m_cfg.sub_section_cnt;
+                append(m_constraint, dim);
+            }
+        }
+    }
+
+public:
+    void build()
+    {
+        AIPUCompilerMsg msg;
+        ElfSubGraphList sg_list = {m_cfg.subgraph_cnt};
+        FeatureMapList fm_list;
+        uint64_t ro_size = aligned(std::max(graph_gen::param_entry_cnt(m_cfg),
+            (uint64_t)m_cfg.subgraph_cnt) * sizeof(uint32_t), SECTION_ALIGN_BYTES);
+
+        m_ro_slice = (ro_size / m_cfg.subgraph_cnt) & ~(sizeof(uint32_t) - 1);
+        m_rodata.assign(ro_size, 0);
+
+        fm_list.num_fm_descriptor = m_cfg.bss_cnt;
+        append(m_fmlist, fm_list);
+        for (uint32_t i = 0; i < m_cfg.bss_cnt; i++)
+            add_bss(i);
+
+        append(m_subgraphs, sg_list);
+        for (uint32_t i = 0; i < m_cfg.subgraph_cnt; i++)
+            add_subgraph(i);
+
+        msg.device = m_cfg.device;
+        if (m_cfg.dynamic_shape)
+        {
+            msg.flag |= 1 << 6;
+            add_dynamic_shape();
+        }
+        append(m_compilermsg, msg);
+    }
+
+public:
+    Builder(const graph_gen::Config &cfg): m_cfg(cfg) {}
+};
+
+aipu_status_t check_config(const graph_gen::Config &cfg)
+{
+    if ((cfg.subgraph_cnt == 0) || (cfg.bss_cnt == 0) || (cfg.bss_cnt > cfg.subgraph_cnt) ||
+        (cfg.sub_section_cnt == 0) || (cfg.text_size == 0) || (cfg.data_size == 0))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    /* the parser rejects a BSS without any reuse section */
+    if ((cfg.input_cnt + cfg.output_cnt + cfg.reuse_cnt == 0) ||
+        ((cfg.bss_cnt > 1) && (cfg.reuse_cnt == 0)))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    if ((cfg.static_size < cfg.sub_section_cnt) || (cfg.reuse_size < cfg.sub_section_cnt) ||
+        ((cfg.private_cnt > 0) && (cfg.private_size < cfg.sub_section_cnt)))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    if (cfg.dynamic_shape && ((cfg.input_cnt == 0) || (cfg.shape_dim == 0)))
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    /* rodata entry offsets are 32 bits */
+    if (graph_gen::param_entry_cnt(cfg) > UINT32_MAX / sizeof(uint32_t) / 2)
+        return AIPU_STATUS_ERROR_INVALID_CONFIG;
+
+    return AIPU_STATUS_SUCCESS;
+}
+}
+
+graph_gen::Config graph_gen::scaled_config(uint32_t scale)
+{
+    Config cfg;
+
+    cfg.subgraph_cnt = 4 * scale;
+    cfg.static_cnt = 16 * scale;
+    cfg.reuse_cnt = 16 * scale;
+    cfg.param_cnt = 4;
+    return cfg;
+}
+
+uint64_t graph_gen::param_entry_cnt(const Config &cfg)
+{
+    uint64_t sections = (uint64_t)cfg.static_cnt + cfg.input_cnt + cfg.output_cnt +
+        (uint64_t)cfg.bss_cnt * cfg.reuse_cnt + (uint64_t)cfg.subgraph_cnt * cfg.private_cnt;
+
+    return sections * cfg.sub_section_cnt * cfg.param_cnt;
+}
+
+aipu_status_t graph_gen::generate(const Config &cfg, std::string &bin)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    Builder builder(cfg);
+    ELFIO::elfio elf;
+    ELFIO::section *text = nullptr;
+    ELFIO::section *note = nullptr;
+    std::string text_data;
+    std::ostringstream os;
+
+    ret = check_config(cfg);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    builder.build();
+
+    elf.create(ELFCLASS32, ELFDATA2LSB);
+    elf.set_type(ET_EXEC);
+    elf.set_machine(ELF_MACHINE_AIPU);
+
+    text_data.assign((size_t)cfg.subgraph_cnt * cfg.text_size, 0);
+    text = elf.sections.add(".text");
+    text->set_type(SHT_PROGBITS);
+    text->set_flags(SHF_ALLOC | SHF_EXECINSTR);
+    text->set_addr_align(16);
+    text->set_data(text_data);
+
+    note = elf.sections.add(".note.aipu");
+    note->set_type(SHT_NOTE);
+    note->set_addr_align(4);
+    {
+        ELFIO::note_section_accessor notes(elf, note);
+
+        notes.add_note(0, "rodata", builder.m_rodata.data(), builder.m_rodata.size());
+        if (!builder.m_weight.empty())
+            notes.add_note(0, "weight", builder.m_weight.data(), builder.m_weight.size());
+        notes.add_note(0, "fmlist", builder.m_fmlist.data(), builder.m_fmlist.size());
+        notes.add_note(0, "subgraphs", builder.m_subgraphs.data(), builder.m_subgraphs.size());
+        notes.add_note(0, "compilermsg", builder.m_compilermsg.data(), builder.m_compilermsg.size());
+        if (cfg.dynamic_shape)
+        {
+            notes.add_note(0, "globalparam", builder.m_globalparam.data(),
+                builder.m_globalparam.size());
+            notes.add_note(0, "inputshapeconstraint", builder.m_constraint.data(),
+                builder.m_constraint.size());
+        }
+    }
+
+    if (!elf.save(os))
+    {
+        ret = AIPU_STATUS_ERROR_INVALID_GBIN;
+        goto finish;
+    }
+    bin = os.str();
+
+finish:
+    return ret;
+}
+
+aipu_status_t graph_gen::generate_file(const Config &cfg, const std::string &file)
+{
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    std::string bin;
+    std::ofstream ofs;
+
+    ret = generate(cfg, bin);
+    if (ret != AIPU_STATUS_SUCCESS)
+        goto finish;
+
+    ofs.open(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+    {
+        ret = AIPU_STATUS_ERROR_OPEN_FILE_FAIL;
+        goto finish;
+    }
+
+    ofs.write(bin.data(), bin.size());
+    if (!ofs.good())
+        ret = AIPU_STATUS_ERROR_WRITE_FILE_FAIL;
+
+finish:
+    return ret;
+}
@@ -0,0 +1,90 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  graph_gen.h
+ * @brief synthetic aipu v3 ELF graph binaries for tests and benchmarks
+ *
+ * @note  the binaries follow the layout ParserELF consumes, but the text is
+ *        all zeroes; they can be loaded and jobs created and scheduled on a
+ *        mock device, they can't run on an NPU or the simulator.
+ */
+
+#ifndef _GRAPH_GEN_H_
+#define _GRAPH_GEN_H_
+
+#include <string>
+#include "standard_api.h"
+#include "kmd/armchina_aipu.h"
+
+namespace graph_gen
+{
+/**
+ * @brief shape of the generated graph
+ *
+ * @note  - every section has sub_section_cnt sub-sections and every sub-section
+ *          is referenced by param_cnt rodata entries, which are the param map
+ *          entries relocated at create_job;
+ *        - BSS 0 holds the static sections and the IO tensors, one reuse section
+ *          per input and per output followed by reuse_cnt intermediate ones;
+ *        - a BSS other than 0 only has reuse_cnt intermediate sections, the
+ *          parser appends them to the reuse sections of BSS 0 as well;
+ *        - subgraph i uses BSS (i * bss_cnt / subgraph_cnt) and depends on
+ *          subgraph i - 1 if chain is set;
+ *        - dynamic_shape adds the global param and input shape constraint
+ *          sections, each input being [1, ..., 1] to [1, ..., size].
+ */
+struct Config
+{
+    uint32_t device = (AIPU_ARCH_ZHOUYI << 20) | (AIPU_ISA_VERSION_ZHOUYI_V3 << 16);
+    uint32_t subgraph_cnt = 1;
+    uint32_t bss_cnt = 1;
+    uint32_t static_cnt = 1;
+    uint32_t static_size = 4096;
+    uint32_t reuse_cnt = 1;
+    uint32_t reuse_size = 4096;
+    uint32_t private_cnt = 0;     /**< private buffers per subgraph */
+    uint32_t private_size = 4096;
+    uint32_t sub_section_cnt = 1;
+    uint32_t param_cnt = 1;
+    uint32_t input_cnt = 1;
+    uint32_t output_cnt = 1;
+    uint32_t text_size = 256;     /**< text bytes per subgraph */
+    uint32_t data_size = 1024;    /**< private data bytes per subgraph, not 0 as JobV3 needs it */
+    bool chain = true;
+    bool dynamic_shape = false;
+    uint32_t shape_dim = 4;
+};
+
+/**
+ * @brief a graph 'scale' times a model of 4 subgraphs with 16 static and
+ *        16 reuse sections, 4 rodata entries each
+ */
+Config scaled_config(uint32_t scale);
+
+/**
+ * @brief number of param map entries the UMD relocates for each job
+ */
+uint64_t param_entry_cnt(const Config &cfg);
+
+/**
+ * @brief build the graph binary in memory
+ *
+ * @retval AIPU_STATUS_SUCCESS
+ * @retval AIPU_STATUS_ERROR_INVALID_CONFIG a count or size is out of range
+ * @retval AIPU_STATUS_ERROR_INVALID_GBIN the ELF can't be written
+ */
+aipu_status_t generate(const Config &cfg, std::string &bin);
+
+/**
+ * @brief build the graph binary into a file
+ *
+ * @retval AIPU_STATUS_ERROR_OPEN_FILE_FAIL
+ * @retval AIPU_STATUS_ERROR_WRITE_FILE_FAIL
+ * @retval the ones of generate()
+ */
+aipu_status_t generate_file(const Config &cfg, const std::string &file);
+}
+
+#endif /* _GRAPH_GEN_H_ */
@@ -0,0 +1,126 @@
+// Copyright (C) 2023-2024 Arm Technology (China) Co. Ltd.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file  main.cpp
+ * @brief aipu_graph_gen: write a synthetic aipu v3 graph binary
+ *
+ * @note  usage: aipu_graph_gen -o aipu.bin [options], see usage()
+ */
+
+#include <getopt.h>
+#include <cstdio>
+#include <cstdlib>
+#include "graph_gen.h"
+
+static void usage(const char *name)
+{
+    graph_gen::Config cfg;
+
+    fprintf(stderr, "usage: %s -o aipu.bin [options]\n"
+        "  --subgraphs N     subgraph count, default %u\n"
+        "  --bss N           BSS count, at most the subgraph count, default %u\n"
+        "  --static N        static sections in BSS 0, default %u\n"
+        "  --static-size B   bytes per static section, default %u\n"
+        "  --reuse N         intermediate reuse sections per BSS, default %u\n"
+        "  --reuse-size B    bytes per reuse section, default %u\n"
+        "  --private N       private buffers per subgraph, default %u\n"
+        "  --private-size B  bytes per private buffer, default %u\n"
+        "  --subsections N   sub-sections per section, default %u\n"
+        "  --params N        rodata entries per sub-section, default %u\n"
+        "  --inputs N        input tensors, default %u\n"
+        "  --outputs N       output tensors, default %u\n"
+        "  --text-size B     text bytes per subgraph, default %u\n"
+        "  --data-size B     private data bytes per subgraph, default %u\n"
+        "  --no-chain        subgraphs don't depend on each other\n"
+        "  --dynamic-shape   add the dynamic shape sections\n"
+        "  --shape-dim N     dims per input shape, default %u\n"
+        "  --device X        device word of the compiler message, default 0x%x\n",
+        name, cfg.subgraph_cnt, cfg.bss_cnt, cfg.static_cnt, cfg.static_size, cfg.reuse_cnt,
+        cfg.reuse_size, cfg.private_cnt, cfg.private_size, cfg.sub_section_cnt, cfg.param_cnt,
+        cfg.input_cnt, cfg.output_cnt, cfg.text_size, cfg.data_size, cfg.shape_dim, cfg.device);
+}
+
+int main(int argc, char **argv)
+{
+    enum {
+        OPT_SUBGRAPHS = 0x100, OPT_BSS, OPT_STATIC, OPT_STATIC_SIZE, OPT_REUSE, OPT_REUSE_SIZE,
+        OPT_PRIVATE, OPT_PRIVATE_SIZE, OPT_SUBSECTIONS, OPT_PARAMS, OPT_INPUTS, OPT_OUTPUTS,
+        OPT_TEXT_SIZE, OPT_DATA_SIZE, OPT_NO_CHAIN, OPT_DYNAMIC_SHAPE, OPT_SHAPE_DIM, OPT_DEVICE,
+    };
+    const struct option opts[] = {
+        {"subgraphs",     required_argument, nullptr, OPT_SUBGRAPHS},
+        {"bss",           required_argument, nullptr, OPT_BSS},
+        {"static",        required_argument, nullptr, OPT_STATIC},
+        {"static-size",   required_argument, nullptr, OPT_STATIC_SIZE},
+        {"reuse",         required_argument, nullptr, OPT_REUSE},
+        {"reuse-size",    required_argument, nullptr, OPT_REUSE_SIZE},
+        {"private",       required_argument, nullptr, OPT_PRIVATE},
+        {"private-size",  required_argument, nullptr, OPT_PRIVATE_SIZE},
+        {"subsections",   required_argument, nullptr, OPT_SUBSECTIONS},
+        {"params",        required_argument, nullptr, OPT_PARAMS},
+        {"inputs",        required_argument, nullptr, OPT_INPUTS},
+        {"outputs",       required_argument, nullptr, OPT_OUTPUTS},
+        {"text-size",     required_argument, nullptr, OPT_TEXT_SIZE},
+        {"data-size",     required_argument, nullptr, OPT_DATA_SIZE},
+        {"no-chain",      no_argument,       nullptr, OPT_NO_CHAIN},
+        {"dynamic-shape", no_argument,       nullptr, OPT_DYNAMIC_SHAPE},
+        {"shape-dim",     required_argument, nullptr, OPT_SHAPE_DIM},
+        {"device",        required_argument, nullptr, OPT_DEVICE},
+        {"help",          no_argument,       nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    graph_gen::Config cfg;
+    const char *out_file = nullptr;
+    aipu_status_t ret = AIPU_STATUS_SUCCESS;
+    int opt = 0;
+
+    while ((opt = getopt_long(argc, argv, "o:h", opts, nullptr)) != -1)
+    {
+        uint32_t val = (optarg != nullptr) ? strtoul(optarg, nullptr, 0) : 0;
+
+        switch (opt)
+        {
+            case 'o': out_file = optarg; break;
+            case OPT_SUBGRAPHS: cfg.subgraph_cnt = val; break;
+            case OPT_BSS: cfg.bss_cnt = val; break;
+            case OPT_STATIC: cfg.static_cnt = val; break;
+            case OPT_STATIC_SIZE: cfg.static_size = val; break;
+            case OPT_REUSE: cfg.reuse_cnt = val; break;
+            case OPT_REUSE_SIZE: cfg.reuse_size = val; break;
+            case OPT_PRIVATE: cfg.private_cnt = val; break;
+            case OPT_PRIVATE_SIZE: cfg.private_size = val; break;
+            case OPT_SUBSECTIONS: cfg.sub_section_cnt = val; break;
+            case OPT_PARAMS: cfg.param_cnt = val; break;
+            case OPT_INPUTS: cfg.input_cnt = val; break;
+            case OPT_OUTPUTS: cfg.output_cnt = val; break;
+            case OPT_TEXT_SIZE: cfg.text_size = val; break;
+            case OPT_DATA_SIZE: cfg.data_size = val; break;
+            case OPT_NO_CHAIN: cfg.chain = false; break;
+            case OPT_DYNAMIC_SHAPE: cfg.dynamic_shape = true; break;
+            case OPT_SHAPE_DIM: cfg.shape_dim = val; break;
+            case OPT_DEVICE: cfg.device = val; break;
+            default:
+                usage(argv[0]);
+                return (opt == 'h') ? 0 : 1;
+        }
+    }
+
+    if (out_file == nullptr)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ret = graph_gen::generate_file(cfg, out_file);
+    if (ret != AIPU_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "generate %s [fail] status 0x%x\n", out_file, ret);
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %u subgraphs, %u BSS, %lu param map entries\n", out_file,
+        cfg.subgraph_cnt, cfg.bss_cnt, graph_gen::param_entry_cnt(cfg));
+    return 0;
+}
@@ -3,9 +3,21 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <cmath>
+#include <fstream>
+#include <thread>
 #include "job_test.h"
 #include "standard_api.h"
 #include "aipu.h"
+#include "utils/quant.h"
+#include "utils/layout.h"
+#include "utils/helper.h"
+#include "utils/dump_writer.h"
+#include "graph_gen/graph_gen.h"
+#if (defined ZHOUYI_V3)
+#include "bench/mock_device.h"
+#endif
 
 TEST_CASE_FIXTURE(JobTest, "init")
 {
@@ -125,6 +137,710 @@ TEST_CASE_FIXTURE(JobTest, "get_tensor")
     CHECK(ret == AIPU_STATUS_SUCCESS);
 }
 
+/**
+ * @brief split 'flat' into segments of a length that doesn't divide the tensors
+ */
+static std::vector<struct iovec> split_iov(std::vector<char> &flat)
+{
+    std::vector<struct iovec> iov;
+    size_t seg = flat.size() / 4 + 1;
+
+    for (size_t off = 0; off < flat.size(); off += seg)
+        iov.push_back({flat.data() + off, std::min(seg, flat.size() - off)});
+    return iov;
+}
+
+TEST_CASE_FIXTURE(JobTest, "run")
+{
+    aipu_status_t ret;
+    uint32_t in_cnt = 0, out_cnt = 0;
+    struct iovec in_iov = {input_dest, (size_t)input_size + 1};
+
+    p_job->init(&m_sim_cfg, &m_hw_cfg);
+#if (defined SIMULATION)
+    p_job->config_simulation(AIPU_CONFIG_TYPE_SIMULATION, &sim_job_config);
+#endif
+    p_gobj->get_tensor_count(AIPU_TENSOR_TYPE_INPUT, &in_cnt);
+    p_gobj->get_tensor_count(AIPU_TENSOR_TYPE_OUTPUT, &out_cnt);
+
+    ret = p_job->run_iov(nullptr, 1, nullptr, 0, -1);
+    CHECK(ret == AIPU_STATUS_ERROR_NULL_PTR);
+
+    ret = p_job->run_iov(&in_iov, 1, nullptr, 0, -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+
+    std::vector<const void*> inputs(in_cnt, nullptr);
+    std::vector<void*> outputs(out_cnt, nullptr);
+    std::vector<std::vector<char>> in_data(in_cnt), out_data(out_cnt), fetched(out_cnt);
+    std::vector<char> in_flat, out_flat, fetched_flat;
+    for (uint32_t i = 0; i < in_cnt; i++)
+    {
+        aipu_tensor_desc_t desc;
+
+        REQUIRE(p_gobj->get_tensor_descriptor(AIPU_TENSOR_TYPE_INPUT, i, &desc) == AIPU_STATUS_SUCCESS);
+        in_data[i].resize(desc.size);
+        inputs[i] = in_data[i].data();
+    }
+    memcpy(in_data[0].data(), input_dest, std::min((size_t)input_size, in_data[0].size()));
+    for (uint32_t i = 0; i < out_cnt; i++)
+    {
+        aipu_tensor_desc_t desc;
+
+        REQUIRE(p_gobj->get_tensor_descriptor(AIPU_TENSOR_TYPE_OUTPUT, i, &desc) == AIPU_STATUS_SUCCESS);
+        out_data[i].resize(desc.size);
+        fetched[i].resize(desc.size);
+        outputs[i] = out_data[i].data();
+    }
+
+    ret = p_job->run(inputs.data(), outputs.data(), -1);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    /* run() gets the same outputs as get_tensor() */
+    for (uint32_t i = 0; i < out_cnt; i++)
+    {
+        ret = p_job->get_tensor(AIPU_TENSOR_TYPE_OUTPUT, i, fetched[i].data());
+        CHECK(ret == AIPU_STATUS_SUCCESS);
+        CHECK(fetched[i] == out_data[i]);
+        fetched_flat.insert(fetched_flat.end(), fetched[i].begin(), fetched[i].end());
+    }
+
+    /* the same job through segments not aligned to the tensors, so they span tensor ends */
+    for (uint32_t i = 0; i < in_cnt; i++)
+        in_flat.insert(in_flat.end(), in_data[i].begin(), in_data[i].end());
+    out_flat.resize(fetched_flat.size());
+    std::vector<struct iovec> in_segs = split_iov(in_flat);
+    std::vector<struct iovec> out_segs = split_iov(out_flat);
+    REQUIRE(in_segs.size() > 1);
+    REQUIRE(out_segs.size() > 1);
+
+    ret = p_job->run_iov(in_segs.data(), in_segs.size(), out_segs.data(), out_segs.size(), -1);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(out_flat == fetched_flat);
+
+    /* the segments must add up to the tensors exactly */
+    in_segs.back().iov_len--;
+    ret = p_job->run_iov(in_segs.data(), in_segs.size(), nullptr, 0, -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+    in_segs.back().iov_len += 2;
+    ret = p_job->run_iov(in_segs.data(), in_segs.size(), nullptr, 0, -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+    in_segs.back().iov_len--;
+
+    out_segs.back().iov_len--;
+    ret = p_job->run_iov(in_segs.data(), in_segs.size(), out_segs.data(), out_segs.size(), -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+    out_segs.push_back({nullptr, 2});
+    ret = p_job->run_iov(in_segs.data(), in_segs.size(), out_segs.data(), out_segs.size(), -1);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+}
+
+#if (defined ZHOUYI_V3)
+TEST_CASE("run_iov")
+{
+    umd_bench::MockDevice dev;
+    MainContext ctx;
+    graph_gen::Config cfg;
+    std::string bin;
+    GRAPH_ID graph_id = 0;
+    JOB_ID job_id = 0;
+    aipu_create_job_cfg_t create_job_cfg = {0};
+    JobBase *job = nullptr;
+    uint32_t size = 0;
+    aipu_status_t ret;
+
+    /* 2 inputs and 2 outputs, one mock run leaves the outputs as they are */
+    cfg.input_cnt = 2;
+    cfg.output_cnt = 2;
+    cfg.reuse_size = 4096;
+    size = cfg.reuse_size;
+    REQUIRE(graph_gen::generate(cfg, bin) == AIPU_STATUS_SUCCESS);
+    ctx.set_dev(&dev);
+    REQUIRE(ctx.load_graph(bin.data(), bin.size(), &graph_id) == AIPU_STATUS_SUCCESS);
+    REQUIRE(ctx.create_job(graph_id, &job_id, &create_job_cfg) == AIPU_STATUS_SUCCESS);
+    job = ctx.get_job_object(job_id);
+    REQUIRE(job != nullptr);
+
+    std::vector<std::vector<char>> in_data(2, std::vector<char>(size));
+    std::vector<std::vector<char>> out_data(2, std::vector<char>(size, 0x5a));
+    std::vector<std::vector<char>> fetched(2, std::vector<char>(size));
+    const void *inputs[2] = {in_data[0].data(), in_data[1].data()};
+    void *outputs[2] = {out_data[0].data(), out_data[1].data()};
+    for (uint32_t i = 0; i < size; i++)
+    {
+        in_data[0][i] = (char)i;
+        in_data[1][i] = (char)(i * 7 + 1);
+    }
+
+    ret = job->run(inputs, outputs, -1);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+
+    /* run() loads what get_tensor() reads back and gets the same outputs */
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        CHECK(job->get_tensor(AIPU_TENSOR_TYPE_INPUT, i, fetched[i].data()) == AIPU_STATUS_SUCCESS);
+        CHECK(fetched[i] == in_data[i]);
+        CHECK(job->get_tensor(AIPU_TENSOR_TYPE_OUTPUT, i, fetched[i].data()) == AIPU_STATUS_SUCCESS);
+        CHECK(fetched[i] == out_data[i]);
+    }
+
+    /* segments spanning both tensors of a side */
+    std::vector<char> in_flat(2 * size), out_flat(2 * size), expected;
+    for (uint32_t i = 0; i < in_flat.size(); i++)
+        in_flat[i] = (char)(i * 3 + 2);
+    std::vector<struct iovec> in_segs = split_iov(in_flat);
+    std::vector<struct iovec> out_segs = split_iov(out_flat);
+    REQUIRE(in_segs.size() == 4);
+    CHECK(in_segs[1].iov_len + in_segs[0].iov_len > size);
+
+    ret = job->run_iov(in_segs.data(), in_segs.size(), out_segs.data(), out_segs.size(), -1);
+    REQUIRE(ret == AIPU_STATUS_SUCCESS);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        CHECK(job->get_tensor(AIPU_TENSOR_TYPE_INPUT, i, fetched[i].data()) == AIPU_STATUS_SUCCESS);
+        CHECK(std::equal(fetched[i].begin(), fetched[i].end(), in_flat.begin() + i * size));
+        CHECK(job->get_tensor(AIPU_TENSOR_TYPE_OUTPUT, i, fetched[i].data()) == AIPU_STATUS_SUCCESS);
+        expected.insert(expected.end(), fetched[i].begin(), fetched[i].end());
+    }
+    CHECK(out_flat == expected);
+
+    /* a segment with null base leaves its part of the tensors as is */
+    in_segs[1].iov_base = nullptr;
+    std::fill(in_flat.begin(), in_flat.end(), 0);
+    ret = job->run_iov(in_segs.data(), in_segs.size(), nullptr, 0, -1);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+    CHECK(job->get_tensor(AIPU_TENSOR_TYPE_INPUT, 0, fetched[0].data()) == AIPU_STATUS_SUCCESS);
+    CHECK(fetched[0][0] == 0);
+    CHECK(fetched[0][in_segs[0].iov_len] == (char)(in_segs[0].iov_len * 3 + 2));
+    in_segs[1].iov_base = in_flat.data() + in_segs[0].iov_len;
+
+    /* the segments must add up to the tensors exactly */
+    in_segs.back().iov_len--;
+    CHECK(job->run_iov(in_segs.data(), in_segs.size(), nullptr, 0, -1) == AIPU_STATUS_ERROR_INVALID_SIZE);
+    in_segs.back().iov_len += 2;
+    CHECK(job->run_iov(in_segs.data(), in_segs.size(), nullptr, 0, -1) == AIPU_STATUS_ERROR_INVALID_SIZE);
+    in_segs.back().iov_len--;
+    out_segs.pop_back();
+    CHECK(job->run_iov(nullptr, 0, out_segs.data(), out_segs.size(), -1) == AIPU_STATUS_ERROR_INVALID_SIZE);
+    out_segs.push_back({out_flat.data(), 2 * size});
+    CHECK(job->run_iov(nullptr, 0, out_segs.data(), out_segs.size(), -1) == AIPU_STATUS_ERROR_INVALID_SIZE);
+
+    CHECK(ctx.get_graph_object(graph_id)->destroy_job(job_id) == AIPU_STATUS_SUCCESS);
+    CHECK(ctx.unload_graph(graph_id) == AIPU_STATUS_SUCCESS);
+    ctx.deinit();
+}
+#endif
+
+TEST_CASE_FIXTURE(JobTest, "tensor_float")
+{
+    aipu_status_t ret;
+    aipu_job_status_t status;
+    aipu_tensor_desc_t in_desc;
+    uint32_t elem_size = 0;
+
+    p_job->init(&m_sim_cfg, &m_hw_cfg);
+    p_gobj->get_tensor_descriptor(AIPU_TENSOR_TYPE_INPUT, 0, &in_desc);
+    elem_size = umd_quant_elem_size(in_desc.data_type);
+
+    ret = p_job->load_tensor_float(0, nullptr);
+    CHECK(ret == AIPU_STATUS_ERROR_NULL_PTR);
+
+    std::vector<float> in_float(in_desc.size, 0.5f);
+    ret = p_job->load_tensor_float(3, in_float.data());
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_TENSOR_ID);
+
+    ret = p_job->get_tensor_float(AIPU_TENSOR_TYPE_INPUT, 0, in_float.data());
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_OP);
+
+    ret = p_job->load_tensor_float(0, in_float.data());
+    CHECK(ret == ((elem_size != 0) ? AIPU_STATUS_SUCCESS : AIPU_STATUS_ERROR_OP_NOT_SUPPORTED));
+
+#if (defined SIMULATION)
+    p_job->config_simulation(AIPU_CONFIG_TYPE_SIMULATION, &sim_job_config);
+#endif
+    p_job->schedule();
+    p_job->get_status_blocking(&status, -1);
+
+    ret = p_job->get_tensor_float(AIPU_TENSOR_TYPE_PRINTF, 0, in_float.data());
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_OP);
+
+    elem_size = umd_quant_elem_size(out_desc.data_type);
+    std::vector<float> out_float(out_desc.size);
+    ret = p_job->get_tensor_float(AIPU_TENSOR_TYPE_OUTPUT, 0, out_float.data());
+    CHECK(ret == ((elem_size != 0) ? AIPU_STATUS_SUCCESS : AIPU_STATUS_ERROR_OP_NOT_SUPPORTED));
+}
+
+TEST_CASE("quantize")
+{
+    const float src[37] = {
+        -200.0f, -1.5f, -0.5f, 0.0f, 0.5f, 1.5f, 2.5f, 3.49f, 126.0f, 300.0f,
+        NAN, -3.0f, 7.0f, 11.0f, 13.0f, 17.0f, 19.0f, 23.0f, 29.0f, 31.0f,
+        37.0f, 41.0f, 43.0f, 47.0f, 53.0f, 59.0f, 61.0f, 67.0f, 71.0f, 73.0f,
+        79.0f, 83.0f, 89.0f, 97.0f, 101.0f, 103.0f, 107.0f
+    };
+    int8_t s8[37];
+    uint8_t u8[37];
+    uint16_t f16[37];
+    float dst[37];
+
+    CHECK(umd_quantize(src, s8, 37, AIPU_DATA_TYPE_S8, 1.0f, 0) == AIPU_STATUS_SUCCESS);
+    CHECK(s8[0] == -128);
+    CHECK(s8[1] == -2);
+    CHECK(s8[4] == 0);
+    CHECK(s8[6] == 2);
+    CHECK(s8[9] == 127);
+    CHECK(s8[10] == -128);
+    CHECK(s8[36] == 107);
+
+    CHECK(umd_quantize(src, u8, 37, AIPU_DATA_TYPE_U8, 2.0f, -10) == AIPU_STATUS_SUCCESS);
+    CHECK(u8[0] == 0);
+    CHECK(u8[5] == 13);
+    CHECK(u8[36] == 224);
+    CHECK(umd_dequantize(u8, dst, 37, AIPU_DATA_TYPE_U8, 2.0f, -10) == AIPU_STATUS_SUCCESS);
+    CHECK(dst[5] == 1.5f);
+    CHECK(dst[36] == 107.0f);
+
+    CHECK(umd_quantize(src, f16, 37, AIPU_DATA_TYPE_F16, 0, 0) == AIPU_STATUS_SUCCESS);
+    CHECK(umd_dequantize(f16, dst, 37, AIPU_DATA_TYPE_F16, 0, 0) == AIPU_STATUS_SUCCESS);
+    CHECK(dst[1] == -1.5f);
+    CHECK(dst[36] == 107.0f);
+    CHECK(dst[10] != dst[10]);
+
+    CHECK(umd_quantize(src, s8, 37, AIPU_DATA_TYPE_BOOL, 1.0f, 0) == AIPU_STATUS_ERROR_OP_NOT_SUPPORTED);
+}
+
+TEST_CASE("pack")
+{
+    int8_t s4[67];
+    int8_t s4_out[68];
+    int16_t s12[41];
+    int16_t s12_out[41];
+    uint8_t packed[82] = {0};
+    float f[41];
+
+    for (uint32_t i = 0; i < 67; i++)
+        s4[i] = (int8_t)(i % 19) - 9;
+    for (uint32_t i = 0; i < 41; i++)
+        s12[i] = (int16_t)(i * 211) - 4100;
+
+    CHECK(umd_quant_elem_cnt(AIPU_DATA_TYPE_COMPACT_S4, 34) == 68);
+    CHECK(umd_quant_elem_cnt(AIPU_DATA_TYPE_COMPACT_S12, 62) == 41);
+    CHECK(umd_quant_elem_cnt(AIPU_DATA_TYPE_ALIGNED_S12, 82) == 41);
+
+    CHECK(umd_pack(s4, packed, 67, AIPU_DATA_TYPE_COMPACT_S4) == AIPU_STATUS_SUCCESS);
+    CHECK(packed[0] == 0x88);
+    CHECK(packed[5] == 0x21);
+    CHECK(umd_unpack(packed, s4_out, 67, AIPU_DATA_TYPE_COMPACT_S4) == AIPU_STATUS_SUCCESS);
+    for (uint32_t i = 0; i < 67; i++)
+        CHECK(s4_out[i] == ((s4[i] < -8) ? -8 : ((s4[i] > 7) ? 7 : s4[i])));
+
+    CHECK(umd_pack(s4, packed, 67, AIPU_DATA_TYPE_ALIGNED_U4) == AIPU_STATUS_SUCCESS);
+    CHECK(packed[0] == 0x0F);
+    CHECK(packed[9] == 0x00);
+    CHECK(packed[20] == 0x0F);
+
+    CHECK(umd_pack(s12, packed, 41, AIPU_DATA_TYPE_COMPACT_S12) == AIPU_STATUS_SUCCESS);
+    CHECK(packed[0] == 0x00);
+    CHECK(packed[1] == 0x08);
+    CHECK(packed[2] == 0x80);
+    CHECK(umd_unpack(packed, s12_out, 41, AIPU_DATA_TYPE_COMPACT_S12) == AIPU_STATUS_SUCCESS);
+    for (uint32_t i = 0; i < 41; i++)
+        CHECK(s12_out[i] == ((s12[i] < -2048) ? -2048 : ((s12[i] > 2047) ? 2047 : s12[i])));
+
+    for (uint32_t i = 0; i < 41; i++)
+        f[i] = (float)s12_out[i];
+    CHECK(umd_quantize(f, packed, 41, AIPU_DATA_TYPE_ALIGNED_S12, 1.0f, 0) == AIPU_STATUS_SUCCESS);
+    CHECK(umd_dequantize(packed, f, 41, AIPU_DATA_TYPE_ALIGNED_S12, 1.0f, 0) == AIPU_STATUS_SUCCESS);
+    for (uint32_t i = 0; i < 41; i++)
+        CHECK(f[i] == (float)s12_out[i]);
+
+    CHECK(umd_pack(s12, packed, 4, AIPU_DATA_TYPE_S32) == AIPU_STATUS_ERROR_OP_NOT_SUPPORTED);
+}
+
+TEST_CASE_FIXTURE(JobTest, "tensor_layout")
+{
+    aipu_status_t ret;
+    aipu_tensor_desc_t in_desc;
+    aipu_tensor_copy_t copy = {1, 1, {0}, {1}, {1}, 0};
+
+    p_job->init(&m_sim_cfg, &m_hw_cfg);
+    p_gobj->get_tensor_descriptor(AIPU_TENSOR_TYPE_INPUT, 0, &in_desc);
+    copy.shape[0] = in_desc.size;
+    std::vector<char> data(in_desc.size, 1), back(in_desc.size, 0);
+
+    ret = p_job->load_tensor_layout(0, nullptr, &copy);
+    CHECK(ret == AIPU_STATUS_ERROR_NULL_PTR);
+
+    ret = p_job->load_tensor_layout(3, data.data(), &copy);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_TENSOR_ID);
+
+    copy.tensor_offset = 1;
+    ret = p_job->load_tensor_layout(0, data.data(), &copy);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_SIZE);
+
+    copy.tensor_offset = 0;
+    copy.elem_size = 3;
+    ret = p_job->load_tensor_layout(0, data.data(), &copy);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_CONFIG);
+
+    copy.elem_size = 1;
+    ret = p_job->load_tensor_layout(0, data.data(), &copy);
+    CHECK(ret == AIPU_STATUS_SUCCESS);
+
+    ret = p_job->get_tensor_layout(AIPU_TENSOR_TYPE_INPUT, 0, back.data(), &copy);
+    CHECK(ret == AIPU_STATUS_ERROR_INVALID_OP);
+}
+
+TEST_CASE("strided_copy")
+{
+    /* NCHW 1x3x5x7 int32 into NHWC with channel padded to 4, and back */
+    const uint64_t shape[4] = {1, 3, 5, 7};
+    const uint64_t nchw[4] = {3 * 5 * 7 * 4, 5 * 7 * 4, 7 * 4, 4};
+    const uint64_t nhwc[4] = {5 * 7 * 4 * 4, 4, 7 * 4 * 4, 4 * 4};
+    int32_t src[3 * 5 * 7], back[3 * 5 * 7] = {0};
+    int32_t padded[5 * 7 * 4];
+    aipu_tensor_copy_t copy = {4, 4, {1, 3, 5, 7}, {0}, {0}, 0};
+
+    for (uint32_t i = 0; i < 3 * 5 * 7; i++)
+        src[i] = i;
+    for (uint32_t i = 0; i < 5 * 7 * 4; i++)
+        padded[i] = -1;
+
+    umd_strided_copy((const char *)src, nchw, (char *)padded, nhwc, shape, 4, 4);
+    for (uint32_t c = 0; c < 3; c++)
+        for (uint32_t hw = 0; hw < 5 * 7; hw++)
+            CHECK(padded[hw * 4 + c] == src[c * 5 * 7 + hw]);
+    for (uint32_t hw = 0; hw < 5 * 7; hw++)
+        CHECK(padded[hw * 4 + 3] == -1);
+
+    umd_strided_copy((const char *)padded, nhwc, (char *)back, nchw, shape, 4, 4);
+    CHECK(memcmp(src, back, sizeof(src)) == 0);
+
+    memcpy(copy.tensor_strides, nhwc, sizeof(nhwc));
+    CHECK(umd_check_tensor_copy(&copy, sizeof(padded)) == AIPU_STATUS_SUCCESS);
+    CHECK(umd_check_tensor_copy(&copy, sizeof(padded) - 5) == AIPU_STATUS_ERROR_INVALID_SIZE);
+    copy.tensor_offset = 4;
+    CHECK(umd_check_tensor_copy(&copy, sizeof(padded)) == AIPU_STATUS_SUCCESS);
+    copy.tensor_offset = 5;
+    CHECK(umd_check_tensor_copy(&copy, sizeof(padded)) == AIPU_STATUS_ERROR_INVALID_SIZE);
+    copy.dim_cnt = AIPU_TENSOR_COPY_MAX_DIMS + 1;
+    CHECK(umd_check_tensor_copy(&copy, sizeof(padded)) == AIPU_STATUS_ERROR_INVALID_CONFIG);
+}
+
+TEST_CASE("job_trace")
+{
+    const char *path = "./job_trace_test.json";
+    std::string json;
+
+    aipudrv::JobTrace::enable(true);
+    aipudrv::JobTrace::record(aipudrv::JOB_TRACE_SCHEDULE, 1000, 3500, 0x500000001UL, 1);
+    std::thread([] {
+        aipudrv::JobTraceSpan span(aipudrv::JOB_TRACE_LOAD_TENSOR, 0x500000002UL, 0);
+    }).join();
+    aipudrv::JobTrace::enable(false);
+    {
+        aipudrv::JobTraceSpan span(aipudrv::JOB_TRACE_GET_TENSOR, 0x500000003UL, 0);
+    }
+
+    CHECK(aipudrv::JobTrace::dump_json(path) == AIPU_STATUS_SUCCESS);
+    std::ifstream ifs(path);
+    json.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    CHECK(json.find("\"name\": \"schedule\", \"cat\": \"job\", \"ph\": \"X\", \"ts\": 1.000, "
+        "\"dur\": 2.500") != std::string::npos);
+    CHECK(json.find("\"job_id\": \"0x500000001\", \"graph_id\": \"0x500000000\", "
+        "\"partition_id\": 1") != std::string::npos);
+    CHECK(json.find("\"job_id\": \"0x500000002\"") != std::string::npos);
+    CHECK(json.find("get_tensor") == std::string::npos);
+    remove(path);
+
+    CHECK(aipudrv::JobTrace::dump_json("/nonexistent/job_trace.json") == AIPU_STATUS_ERROR_OPEN_FILE_FAIL);
+}
+
+TEST_CASE("metrics")
+{
+    const char *path = "./metrics_test.prom";
+    aipudrv::Metrics metrics;
+    aipu_metrics_t out = {0};
+    std::vector<std::pair<uint64_t, aipu_job_counters_t>> graphs(1);
+    std::string prom;
+
+    /* log-linear buckets, 4 per power of 2 */
+    CHECK(aipudrv::LatencyHist::bucket(0) == 0);
+    CHECK(aipudrv::LatencyHist::bucket(3) == 3);
+    CHECK(aipudrv::LatencyHist::bucket(4) == 4);
+    CHECK(aipudrv::LatencyHist::bucket(7) == 7);
+    CHECK(aipudrv::LatencyHist::bucket(8) == 8);
+    CHECK(aipudrv::LatencyHist::bucket(1000) == 35);
+    CHECK(aipudrv::LatencyHist::bucket(~0UL) == AIPU_METRICS_HIST_BUCKETS - 1);
+    for (uint32_t i = 0; i < AIPU_METRICS_HIST_BUCKETS - 1; i++)
+    {
+        CHECK(aipudrv::LatencyHist::bucket(aipudrv::LatencyHist::bucket_end(i) - 1) == i);
+        CHECK(aipudrv::LatencyHist::bucket(aipudrv::LatencyHist::bucket_end(i)) == i + 1);
+    }
+
+    metrics.jobs().created(0);
+    metrics.jobs().created(5);
+    metrics.commit(0, 1);
+    metrics.commit(1, 1);
+    metrics.done(0, 1, false);
+    metrics.done(1, 1, true);
+    metrics.commit(0, 9);
+    metrics.add_latency(AIPU_METRICS_LAT_WAIT, 1000);
+    metrics.add_latency(AIPU_METRICS_LAT_WAIT, 3000);
+    metrics.read(&out);
+    CHECK(out.jobs.created[0] == 1);
+    CHECK(out.jobs.created[1] == 1);
+    CHECK(out.jobs.scheduled[0] == 2);
+    CHECK(out.jobs.completed[0] == 1);
+    CHECK(out.jobs.failed[1] == 1);
+    CHECK(out.inflight[1] == 0);
+    CHECK(out.inflight_max[1] == 2);
+    CHECK(out.inflight[AIPU_METRICS_PARTITION_CNT - 1] == 1);
+    CHECK(out.latency[AIPU_METRICS_LAT_WAIT].count == 2);
+    CHECK(out.latency[AIPU_METRICS_LAT_WAIT].sum_ns == 4000);
+    CHECK(out.latency[AIPU_METRICS_LAT_WAIT].max_ns == 3000);
+
+    graphs[0].first = 0x700000000UL;
+    metrics.jobs().read(&graphs[0].second);
+    CHECK(aipudrv::write_metrics_prom(path, &out, graphs) == AIPU_STATUS_SUCCESS);
+    std::ifstream ifs(path);
+    prom.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    CHECK(prom.find("aipu_umd_jobs_failed_total{graph=\"all\",qos=\"high\"} 1\n") != std::string::npos);
+    CHECK(prom.find("aipu_umd_jobs_created_total{graph=\"0x700000000\",qos=\"low\"} 1\n") != std::string::npos);
+    CHECK(prom.find("aipu_umd_jobs_inflight_max{partition=\"1\"} 2\n") != std::string::npos);
+    CHECK(prom.find("aipu_umd_latency_seconds_bucket{op=\"wait\",le=\"+Inf\"} 2\n") != std::string::npos);
+    CHECK(prom.find("aipu_umd_latency_seconds_count{op=\"wait\"} 2\n") != std::string::npos);
+    remove(path);
+
+    CHECK(aipudrv::write_metrics_prom("/nonexistent/metrics.prom", &out, graphs) ==
+        AIPU_STATUS_ERROR_OPEN_FILE_FAIL);
+}
+
+TEST_CASE("profile_report")
+{
+    struct Record
+    {
+        uint32_t layer_id;
+        uint32_t rsvd;
+        uint64_t start;
+        uint64_t end;
+    };
+    const char *path = "./profile_report_test.csv";
+    aipu_profile_layout_t layout = {16, sizeof(Record), 0, 8, 16};
+    aipudrv::ProfileRegions regions = {{0, 0}, {1, 256}};
+    std::vector<aipudrv::ProfileSample> samples;
+    std::vector<aipu_profile_layer_stats_t> stats;
+    aipudrv::ProfileReport report;
+    std::vector<char> buf(512, 0);
+    Record *sg0 = (Record *)(buf.data() + 16);
+    Record *sg1 = (Record *)(buf.data() + 256 + 16);
+    std::string csv;
+
+    /* subgraph 0: layers 3 and 4, subgraph 1: layer 3; unused records are 0 */
+    sg0[0] = {3, 0, 100, 600};
+    sg0[1] = {4, 0, 600, 650};
+    sg1[0] = {3, 0, 1000, 1100};
+    CHECK(aipudrv::decode_profile(buf.data(), buf.size(), regions, &layout, samples) ==
+        AIPU_STATUS_SUCCESS);
+    REQUIRE(samples.size() == 3);
+    CHECK(samples[1].sg_id == 0);
+    CHECK(samples[1].layer_id == 4);
+    CHECK(samples[1].cycles == 50);
+    CHECK(samples[2].sg_id == 1);
+    CHECK(samples[2].cycles == 100);
+
+    for (uint64_t i = 1; i <= 100; i++)
+    {
+        sg0[0].end = sg0[0].start + i * 10;
+        samples.clear();
+        aipudrv::decode_profile(buf.data(), buf.size(), regions, &layout, samples);
+        report.add(samples);
+    }
+    report.read(stats, 1000, false);
+    REQUIRE(stats.size() == 3);
+    CHECK(stats[0].subgraph_id == 0);
+    CHECK(stats[0].layer_id == 3);
+    CHECK(stats[0].runs == 100);
+    CHECK(stats[0].min_cycles == 10);
+    CHECK(stats[0].mean_cycles == 505);
+    CHECK(stats[0].p99_cycles == 990);
+    CHECK(stats[0].max_cycles == 1000);
+    CHECK(stats[0].p99_us == doctest::Approx(0.99));
+    CHECK(stats[2].subgraph_id == 1);
+
+    CHECK(aipudrv::write_profile_csv(path, stats) == AIPU_STATUS_SUCCESS);
+    std::ifstream ifs(path);
+    csv.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    CHECK(csv.find("0,3,100,10,505,990,1000,0.505,0.990\n") != std::string::npos);
+    remove(path);
+
+    report.read(stats, 0, true);
+    CHECK(stats[0].mean_us == 0);
+    report.read(stats, 0, false);
+    CHECK(stats.empty());
+
+    layout.end_offset = 20;
+    CHECK(aipudrv::decode_profile(buf.data(), buf.size(), regions, &layout, samples) ==
+        AIPU_STATUS_ERROR_INVALID_CONFIG);
+}
+
+TEST_CASE("printf_stream")
+{
+    /* 8-byte header and 32 bytes of ring */
+    std::vector<char> buf(40, 0);
+    std::vector<std::string> lines;
+    auto read = [&buf](uint32_t offset, char *dest, uint32_t size) {
+        memcpy(dest, buf.data() + offset, size);
+    };
+    auto emit = [&lines](const char *line, uint32_t len) {
+        lines.push_back(std::string(line, len));
+    };
+    auto npu_printf = [&buf](const char *text) {
+        int32_t *header = (int32_t *)buf.data();
+
+        for (; *text != '\0'; text++)
+        {
+            buf[8 + header[1]] = *text;
+            if (++header[1] == 32)
+            {
+                header[0] = 1;
+                header[1] = 0;
+            }
+        }
+    };
+    aipudrv::PrintfRing ring(read, buf.size());
+
+    CHECK(ring.poll(emit) == 0);
+    npu_printf("abc\nde");
+    CHECK(ring.poll(emit) == 6);
+    REQUIRE(lines.size() == 1);
+    CHECK(lines[0] == "abc");
+
+    /* wraps within a poll */
+    npu_printf("f\n0123456789012345678901234\nxy\n");
+    CHECK(ring.poll(emit) == 31);
+    REQUIRE(lines.size() == 4);
+    CHECK(lines[1] == "def");
+    CHECK(lines[2] == "0123456789012345678901234");
+    CHECK(lines[3] == "xy");
+    CHECK(ring.get_lost() == 0);
+
+    /* the first wrap passes the read position */
+    memset(buf.data(), 0, buf.size());
+    aipudrv::PrintfRing lapped(read, buf.size());
+    npu_printf("12345\n");
+    lapped.poll(emit);
+    npu_printf("AAAAAAAAAAAAAAAAAAAAAAAAA\nBB\nCCCC\n");
+    lines.clear();
+    lapped.poll(emit);
+    CHECK(lapped.get_lost() == 2);
+    CHECK(lines == std::vector<std::string>({"BB", "CCCC"}));
+
+    /* a new job run zeroes the header */
+    memset(buf.data(), 0, 8);
+    npu_printf("run2");
+    lines.clear();
+    lapped.poll(emit);
+    CHECK(lines.empty());
+    lapped.flush(emit);
+    CHECK(lines == std::vector<std::string>({"run2"}));
+
+    /* the stream drains an unterminated line on stop */
+    std::vector<std::string> sink_lines;
+    aipu_printf_stream_t cfg = {0};
+
+    memset(buf.data(), 0, buf.size());
+    cfg.job_id = 7;
+    cfg.arg = &sink_lines;
+    cfg.poll_ms = 1;
+    cfg.sink = [](uint64_t job_id, const char *line, uint32_t len, void *arg) {
+        CHECK(job_id == 7);
+        CHECK(strlen(line) == len);
+        ((std::vector<std::string> *)arg)->push_back(line);
+    };
+    aipudrv::PrintfStream stream(read, buf.size(), &cfg);
+    npu_printf("hello\nnpu");
+    CHECK(stream.stop() == 0);
+    CHECK(sink_lines == std::vector<std::string>({"hello", "npu"}));
+}
+
+TEST_CASE("dump_writer")
+{
+    aipu_dump_writer_cfg_t cfg = {0};
+    std::vector<char> weight(1 << 20, 0x5a);
+    std::vector<char> frame;
+    struct stat st0, st1;
+    char magic[4] = {0};
+
+    cfg.async = 1;
+    cfg.dedup = 1;
+    cfg.max_pending_mb = 1;
+    umd_dump_writer_config(&cfg);
+    CHECK(umd_dump_writer_active());
+
+    /* the snapshot is taken on the call, the source can change right after */
+    CHECK(umd_dump_file_helper("./dump_writer_0.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    CHECK(umd_dump_file_helper("./dump_writer_1.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    weight[0] = 0;
+    CHECK(umd_dump_file_helper("./dump_writer_2.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    CHECK(umd_dump_writer_flush() == AIPU_STATUS_SUCCESS);
+
+    REQUIRE(stat("./dump_writer_0.bin", &st0) == 0);
+    REQUIRE(stat("./dump_writer_1.bin", &st1) == 0);
+    CHECK(st0.st_ino == st1.st_ino);
+    CHECK(st0.st_size == (1 << 20));
+    REQUIRE(stat("./dump_writer_2.bin", &st1) == 0);
+    CHECK(st0.st_ino != st1.st_ino);
+
+    /* the same size and hash but other bytes on disk, as on a collision, isn't linked */
+    {
+        std::fstream fs("./dump_writer_2.bin", std::ios::binary | std::ios::in | std::ios::out);
+        fs.put(0x11);
+    }
+    CHECK(umd_dump_file_helper("./dump_writer_4.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    CHECK(umd_dump_writer_flush() == AIPU_STATUS_SUCCESS);
+    REQUIRE(stat("./dump_writer_4.bin", &st0) == 0);
+    CHECK(st0.st_ino != st1.st_ino);
+    {
+        std::vector<char> back(weight.size());
+        std::ifstream ifs("./dump_writer_4.bin", std::ios::binary);
+
+        ifs.read(back.data(), back.size());
+        CHECK(back == weight);
+    }
+
+    CHECK(umd_dump_file_helper("/nonexistent/dump_writer.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    CHECK(umd_dump_writer_flush() == AIPU_STATUS_ERROR_WRITE_FILE_FAIL);
+    CHECK(umd_dump_writer_flush() == AIPU_STATUS_SUCCESS);
+
+    /* synchronous and compressed */
+    cfg.async = 0;
+    cfg.dedup = 0;
+    cfg.compress = AIPU_DUMP_COMPRESS_LZ4;
+    umd_dump_writer_config(&cfg);
+    CHECK(umd_dump_file_helper("./dump_writer_3.bin", weight.data(), weight.size()) ==
+        AIPU_STATUS_SUCCESS);
+    REQUIRE(stat("./dump_writer_3.bin.lz4", &st0) == 0);
+    CHECK(st0.st_size < 64 * 1024);
+    std::ifstream ifs("./dump_writer_3.bin.lz4", std::ios::binary);
+    ifs.read(magic, sizeof(magic));
+    CHECK(memcmp(magic, "\x04\x22\x4d\x18", 4) == 0);
+
+    umd_lz4_compress_frame(nullptr, 0, frame);
+    CHECK(frame.size() == 19);
+
+    cfg.compress = AIPU_DUMP_COMPRESS_NONE;
+    umd_dump_writer_config(&cfg);
+    CHECK(!umd_dump_writer_active());
+    for (auto name : {"./dump_writer_0.bin", "./dump_writer_1.bin", "./dump_writer_2.bin",
+        "./dump_writer_3.bin.lz4", "./dump_writer_4.bin"})
+        remove(name);
+}
+
 #if (defined SIMULATION)
 TEST_CASE_FIXTURE(JobTest, "config_simulation")
 {
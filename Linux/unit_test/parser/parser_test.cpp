@@ -3,8 +3,10 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <stdlib.h>
+#include <sstream>
 #include "parser_test.h"
 #include "aipu.h"
+#include "graph_gen/graph_gen.h"
 
 TEST_CASE_FIXTURE(ParserTest, "get_graph_bin_version")
 {
@@ -36,3 +38,65 @@ TEST_CASE_FIXTURE(ParserTest, "parse_graph_header_top")
     CHECK(ret == AIPU_STATUS_SUCCESS);
 }
 #endif
+
+#if (defined ZHOUYI_V3)
+/**
+ * @brief a device that is never touched, parsing needs none
+ */
+class ParseOnlyDevice: public DeviceBase
+{
+public:
+    bool has_target(uint32_t arch, uint32_t version, uint32_t config, uint32_t rev)
+    {
+        return true;
+    }
+    aipu_status_t schedule(const JobDesc& job)
+    {
+        return AIPU_STATUS_ERROR_INVALID_OP;
+    }
+};
+
+TEST_CASE("parse_generated_graph")
+{
+    graph_gen::Config cfg;
+    ParseOnlyDevice dev;
+    MainContext ctx;
+    GraphV3X graph(&ctx, 1, &dev);
+    ParserELF parser;
+    std::string bin;
+
+    cfg.subgraph_cnt = 8;
+    cfg.bss_cnt = 2;
+    cfg.static_cnt = 4;
+    cfg.reuse_cnt = 3;
+    cfg.private_cnt = 2;
+    cfg.sub_section_cnt = 2;
+    cfg.param_cnt = 3;
+    cfg.input_cnt = 2;
+    cfg.output_cnt = 3;
+    cfg.dynamic_shape = true;
+    REQUIRE(graph_gen::generate(cfg, bin) == AIPU_STATUS_SUCCESS);
+
+    std::istringstream is(bin);
+    CHECK(parser.parse_graph(is, bin.size(), graph) == AIPU_STATUS_SUCCESS);
+    CHECK(graph.get_subgraph_cnt() == 8);
+    CHECK(graph.get_subgraph(7).bss_idx == 1);
+    CHECK(graph.get_subgraph(7).precursors.size() == 1);
+    CHECK(graph.get_subgraph(7).private_buffers.size() == 2);
+    CHECK(graph.get_subgraph(7).private_buffers_map.size() == 2 * 2 * 3);
+    CHECK(graph.get_bss_cnt() == 2);
+    CHECK(graph.get_bss(0).static_sections.size() == 4);
+    CHECK(graph.get_bss(0).reuse_sections.size() == 2 + 3 + 3 + 3);
+    CHECK(graph.get_bss(1).reuse_sections.size() == 3);
+    CHECK(graph.get_bss(0).param_map.size() == (4 + 2 + 3 + 3 + 3) * 2 * 3);
+    CHECK(graph.get_bss(0).param_map.size() + 8 * 2 * 2 * 3 == graph_gen::param_entry_cnt(cfg));
+    CHECK(graph.get_bss(0).io.inputs.size() == 2);
+    CHECK(graph.get_bss(0).io.outputs.size() == 3);
+    CHECK(graph.get_bss(0).io.outputs[2].id == 2);
+    CHECK(graph.is_dynamic_shape());
+    CHECK(graph.get_dynamic_shape_num() == 2);
+
+    cfg.bss_cnt = 9;
+    CHECK(graph_gen::generate(cfg, bin) == AIPU_STATUS_ERROR_INVALID_CONFIG);
+}
+#endif